@@ -0,0 +1,241 @@
+//***************************************************************************************
+// AssetCooker.cpp
+//***************************************************************************************
+
+#include "AssetCooker.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <vector>
+#include "CookManifest.h"
+#include "MeshCooker.h"
+#include "TextureCooker.h"
+#include "../Common/ParallelFor.h"
+
+namespace fs = std::filesystem;
+
+const char* AssetCooker::ManifestFilename = "CookManifest.txt";
+
+namespace
+{
+	struct CookRule
+	{
+		const char* Directory;
+		const char* Extension;
+		const char* OutputExtension;
+		std::string (*Recipe)();
+		bool (*Cook)(const std::string& source, const std::string& output, std::string& error);
+	};
+
+	const CookRule gRules[] =
+	{
+		{ "Models",   ".txt", ".m3db", MeshCooker::Recipe,    MeshCooker::CookTxtModel },
+		{ "Models",   ".m3d", ".m3db", MeshCooker::Recipe,    MeshCooker::CookM3d },
+		{ "Textures", ".dds", ".dds",  TextureCooker::Recipe, TextureCooker::CookDds },
+		{ "Textures", ".bmp", ".dds",  TextureCooker::Recipe, TextureCooker::CookBmp },
+	};
+
+	enum class CookStatus
+	{
+		UpToDate,
+		Cooked,
+		Failed
+	};
+
+	struct CookJob
+	{
+		// Relative to the roots, with '/' separators.
+		std::string Source;
+		std::string Output;
+		const CookRule* Rule = nullptr;
+		std::uintmax_t Size = 0;
+
+		CookStatus Status = CookStatus::Failed;
+		CookRecord Record;
+		std::string Error;
+		double Ms = 0.0;
+	};
+
+	std::string ToLower(std::string s)
+	{
+		std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return (char)tolower(c); });
+		return s;
+	}
+
+	std::vector<CookJob> FindAssets(const fs::path& sourceRoot)
+	{
+		std::vector<CookJob> jobs;
+		for(const CookRule& rule : gRules)
+		{
+			std::error_code ec;
+			for(fs::directory_iterator it(sourceRoot / rule.Directory, ec), end; !ec && it != end; it.increment(ec))
+			{
+				if(!it->is_regular_file() || ToLower(it->path().extension().string()) != rule.Extension)
+					continue;
+
+				CookJob job;
+				job.Source = std::string(rule.Directory) + "/" + it->path().filename().string();
+				job.Output = std::string(rule.Directory) + "/" + it->path().stem().string() + rule.OutputExtension;
+				job.Rule = &rule;
+				job.Size = it->file_size();
+				jobs.push_back(job);
+			}
+		}
+
+		std::sort(jobs.begin(), jobs.end(), [](const CookJob& a, const CookJob& b) { return a.Source < b.Source; });
+		return jobs;
+	}
+
+	void CookAsset(CookJob& job, const CookManifest& manifest, const AssetCooker::Options& options)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+
+		fs::path source = fs::path(options.SourceRoot) / job.Source;
+		fs::path output = fs::path(options.OutputRoot) / job.Output;
+
+		job.Record.Recipe = job.Rule->Recipe();
+		job.Record.Output = job.Output;
+		if(!CookManifest::HashFile(source.string(), job.Record.Hash))
+		{
+			job.Status = CookStatus::Failed;
+			job.Error = "can't read source";
+			return;
+		}
+
+		const CookRecord* previous = manifest.Find(job.Source);
+		std::error_code ec;
+		if(!options.Force && previous != nullptr && previous->Hash == job.Record.Hash &&
+			previous->Recipe == job.Record.Recipe && previous->Output == job.Output && fs::exists(output, ec))
+		{
+			job.Status = CookStatus::UpToDate;
+			return;
+		}
+
+		fs::path temp = output;
+		temp += ".tmp";
+		if(!job.Rule->Cook(source.string(), temp.string(), job.Error))
+		{
+			fs::remove(temp, ec);
+			job.Status = CookStatus::Failed;
+			return;
+		}
+
+		fs::rename(temp, output, ec);
+		if(ec)
+		{
+			fs::remove(temp, ec);
+			job.Status = CookStatus::Failed;
+			job.Error = "can't replace " + output.string();
+			return;
+		}
+
+		job.Status = CookStatus::Cooked;
+		job.Ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+bool AssetCooker::Run(const Options& options, Summary& summary)
+{
+	summary = Summary();
+	auto start = std::chrono::high_resolution_clock::now();
+
+	const fs::path outputRoot(options.OutputRoot);
+	const std::string manifestPath = (outputRoot / ManifestFilename).string();
+
+	CookManifest manifest;
+	manifest.Load(manifestPath);
+
+	std::vector<CookJob> jobs = FindAssets(options.SourceRoot);
+
+	//
+	// Two sources that cook to the same output (say tree.bmp and tree.dds) would
+	// overwrite each other; the first in name order wins.
+	//
+
+	std::map<std::string, std::string> outputs;
+	std::vector<size_t> order;
+	for(size_t i = 0; i < jobs.size(); ++i)
+	{
+		auto inserted = outputs.insert({ ToLower(jobs[i].Output), jobs[i].Source });
+		if(!inserted.second)
+		{
+			jobs[i].Error = "same output as " + inserted.first->second;
+			continue;
+		}
+
+		std::error_code ec;
+		fs::create_directories((outputRoot / jobs[i].Output).parent_path(), ec);
+		order.push_back(i);
+	}
+
+	// Biggest first, so a large model doesn't start last and finish alone.
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return jobs[a].Size > jobs[b].Size; });
+
+	unsigned numThreads = ResolveThreadCount(options.NumThreads);
+	ParallelFor(order.size(), numThreads, [&](unsigned, size_t i)
+	{
+		CookAsset(jobs[order[i]], manifest, options);
+	});
+
+	//
+	// Report and update the manifest in name order.
+	//
+
+	bool succeeded = true;
+	for(const CookJob& job : jobs)
+	{
+		switch(job.Status)
+		{
+		case CookStatus::UpToDate:
+			++summary.UpToDate;
+			break;
+		case CookStatus::Cooked:
+			++summary.Cooked;
+			manifest.Set(job.Source, job.Record);
+			printf("cooked   %s -> %s (%.1f ms)\n", job.Source.c_str(), job.Output.c_str(), job.Ms);
+			break;
+		case CookStatus::Failed:
+			++summary.Failed;
+			manifest.Remove(job.Source);
+			printf("FAILED   %s: %s\n", job.Source.c_str(), job.Error.c_str());
+			succeeded = false;
+			break;
+		}
+	}
+
+	// Outputs whose source is gone.
+	std::vector<std::string> stale;
+	for(const auto& record : manifest.GetRecords())
+	{
+		bool found = std::any_of(jobs.begin(), jobs.end(), [&](const CookJob& job) { return job.Source == record.first; });
+		if(!found)
+			stale.push_back(record.first);
+	}
+
+	for(const std::string& source : stale)
+	{
+		std::error_code ec;
+		const CookRecord* record = manifest.Find(source);
+		if(outputs.count(ToLower(record->Output)) == 0)
+			fs::remove(outputRoot / record->Output, ec);
+
+		printf("removed  %s\n", record->Output.c_str());
+		manifest.Remove(source);
+		++summary.Removed;
+	}
+
+	if(!manifest.Save(manifestPath))
+	{
+		printf("FAILED   can't write %s\n", manifestPath.c_str());
+		succeeded = false;
+	}
+
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	printf("%u cooked, %u up to date, %u failed, %u removed in %.1f ms on %u threads\n",
+		summary.Cooked, summary.UpToDate, summary.Failed, summary.Removed, ms, numThreads);
+
+	return succeeded;
+}
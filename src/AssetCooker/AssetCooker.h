@@ -0,0 +1,54 @@
+//***************************************************************************************
+// AssetCooker.h
+//
+// Turns the raw demo assets under a source root into runtime-ready files under an
+// output root, mirroring the directory layout:
+//
+//   Models/*.txt, Models/*.m3d   ->  Models/*.m3db   (MeshCooker)
+//   Textures/*.dds               ->  Textures/*.dds  (TextureCooker)
+//   Textures/*.bmp               ->  Textures/*.dds  (TextureCooker)
+//
+// A CookManifest in the output root remembers the content hash and recipe each
+// output was made from, so a run only recooks assets whose content or cooker
+// changed, or whose output is missing.  Outputs of deleted sources are removed.
+// Assets are independent and cook on ParallelFor, largest first; each output is
+// written to a temporary file and renamed, so an interrupted run never leaves a
+// half-written output that the manifest calls up to date.
+//***************************************************************************************
+
+#pragma once
+
+#include <string>
+
+class AssetCooker
+{
+public:
+	struct Options
+	{
+		std::string SourceRoot = "..";
+		std::string OutputRoot = "../Cooked";
+
+		// 0 uses every hardware thread.
+		unsigned NumThreads = 0;
+
+		// Recook everything, ignoring the manifest.
+		bool Force = false;
+	};
+
+	struct Summary
+	{
+		unsigned Cooked = 0;
+		unsigned UpToDate = 0;
+		unsigned Failed = 0;
+		unsigned Removed = 0;
+	};
+
+	///<summary>
+	/// Cooks every asset that is out of date, prints one line per asset, and saves
+	/// the manifest.  Returns false if any asset failed; the others are still
+	/// cooked and recorded.
+	///</summary>
+	static bool Run(const Options& options, Summary& summary);
+
+	static const char* ManifestFilename;
+};
@@ -0,0 +1,79 @@
+//***************************************************************************************
+// CookManifest.cpp
+//***************************************************************************************
+
+#include "CookManifest.h"
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include "../Common/MappedFile.h"
+
+void CookManifest::Load(const std::string& filename)
+{
+	mRecords.clear();
+
+	std::ifstream fin(filename);
+	std::string line;
+	while(std::getline(fin, line))
+	{
+		size_t tab0 = line.find('\t');
+		size_t tab1 = tab0 == std::string::npos ? tab0 : line.find('\t', tab0 + 1);
+		size_t tab2 = tab1 == std::string::npos ? tab1 : line.find('\t', tab1 + 1);
+		if(tab2 == std::string::npos)
+			continue;
+
+		CookRecord record;
+		if(sscanf(line.c_str() + tab0 + 1, "%" SCNx64, &record.Hash) != 1)
+			continue;
+
+		record.Recipe = line.substr(tab1 + 1, tab2 - tab1 - 1);
+		record.Output = line.substr(tab2 + 1);
+		mRecords[line.substr(0, tab0)] = record;
+	}
+}
+
+bool CookManifest::Save(const std::string& filename)const
+{
+	std::ofstream fout(filename);
+	for(const auto& entry : mRecords)
+	{
+		char hash[17];
+		snprintf(hash, sizeof(hash), "%016" PRIx64, entry.second.Hash);
+		fout << entry.first << '\t' << hash << '\t' << entry.second.Recipe << '\t' << entry.second.Output << '\n';
+	}
+
+	return !fout.fail();
+}
+
+const CookRecord* CookManifest::Find(const std::string& source)const
+{
+	auto it = mRecords.find(source);
+	return it == mRecords.end() ? nullptr : &it->second;
+}
+
+void CookManifest::Set(const std::string& source, const CookRecord& record)
+{
+	mRecords[source] = record;
+}
+
+void CookManifest::Remove(const std::string& source)
+{
+	mRecords.erase(source);
+}
+
+bool CookManifest::HashFile(const std::string& filename, std::uint64_t& hash)
+{
+	MappedFile file;
+	if(!file.Open(filename))
+		return false;
+
+	std::uint64_t h = 0xcbf29ce484222325ull;
+	for(const char* p = file.Begin(); p != file.End(); ++p)
+	{
+		h ^= (unsigned char)*p;
+		h *= 0x100000001b3ull;
+	}
+
+	hash = h;
+	return true;
+}
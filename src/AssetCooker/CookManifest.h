@@ -0,0 +1,56 @@
+//***************************************************************************************
+// CookManifest.h
+//
+// Record of what AssetCooker last produced.  One line per source asset, tab
+// separated:
+//
+//   source path   content hash   recipe   output path
+//
+// Paths are relative to the asset root.  The hash is FNV-1a 64 over the source
+// bytes and the recipe names the cooker and its version, so an asset is recooked
+// when either its content or the code that cooks it changes, and never because a
+// file was merely touched.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+struct CookRecord
+{
+	std::uint64_t Hash = 0;
+	std::string Recipe;
+	std::string Output;
+};
+
+class CookManifest
+{
+public:
+	///<summary>
+	/// Reads filename.  A missing file gives an empty manifest; malformed lines are
+	/// skipped, which just means those assets get recooked.
+	///</summary>
+	void Load(const std::string& filename);
+	bool Save(const std::string& filename)const;
+
+	///<summary>
+	/// The record for source, or null if it has never been cooked.
+	///</summary>
+	const CookRecord* Find(const std::string& source)const;
+
+	void Set(const std::string& source, const CookRecord& record);
+	void Remove(const std::string& source);
+
+	const std::map<std::string, CookRecord>& GetRecords()const { return mRecords; }
+
+	///<summary>
+	/// FNV-1a 64 of the file's bytes.  Returns false if it can't be read.
+	///</summary>
+	static bool HashFile(const std::string& filename, std::uint64_t& hash);
+
+private:
+	// Ordered so the saved file is the same for the same content.
+	std::map<std::string, CookRecord> mRecords;
+};
@@ -0,0 +1,241 @@
+//***************************************************************************************
+// MeshCooker.cpp
+//***************************************************************************************
+
+#include "MeshCooker.h"
+#include <algorithm>
+#include "../Common/MeshOptimizer.h"
+#include "../Common/TxtModelLoader.h"
+#include "../Chapter 23 Character Animation/SkinnedMesh/M3dBinary.h"
+
+namespace
+{
+	using uint32 = std::uint32_t;
+
+	// Bump when the cooked output of the same source changes.
+	const int MeshCookerVersion = 1;
+
+	const size_t MaxVertices16 = 65536;
+
+	///<summary>
+	/// True if every index that points into a subset's vertex range comes from that
+	/// subset's own triangles, so each range can be renumbered on its own.
+	///</summary>
+	bool SubsetVertexRangesArePrivate(const std::vector<USHORT>& indices, size_t vertexCount,
+		const std::vector<M3DLoader::Subset>& subsets)
+	{
+		const int NoSubset = -1;
+		std::vector<int> vertexOwner(vertexCount, NoSubset);
+		std::vector<int> indexOwner(indices.size(), NoSubset);
+
+		for(size_t s = 0; s < subsets.size(); ++s)
+		{
+			const M3DLoader::Subset& subset = subsets[s];
+			for(uint32 v = subset.VertexStart; v < subset.VertexStart + subset.VertexCount; ++v)
+			{
+				if(vertexOwner[v] != NoSubset)
+					return false;
+				vertexOwner[v] = (int)s;
+			}
+
+			for(size_t i = 3*(size_t)subset.FaceStart; i < 3*((size_t)subset.FaceStart + subset.FaceCount); ++i)
+			{
+				if(indexOwner[i] != NoSubset)
+					return false;
+				indexOwner[i] = (int)s;
+			}
+		}
+
+		for(size_t i = 0; i < indices.size(); ++i)
+		{
+			int owner = vertexOwner[indices[i]];
+			if(owner != NoSubset && owner != indexOwner[i])
+				return false;
+		}
+
+		return true;
+	}
+
+	///<summary>
+	/// Optimizes each subset's triangles for the vertex cache, then renumbers the
+	/// vertices for fetch.  If no subset's vertex range is referenced from outside
+	/// the subset, each range is renumbered in place; otherwise the whole vertex
+	/// array is renumbered at once and each subset's vertex range is reset to the
+	/// span of vertices its triangles now use.
+	///</summary>
+	template<typename VertexT>
+	bool OptimizeSubsets(std::vector<VertexT>& vertices, std::vector<USHORT>& indices,
+		std::vector<M3DLoader::Subset>& subsets, std::string& error)
+	{
+		for(const M3DLoader::Subset& subset : subsets)
+		{
+			if((size_t)subset.FaceStart + subset.FaceCount > indices.size() / 3 ||
+				(size_t)subset.VertexStart + subset.VertexCount > vertices.size())
+			{
+				error = "subset " + std::to_string(subset.Id) + " is out of range";
+				return false;
+			}
+		}
+
+		for(size_t i = 0; i < indices.size(); ++i)
+		{
+			if(indices[i] >= vertices.size())
+			{
+				error = "index " + std::to_string(indices[i]) + " is out of range";
+				return false;
+			}
+		}
+
+		for(const M3DLoader::Subset& subset : subsets)
+		{
+			const size_t first = 3*(size_t)subset.FaceStart;
+			const size_t count = 3*(size_t)subset.FaceCount;
+
+			std::vector<uint32> subsetIndices(indices.begin() + first, indices.begin() + first + count);
+			MeshOptimizer::OptimizeVertexCache(subsetIndices.data(), count, vertices.size());
+			for(size_t i = 0; i < count; ++i)
+				indices[first + i] = (USHORT)subsetIndices[i];
+		}
+
+		if(!SubsetVertexRangesArePrivate(indices, vertices.size(), subsets))
+		{
+			std::vector<uint32> indices32(indices.begin(), indices.end());
+			MeshOptimizer::RemapVertices(vertices,
+				MeshOptimizer::OptimizeVertexFetchRemap(indices32.data(), indices32.size(), vertices.size()));
+
+			for(size_t i = 0; i < indices.size(); ++i)
+				indices[i] = (USHORT)indices32[i];
+
+			for(M3DLoader::Subset& subset : subsets)
+			{
+				const size_t first = 3*(size_t)subset.FaceStart;
+				const size_t count = 3*(size_t)subset.FaceCount;
+				if(count == 0)
+					continue;
+
+				auto range = std::minmax_element(indices.begin() + first, indices.begin() + first + count);
+				subset.VertexStart = *range.first;
+				subset.VertexCount = *range.second - *range.first + 1u;
+			}
+
+			return true;
+		}
+
+		for(const M3DLoader::Subset& subset : subsets)
+		{
+			const size_t first = 3*(size_t)subset.FaceStart;
+			const size_t count = 3*(size_t)subset.FaceCount;
+
+			std::vector<uint32> subsetIndices(count);
+			for(size_t i = 0; i < count; ++i)
+				subsetIndices[i] = indices[first + i] - subset.VertexStart;
+
+			std::vector<uint32> remap = MeshOptimizer::OptimizeVertexFetchRemap(subsetIndices.data(), count, subset.VertexCount);
+
+			std::vector<VertexT> subsetVertices(vertices.begin() + subset.VertexStart,
+				vertices.begin() + subset.VertexStart + subset.VertexCount);
+			for(uint32 v = 0; v < subset.VertexCount; ++v)
+				vertices[subset.VertexStart + remap[v]] = subsetVertices[v];
+
+			for(size_t i = 0; i < count; ++i)
+				indices[first + i] = (USHORT)(subsetIndices[i] + subset.VertexStart);
+		}
+
+		return true;
+	}
+}
+
+std::string MeshCooker::Recipe()
+{
+	return "mesh" + std::to_string(MeshCookerVersion) + "-m3db" + std::to_string(M3dBinaryFile::Version);
+}
+
+bool MeshCooker::CookTxtModel(const std::string& source, const std::string& output, std::string& error)
+{
+	std::vector<M3DLoader::Vertex> vertices;
+	std::vector<uint32> indices;
+
+	// Assets already cook in parallel, so each one keeps to its own thread.
+	if(!TxtModelLoader::Load(source, vertices, indices, nullptr, 1))
+	{
+		error = "can't load model";
+		return false;
+	}
+
+	if(vertices.size() > MaxVertices16)
+	{
+		error = "more than 65536 vertices; cooked models use 16-bit indices";
+		return false;
+	}
+
+	MeshOptimizer::OptimizeMesh(vertices, indices);
+
+	std::vector<USHORT> indices16(indices.begin(), indices.end());
+
+	M3DLoader::Subset subset;
+	subset.Id = 0;
+	subset.VertexCount = (UINT)vertices.size();
+	subset.FaceCount = (UINT)indices.size() / 3;
+
+	if(!M3dBinaryFile::Write(output, vertices, indices16, { subset }, {}))
+	{
+		error = "can't write " + output;
+		return false;
+	}
+
+	return true;
+}
+
+bool MeshCooker::CookM3d(const std::string& source, const std::string& output, std::string& error)
+{
+	UINT numBones = 0;
+	if(!M3DLoader::ReadBoneCount(source, numBones))
+	{
+		error = "can't read m3d header";
+		return false;
+	}
+
+	M3DLoader m3dLoader;
+	std::vector<USHORT> indices;
+	std::vector<M3DLoader::Subset> subsets;
+	std::vector<M3DLoader::M3dMaterial> mats;
+
+	bool written = false;
+	if(numBones > 0)
+	{
+		std::vector<M3DLoader::SkinnedVertex> vertices;
+		SkinnedData skinInfo;
+		if(!m3dLoader.LoadM3d(source, vertices, indices, subsets, mats, skinInfo))
+		{
+			error = "can't load model";
+			return false;
+		}
+
+		if(!OptimizeSubsets(vertices, indices, subsets, error))
+			return false;
+
+		written = M3dBinaryFile::Write(output, vertices, indices, subsets, mats, skinInfo);
+	}
+	else
+	{
+		std::vector<M3DLoader::Vertex> vertices;
+		if(!m3dLoader.LoadM3d(source, vertices, indices, subsets, mats))
+		{
+			error = "can't load model";
+			return false;
+		}
+
+		if(!OptimizeSubsets(vertices, indices, subsets, error))
+			return false;
+
+		written = M3dBinaryFile::Write(output, vertices, indices, subsets, mats);
+	}
+
+	if(!written)
+	{
+		error = "can't write " + output;
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,29 @@
+//***************************************************************************************
+// MeshCooker.h
+//
+// Cooks the demo models into the binary M3D format (M3dBinary.h), which the
+// runtime maps and uploads without parsing:
+//   -Text models (Skull.txt, Car.txt) are reordered for the post-transform cache
+//    and for vertex fetch and written as a static model with one subset.  They
+//    have no texture coordinates, so they get no tangents.
+//   -.m3d models keep their authored tangents and subsets; each subset is
+//    reordered on its own so subset ranges stay valid.
+// Bounds are computed by M3dBinaryFile::Write and stored in the header.
+//***************************************************************************************
+
+#pragma once
+
+#include <string>
+
+class MeshCooker
+{
+public:
+	///<summary>
+	/// Names this cooker and the formats it writes.  It changes whenever the same
+	/// source would cook to a different output, which makes every mesh recook.
+	///</summary>
+	static std::string Recipe();
+
+	static bool CookTxtModel(const std::string& source, const std::string& output, std::string& error);
+	static bool CookM3d(const std::string& source, const std::string& output, std::string& error);
+};
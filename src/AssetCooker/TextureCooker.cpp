@@ -0,0 +1,206 @@
+//***************************************************************************************
+// TextureCooker.cpp
+//***************************************************************************************
+
+#include "TextureCooker.h"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+#include "../Common/BcDecoder.h"
+#include "../Common/BcEncoder.h"
+#include "../Common/DdsFile.h"
+#include "../Common/DdsWriter.h"
+#include "../Common/MipGenerator.h"
+#include "../Common/RgbaImage.h"
+
+namespace
+{
+	using uint8 = std::uint8_t;
+	using uint32 = std::uint32_t;
+
+	// Bump when the cooked output of the same source changes.
+	const int TextureCookerVersion = 3;
+
+	// Alpha-tested textures are drawn where alpha is at least half.
+	const float CutoutAlphaReference = 0.5f;
+
+	// Writes the full mip chain of image; encode turns each level's pixels into the
+	// bytes written for it.
+	template<typename EncodeFunc>
+	bool WriteDdsWithMips(const std::string& filename, DXGI_FORMAT format, const RgbaImage& image,
+		const MipGenerator::Options& options, const EncodeFunc& encode)
+	{
+		std::vector<RgbaImage> levels;
+		MipGenerator::Generate(image, options, levels);
+
+		std::vector<std::vector<uint8>> mips(levels.size());
+		for(uint32 level = 0; level < (uint32)levels.size(); ++level)
+			encode(level, levels[level], mips[level]);
+
+		return DdsWriter::Write(filename, format, image.Width, image.Height, mips);
+	}
+
+	// Formats with four 8-bit channels, which MipGenerator filters whatever the
+	// channel order.
+	bool HasByteChannels(DXGI_FORMAT format)
+	{
+		return format == DXGI_FORMAT_R8G8B8A8_UNORM || format == DXGI_FORMAT_B8G8R8A8_UNORM ||
+			format == DXGI_FORMAT_B8G8R8X8_UNORM;
+	}
+
+	// Block formats whose mips can be decoded, regenerated and encoded again.
+	bool CanReencode(DXGI_FORMAT format)
+	{
+		return format == DXGI_FORMAT_BC1_UNORM || format == DXGI_FORMAT_BC3_UNORM;
+	}
+
+	// Opaque images and cutouts (alpha only 0 or 255) fit BC1 with its 1-bit alpha;
+	// anything with partial alpha needs BC3.
+	DXGI_FORMAT ChooseBlockFormat(const RgbaImage& image)
+	{
+		for(size_t i = 3; i < image.Pixels.size(); i += 4)
+		{
+			if(image.Pixels[i] != 0 && image.Pixels[i] != 255)
+				return DXGI_FORMAT_BC3_UNORM;
+		}
+
+		return DXGI_FORMAT_BC1_UNORM;
+	}
+
+	// An alpha-tested image: some texels are fully transparent and nearly all of the
+	// rest are opaque, the few in between being antialiased edges.
+	bool IsCutout(const RgbaImage& image)
+	{
+		size_t transparent = 0;
+		size_t partial = 0;
+		for(size_t i = 3; i < image.Pixels.size(); i += 4)
+		{
+			transparent += image.Pixels[i] == 0;
+			partial += image.Pixels[i] != 0 && image.Pixels[i] != 255;
+		}
+
+		return transparent > 0 && partial*20 < image.Pixels.size() / 4;
+	}
+
+	// The src/Textures naming convention for tangent-space normal maps.
+	bool IsNormalMap(const std::string& source)
+	{
+		return std::filesystem::path(source).stem().string().find("_nmap") != std::string::npos;
+	}
+
+	// Kaiser keeps the smaller mips sharper than a box does.  Colour is filtered in
+	// linear light; normal maps hold vectors, not sRGB colour.
+	MipGenerator::Options ChooseMipOptions(const std::string& source, const RgbaImage& image, bool hasAlpha)
+	{
+		MipGenerator::Options options;
+		options.Kernel = MipGenerator::Filter::Kaiser;
+		options.Srgb = !IsNormalMap(source);
+		options.AlphaReference = hasAlpha && IsCutout(image) ? CutoutAlphaReference : 0.0f;
+
+		// Assets already cook in parallel, so each one keeps to its own thread.
+		options.NumThreads = 1;
+		return options;
+	}
+
+	bool CopyUnchanged(const std::string& source, const std::string& output, std::string& error)
+	{
+		std::error_code ec;
+		if(!std::filesystem::copy_file(source, output, std::filesystem::copy_options::overwrite_existing, ec))
+		{
+			error = "can't write " + output;
+			return false;
+		}
+
+		return true;
+	}
+}
+
+std::string TextureCooker::Recipe()
+{
+	return "texture" + std::to_string(TextureCookerVersion);
+}
+
+bool TextureCooker::CookBmp(const std::string& source, const std::string& output, std::string& error)
+{
+	RgbaImage image;
+	if(!RgbaImage::LoadBmp(source, image, error))
+		return false;
+
+	const DXGI_FORMAT format = ChooseBlockFormat(image);
+	const MipGenerator::Options options = ChooseMipOptions(source, image, true);
+
+	bool written = WriteDdsWithMips(output, format, image, options, [&](uint32, const RgbaImage& mip, std::vector<uint8>& blocks)
+	{
+		BcEncoder::Encode(format, mip.Pixels.data(), mip.Width, mip.Height, blocks, BcEncoder::Quality::Normal, 1);
+	});
+
+	if(!written)
+	{
+		error = "can't write " + output;
+		return false;
+	}
+
+	return true;
+}
+
+bool TextureCooker::CookDds(const std::string& source, const std::string& output, std::string& error)
+{
+	// Files the runtime loader would reject fail here instead of at startup.
+	DdsFile dds;
+	DdsStatus status = dds.Open(source);
+	if(status != DdsStatus::Ok)
+	{
+		error = DdsFile::StatusString(status);
+		return false;
+	}
+
+	// Only a legacy header is rewritten; its pixel format is kept as is.
+	const DXGI_FORMAT format = dds.GetFormat();
+	const bool plain2D = dds.GetDimension() == DdsDimension::Texture2D && dds.GetArraySize() == 1 && !dds.HasDx10Header();
+	const bool canFilter = HasByteChannels(format) || CanReencode(format);
+
+	if(!plain2D || !canFilter || MipGenerator::FullMipCount(dds.GetWidth(), dds.GetHeight()) == 1)
+		return CopyUnchanged(source, output, error);
+
+	const DdsSubresource& top = dds.GetSubresource(0, 0);
+
+	RgbaImage image;
+	image.Width = top.Width;
+	image.Height = top.Height;
+	if(HasByteChannels(format))
+	{
+		image.Pixels.assign(top.Data, top.Data + top.SlicePitch);
+	}
+	else
+	{
+		image.Pixels.resize(4*(size_t)top.Width*top.Height);
+		BcDecoder::Decode(format, top.Data, top.RowPitch, top.Width, top.Height, image.Pixels.data(), image.RowPitch());
+	}
+
+	// Authored mips are kept, except a cutout's: averaged alpha erodes it until the
+	// small mips vanish, which regenerating with coverage preservation fixes.
+	const bool hasAlpha = format != DXGI_FORMAT_B8G8R8X8_UNORM;
+	const MipGenerator::Options options = ChooseMipOptions(source, image, hasAlpha);
+	if(dds.GetMipCount() > 1 && options.AlphaReference == 0.0f)
+		return CopyUnchanged(source, output, error);
+
+	// The top level is written back as it was; only the levels below are new.
+	bool written = WriteDdsWithMips(output, format, image, options, [&](uint32 level, const RgbaImage& mip, std::vector<uint8>& bytes)
+	{
+		if(level == 0)
+			bytes.assign(top.Data, top.Data + top.SlicePitch);
+		else if(HasByteChannels(format))
+			bytes = mip.Pixels;
+		else
+			BcEncoder::Encode(format, mip.Pixels.data(), mip.Width, mip.Height, bytes, BcEncoder::Quality::Normal, 1);
+	});
+
+	if(!written)
+	{
+		error = "can't write " + output;
+		return false;
+	}
+
+	return true;
+}
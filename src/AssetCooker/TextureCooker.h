@@ -0,0 +1,33 @@
+//***************************************************************************************
+// TextureCooker.h
+//
+// Cooks textures into DDS files CreateDDSTextureFromFile12 loads with a full mip
+// chain:
+//   -.bmp (24 or 32-bit, e.g. tree0.bmp) is block compressed: BC1 if it is opaque
+//    or its alpha is only 0 or 255, BC3 otherwise (BcEncoder, Normal quality).
+//   -A 2D DDS with 8-bit channels, BC1 or BC3 and no mips gets its mip chain
+//    generated; block compressed levels are decoded and encoded again.
+//   -A cutout (alpha tested, e.g. WireFence.dds) gets its mips regenerated with
+//    its alpha coverage preserved, even if it already has some.
+//   -Any other DDS (BC2, cube maps, arrays, files that already have mips) is
+//    copied unchanged.
+// A DDS's top level is kept bit for bit.  Mips use MipGenerator's Kaiser filter,
+// in linear light except for normal maps (*_nmap).
+//***************************************************************************************
+
+#pragma once
+
+#include <string>
+
+class TextureCooker
+{
+public:
+	///<summary>
+	/// Names this cooker.  It changes whenever the same source would cook to a
+	/// different output, which makes every texture recook.
+	///</summary>
+	static std::string Recipe();
+
+	static bool CookBmp(const std::string& source, const std::string& output, std::string& error);
+	static bool CookDds(const std::string& source, const std::string& output, std::string& error);
+};
@@ -0,0 +1,53 @@
+//***************************************************************************************
+// main.cpp
+//
+// Console entry point for the asset cooker.
+//
+//   AssetCooker.exe [--source dir] [--output dir] [--threads n] [--force]
+//
+// The defaults cook the shared assets in src/Models and src/Textures into
+// src/Cooked when run from the project directory.
+//***************************************************************************************
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "AssetCooker.h"
+
+namespace
+{
+	void PrintUsage()
+	{
+		printf("usage: AssetCooker [--source dir] [--output dir] [--threads n] [--force]\n");
+		printf("  --source   asset root holding Models and Textures (default ..)\n");
+		printf("  --output   where the cooked files and %s go (default ../Cooked)\n", AssetCooker::ManifestFilename);
+		printf("  --threads  worker threads, 0 for every hardware thread (default 0)\n");
+		printf("  --force    recook every asset\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	AssetCooker::Options options;
+
+	for(int a = 1; a < argc; ++a)
+	{
+		bool hasValue = a + 1 < argc;
+		if(strcmp(argv[a], "--source") == 0 && hasValue)
+			options.SourceRoot = argv[++a];
+		else if(strcmp(argv[a], "--output") == 0 && hasValue)
+			options.OutputRoot = argv[++a];
+		else if(strcmp(argv[a], "--threads") == 0 && hasValue)
+			options.NumThreads = (unsigned)strtoul(argv[++a], nullptr, 10);
+		else if(strcmp(argv[a], "--force") == 0)
+			options.Force = true;
+		else
+		{
+			PrintUsage();
+			return 2;
+		}
+	}
+
+	AssetCooker::Summary summary;
+	return AssetCooker::Run(options, summary) ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+//***************************************************************************************
+// AnimSampleBenchmark.cpp
+//
+// Samples every bone of soldier.m3d's clip with AnimationClip::Interpolate and
+// with a ClipSampler: 64 instances playing at 60 Hz from staggered start times,
+// each with its own cursor, and then seeks to random times.  Prints the time per
+// pose, the speedup, and the largest difference of a to-parent matrix element
+// from Interpolate's.  Then compares the whole pose, final transforms included,
+// from SkinnedData::GetFinalTransforms by clip name and by ClipHandle with a
+// Pose per instance.
+//***************************************************************************************
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "BenchmarkUtil.h"
+#include "../Chapter 23 Character Animation/SkinnedMesh/ClipSampler.h"
+#include "../Chapter 23 Character Animation/SkinnedMesh/LoadM3d.h"
+
+using namespace DirectX;
+
+namespace
+{
+	const UINT InstanceCount = 64;
+	const UINT FrameCount = 600;
+	const UINT SeekCount = 20000;
+
+	float MaxDifference(const std::vector<XMFLOAT4X4>& a, const std::vector<XMFLOAT4X4>& b)
+	{
+		float diff = 0.0f;
+		for(size_t i = 0; i < a.size(); ++i)
+		{
+			for(int r = 0; r < 4; ++r)
+			{
+				for(int c = 0; c < 4; ++c)
+					diff = (std::max)(diff, std::fabs(a[i].m[r][c] - b[i].m[r][c]));
+			}
+		}
+
+		return diff;
+	}
+
+	// The time of each pose sampled, in the order they are sampled.
+	std::vector<float> PlaybackTimes(float endTime)
+	{
+		std::vector<float> times;
+		times.reserve(InstanceCount*FrameCount);
+		for(UINT frame = 0; frame < FrameCount; ++frame)
+		{
+			for(UINT i = 0; i < InstanceCount; ++i)
+			{
+				float t = i*endTime / InstanceCount + frame / 60.0f;
+				times.push_back(std::fmod(t, endTime));
+			}
+		}
+
+		return times;
+	}
+
+	std::vector<float> SeekTimes(float startTime, float endTime)
+	{
+		std::mt19937 rng(22);
+		std::uniform_real_distribution<float> time(startTime - 0.1f, endTime + 0.1f);
+
+		std::vector<float> times(SeekCount);
+		for(float& t : times)
+			t = time(rng);
+
+		return times;
+	}
+
+	void Compare(const char* name, const AnimationClip& clip, const ClipSampler& sampler,
+		const std::vector<float>& times)
+	{
+		const UINT boneCount = sampler.GetTrackCount();
+		std::vector<XMFLOAT4X4> reference(boneCount);
+		std::vector<XMFLOAT4X4> sampled(boneCount);
+		std::vector<ClipSampler::Cursor> cursors(InstanceCount);
+
+		double referenceMs = BestOfMs(3, [&]()
+		{
+			for(float t : times)
+				clip.Interpolate(t, reference);
+		});
+
+		double samplerMs = BestOfMs(3, [&]()
+		{
+			for(size_t i = 0; i < times.size(); ++i)
+				sampler.Sample(times[i], cursors[i % InstanceCount], sampled.data());
+		});
+
+		float maxDiff = 0.0f;
+		for(auto& cursor : cursors)
+			cursor.Keys.clear();
+		for(size_t i = 0; i < times.size(); ++i)
+		{
+			clip.Interpolate(times[i], reference);
+			sampler.Sample(times[i], cursors[i % InstanceCount], sampled.data());
+			maxDiff = (std::max)(maxDiff, MaxDifference(reference, sampled));
+		}
+
+		const double poses = (double)times.size();
+		printf("%-12s %14.1f %14.1f %9.1fx %12.2e\n", name, 1.0e6*referenceMs / poses, 1.0e6*samplerMs / poses,
+			referenceMs / samplerMs, maxDiff);
+	}
+
+	void ComparePoses(const SkinnedData& skinInfo, const std::string& clipName, const std::vector<float>& times)
+	{
+		const SkinnedData::ClipHandle clip = skinInfo.FindClip(clipName);
+		std::vector<XMFLOAT4X4> reference(skinInfo.BoneCount());
+		std::vector<XMFLOAT4X4> finals(skinInfo.BoneCount());
+		std::vector<SkinnedData::Pose> poses(InstanceCount);
+
+		double referenceMs = BestOfMs(3, [&]()
+		{
+			for(float t : times)
+				skinInfo.GetFinalTransforms(clipName, t, reference);
+		});
+
+		double poseMs = BestOfMs(3, [&]()
+		{
+			for(size_t i = 0; i < times.size(); ++i)
+				skinInfo.GetFinalTransforms(clip, times[i], poses[i % InstanceCount], finals.data());
+		});
+
+		float maxDiff = 0.0f;
+		for(size_t i = 0; i < times.size(); ++i)
+		{
+			skinInfo.GetFinalTransforms(clipName, times[i], reference);
+			skinInfo.GetFinalTransforms(clip, times[i], poses[i % InstanceCount], finals.data());
+			maxDiff = (std::max)(maxDiff, MaxDifference(reference, finals));
+		}
+
+		const double count = (double)times.size();
+		printf("%-12s %14.1f %14.1f %9.1fx %12.2e\n", "final pose", 1.0e6*referenceMs / count, 1.0e6*poseMs / count,
+			referenceMs / poseMs, maxDiff);
+	}
+}
+
+void RunAnimSampleBenchmark()
+{
+	std::vector<M3DLoader::SkinnedVertex> vertices;
+	std::vector<USHORT> indices;
+	std::vector<M3DLoader::Subset> subsets;
+	std::vector<M3DLoader::M3dMaterial> mats;
+	SkinnedData skinInfo;
+
+	M3DLoader m3dLoader;
+	if(!m3dLoader.LoadM3d(BENCH_MODELS_DIR "soldier.m3d", vertices, indices, subsets, mats, skinInfo) ||
+		skinInfo.GetAnimations().empty())
+	{
+		printf("soldier.m3d not found\n");
+		return;
+	}
+
+	const auto& animation = *skinInfo.GetAnimations().begin();
+	const AnimationClip& clip = animation.second;
+
+	Stopwatch timer;
+	ClipSampler sampler(clip);
+	double buildMs = timer.ElapsedMs();
+
+	printf("clip \"%s\": %u bones, %u keys, %.2f s; sampler built in %.3f ms\n", animation.first.c_str(),
+		sampler.GetTrackCount(), sampler.GetKeyCount(), sampler.GetEndTime() - sampler.GetStartTime(), buildMs);
+	printf("%-12s %14s %14s %10s %12s\n", "access", "Interpolate ns", "sampler ns", "speedup", "max error");
+
+	Compare("playback", clip, sampler, PlaybackTimes(sampler.GetEndTime()));
+	Compare("seeks", clip, sampler, SeekTimes(sampler.GetStartTime(), sampler.GetEndTime()));
+
+	printf("\n%-12s %14s %14s %10s %12s\n", "playback", "by name ns", "Pose ns", "speedup", "max error");
+	ComparePoses(skinInfo, animation.first, PlaybackTimes(sampler.GetEndTime()));
+}
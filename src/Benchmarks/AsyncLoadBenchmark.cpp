@@ -0,0 +1,175 @@
+//***************************************************************************************
+// AsyncLoadBenchmark.cpp
+//
+// Times the CPU side of a demo's startup loads -- Skull.txt and Car.txt with
+// tangents, soldier.m3d, and every texture in src/Textures -- run one after another
+// on the calling thread and submitted together to an AsyncLoader.  The loader's
+// wall time should approach the longest single job rather than the sum.  Also
+// checks that the results match and that a failed read is rethrown by get().
+//***************************************************************************************
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include "BenchmarkUtil.h"
+#include "../Common/AsyncLoader.h"
+#include "../Common/ParallelFor.h"
+#include "../Common/TangentGenerator.h"
+#include "../Common/TxtModelLoader.h"
+#include "../Chapter 23 Character Animation/SkinnedMesh/LoadM3d.h"
+
+namespace
+{
+	// Every job returns a checksum of what it loaded, so the serial and
+	// asynchronous runs can be compared without keeping the data around.
+	struct LoadJob
+	{
+		std::string Name;
+		std::function<size_t()> Run;
+	};
+
+	size_t Checksum(const void* data, size_t size)
+	{
+		// FNV-1a.
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		size_t hash = (size_t)14695981039346656037ull;
+		for(size_t i = 0; i < size; ++i)
+			hash = (hash ^ bytes[i]) * (size_t)1099511628211ull;
+		return hash;
+	}
+
+	std::vector<LoadJob> MakeJobs()
+	{
+		std::vector<LoadJob> jobs;
+
+		// The loaders run on one thread each; the concurrency comes from the pool.
+		const char* txtModels[] = { "Skull.txt", "Car.txt" };
+		for(const char* name : txtModels)
+		{
+			std::string filename = std::string(BENCH_MODELS_DIR) + name;
+			jobs.push_back({ name, [filename]()
+			{
+				GeometryGenerator::MeshData meshData;
+				if(!TxtModelLoader::Load(filename, meshData, nullptr, 1))
+					throw std::runtime_error("can't load " + filename);
+				TangentGenerator::Generate(meshData, 1);
+
+				return Checksum(meshData.Vertices.data(), meshData.Vertices.size() * sizeof(GeometryGenerator::Vertex)) ^
+					Checksum(meshData.Indices32.data(), meshData.Indices32.size() * sizeof(GeometryGenerator::uint32));
+			} });
+		}
+
+		std::string soldierFile = std::string(BENCH_MODELS_DIR) + "soldier.m3d";
+		jobs.push_back({ "soldier.m3d", [soldierFile]()
+		{
+			std::vector<M3DLoader::SkinnedVertex> vertices;
+			std::vector<USHORT> indices;
+			std::vector<M3DLoader::Subset> subsets;
+			std::vector<M3DLoader::M3dMaterial> mats;
+			SkinnedData skinInfo;
+
+			M3DLoader loader;
+			if(!loader.LoadM3d(soldierFile, vertices, indices, subsets, mats, skinInfo))
+				throw std::runtime_error("can't load " + soldierFile);
+
+			return Checksum(vertices.data(), vertices.size() * sizeof(M3DLoader::SkinnedVertex)) ^
+				Checksum(indices.data(), indices.size() * sizeof(USHORT));
+		} });
+
+		std::error_code ec;
+		for(std::filesystem::directory_iterator it("../Textures", ec), end; !ec && it != end; it.increment(ec))
+		{
+			if(it->path().extension() != ".dds")
+				continue;
+
+			std::string filename = it->path().string();
+			jobs.push_back({ it->path().filename().string(), [filename]()
+			{
+				std::ifstream fin(filename, std::ios::binary | std::ios::ate);
+				std::vector<char> data((size_t)fin.tellg());
+				fin.seekg(0);
+				fin.read(data.data(), data.size());
+				if(!fin)
+					throw std::runtime_error("can't read " + filename);
+
+				return Checksum(data.data(), data.size());
+			} });
+		}
+
+		return jobs;
+	}
+}
+
+void RunAsyncLoadBenchmark()
+{
+	std::vector<LoadJob> jobs = MakeJobs();
+	unsigned numThreads = ResolveThreadCount(0);
+
+	// A first pass warms the file cache, so every run reads from memory.
+	std::vector<size_t> expected;
+	try
+	{
+		for(const LoadJob& job : jobs)
+			expected.push_back(job.Run());
+	}
+	catch(const std::exception& e)
+	{
+		printf("%s, skipping.\n", e.what());
+		return;
+	}
+
+	double longestMs = 0.0;
+	std::string longestName;
+	for(const LoadJob& job : jobs)
+	{
+		double ms = BestOfMs(3, [&]() { job.Run(); });
+		if(ms > longestMs)
+		{
+			longestMs = ms;
+			longestName = job.Name;
+		}
+	}
+
+	double serialMs = BestOfMs(3, [&]()
+	{
+		for(const LoadJob& job : jobs)
+			job.Run();
+	});
+
+	bool same = true;
+	double asyncMs = BestOfMs(3, [&]()
+	{
+		AsyncLoader loader(numThreads);
+
+		std::vector<std::shared_future<size_t>> results;
+		for(const LoadJob& job : jobs)
+			results.push_back(loader.Submit(job.Run));
+
+		for(size_t i = 0; i < results.size(); ++i)
+			same = same && results[i].get() == expected[i];
+	});
+
+	printf("%zu jobs: serial %.2f ms, AsyncLoader on %u threads %.2f ms (%.1fx), longest job %s %.2f ms\n",
+		jobs.size(), serialMs, numThreads, asyncMs, serialMs / asyncMs, longestName.c_str(), longestMs);
+	printf("Same results: %s\n", same ? "yes" : "NO");
+
+	//
+	// Errors reach the caller through get().
+	//
+
+	bool rethrown = false;
+	{
+		AsyncLoader loader(2);
+		auto missing = loader.ReadFile(L"../Textures/AsyncLoadBenchmark_missing.dds");
+		try
+		{
+			missing.get();
+		}
+		catch(const std::runtime_error&)
+		{
+			rethrown = true;
+		}
+	}
+	printf("Failed read rethrown by get(): %s\n", rethrown ? "yes" : "NO");
+}
@@ -0,0 +1,192 @@
+//***************************************************************************************
+// AtlasBenchmark.cpp
+//
+// RectPacker on random sets of 64 to 2048 rectangles of 8 to 256 texels: the
+// smallest square bin each set fits in, its occupancy, and the time to pack it,
+// against a shelf packer (rows of rectangles sorted by height) for reference.
+// Then packs the tree billboard and crate textures with TextureAtlas, as an atlas
+// and as a texture array, and prints the page size, the occupancy, and how many
+// textures (resources and SRVs) it replaces.
+//***************************************************************************************
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include "BenchmarkUtil.h"
+#include "../Common/RectPacker.h"
+#include "../Common/TextureAtlas.h"
+
+namespace
+{
+	typedef std::uint32_t uint32;
+	typedef std::uint64_t uint64;
+
+	typedef RectPacker::Rect Rect;
+
+	std::vector<Rect> RandomSizes(uint32 count, uint32 seed)
+	{
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> logSize(std::log(8.0f), std::log(256.0f));
+
+		// Log-uniform sizes: many small images and a few large ones, as in most
+		// texture sets.
+		std::vector<Rect> sizes(count);
+		for(Rect& r : sizes)
+		{
+			r.Width = (uint32)std::exp(logSize(rng));
+			r.Height = (uint32)std::exp(logSize(rng));
+		}
+
+		return sizes;
+	}
+
+	// Rows left to right, tallest rectangles first.
+	uint32 ShelfPack(const std::vector<Rect>& sizes, uint32 width, uint32 height)
+	{
+		std::vector<uint32> order(sizes.size());
+		std::iota(order.begin(), order.end(), 0u);
+		std::sort(order.begin(), order.end(), [&sizes](uint32 a, uint32 b) { return sizes[a].Height > sizes[b].Height; });
+
+		uint32 x = 0;
+		uint32 y = 0;
+		uint32 shelfHeight = 0;
+		uint32 count = 0;
+		for(uint32 i : order)
+		{
+			if(x + sizes[i].Width > width)
+			{
+				x = 0;
+				y += shelfHeight;
+				shelfHeight = 0;
+			}
+
+			if(sizes[i].Width > width || y + sizes[i].Height > height)
+				break;
+
+			x += sizes[i].Width;
+			shelfHeight = (std::max)(shelfHeight, sizes[i].Height);
+			++count;
+		}
+
+		return count;
+	}
+
+	uint32 MaxRectsPack(const std::vector<Rect>& sizes, uint32 width, uint32 height)
+	{
+		RectPacker packer(width, height);
+		std::vector<Rect> placed;
+		return packer.Pack(sizes, placed);
+	}
+
+	// Smallest square side, in steps of 4 texels, that fits every rectangle.
+	template<typename PackFunc>
+	uint32 SmallestSquare(const std::vector<Rect>& sizes, PackFunc pack)
+	{
+		uint64 area = 0;
+		uint32 largest = 0;
+		for(const Rect& r : sizes)
+		{
+			area += (uint64)r.Width*r.Height;
+			largest = (std::max)(largest, (std::max)(r.Width, r.Height));
+		}
+
+		uint32 side = (std::max)((uint32)std::sqrt((double)area), largest);
+		side = (side + 3) & ~3u;
+		while(pack(sizes, side, side) < (uint32)sizes.size())
+			side += 4;
+
+		return side;
+	}
+
+	void RandomSets()
+	{
+		printf("%-6s %22s %22s %10s\n", "rects", "MaxRects side / occ", "shelf side / occ", "pack ms");
+
+		const uint32 counts[] = { 64, 256, 1024, 2048 };
+		for(uint32 count : counts)
+		{
+			std::vector<Rect> sizes = RandomSizes(count, count);
+			uint64 area = 0;
+			for(const Rect& r : sizes)
+				area += (uint64)r.Width*r.Height;
+
+			uint32 maxRectsSide = SmallestSquare(sizes, MaxRectsPack);
+			uint32 shelfSide = SmallestSquare(sizes, ShelfPack);
+			double ms = BestOfMs(5, [&]() { MaxRectsPack(sizes, maxRectsSide, maxRectsSide); });
+
+			printf("%-6u %13u %7.1f%% %13u %7.1f%% %10.3f\n", count,
+				maxRectsSide, 100.0*area / ((double)maxRectsSide*maxRectsSide),
+				shelfSide, 100.0*area / ((double)shelfSide*shelfSide), ms);
+		}
+	}
+
+	void TextureSet()
+	{
+		const char* files[] =
+		{
+			"tree01S.dds", "tree02S.dds", "tree35S.dds",
+			"tree0.bmp", "tree1.bmp", "tree2.bmp",
+			"WoodCrate01.dds", "WoodCrate02.dds", "WireFence.dds",
+		};
+
+		std::vector<TextureAtlas::Source> sources;
+		for(const char* file : files)
+		{
+			TextureAtlas::Source source;
+			std::string error;
+			if(!RgbaImage::Load(std::string("../Textures/") + file, source.Image, error))
+			{
+				printf("%s: %s\n", file, error.c_str());
+				return;
+			}
+
+			source.Name = file;
+			sources.push_back(std::move(source));
+		}
+
+		printf("\n%u textures:\n", (uint32)sources.size());
+		printf("%-22s %12s %7s %10s %6s %10s\n", "layout", "size", "slices", "occupancy", "mips", "build ms");
+
+		struct Config
+		{
+			const char* Name;
+			TextureAtlas::Layout Kind;
+			bool PowerOfTwo;
+			uint32 MaxSize;
+		};
+
+		const Config configs[] =
+		{
+			{ "atlas, pow2",          TextureAtlas::Layout::Atlas, true,  4096 },
+			{ "atlas, any size",      TextureAtlas::Layout::Atlas, false, 4096 },
+			{ "atlas, 1024 pages",    TextureAtlas::Layout::Atlas, true,  1024 },
+			{ "array",                TextureAtlas::Layout::Array, true,  4096 },
+		};
+
+		for(const Config& config : configs)
+		{
+			TextureAtlas::Options options;
+			options.Kind = config.Kind;
+			options.PowerOfTwo = config.PowerOfTwo;
+			options.MaxSize = config.MaxSize;
+
+			TextureAtlas::Result result;
+			std::string error;
+			double ms = BestOfMs(3, [&]() { TextureAtlas::Build(sources, options, result, error); });
+
+			char size[32];
+			snprintf(size, sizeof(size), "%ux%u", result.Width, result.Height);
+			printf("%-22s %12s %7u %9.1f%% %6u %10.2f\n", config.Name, size, (uint32)result.Slices.size(),
+				100.0f*result.Occupancy, result.CleanMipCount, ms);
+		}
+
+		printf("%u resources and SRVs become 1\n", (uint32)sources.size());
+	}
+}
+
+void RunAtlasBenchmark()
+{
+	RandomSets();
+	TextureSet();
+}
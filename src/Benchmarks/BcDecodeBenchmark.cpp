@@ -0,0 +1,254 @@
+//***************************************************************************************
+// BcDecodeBenchmark.cpp
+//
+// Decode throughput of BcDecoder in megapixels per second, per format, on one
+// thread and on every hardware thread.  BC1, BC2 and BC3 decode every subresource
+// of the matching textures in src/Textures; the repo has no BC4, BC5 or BC7
+// textures, so those decode a 1024x1024 surface of random blocks (BC7 with every
+// mode equally likely).  Also checks hand-made blocks against their known colours,
+// that thread counts don't change the output, and that DecodeTexel agrees with
+// Decode on the BC3 tree billboard array treearray.dds.
+//***************************************************************************************
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include "BenchmarkUtil.h"
+#include "../Common/BcDecoder.h"
+#include "../Common/ParallelFor.h"
+
+namespace
+{
+	typedef std::uint8_t uint8;
+	typedef std::uint32_t uint32;
+
+	// One surface to decode: a view into a DdsFile or into owned random blocks.
+	struct Surface
+	{
+		const uint8* Blocks;
+		size_t RowPitch;
+		uint32 Width;
+		uint32 Height;
+	};
+
+	struct FormatRun
+	{
+		const char* Name;
+		DXGI_FORMAT Format;
+		std::vector<Surface> Surfaces;
+		std::string Source;
+	};
+
+	std::vector<uint8> RandomBlocks(DXGI_FORMAT format, uint32 width, uint32 height)
+	{
+		const size_t blockBytes = (format == DXGI_FORMAT_BC4_UNORM) ? 8 : 16;
+		std::vector<uint8> blocks((size_t)(width / 4) * (height / 4) * blockBytes);
+
+		std::mt19937 rng(1234);
+		for(uint8& b : blocks)
+			b = (uint8)rng();
+
+		// Mode m is m zero bits and a one in the low bits of the first byte.
+		if(format == DXGI_FORMAT_BC7_UNORM)
+		{
+			for(size_t i = 0; i < blocks.size(); i += blockBytes)
+			{
+				uint32 mode = rng() % 8;
+				blocks[i] = (uint8)((blocks[i] & ~((2u << mode) - 1)) | (1u << mode));
+			}
+		}
+
+		return blocks;
+	}
+
+	size_t PixelCount(const std::vector<Surface>& surfaces)
+	{
+		size_t pixels = 0;
+		for(const Surface& s : surfaces)
+			pixels += (size_t)s.Width * s.Height;
+		return pixels;
+	}
+
+	void DecodeAll(DXGI_FORMAT format, const std::vector<Surface>& surfaces, std::vector<uint8>& pixels, unsigned numThreads)
+	{
+		uint8* dst = pixels.data();
+		for(const Surface& s : surfaces)
+		{
+			BcDecoder::Decode(format, s.Blocks, s.RowPitch, s.Width, s.Height, dst, (size_t)s.Width * 4, numThreads);
+			dst += (size_t)s.Width * s.Height * 4;
+		}
+	}
+
+	bool DecodesTo(DXGI_FORMAT format, const uint8* block, const uint8 expected[4])
+	{
+		uint8 pixels[64];
+		if(!BcDecoder::DecodeBlock(format, block, pixels))
+			return false;
+
+		for(int i = 0; i < 16; ++i)
+		{
+			if(memcmp(pixels + 4*i, expected, 4) != 0)
+				return false;
+		}
+
+		return true;
+	}
+
+	// Solid blocks whose decoded colour follows directly from the spec.
+	bool CheckKnownBlocks()
+	{
+		// BC1: color0 = color1 = pure red in 5:6:5, every index 0.
+		const uint8 bc1[8] = { 0x00, 0xF8, 0x00, 0xF8, 0, 0, 0, 0 };
+		const uint8 red[4] = { 255, 0, 0, 255 };
+
+		// BC1 with color0 <= color1 and every index 3: transparent black.
+		const uint8 bc1Clear[8] = { 0x00, 0x00, 0x1F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF };
+		const uint8 clear[4] = { 0, 0, 0, 0 };
+
+		// BC2: alpha nibbles 0x8 (136), pure green colour.
+		const uint8 bc2[16] = { 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0xE0, 0x07, 0xE0, 0x07, 0, 0, 0, 0 };
+		const uint8 green136[4] = { 0, 255, 0, 136 };
+
+		// BC3: alpha endpoints 200 and 100, every index 1; pure blue colour.
+		const uint8 bc3[16] = { 200, 100, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x1F, 0x00, 0x1F, 0x00, 0, 0, 0, 0 };
+		const uint8 blue100[4] = { 0, 0, 255, 100 };
+
+		// BC4: endpoints 90 and 10, every index 2: (6*90 + 10)/7 = 78.6.
+		const uint8 bc4[8] = { 90, 10, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49 };
+		const uint8 red79[4] = { 79, 0, 0, 255 };
+
+		// BC5 SNORM: red endpoint -128 (read as -127), green 64, every index 0.
+		const uint8 bc5[16] = { 0x80, 0x80, 0, 0, 0, 0, 0, 0, 64, 64, 0, 0, 0, 0, 0, 0 };
+		const uint8 signedRG[4] = { 0x81, 64, 0, 127 };
+
+		// BC7 mode 6: every 7-bit endpoint component 127 with p-bits 1, so every
+		// texel is opaque white whatever its index.
+		uint8 bc7[16] = {};
+		bc7[0] = 0x40 | 0x80;   // mode 6 bit, then R0 bit 0
+		for(int bit = 8; bit < 7 + 56 + 2; ++bit)
+			bc7[bit / 8] |= (uint8)(1u << (bit % 8));
+		const uint8 white[4] = { 255, 255, 255, 255 };
+
+		return DecodesTo(DXGI_FORMAT_BC1_UNORM, bc1, red) &&
+			DecodesTo(DXGI_FORMAT_BC1_UNORM, bc1Clear, clear) &&
+			DecodesTo(DXGI_FORMAT_BC2_UNORM, bc2, green136) &&
+			DecodesTo(DXGI_FORMAT_BC3_UNORM, bc3, blue100) &&
+			DecodesTo(DXGI_FORMAT_BC4_UNORM, bc4, red79) &&
+			DecodesTo(DXGI_FORMAT_BC5_SNORM, bc5, signedRG) &&
+			DecodesTo(DXGI_FORMAT_BC7_UNORM, bc7, white);
+	}
+}
+
+void RunBcDecodeBenchmark()
+{
+	printf("Known blocks decode correctly: %s\n", CheckKnownBlocks() ? "yes" : "NO");
+
+	//
+	// Gather the surfaces for every format.
+	//
+
+	std::vector<std::unique_ptr<DdsFile>> files;
+	std::error_code ec;
+	for(std::filesystem::directory_iterator it("../Textures", ec), end; !ec && it != end; it.increment(ec))
+	{
+		if(it->path().extension() != ".dds")
+			continue;
+
+		std::unique_ptr<DdsFile> dds(new DdsFile());
+		if(dds->Open(it->path().string()) == DdsStatus::Ok && BcDecoder::IsSupported(dds->GetFormat()))
+			files.push_back(std::move(dds));
+	}
+
+	FormatRun runs[] =
+	{
+		{ "BC1", DXGI_FORMAT_BC1_UNORM, {}, "" },
+		{ "BC2", DXGI_FORMAT_BC2_UNORM, {}, "" },
+		{ "BC3", DXGI_FORMAT_BC3_UNORM, {}, "" },
+		{ "BC4", DXGI_FORMAT_BC4_UNORM, {}, "" },
+		{ "BC5", DXGI_FORMAT_BC5_UNORM, {}, "" },
+		{ "BC7", DXGI_FORMAT_BC7_UNORM, {}, "" },
+	};
+
+	for(const auto& dds : files)
+	{
+		for(FormatRun& run : runs)
+		{
+			if(dds->GetFormat() != run.Format)
+				continue;
+
+			for(const DdsSubresource& sub : dds->GetSubresources())
+			{
+				for(uint32 z = 0; z < sub.Depth; ++z)
+					run.Surfaces.push_back({ sub.Data + z*sub.SlicePitch, sub.RowPitch, sub.Width, sub.Height });
+			}
+			run.Source = "src/Textures";
+		}
+	}
+
+	const uint32 randomSize = 1024;
+	std::vector<std::vector<uint8>> randomBlocks;
+	for(FormatRun& run : runs)
+	{
+		if(!run.Surfaces.empty())
+			continue;
+
+		randomBlocks.push_back(RandomBlocks(run.Format, randomSize, randomSize));
+		const size_t blockBytes = randomBlocks.back().size() / ((randomSize / 4) * (randomSize / 4));
+		run.Surfaces.push_back({ randomBlocks.back().data(), (randomSize / 4) * blockBytes, randomSize, randomSize });
+		run.Source = "random blocks";
+	}
+
+	//
+	// Throughput on one thread and on all of them.
+	//
+
+	unsigned numThreads = ResolveThreadCount(0);
+	bool threadsAgree = true;
+	printf("%-4s %-14s %8s %14s %18s\n", "", "source", "MPixels", "1 thread MP/s", "threads MP/s");
+	for(const FormatRun& run : runs)
+	{
+		const size_t pixelCount = PixelCount(run.Surfaces);
+		const double mp = pixelCount / 1.0e6;
+		std::vector<uint8> serial(pixelCount * 4);
+		std::vector<uint8> parallel(serial.size());
+
+		double serialMs = BestOfMs(5, [&]() { DecodeAll(run.Format, run.Surfaces, serial, 1); });
+		double parallelMs = BestOfMs(5, [&]() { DecodeAll(run.Format, run.Surfaces, parallel, numThreads); });
+		threadsAgree = threadsAgree && serial == parallel;
+
+		printf("%-4s %-14s %8.2f %14.0f %11.0f (%2u)\n", run.Name, run.Source.c_str(), mp,
+			mp / (serialMs / 1000.0), mp / (parallelMs / 1000.0), numThreads);
+	}
+	printf("Same output on 1 and %u threads: %s\n", numThreads, threadsAgree ? "yes" : "NO");
+
+	//
+	// CPU-side alpha test against the tree billboards.
+	//
+
+	DdsFile trees;
+	if(trees.Open("../Textures/treearray.dds") != DdsStatus::Ok || !BcDecoder::IsSupported(trees.GetFormat()))
+		return;
+
+	std::vector<uint8> pixels;
+	BcDecoder::Decode(trees, 0, 0, pixels);
+
+	const DdsSubresource& top = trees.GetSubresource(0, 0);
+	bool texelsAgree = true;
+	size_t opaque = 0;
+	for(uint32 y = 0; y < top.Height; y += 7)
+	{
+		for(uint32 x = 0; x < top.Width; x += 5)
+		{
+			uint8 rgba[4];
+			BcDecoder::DecodeTexel(trees.GetFormat(), top.Data, top.RowPitch, x, y, rgba);
+			texelsAgree = texelsAgree && memcmp(rgba, &pixels[((size_t)y*top.Width + x)*4], 4) == 0;
+		}
+	}
+	for(size_t i = 3; i < pixels.size(); i += 4)
+		opaque += pixels[i] >= 128;
+
+	printf("treearray.dds slice 0: %.1f%% of texels pass an alpha test at 0.5; DecodeTexel agrees with Decode: %s\n",
+		100.0 * opaque / (pixels.size() / 4), texelsAgree ? "yes" : "NO");
+}
@@ -0,0 +1,110 @@
+//***************************************************************************************
+// BcEncodeBenchmark.cpp
+//
+// Encode throughput of BcEncoder in megapixels per second and the PSNR of the
+// decoded result, per format and quality preset, on one thread and on every
+// hardware thread.  Colour formats encode the tree0.bmp cutout; BC4 and BC5 encode
+// the decoded bricks_nmap.dds normal map, the data they are meant for.  Also checks
+// that thread counts don't change the output.
+//***************************************************************************************
+
+#include <cmath>
+#include "BenchmarkUtil.h"
+#include "../Common/BcDecoder.h"
+#include "../Common/BcEncoder.h"
+#include "../Common/RgbaImage.h"
+#include "../Common/ParallelFor.h"
+
+namespace
+{
+	typedef std::uint8_t uint8;
+	typedef std::uint32_t uint32;
+
+	struct FormatRun
+	{
+		const char* Name;
+		DXGI_FORMAT Format;
+		const RgbaImage* Image;
+		unsigned Channels; // channels compared for PSNR
+	};
+
+	double Psnr(const FormatRun& run, const std::vector<uint8>& blocks)
+	{
+		const RgbaImage& image = *run.Image;
+		std::vector<uint8> decoded(image.Pixels.size());
+		BcDecoder::Decode(run.Format, blocks.data(), blocks.size() / ((image.Height + 3) / 4),
+			image.Width, image.Height, decoded.data(), image.RowPitch());
+
+		double sum = 0.0;
+		for(size_t p = 0; p < image.Pixels.size(); p += 4)
+		{
+			for(unsigned c = 0; c < run.Channels; ++c)
+			{
+				double d = (double)image.Pixels[p + c] - decoded[p + c];
+				sum += d*d;
+			}
+		}
+
+		double mse = sum / ((double)image.Width*image.Height*run.Channels);
+		return mse > 0.0 ? 10.0*std::log10(255.0*255.0 / mse) : 99.0;
+	}
+}
+
+void RunBcEncodeBenchmark()
+{
+	RgbaImage color;
+	RgbaImage normals;
+	std::string error;
+	if(!RgbaImage::Load("../Textures/tree0.bmp", color, error) ||
+		!RgbaImage::Load("../Textures/bricks_nmap.dds", normals, error))
+	{
+		printf("Can't load the benchmark textures: %s\n", error.c_str());
+		return;
+	}
+
+	// BC1 alpha is 1 bit, so only its colour counts.
+	const FormatRun runs[] =
+	{
+		{ "BC1", DXGI_FORMAT_BC1_UNORM, &color,   3 },
+		{ "BC3", DXGI_FORMAT_BC3_UNORM, &color,   4 },
+		{ "BC7", DXGI_FORMAT_BC7_UNORM, &color,   4 },
+		{ "BC4", DXGI_FORMAT_BC4_UNORM, &normals, 1 },
+		{ "BC5", DXGI_FORMAT_BC5_UNORM, &normals, 2 },
+	};
+
+	const struct { const char* Name; BcEncoder::Quality Quality; } qualities[] =
+	{
+		{ "fast",   BcEncoder::Quality::Fast },
+		{ "normal", BcEncoder::Quality::Normal },
+		{ "high",   BcEncoder::Quality::High },
+	};
+
+	printf("tree0.bmp %ux%u, bricks_nmap.dds %ux%u\n", color.Width, color.Height, normals.Width, normals.Height);
+
+	unsigned numThreads = ResolveThreadCount(0);
+	bool threadsAgree = true;
+	printf("%-4s %-7s %14s %18s %10s\n", "", "quality", "1 thread MP/s", "threads MP/s", "PSNR dB");
+	for(const FormatRun& run : runs)
+	{
+		const RgbaImage& image = *run.Image;
+		const double mp = (double)image.Width*image.Height / 1.0e6;
+
+		for(const auto& q : qualities)
+		{
+			std::vector<uint8> serial;
+			std::vector<uint8> parallel;
+
+			// BC7 at high quality takes seconds per run, so it is timed once.
+			int numRuns = (run.Format == DXGI_FORMAT_BC7_UNORM && q.Quality != BcEncoder::Quality::Fast) ? 1 : 3;
+			double serialMs = BestOfMs(numRuns, [&]() {
+				BcEncoder::Encode(run.Format, image.Pixels.data(), image.Width, image.Height, serial, q.Quality, 1); });
+			double parallelMs = BestOfMs(numRuns, [&]() {
+				BcEncoder::Encode(run.Format, image.Pixels.data(), image.Width, image.Height, parallel, q.Quality, numThreads); });
+			threadsAgree = threadsAgree && serial == parallel;
+
+			printf("%-4s %-7s %14.2f %11.2f (%2u) %10.2f\n", run.Name, q.Name,
+				mp / (serialMs / 1000.0), mp / (parallelMs / 1000.0), numThreads, Psnr(run, serial));
+		}
+	}
+	printf("Same output on 1 and %u threads: %s\n", numThreads, threadsAgree ? "yes" : "NO");
+}
@@ -0,0 +1,76 @@
+//***************************************************************************************
+// BenchmarkModels.cpp
+//
+// Loads the repo's models into GeometryGenerator::MeshData so every benchmark
+// works on the same data.
+//***************************************************************************************
+
+#include "BenchmarkUtil.h"
+#include "../Common/TxtModelLoader.h"
+#include "../Chapter 23 Character Animation/SkinnedMesh/LoadM3d.h"
+
+using namespace DirectX;
+
+static bool LoadTxtModel(const std::string& filename, BenchModel& model)
+{
+	if(!TxtModelLoader::Load(filename, model.Mesh))
+		return false;
+
+	model.Subsets.push_back({ 0, (GeometryGenerator::uint32)model.Mesh.Indices32.size() });
+
+	return true;
+}
+
+static bool LoadM3dModel(const std::string& filename, BenchModel& model)
+{
+	std::vector<M3DLoader::SkinnedVertex> vertices;
+	std::vector<USHORT> indices;
+	std::vector<M3DLoader::Subset> subsets;
+	std::vector<M3DLoader::M3dMaterial> mats;
+	SkinnedData skinInfo;
+
+	M3DLoader m3dLoader;
+	if(!m3dLoader.LoadM3d(filename, vertices, indices, subsets, mats, skinInfo))
+		return false;
+
+	model.Mesh.Vertices.resize(vertices.size());
+	for(size_t i = 0; i < vertices.size(); ++i)
+	{
+		model.Mesh.Vertices[i].Position = vertices[i].Pos;
+		model.Mesh.Vertices[i].Normal = vertices[i].Normal;
+		model.Mesh.Vertices[i].TangentU = vertices[i].TangentU;
+		model.Mesh.Vertices[i].TexC = vertices[i].TexC;
+	}
+
+	model.Mesh.Indices32.assign(indices.begin(), indices.end());
+
+	for(auto& subset : subsets)
+		model.Subsets.push_back({ subset.FaceStart*3, subset.FaceCount*3 });
+
+	return true;
+}
+
+std::vector<BenchModel> LoadBenchModels()
+{
+	std::vector<BenchModel> models;
+
+	const char* txtModels[] = { "Skull.txt", "Car.txt" };
+	for(const char* name : txtModels)
+	{
+		BenchModel model;
+		model.Name = name;
+		if(LoadTxtModel(std::string(BENCH_MODELS_DIR) + name, model))
+			models.push_back(std::move(model));
+		else
+			printf("%s not found, skipping.\n", name);
+	}
+
+	BenchModel soldier;
+	soldier.Name = "soldier.m3d";
+	if(LoadM3dModel(std::string(BENCH_MODELS_DIR) + "soldier.m3d", soldier))
+		models.push_back(std::move(soldier));
+	else
+		printf("soldier.m3d not found, skipping.\n");
+
+	return models;
+}
@@ -0,0 +1,76 @@
+//***************************************************************************************
+// BenchmarkUtil.h
+//
+// Small helpers shared by the CPU benchmarks: a wall-clock stopwatch, a function
+// that times a callable over several runs and keeps the best one, and loaders for
+// the models in src/Models.
+//***************************************************************************************
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+#include "../Common/GeometryGenerator.h"
+
+class Stopwatch
+{
+public:
+	Stopwatch() { Reset(); }
+
+	void Reset()
+	{
+		mStart = std::chrono::high_resolution_clock::now();
+	}
+
+	// Milliseconds since construction or the last Reset().
+	double ElapsedMs()const
+	{
+		auto now = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double, std::milli>(now - mStart).count();
+	}
+
+private:
+	std::chrono::high_resolution_clock::time_point mStart;
+};
+
+///<summary>
+/// Runs func numRuns times and returns the fastest run in milliseconds.  The
+/// fastest run is the least disturbed by the OS, so it is the most stable number
+/// to compare between two implementations.
+///</summary>
+inline double BestOfMs(int numRuns, const std::function<void()>& func)
+{
+	double best = 1.0e30;
+	for(int i = 0; i < numRuns; ++i)
+	{
+		Stopwatch timer;
+		func();
+		double ms = timer.ElapsedMs();
+		if(ms < best)
+			best = ms;
+	}
+
+	return best;
+}
+
+// Benchmarks that load assets expect to be run from the Benchmarks directory.
+#define BENCH_MODELS_DIR "../Models/"
+
+struct BenchModel
+{
+	std::string Name;
+	GeometryGenerator::MeshData Mesh;
+
+	// Index ranges (first index, index count) that are drawn separately.  A model
+	// without subsets has a single range covering the whole index buffer.
+	std::vector<std::pair<GeometryGenerator::uint32, GeometryGenerator::uint32>> Subsets;
+};
+
+///<summary>
+/// Loads Skull.txt, Car.txt and soldier.m3d.  Models that can't be found are
+/// reported and skipped.
+///</summary>
+std::vector<BenchModel> LoadBenchModels();
@@ -0,0 +1,161 @@
+//***************************************************************************************
+// BoundsBenchmark.cpp
+//
+// Compares BoundingVolumes with the per-vertex XMVectorMin/XMVectorMax loop the
+// demos use and with DirectXCollision's CreateFromPoints, on the repo's models and
+// on a few million random points: speed, tightness (sphere radius, box volume),
+// that every point is inside, and that the result doesn't depend on the thread
+// count.
+//***************************************************************************************
+
+#include <cmath>
+#include <random>
+#include "BenchmarkUtil.h"
+#include "../Common/BoundingVolumes.h"
+#include "../Common/ParallelFor.h"
+
+using namespace DirectX;
+
+namespace
+{
+	BoundingBox LoopAabb(const XMFLOAT3* positions, size_t stride, size_t count)
+	{
+		XMVECTOR vMin = XMVectorReplicate(+1.0e30f);
+		XMVECTOR vMax = XMVectorReplicate(-1.0e30f);
+		for(size_t i = 0; i < count; ++i)
+		{
+			XMVECTOR P = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const char*>(positions) + i*stride));
+			vMin = XMVectorMin(vMin, P);
+			vMax = XMVectorMax(vMax, P);
+		}
+
+		BoundingBox bounds;
+		XMStoreFloat3(&bounds.Center, 0.5f*(vMin + vMax));
+		XMStoreFloat3(&bounds.Extents, 0.5f*(vMax - vMin));
+		return bounds;
+	}
+
+	bool SphereContains(const BoundingSphere& s, const XMFLOAT3* positions, size_t stride, size_t count)
+	{
+		float r2 = s.Radius*s.Radius;
+		for(size_t i = 0; i < count; ++i)
+		{
+			const XMFLOAT3& p = *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const char*>(positions) + i*stride);
+			if(XMVectorGetX(XMVector3LengthSq(XMLoadFloat3(&p) - XMLoadFloat3(&s.Center))) > r2)
+				return false;
+		}
+		return true;
+	}
+
+	bool ObbContains(const BoundingOrientedBox& box, const XMFLOAT3* positions, size_t stride, size_t count)
+	{
+		XMMATRIX R = XMMatrixRotationQuaternion(XMLoadFloat4(&box.Orientation));
+		const float* extents = &box.Extents.x;
+		for(size_t i = 0; i < count; ++i)
+		{
+			const XMFLOAT3& p = *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const char*>(positions) + i*stride);
+			XMVECTOR d = XMLoadFloat3(&p) - XMLoadFloat3(&box.Center);
+			for(int k = 0; k < 3; ++k)
+			{
+				float local = XMVectorGetX(XMVector3Dot(d, R.r[k]));
+				if(fabsf(local) > extents[k]*1.0001f + 1.0e-5f)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	float Volume(const XMFLOAT3& extents)
+	{
+		return 8.0f*extents.x*extents.y*extents.z;
+	}
+
+	bool SameBox(const BoundingBox& a, const BoundingBox& b)
+	{
+		return a.Center.x == b.Center.x && a.Center.y == b.Center.y && a.Center.z == b.Center.z &&
+			a.Extents.x == b.Extents.x && a.Extents.y == b.Extents.y && a.Extents.z == b.Extents.z;
+	}
+
+	void RunPoints(const std::string& name, const XMFLOAT3* positions, size_t stride, size_t count, int numRuns)
+	{
+		unsigned numThreads = ResolveThreadCount(0);
+		PointsSoA soa = BoundingVolumes::ToSoA(positions, stride, count);
+
+		printf("%s: %zu points\n", name.c_str(), count);
+
+		//
+		// Boxes.
+		//
+
+		BoundingBox loopBox, aosBox, soaBox, parallelBox;
+		double loopMs = BestOfMs(numRuns, [&]() { loopBox = LoopAabb(positions, stride, count); });
+		double aosMs = BestOfMs(numRuns, [&]() { aosBox = BoundingVolumes::ComputeAabb(positions, stride, count); });
+		double soaMs = BestOfMs(numRuns, [&]() { soaBox = BoundingVolumes::ComputeAabb(soa.GetStream()); });
+		double parallelMs = BestOfMs(numRuns, [&]() { parallelBox = BoundingVolumes::ComputeAabb(soa.GetStream(), numThreads); });
+
+		printf("  AABB: loop %.3f ms, strided %.3f ms, SoA %.3f ms, SoA %u threads %.3f ms, same box: %s\n",
+			loopMs, aosMs, soaMs, numThreads, parallelMs,
+			SameBox(loopBox, aosBox) && SameBox(loopBox, soaBox) && SameBox(loopBox, parallelBox) ? "yes" : "NO");
+
+		//
+		// Spheres.
+		//
+
+		BoundingSphere dxSphere, sphere, parallelSphere;
+		double dxMs = BestOfMs(numRuns, [&]() { BoundingSphere::CreateFromPoints(dxSphere, count, positions, stride); });
+		double sphereMs = BestOfMs(numRuns, [&]() { sphere = BoundingVolumes::ComputeSphere(soa.GetStream()); });
+		double parallelSphereMs = BestOfMs(numRuns, [&]() { parallelSphere = BoundingVolumes::ComputeSphere(soa.GetStream(), numThreads); });
+
+		auto same = [](const BoundingSphere& a, const BoundingSphere& b)
+		{
+			return a.Radius == b.Radius && a.Center.x == b.Center.x && a.Center.y == b.Center.y && a.Center.z == b.Center.z;
+		};
+		bool sameSphere = same(sphere, parallelSphere) && same(sphere, BoundingVolumes::ComputeSphere(soa.GetStream(), 3));
+
+		printf("  sphere: CreateFromPoints r=%.4f %.3f ms, ComputeSphere r=%.4f (%.1f%% smaller) %.3f ms, %u threads %.3f ms\n",
+			dxSphere.Radius, dxMs, sphere.Radius, 100.0f*(1.0f - sphere.Radius/dxSphere.Radius), sphereMs, numThreads, parallelSphereMs);
+		printf("          contains every point: %s, same for 1/3/%u threads: %s\n",
+			SphereContains(sphere, positions, stride, count) ? "yes" : "NO", numThreads, sameSphere ? "yes" : "NO");
+
+		//
+		// Oriented boxes.
+		//
+
+		BoundingOrientedBox dxObb, obb;
+		double dxObbMs = BestOfMs(numRuns, [&]() { BoundingOrientedBox::CreateFromPoints(dxObb, count, positions, stride); });
+		double obbMs = BestOfMs(numRuns, [&]() { obb = BoundingVolumes::ComputeObb(soa.GetStream(), numThreads); });
+
+		printf("  OBB: CreateFromPoints volume %.4f %.3f ms, ComputeObb volume %.4f %.3f ms (AABB volume %.4f), contains every point: %s\n",
+			Volume(dxObb.Extents), dxObbMs, Volume(obb.Extents), obbMs, Volume(aosBox.Extents),
+			ObbContains(obb, positions, stride, count) ? "yes" : "NO");
+	}
+}
+
+void RunBoundsBenchmark()
+{
+	for(const BenchModel& model : LoadBenchModels())
+	{
+		const GeometryGenerator::MeshData& mesh = model.Mesh;
+		RunPoints(model.Name, &mesh.Vertices[0].Position, sizeof(GeometryGenerator::Vertex), mesh.Vertices.size(), 10);
+	}
+
+	//
+	// Four million points in a rotated, stretched ellipsoid.
+	//
+
+	std::mt19937 rng(1234);
+	std::normal_distribution<float> normal(0.0f, 1.0f);
+	XMMATRIX transform = XMMatrixScaling(40.0f, 10.0f, 3.0f) *
+		XMMatrixRotationQuaternion(XMQuaternionNormalize(XMVectorSet(0.3f, 0.5f, 0.1f, 0.8f))) *
+		XMMatrixTranslation(100.0f, -20.0f, 5.0f);
+
+	std::vector<XMFLOAT3> points(4000000);
+	for(XMFLOAT3& p : points)
+	{
+		XMVECTOR v = XMVector3Normalize(XMVectorSet(normal(rng), normal(rng), normal(rng), 0.0f));
+		v *= powf(std::uniform_real_distribution<float>(0.0f, 1.0f)(rng), 1.0f/3.0f);
+		XMStoreFloat3(&p, XMVector3TransformCoord(v, transform));
+	}
+
+	RunPoints("Random ellipsoid", points.data(), sizeof(XMFLOAT3), points.size(), 3);
+}
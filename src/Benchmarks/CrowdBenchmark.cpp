@@ -0,0 +1,127 @@
+//***************************************************************************************
+// CrowdBenchmark.cpp
+//
+// Animates crowds of soldier.m3d instances with CrowdAnimator, without a device:
+// the palettes go to a system memory buffer laid out as the skinned constant
+// buffer is.  For 1, 2, 4, ... threads up to every hardware thread, prints the
+// instances animated per millisecond, the speedup over one thread, and the
+// ranges stolen per frame; and, for reference, the same loop on ParallelFor,
+// which starts its threads on every call.  Checks that every thread count writes
+// the same palettes.
+//***************************************************************************************
+
+#include <cmath>
+#include <cstring>
+#include "BenchmarkUtil.h"
+#include "../Common/ParallelFor.h"
+#include "../Common/TaskScheduler.h"
+#include "../Chapter 23 Character Animation/SkinnedMesh/CrowdAnimator.h"
+#include "../Chapter 23 Character Animation/SkinnedMesh/LoadM3d.h"
+
+using namespace DirectX;
+
+namespace
+{
+	const UINT FramesPerRun = 60;
+	const float FrameTime = 1.0f / 60.0f;
+
+	std::vector<float> StartTimes(UINT count, float endTime)
+	{
+		std::vector<float> times(count);
+		for(UINT i = 0; i < count; ++i)
+			times[i] = endTime*((i*7919u) % count) / count;
+
+		return times;
+	}
+
+	std::vector<unsigned> ThreadCounts()
+	{
+		std::vector<unsigned> counts;
+		const unsigned hardware = ResolveThreadCount(0);
+		for(unsigned n = 1; n < hardware; n *= 2)
+			counts.push_back(n);
+		counts.push_back(hardware);
+
+		return counts;
+	}
+
+	void RunCrowd(const SkinnedData& skinInfo, UINT instanceCount)
+	{
+		const SkinnedData::ClipHandle clip = skinInfo.FindClip(skinInfo.GetAnimations().begin()->first);
+		const std::vector<float> startTimes = StartTimes(instanceCount, skinInfo.GetClipEndTime(clip));
+
+		// One constant buffer element per instance.
+		const UINT stride = (skinInfo.BoneCount()*sizeof(XMFLOAT4X4) + 255) & ~255u;
+		std::vector<BYTE> reference;
+
+		printf("%u instances:\n", instanceCount);
+		printf("%-8s %12s %9s %12s %16s %10s\n", "threads", "inst/ms", "speedup", "steals/frame", "ParallelFor i/ms", "palettes");
+
+		double oneThread = 0.0;
+		for(unsigned threads : ThreadCounts())
+		{
+			TaskScheduler scheduler(threads);
+			CrowdAnimator crowd(skinInfo, scheduler);
+			for(float t : startTimes)
+				crowd.AddInstance(clip, t);
+
+			std::vector<BYTE> palettes((size_t)instanceCount*stride);
+			double ms = BestOfMs(3, [&]()
+			{
+				for(UINT frame = 0; frame < FramesPerRun; ++frame)
+					crowd.Update(FrameTime, palettes.data(), stride);
+			});
+
+			// The same work with threads started for every frame.
+			std::vector<SkinnedData::Pose> poses(instanceCount);
+			std::vector<float> timePos = startTimes;
+			std::vector<BYTE> scratch((size_t)instanceCount*stride);
+			double parallelForMs = BestOfMs(3, [&]()
+			{
+				for(UINT frame = 0; frame < FramesPerRun; ++frame)
+				{
+					ParallelFor(instanceCount, threads, [&](unsigned, size_t i)
+					{
+						timePos[i] = std::fmod(timePos[i] + FrameTime, skinInfo.GetClipEndTime(clip));
+						skinInfo.GetFinalTransforms(clip, timePos[i], poses[i],
+							reinterpret_cast<XMFLOAT4X4*>(scratch.data() + i*stride));
+					});
+				}
+			});
+
+			if(reference.empty())
+			{
+				reference = palettes;
+				oneThread = ms;
+			}
+
+			const double frames = 3.0*FramesPerRun;
+			printf("%-8u %12.1f %8.2fx %12.1f %16.1f %10s\n", threads,
+				instanceCount*FramesPerRun / ms, oneThread / ms,
+				scheduler.GetStealCount() / frames,
+				instanceCount*FramesPerRun / parallelForMs,
+				memcmp(palettes.data(), reference.data(), palettes.size()) == 0 ? "same" : "DIFFERENT");
+		}
+	}
+}
+
+void RunCrowdBenchmark()
+{
+	std::vector<M3DLoader::SkinnedVertex> vertices;
+	std::vector<USHORT> indices;
+	std::vector<M3DLoader::Subset> subsets;
+	std::vector<M3DLoader::M3dMaterial> mats;
+	SkinnedData skinInfo;
+
+	M3DLoader m3dLoader;
+	if(!m3dLoader.LoadM3d(BENCH_MODELS_DIR "soldier.m3d", vertices, indices, subsets, mats, skinInfo) ||
+		skinInfo.GetAnimations().empty())
+	{
+		printf("soldier.m3d not found\n");
+		return;
+	}
+
+	RunCrowd(skinInfo, 128);
+	printf("\n");
+	RunCrowd(skinInfo, 1024);
+}
@@ -0,0 +1,184 @@
+//***************************************************************************************
+// DdsBenchmark.cpp
+//
+// Parses every texture in src/Textures with DdsFile two ways: read into a heap
+// buffer and parsed (what DDSTextureLoader used to do) against mapped and parsed in
+// place.  Reports what the files hold, that both ways lay out the same
+// subresources, and that damaged files are rejected with the right status.
+//***************************************************************************************
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include "BenchmarkUtil.h"
+#include "../Common/DdsFile.h"
+
+namespace
+{
+	std::vector<char> ReadWholeFile(const std::string& filename)
+	{
+		std::ifstream fin(filename, std::ios::binary | std::ios::ate);
+		std::vector<char> data((size_t)fin.tellg());
+		fin.seekg(0);
+		fin.read(data.data(), data.size());
+		return data;
+	}
+
+	// Same layout relative to the start of each file's bytes.
+	bool SameLayout(const DdsFile& a, const void* aBase, const DdsFile& b, const void* bBase)
+	{
+		const auto& subsA = a.GetSubresources();
+		const auto& subsB = b.GetSubresources();
+		if(subsA.size() != subsB.size() || a.GetFormat() != b.GetFormat())
+			return false;
+
+		for(size_t i = 0; i < subsA.size(); ++i)
+		{
+			if(subsA[i].Data - (const std::uint8_t*)aBase != subsB[i].Data - (const std::uint8_t*)bBase ||
+				subsA[i].RowPitch != subsB[i].RowPitch || subsA[i].SlicePitch != subsB[i].SlicePitch ||
+				subsA[i].Width != subsB[i].Width || subsA[i].Height != subsB[i].Height)
+				return false;
+		}
+
+		return true;
+	}
+
+	DdsStatus ParseDamaged(std::vector<char> data, size_t size, const std::function<void(DDS_HEADER&)>& damage)
+	{
+		DDS_HEADER header;
+		memcpy(&header, data.data() + 4, sizeof(header));
+		damage(header);
+		memcpy(data.data() + 4, &header, sizeof(header));
+
+		DdsFile dds;
+		return dds.Parse(data.data(), size);
+	}
+}
+
+void RunDdsBenchmark()
+{
+	std::vector<std::string> files;
+	std::error_code ec;
+	for(std::filesystem::directory_iterator it("../Textures", ec), end; !ec && it != end; it.increment(ec))
+	{
+		if(it->path().extension() == ".dds")
+			files.push_back(it->path().string());
+	}
+
+	if(files.empty())
+	{
+		printf("No textures found, skipping.\n");
+		return;
+	}
+
+	std::sort(files.begin(), files.end());
+
+	//
+	// What the shipped textures hold.
+	//
+
+	std::map<std::string, int> kinds;
+	size_t totalBytes = 0;
+	size_t subresources = 0;
+	int failed = 0;
+	for(const std::string& file : files)
+	{
+		DdsFile dds;
+		DdsStatus status = dds.Open(file);
+		if(status != DdsStatus::Ok)
+		{
+			printf("  %s: %s\n", file.c_str(), DdsFile::StatusString(status));
+			++failed;
+			continue;
+		}
+
+		char kind[64];
+		snprintf(kind, sizeof(kind), "format %d%s%s", (int)dds.GetFormat(), dds.IsCubeMap() ? " cube" : "",
+			dds.GetMipCount() > 1 ? " mipped" : "");
+		++kinds[kind];
+		subresources += dds.GetSubresources().size();
+		totalBytes += (size_t)std::filesystem::file_size(file);
+	}
+
+	printf("%zu textures, %.1f MB, %zu subresources, %d rejected\n", files.size(), totalBytes / (1024.0*1024.0), subresources, failed);
+	for(const auto& kind : kinds)
+		printf("  %-28s %d\n", kind.first.c_str(), kind.second);
+
+	//
+	// Read and parse against map and parse.
+	//
+
+	double readMs = BestOfMs(5, [&]()
+	{
+		for(const std::string& file : files)
+		{
+			std::vector<char> data = ReadWholeFile(file);
+			DdsFile dds;
+			dds.Parse(data.data(), data.size());
+		}
+	});
+
+	double mapMs = BestOfMs(5, [&]()
+	{
+		for(const std::string& file : files)
+		{
+			DdsFile dds;
+			dds.Open(file);
+		}
+	});
+
+	bool same = true;
+	for(const std::string& file : files)
+	{
+		std::vector<char> data = ReadWholeFile(file);
+		DdsFile read;
+		read.Parse(data.data(), data.size());
+
+		MappedFile mapped(file);
+		DdsFile inPlace;
+		inPlace.Parse(mapped.Begin(), mapped.Size());
+
+		same = same && SameLayout(read, data.data(), inPlace, mapped.Begin());
+	}
+
+	printf("Read and parse %.2f ms, map and parse %.2f ms (%.1fx)\n", readMs, mapMs, readMs / mapMs);
+	printf("Same subresource layout: %s\n", same ? "yes" : "NO");
+
+	//
+	// Damaged files, made from the first texture that has mips.
+	//
+
+	std::vector<char> sample;
+	for(const std::string& file : files)
+	{
+		DdsFile dds;
+		if(dds.Open(file) == DdsStatus::Ok && dds.GetMipCount() > 1 && !dds.HasDx10Header() && !dds.IsCubeMap())
+		{
+			sample = ReadWholeFile(file);
+			break;
+		}
+	}
+
+	if(sample.empty())
+		return;
+
+	const size_t size = sample.size();
+	auto none = [](DDS_HEADER&) {};
+	bool rejected =
+		ParseDamaged(sample, size - 1, none) == DdsStatus::Truncated &&
+		ParseDamaged(sample, 64, none) == DdsStatus::Truncated &&
+		ParseDamaged(sample, size, [](DDS_HEADER& h) { h.size = 0; }) == DdsStatus::Invalid &&
+		ParseDamaged(sample, size, [](DDS_HEADER& h) { h.mipMapCount = 40; }) == DdsStatus::Invalid &&
+		ParseDamaged(sample, size, [](DDS_HEADER& h) { h.width = 0; }) == DdsStatus::Invalid &&
+		ParseDamaged(sample, size, [](DDS_HEADER& h) { h.caps2 = DDS_CUBEMAP_POSITIVEX; }) == DdsStatus::Unsupported &&
+		ParseDamaged(sample, size, [](DDS_HEADER& h) { h.ddspf.flags = DDS_FOURCC; h.ddspf.fourCC = 0x12345678; }) == DdsStatus::Unsupported;
+
+	std::vector<char> notDds(sample);
+	notDds[0] = 'X';
+	DdsFile dds;
+	rejected = rejected && dds.Parse(notDds.data(), notDds.size()) == DdsStatus::Invalid;
+
+	printf("Damaged files rejected: %s\n", rejected ? "yes" : "NO");
+}
@@ -0,0 +1,55 @@
+//***************************************************************************************
+// LodBenchmark.cpp
+//
+// Builds an LOD chain for each of the repo's models and prints the triangle count,
+// error and build time per level, plus the LOD picked at a few view distances.
+// Levels whose triangle target couldn't be reached are marked.
+//***************************************************************************************
+
+#include "BenchmarkUtil.h"
+#include "../Common/MeshSimplifier.h"
+#include "../Common/MathHelper.h"
+#include <DirectXCollision.h>
+
+using namespace DirectX;
+
+void RunLodBenchmark()
+{
+	std::vector<BenchModel> models = LoadBenchModels();
+
+	GeometryGenerator geoGen;
+	BenchModel geosphere;
+	geosphere.Name = "CreateGeosphere(6)";
+	geosphere.Mesh = geoGen.CreateGeosphere(1.0f, 6);
+	models.push_back(std::move(geosphere));
+
+	const std::vector<float> ratios = { 1.0f, 0.5f, 0.25f, 0.125f, 0.0625f };
+
+	for(BenchModel& model : models)
+	{
+		const GeometryGenerator::MeshData& mesh = model.Mesh;
+
+		std::vector<MeshLod> lods;
+		double ms = BestOfMs(3, [&]() { lods = MeshSimplifier::BuildLodChain(mesh, ratios); });
+
+		BoundingSphere bounds;
+		BoundingSphere::CreateFromPoints(bounds, mesh.Vertices.size(), &mesh.Vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+
+		printf("%s: %zu vertices, radius %.2f, chain built in %.2f ms\n",
+			model.Name.c_str(), mesh.Vertices.size(), bounds.Radius, ms);
+
+		for(size_t i = 0; i < lods.size(); ++i)
+		{
+			printf("  LOD %zu: target %5.1f%%, got %5.1f%%, %7u triangles, error %.4f (%.3f%% of radius)%s\n",
+				i, 100.0f*lods[i].TargetRatio, 100.0f*lods[i].Ratio, lods[i].TriangleCount,
+				lods[i].Error, 100.0f*lods[i].Error / bounds.Radius,
+				lods[i].TriangleCount > (size_t)(lods[i].TargetRatio * (mesh.Indices32.size() / 3)) ? ", target not reached" : "");
+		}
+
+		// 1080p, 45 degree vertical field of view as in the demos.
+		printf("  selected LOD at 2/8/32/128 radii:");
+		for(float radii : { 2.0f, 8.0f, 32.0f, 128.0f })
+			printf(" %zu", MeshSimplifier::SelectLod(lods, radii*bounds.Radius, 0.25f*MathHelper::Pi, 1080.0f));
+		printf("\n\n");
+	}
+}
@@ -0,0 +1,231 @@
+//***************************************************************************************
+// M3dBenchmark.cpp
+//
+// Converts soldier.m3d to the binary format and compares loading both: the text
+// parse through M3DLoader::LoadM3d against mapping the binary file with
+// M3dBinaryFile.  Checks that both give the same vertices, indices, subsets,
+// materials and animation, and that damaged files are rejected.
+//***************************************************************************************
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "BenchmarkUtil.h"
+#include "../Chapter 23 Character Animation/SkinnedMesh/M3dBinary.h"
+
+using namespace DirectX;
+
+namespace
+{
+	struct SkinnedModel
+	{
+		std::vector<M3DLoader::SkinnedVertex> Vertices;
+		std::vector<USHORT> Indices;
+		std::vector<M3DLoader::Subset> Subsets;
+		std::vector<M3DLoader::M3dMaterial> Mats;
+		SkinnedData SkinInfo;
+	};
+
+	bool SameMaterials(const std::vector<M3DLoader::M3dMaterial>& a, const std::vector<M3DLoader::M3dMaterial>& b)
+	{
+		if(a.size() != b.size())
+			return false;
+
+		for(size_t i = 0; i < a.size(); ++i)
+		{
+			if(a[i].Name != b[i].Name || a[i].MaterialTypeName != b[i].MaterialTypeName ||
+				a[i].DiffuseMapName != b[i].DiffuseMapName || a[i].NormalMapName != b[i].NormalMapName ||
+				a[i].AlphaClip != b[i].AlphaClip || a[i].Roughness != b[i].Roughness ||
+				memcmp(&a[i].DiffuseAlbedo, &b[i].DiffuseAlbedo, sizeof(XMFLOAT4)) != 0 ||
+				memcmp(&a[i].FresnelR0, &b[i].FresnelR0, sizeof(XMFLOAT3)) != 0)
+				return false;
+		}
+
+		return true;
+	}
+
+	bool SameSubsets(const std::vector<M3DLoader::Subset>& a, const std::vector<M3DLoader::Subset>& b)
+	{
+		if(a.size() != b.size())
+			return false;
+
+		for(size_t i = 0; i < a.size(); ++i)
+		{
+			if(a[i].Id != b[i].Id || a[i].VertexStart != b[i].VertexStart || a[i].VertexCount != b[i].VertexCount ||
+				a[i].FaceStart != b[i].FaceStart || a[i].FaceCount != b[i].FaceCount)
+				return false;
+		}
+
+		return true;
+	}
+
+	// Compares the final transforms of every clip at a spread of times, which covers
+	// the hierarchy, the offsets and the keyframes.
+	bool SameAnimation(const SkinnedData& a, const SkinnedData& b)
+	{
+		if(a.BoneCount() != b.BoneCount() || a.GetAnimations().size() != b.GetAnimations().size())
+			return false;
+
+		std::vector<XMFLOAT4X4> transformsA(a.BoneCount());
+		std::vector<XMFLOAT4X4> transformsB(b.BoneCount());
+		for(const auto& clip : a.GetAnimations())
+		{
+			if(b.GetAnimations().count(clip.first) == 0)
+				return false;
+
+			float endTime = a.GetClipEndTime(clip.first);
+			for(int i = 0; i <= 16; ++i)
+			{
+				float t = endTime*i / 16.0f;
+				a.GetFinalTransforms(clip.first, t, transformsA);
+				b.GetFinalTransforms(clip.first, t, transformsB);
+				if(memcmp(transformsA.data(), transformsB.data(), transformsA.size()*sizeof(XMFLOAT4X4)) != 0)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool Rejects(const std::string& filename, const std::vector<char>& contents)
+	{
+		{
+			std::ofstream fout(filename, std::ios::binary);
+			fout.write(contents.data(), contents.size());
+		}
+
+		M3dBinaryFile file;
+		return !file.Open(filename);
+	}
+}
+
+void RunM3dBenchmark()
+{
+	const std::string textFile = std::string(BENCH_MODELS_DIR) + "soldier.m3d";
+	const std::string binaryFile = "M3dBenchmark.tmp";
+
+	M3DLoader m3dLoader;
+	SkinnedModel text;
+	if(!m3dLoader.LoadM3d(textFile, text.Vertices, text.Indices, text.Subsets, text.Mats, text.SkinInfo))
+	{
+		printf("soldier.m3d not found, skipping.\n");
+		return;
+	}
+
+	Stopwatch convertTimer;
+	bool converted = M3dBinaryFile::Convert(textFile, binaryFile);
+	double convertMs = convertTimer.ElapsedMs();
+	if(!converted)
+	{
+		printf("Conversion failed.\n");
+		return;
+	}
+
+	//
+	// Load times.  "Mapped" is what SkinnedMeshApp does with the binary file: the
+	// vertices and indices are used in place, the rest is copied out.
+	//
+
+	double textMs = BestOfMs(5, [&]()
+	{
+		SkinnedModel model;
+		m3dLoader.LoadM3d(textFile, model.Vertices, model.Indices, model.Subsets, model.Mats, model.SkinInfo);
+	});
+
+	double mappedMs = BestOfMs(5, [&]()
+	{
+		SkinnedModel model;
+		M3dBinaryFile file;
+		file.Open(binaryFile);
+		file.GetSubsets(model.Subsets);
+		file.GetMaterials(model.Mats);
+		file.GetSkinnedData(model.SkinInfo);
+	});
+
+	SkinnedModel binary;
+	double binaryMs = BestOfMs(5, [&]()
+	{
+		binary = SkinnedModel();
+		m3dLoader.LoadM3d(binaryFile, binary.Vertices, binary.Indices, binary.Subsets, binary.Mats, binary.SkinInfo);
+	});
+
+	std::ifstream fin(binaryFile, std::ios::binary | std::ios::ate);
+	printf("soldier.m3d: %zu vertices, %zu triangles, %u bones, %zu clips; binary file %lld bytes, converted in %.2f ms\n",
+		text.Vertices.size(), text.Indices.size() / 3, text.SkinInfo.BoneCount(), text.SkinInfo.GetAnimations().size(),
+		(long long)fin.tellg(), convertMs);
+	fin.close();
+	printf("  text LoadM3d %.2f ms, binary LoadM3d %.2f ms (%.1fx), mapped %.2f ms (%.1fx)\n",
+		textMs, binaryMs, textMs / binaryMs, mappedMs, textMs / mappedMs);
+
+	M3dBinaryFile file;
+	bool opened = file.Open(binaryFile);
+	bool sameMapped = opened && file.IsSkinned() &&
+		file.GetVertexCount() == text.Vertices.size() &&
+		file.GetIndexCount() == text.Indices.size() &&
+		memcmp(file.GetSkinnedVertices(), text.Vertices.data(), text.Vertices.size()*sizeof(M3DLoader::SkinnedVertex)) == 0 &&
+		memcmp(file.GetIndices(), text.Indices.data(), text.Indices.size()*sizeof(USHORT)) == 0;
+	file.Close();
+
+	bool same =
+		binary.Vertices.size() == text.Vertices.size() &&
+		memcmp(binary.Vertices.data(), text.Vertices.data(), text.Vertices.size()*sizeof(M3DLoader::SkinnedVertex)) == 0 &&
+		binary.Indices == text.Indices &&
+		SameSubsets(binary.Subsets, text.Subsets) &&
+		SameMaterials(binary.Mats, text.Mats) &&
+		SameAnimation(binary.SkinInfo, text.SkinInfo);
+	printf("  mapped vertices/indices same as text: %s, LoadM3d of binary same as text: %s\n",
+		sameMapped ? "yes" : "NO", same ? "yes" : "NO");
+
+	//
+	// Damaged files.
+	//
+
+	std::vector<char> contents;
+	{
+		std::ifstream in(binaryFile, std::ios::binary);
+		contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+
+	std::vector<char> wrongVersion = contents;
+	M3dbHeader* header = reinterpret_cast<M3dbHeader*>(wrongVersion.data());
+	header->Version = M3dBinaryFile::Version + 1;
+
+	std::vector<char> truncated(contents.begin(), contents.end() - 16);
+
+	std::vector<char> badCount = contents;
+	header = reinterpret_cast<M3dbHeader*>(badCount.data());
+	header->VertexCount += 1;
+
+	std::vector<char> badKeyframes = contents;
+	header = reinterpret_cast<M3dbHeader*>(badKeyframes.data());
+	M3dbBoneAnimation* boneAnimations = reinterpret_cast<M3dbBoneAnimation*>(badKeyframes.data() + header->BoneAnimations.Offset);
+	boneAnimations[0].KeyframeCount = header->KeyframeCount + 1;
+
+	std::vector<char> badSubset = contents;
+	header = reinterpret_cast<M3dbHeader*>(badSubset.data());
+	M3dbSubset* subsets = reinterpret_cast<M3dbSubset*>(badSubset.data() + header->Subsets.Offset);
+	subsets[0].VertexCount = header->VertexCount - subsets[0].VertexStart + 1;
+
+	std::vector<char> badIndex = contents;
+	header = reinterpret_cast<M3dbHeader*>(badIndex.data());
+	USHORT* indices = reinterpret_cast<USHORT*>(badIndex.data() + header->Indices.Offset);
+	indices[header->IndexCount - 1] = (USHORT)header->VertexCount;
+
+	std::vector<char> badBoneIndex = contents;
+	header = reinterpret_cast<M3dbHeader*>(badBoneIndex.data());
+	M3DLoader::SkinnedVertex* vertices = reinterpret_cast<M3DLoader::SkinnedVertex*>(badBoneIndex.data() + header->Vertices.Offset);
+	vertices[0].BoneIndices[0] = (BYTE)header->BoneCount;
+
+	bool rejected =
+		Rejects(binaryFile, wrongVersion) &&
+		Rejects(binaryFile, truncated) &&
+		Rejects(binaryFile, badCount) &&
+		Rejects(binaryFile, badKeyframes) &&
+		Rejects(binaryFile, badSubset) &&
+		Rejects(binaryFile, badIndex) &&
+		Rejects(binaryFile, badBoneIndex) &&
+		Rejects(binaryFile, std::vector<char>(contents.begin(), contents.begin() + 8));
+	printf("Damaged files rejected: %s\n", rejected ? "yes" : "NO");
+
+	remove(binaryFile.c_str());
+}
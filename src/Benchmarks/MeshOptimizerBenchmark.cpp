@@ -0,0 +1,85 @@
+//***************************************************************************************
+// MeshOptimizerBenchmark.cpp
+//
+// Reports post-transform cache efficiency (ACMR/ATVR) of the repo's models before
+// and after MeshOptimizer, for a few simulated FIFO and LRU cache sizes.
+//***************************************************************************************
+
+#include "BenchmarkUtil.h"
+#include "../Common/MeshOptimizer.h"
+
+struct CacheConfig
+{
+	MeshOptimizer::CacheType Type;
+	GeometryGenerator::uint32 Size;
+	const char* Name;
+};
+
+static const CacheConfig gCacheConfigs[] =
+{
+	{ MeshOptimizer::CacheType::Fifo, 16, "FIFO 16" },
+	{ MeshOptimizer::CacheType::Fifo, 32, "FIFO 32" },
+	{ MeshOptimizer::CacheType::Lru,  16, "LRU 16" },
+	{ MeshOptimizer::CacheType::Lru,  32, "LRU 32" },
+};
+
+static void PrintCacheStats(const char* label, const GeometryGenerator::MeshData& mesh)
+{
+	for(const CacheConfig& config : gCacheConfigs)
+	{
+		MeshOptimizer::CacheStats stats = MeshOptimizer::AnalyzeVertexCache(
+			mesh.Indices32.data(), mesh.Indices32.size(), mesh.Vertices.size(),
+			config.Size, config.Type);
+
+		printf("  %-7s %-8s ACMR %6.3f  ATVR %6.3f\n", label, config.Name, stats.Acmr, stats.Atvr);
+	}
+}
+
+void RunMeshOptimizerBenchmark()
+{
+	std::vector<BenchModel> models = LoadBenchModels();
+
+	GeometryGenerator geoGen;
+
+	BenchModel grid;
+	grid.Name = "CreateGrid(160x160)";
+	grid.Mesh = geoGen.CreateGrid(160.0f, 160.0f, 160, 160);
+	grid.Subsets.push_back({ 0, (GeometryGenerator::uint32)grid.Mesh.Indices32.size() });
+	models.push_back(std::move(grid));
+
+	BenchModel geosphere;
+	geosphere.Name = "CreateGeosphere(5)";
+	geosphere.Mesh = geoGen.CreateGeosphere(1.0f, 5);
+	geosphere.Subsets.push_back({ 0, (GeometryGenerator::uint32)geosphere.Mesh.Indices32.size() });
+	models.push_back(std::move(geosphere));
+
+	for(BenchModel& model : models)
+	{
+		GeometryGenerator::MeshData& mesh = model.Mesh;
+
+		printf("%s: %zu vertices, %zu triangles\n", model.Name.c_str(),
+			mesh.Vertices.size(), mesh.Indices32.size()/3);
+
+		PrintCacheStats("before", mesh);
+
+		// Subsets are drawn separately, so each one is reordered on its own.
+		// The vertex renumbering is global since subsets index the whole buffer.
+		Stopwatch timer;
+		for(auto& subset : model.Subsets)
+		{
+			MeshOptimizer::OptimizeVertexCache(&mesh.Indices32[subset.first], subset.second,
+				mesh.Vertices.size(), 32);
+		}
+		double cacheMs = timer.ElapsedMs();
+
+		timer.Reset();
+		std::vector<GeometryGenerator::uint32> remap = MeshOptimizer::OptimizeVertexFetchRemap(
+			mesh.Indices32.data(), mesh.Indices32.size(), mesh.Vertices.size());
+		MeshOptimizer::RemapVertices(mesh.Vertices, remap);
+		double fetchMs = timer.ElapsedMs();
+
+		PrintCacheStats("after", mesh);
+
+		printf("  OptimizeVertexCache %.2f ms, OptimizeVertexFetch %.2f ms\n\n", cacheMs, fetchMs);
+	}
+}
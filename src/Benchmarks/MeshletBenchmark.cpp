@@ -0,0 +1,91 @@
+//***************************************************************************************
+// MeshletBenchmark.cpp
+//
+// Builds meshlets for the repo's models with one thread and with every hardware
+// thread, checks that both give the same result, and reports how many meshlets a
+// normal cone test would reject from a few viewpoints.
+//***************************************************************************************
+
+#include "BenchmarkUtil.h"
+#include "../Common/MeshOptimizer.h"
+#include "../Common/MeshletBuilder.h"
+#include "../Common/ParallelFor.h"
+
+using namespace DirectX;
+
+static bool SameMeshlets(const MeshletData& a, const MeshletData& b)
+{
+	if(a.Meshlets.size() != b.Meshlets.size() ||
+	   a.VertexIndices != b.VertexIndices ||
+	   a.PrimitiveIndices != b.PrimitiveIndices)
+		return false;
+
+	for(size_t i = 0; i < a.Meshlets.size(); ++i)
+	{
+		const Meshlet& ma = a.Meshlets[i];
+		const Meshlet& mb = b.Meshlets[i];
+		if(ma.VertexOffset != mb.VertexOffset || ma.TriangleOffset != mb.TriangleOffset ||
+		   ma.Bounds.Radius != mb.Bounds.Radius || ma.ConeCutoff != mb.ConeCutoff)
+			return false;
+	}
+
+	return true;
+}
+
+void RunMeshletBenchmark()
+{
+	std::vector<BenchModel> models = LoadBenchModels();
+
+	GeometryGenerator geoGen;
+	BenchModel geosphere;
+	geosphere.Name = "CreateGeosphere(7)";
+	geosphere.Mesh = geoGen.CreateGeosphere(1.0f, 7);
+	models.push_back(std::move(geosphere));
+
+	unsigned numThreads = ResolveThreadCount(0);
+
+	for(BenchModel& model : models)
+	{
+		GeometryGenerator::MeshData& mesh = model.Mesh;
+		MeshOptimizer::OptimizeVertexCache(mesh.Indices32.data(), mesh.Indices32.size(), mesh.Vertices.size());
+
+		MeshletData serial, parallel;
+		double serialMs = BestOfMs(5, [&]() { serial = MeshletBuilder::Build(mesh, 64, 124, 1); });
+		double parallelMs = BestOfMs(5, [&]() { parallel = MeshletBuilder::Build(mesh, 64, 124, numThreads); });
+
+		size_t meshletCount = serial.Meshlets.size();
+
+		printf("%s: %zu triangles -> %zu meshlets, %.1f vertices and %.1f triangles per meshlet\n",
+			model.Name.c_str(), mesh.Indices32.size()/3, meshletCount,
+			(double)serial.VertexIndices.size() / meshletCount,
+			(double)serial.PrimitiveIndices.size() / 3 / meshletCount);
+
+		printf("  1 thread %.2f ms, %u threads %.2f ms, identical: %s\n",
+			serialMs, numThreads, parallelMs, SameMeshlets(serial, parallel) ? "yes" : "NO");
+
+		// Look at the model from the six axis directions, far enough out to see it all.
+		BoundingSphere modelBounds;
+		BoundingSphere::CreateFromPoints(modelBounds, mesh.Vertices.size(), &mesh.Vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+
+		const XMVECTOR dirs[6] =
+		{
+			XMVectorSet(+1.0f, 0.0f, 0.0f, 0.0f), XMVectorSet(-1.0f, 0.0f, 0.0f, 0.0f),
+			XMVectorSet(0.0f, +1.0f, 0.0f, 0.0f), XMVectorSet(0.0f, -1.0f, 0.0f, 0.0f),
+			XMVectorSet(0.0f, 0.0f, +1.0f, 0.0f), XMVectorSet(0.0f, 0.0f, -1.0f, 0.0f),
+		};
+
+		size_t culled = 0;
+		for(const XMVECTOR& dir : dirs)
+		{
+			XMVECTOR eye = XMLoadFloat3(&modelBounds.Center) + 3.0f*modelBounds.Radius*dir;
+			for(const Meshlet& meshlet : serial.Meshlets)
+			{
+				if(MeshletBuilder::IsBackfacing(meshlet, eye))
+					culled++;
+			}
+		}
+
+		printf("  cone culling rejects %.1f%% of meshlets on average over 6 views\n\n",
+			100.0 * culled / (6.0 * meshletCount));
+	}
+}
@@ -0,0 +1,180 @@
+//***************************************************************************************
+// MipBenchmark.cpp
+//
+// MipGenerator throughput in megapixels of source per second, per filter, with
+// and without sRGB conversion, on one thread and on every hardware thread.  The
+// source is WireFence.dds tiled to 2048x2048.  Also prints the alpha coverage of
+// each WireFence.dds mip as authored, as generated, and as generated with coverage
+// preservation, and checks that writing into a padded upload-style layout gives
+// the same texels as the packed one.
+//***************************************************************************************
+
+#include <cstring>
+#include "BenchmarkUtil.h"
+#include "../Common/BcDecoder.h"
+#include "../Common/DdsFile.h"
+#include "../Common/MipGenerator.h"
+#include "../Common/ParallelFor.h"
+
+namespace
+{
+	typedef std::uint8_t uint8;
+	typedef std::uint32_t uint32;
+
+	// D3D12_TEXTURE_DATA_PITCH_ALIGNMENT: upload buffer rows start on 256 bytes.
+	const size_t UploadPitchAlignment = 256;
+
+	RgbaImage Tile(const RgbaImage& image, uint32 repeat)
+	{
+		RgbaImage tiled;
+		tiled.Width = image.Width*repeat;
+		tiled.Height = image.Height*repeat;
+		tiled.Pixels.resize(4*(size_t)tiled.Width*tiled.Height);
+
+		for(uint32 y = 0; y < tiled.Height; ++y)
+		{
+			const uint8* src = &image.Pixels[(y % image.Height)*image.RowPitch()];
+			for(uint32 r = 0; r < repeat; ++r)
+				memcpy(&tiled.Pixels[y*tiled.RowPitch() + r*image.RowPitch()], src, image.RowPitch());
+		}
+
+		return tiled;
+	}
+
+	// Generates into one buffer laid out like a texture's footprints in an upload
+	// heap, then checks each level against the packed mips.
+	bool UploadLayoutMatches(const RgbaImage& image, const MipGenerator::Options& options,
+		const std::vector<RgbaImage>& packed)
+	{
+		std::vector<MipGenerator::MipTarget> targets;
+		std::vector<size_t> offsets;
+		size_t size = 0;
+		for(size_t level = 1; level < packed.size(); ++level)
+		{
+			size_t pitch = (packed[level].RowPitch() + UploadPitchAlignment - 1) & ~(UploadPitchAlignment - 1);
+			offsets.push_back(size);
+			targets.push_back({ nullptr, pitch });
+			size += pitch*packed[level].Height;
+		}
+
+		std::vector<uint8> upload(size);
+		for(size_t i = 0; i < targets.size(); ++i)
+			targets[i].Data = upload.data() + offsets[i];
+
+		MipGenerator::Generate(image.Pixels.data(), image.RowPitch(), image.Width, image.Height,
+			targets.data(), (uint32)targets.size(), options);
+
+		for(size_t level = 1; level < packed.size(); ++level)
+		{
+			const RgbaImage& mip = packed[level];
+			for(uint32 y = 0; y < mip.Height; ++y)
+			{
+				const uint8* row = static_cast<const uint8*>(targets[level - 1].Data) + y*targets[level - 1].RowPitch;
+				if(memcmp(row, &mip.Pixels[y*mip.RowPitch()], mip.RowPitch()) != 0)
+					return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+void RunMipBenchmark()
+{
+	DdsFile fence;
+	std::vector<uint8> pixels;
+	if(fence.Open("../Textures/WireFence.dds") != DdsStatus::Ok || !BcDecoder::Decode(fence, 0, 0, pixels))
+	{
+		printf("Can't load WireFence.dds\n");
+		return;
+	}
+
+	RgbaImage top;
+	top.Width = fence.GetWidth();
+	top.Height = fence.GetHeight();
+	top.Pixels = pixels;
+
+	//
+	// Throughput.
+	//
+
+	const RgbaImage source = Tile(top, 4);
+	const double mp = (double)source.Width*source.Height / 1.0e6;
+	const unsigned numThreads = ResolveThreadCount(0);
+
+	const struct { const char* Name; MipGenerator::Filter Filter; } filters[] =
+	{
+		{ "box",     MipGenerator::Filter::Box },
+		{ "kaiser",  MipGenerator::Filter::Kaiser },
+		{ "lanczos", MipGenerator::Filter::Lanczos },
+	};
+
+	printf("Source %ux%u (WireFence.dds tiled 4x4)\n", source.Width, source.Height);
+	printf("%-8s %-6s %14s %18s\n", "filter", "space", "1 thread MP/s", "threads MP/s");
+
+	bool threadsAgree = true;
+	bool uploadMatches = true;
+	for(const auto& f : filters)
+	{
+		for(int srgb = 0; srgb < 2; ++srgb)
+		{
+			MipGenerator::Options options;
+			options.Kernel = f.Filter;
+			options.Srgb = srgb != 0;
+
+			std::vector<RgbaImage> serial;
+			std::vector<RgbaImage> parallel;
+			options.NumThreads = 1;
+			double serialMs = BestOfMs(3, [&]() { MipGenerator::Generate(source, options, serial); });
+			options.NumThreads = numThreads;
+			double parallelMs = BestOfMs(3, [&]() { MipGenerator::Generate(source, options, parallel); });
+
+			for(size_t level = 0; level < serial.size(); ++level)
+				threadsAgree = threadsAgree && serial[level].Pixels == parallel[level].Pixels;
+			uploadMatches = uploadMatches && UploadLayoutMatches(source, options, serial);
+
+			printf("%-8s %-6s %14.1f %11.1f (%2u)\n", f.Name, srgb ? "sRGB" : "stored",
+				mp / (serialMs / 1000.0), mp / (parallelMs / 1000.0), numThreads);
+		}
+	}
+	printf("Same output on 1 and %u threads: %s\n", numThreads, threadsAgree ? "yes" : "NO");
+	printf("Padded upload layout matches packed mips: %s\n", uploadMatches ? "yes" : "NO");
+
+	//
+	// Alpha coverage of the fence down the chain.
+	//
+
+	const float reference = 0.5f;
+	MipGenerator::Options plain;
+	plain.Kernel = MipGenerator::Filter::Kaiser;
+	plain.Srgb = true;
+	MipGenerator::Options preserved = plain;
+	preserved.AlphaReference = reference;
+
+	std::vector<RgbaImage> plainMips;
+	std::vector<RgbaImage> preservedMips;
+	MipGenerator::Generate(top, plain, plainMips);
+	MipGenerator::Generate(top, preserved, preservedMips);
+
+	printf("\nWireFence.dds alpha coverage at %.1f\n", reference);
+	printf("%-5s %-9s %9s %10s %10s\n", "mip", "size", "authored", "generated", "preserved");
+	for(uint32 level = 0; level < (uint32)plainMips.size(); ++level)
+	{
+		char size[16];
+		snprintf(size, sizeof(size), "%ux%u", plainMips[level].Width, plainMips[level].Height);
+
+		RgbaImage authored;
+		if(level < fence.GetMipCount())
+		{
+			const DdsSubresource& sub = fence.GetSubresource(level, 0);
+			authored.Width = sub.Width;
+			authored.Height = sub.Height;
+			BcDecoder::Decode(fence, level, 0, authored.Pixels);
+		}
+
+		printf("%-5u %-9s %8.1f%% %9.1f%% %9.1f%%\n", level, size,
+			100.0f*MipGenerator::AlphaCoverage(authored, reference),
+			100.0f*MipGenerator::AlphaCoverage(plainMips[level], reference),
+			100.0f*MipGenerator::AlphaCoverage(preservedMips[level], reference));
+	}
+}
@@ -0,0 +1,131 @@
+//***************************************************************************************
+// PoseCacheBenchmark.cpp
+//
+// Animates 1024 soldier.m3d instances with CrowdAnimator, with and without a
+// PoseCache, as the instances are spread over more and more phases of the clip:
+// all in lockstep, a few phase buckets, and every instance on its own.  Prints
+// the instances animated per millisecond each way, the cache's hit rate, the
+// poses it evaluated and evicted per frame, its memory, and the largest
+// difference of a palette element from the uncached one (the cost of rounding
+// times to TimeStep).  At the default TimeStep a cache of 256 poses holds the
+// whole 1.25 s clip, so once the crowd has played it through, every phase hits;
+// the 16 pose cache shows a crowd with more phases than poses to keep them in.
+//***************************************************************************************
+
+#include <algorithm>
+#include <cmath>
+#include "BenchmarkUtil.h"
+#include "../Common/TaskScheduler.h"
+#include "../Chapter 23 Character Animation/SkinnedMesh/CrowdAnimator.h"
+#include "../Chapter 23 Character Animation/SkinnedMesh/LoadM3d.h"
+#include "../Chapter 23 Character Animation/SkinnedMesh/PoseCache.h"
+
+using namespace DirectX;
+
+namespace
+{
+	const UINT InstanceCount = 1024;
+	const UINT FramesPerRun = 60;
+	const float FrameTime = 1.0f / 60.0f;
+
+	struct Config
+	{
+		UINT Phases;
+		UINT MaxPoses;
+	};
+
+	void Run(const SkinnedData& skinInfo, TaskScheduler& scheduler, const Config& config)
+	{
+		const SkinnedData::ClipHandle clip = skinInfo.FindClip(skinInfo.GetAnimations().begin()->first);
+		const float clipLength = skinInfo.GetClipEndTime(clip);
+		const UINT stride = (skinInfo.BoneCount()*sizeof(XMFLOAT4X4) + 255) & ~255u;
+
+		PoseCache::Settings settings;
+		settings.MaxPoses = config.MaxPoses;
+		PoseCache cache(skinInfo, settings);
+
+		CrowdAnimator exact(skinInfo, scheduler);
+		CrowdAnimator cached(skinInfo, scheduler);
+		cached.SetPoseCache(&cache);
+		for(UINT i = 0; i < InstanceCount; ++i)
+		{
+			float timePos = clipLength*((i*7919u) % config.Phases) / config.Phases;
+			exact.AddInstance(clip, timePos);
+			cached.AddInstance(clip, timePos);
+		}
+
+		std::vector<BYTE> exactPalettes((size_t)InstanceCount*stride);
+		std::vector<BYTE> cachedPalettes((size_t)InstanceCount*stride);
+
+		double exactMs = BestOfMs(3, [&]()
+		{
+			for(UINT frame = 0; frame < FramesPerRun; ++frame)
+				exact.Update(FrameTime, exactPalettes.data(), stride);
+		});
+
+		double cachedMs = BestOfMs(3, [&]()
+		{
+			for(UINT frame = 0; frame < FramesPerRun; ++frame)
+				cached.Update(FrameTime, cachedPalettes.data(), stride);
+		});
+
+		// Both crowds are at the same times now.
+		float maxDiff = 0.0f;
+		for(UINT i = 0; i < InstanceCount; ++i)
+		{
+			const XMFLOAT4X4* a = reinterpret_cast<const XMFLOAT4X4*>(exactPalettes.data() + (size_t)i*stride);
+			const XMFLOAT4X4* b = reinterpret_cast<const XMFLOAT4X4*>(cachedPalettes.data() + (size_t)i*stride);
+			for(UINT bone = 0; bone < skinInfo.BoneCount(); ++bone)
+			{
+				for(int r = 0; r < 4; ++r)
+				{
+					for(int c = 0; c < 4; ++c)
+						maxDiff = (std::max)(maxDiff, std::fabs(a[bone].m[r][c] - b[bone].m[r][c]));
+				}
+			}
+		}
+
+		const PoseCache::Stats stats = cache.GetStats();
+		const double frames = 3.0*FramesPerRun;
+		printf("%-7u %6u %11.1f %11.1f %8.1fx %8.2f%% %10.1f %10.1f %7.0f %10.2e\n", config.Phases, config.MaxPoses,
+			InstanceCount*FramesPerRun / exactMs, InstanceCount*FramesPerRun / cachedMs, exactMs / cachedMs,
+			100.0f*stats.HitRate(), stats.Misses / frames, stats.Evictions / frames, cache.GetMemoryBytes() / 1024.0,
+			maxDiff);
+	}
+}
+
+void RunPoseCacheBenchmark()
+{
+	std::vector<M3DLoader::SkinnedVertex> vertices;
+	std::vector<USHORT> indices;
+	std::vector<M3DLoader::Subset> subsets;
+	std::vector<M3DLoader::M3dMaterial> mats;
+	SkinnedData skinInfo;
+
+	M3DLoader m3dLoader;
+	if(!m3dLoader.LoadM3d(BENCH_MODELS_DIR "soldier.m3d", vertices, indices, subsets, mats, skinInfo) ||
+		skinInfo.GetAnimations().empty())
+	{
+		printf("soldier.m3d not found\n");
+		return;
+	}
+
+	TaskScheduler scheduler;
+	printf("%u instances, %u threads, TimeStep %.4f s\n", InstanceCount, scheduler.GetThreadCount(),
+		PoseCache::Settings().TimeStep);
+	printf("%-7s %6s %11s %11s %9s %9s %10s %10s %7s %10s\n", "phases", "poses", "exact i/ms", "cached i/ms",
+		"speedup", "hits", "evals/frm", "evict/frm", "KB", "max error");
+
+	const Config configs[] =
+	{
+		{ 1,    256 },
+		{ 8,    256 },
+		{ 64,   256 },
+		{ 1024, 256 },
+		{ 8,    16 },
+		{ 64,   16 },
+	};
+
+	for(const Config& config : configs)
+		Run(skinInfo, scheduler, config);
+}
@@ -0,0 +1,120 @@
+//***************************************************************************************
+// QuantizeBenchmark.cpp
+//
+// Quantizes the repo's models and reports the vertex buffer size before and after,
+// the worst error per attribute and the encode/decode speed, and checks that the
+// tangent handedness of M3DLoader::Vertex survives the round trip.
+//***************************************************************************************
+
+#include "BenchmarkUtil.h"
+#include "../Common/TangentGenerator.h"
+#include "../Common/VertexQuantizer.h"
+#include "../Chapter 23 Character Animation/SkinnedMesh/LoadM3d.h"
+
+static void PrintError(const QuantizationError& error, const QuantizationParams& params)
+{
+	float extent = (std::max)(params.Extent.x, (std::max)(params.Extent.y, params.Extent.z));
+
+	printf("  max error: position %.6f (%.5f%% of extent), normal %.4f deg, tangent %.4f deg, texc %.6f",
+		error.Position, extent > 0.0f ? 100.0f*error.Position/extent : 0.0f,
+		error.NormalDegrees, error.TangentDegrees, error.TexC);
+}
+
+void RunQuantizeBenchmark()
+{
+	std::vector<BenchModel> models = LoadBenchModels();
+
+	GeometryGenerator geoGen;
+	BenchModel grid;
+	grid.Name = "CreateGrid(160, 160, 500, 500)";
+	grid.Mesh = geoGen.CreateGrid(160.0f, 160.0f, 500, 500);
+	models.push_back(std::move(grid));
+
+	for(const BenchModel& model : models)
+	{
+		const GeometryGenerator::MeshData& mesh = model.Mesh;
+		size_t vertexCount = mesh.Vertices.size();
+
+		VertexStreams streams = VertexQuantizer::Describe(mesh);
+		QuantizationParams params = VertexQuantizer::ComputeParams(streams);
+
+		std::vector<QuantizedVertex> packed(vertexCount);
+		std::vector<GeometryGenerator::Vertex> decoded(vertexCount);
+		QuantizationError error;
+
+		double encodeMs = BestOfMs(5, [&]() { VertexQuantizer::Encode(streams, params, packed.data()); });
+		double decodeMs = BestOfMs(5, [&]() { VertexQuantizer::Decode(packed.data(), vertexCount, params, decoded.data()); });
+		VertexQuantizer::Encode(streams, params, packed.data(), &error);
+
+		printf("%s: %zu vertices, %zu -> %zu bytes (%zu -> %zu per vertex)\n",
+			model.Name.c_str(), vertexCount,
+			vertexCount*sizeof(GeometryGenerator::Vertex), vertexCount*sizeof(QuantizedVertex),
+			sizeof(GeometryGenerator::Vertex), sizeof(QuantizedVertex));
+		PrintError(error, params);
+		printf("\n  encode %.2f ms (%.1f Mvertices/s), decode %.2f ms (%.1f Mvertices/s)\n\n",
+			encodeMs, vertexCount / (1000.0*encodeMs), decodeMs, vertexCount / (1000.0*decodeMs));
+	}
+
+	//
+	// Static M3DLoader vertices keep the handedness in TangentU.w.  A grid whose
+	// texture is mirrored about x = 0 has both signs, and every vertex must decode
+	// to the sign it was encoded with.
+	//
+
+	GeometryGenerator::MeshData mirrored = geoGen.CreateGrid(10.0f, 10.0f, 101, 101);
+	std::vector<M3DLoader::Vertex> m3dVertices(mirrored.Vertices.size());
+	for(size_t i = 0; i < m3dVertices.size(); ++i)
+	{
+		const GeometryGenerator::Vertex& v = mirrored.Vertices[i];
+		m3dVertices[i].Pos = v.Position;
+		m3dVertices[i].Normal = v.Normal;
+		m3dVertices[i].TexC = DirectX::XMFLOAT2(1.0f - fabsf(2.0f*v.TexC.x - 1.0f), v.TexC.y);
+	}
+	std::vector<USHORT> m3dIndices(mirrored.Indices32.begin(), mirrored.Indices32.end());
+	TangentGenerator::Generate(m3dVertices, m3dIndices, 0);
+
+	VertexStreams m3dStreams = VertexQuantizer::DescribeVertices(m3dVertices);
+	std::vector<QuantizedVertex> m3dPacked(m3dVertices.size());
+	VertexQuantizer::Encode(m3dStreams, VertexQuantizer::ComputeParams(m3dStreams), m3dPacked.data());
+
+	size_t leftHanded = 0;
+	size_t signMismatches = 0;
+	for(size_t i = 0; i < m3dVertices.size(); ++i)
+	{
+		leftHanded += m3dVertices[i].TangentU.w < 0.0f ? 1 : 0;
+		signMismatches += VertexQuantizer::DecodeTangentSign(m3dPacked[i].Position) != m3dVertices[i].TangentU.w ? 1 : 0;
+	}
+	printf("Mirrored CreateGrid as M3DLoader::Vertex: %zu vertices, %zu left-handed, %zu tangent signs changed by encoding\n\n",
+		m3dVertices.size(), leftHanded, signMismatches);
+
+	//
+	// The skinned soldier, straight from the M3DLoader vertex array.
+	//
+
+	std::vector<M3DLoader::SkinnedVertex> vertices;
+	std::vector<USHORT> indices;
+	std::vector<M3DLoader::Subset> subsets;
+	std::vector<M3DLoader::M3dMaterial> mats;
+	SkinnedData skinInfo;
+
+	M3DLoader m3dLoader;
+	if(!m3dLoader.LoadM3d(std::string(BENCH_MODELS_DIR) + "soldier.m3d", vertices, indices, subsets, mats, skinInfo))
+	{
+		printf("soldier.m3d not found, skipping the skinned vertices.\n");
+		return;
+	}
+
+	VertexStreams streams = VertexQuantizer::DescribeSkinned(vertices);
+	QuantizationParams params = VertexQuantizer::ComputeParams(streams);
+
+	std::vector<QuantizedSkinnedVertex> packed(vertices.size());
+	QuantizationError error;
+	double encodeMs = BestOfMs(5, [&]() { VertexQuantizer::Encode(streams, params, packed.data()); });
+	VertexQuantizer::Encode(streams, params, packed.data(), &error);
+
+	printf("soldier.m3d (skinned): %zu vertices, %zu -> %zu bytes (%zu -> %zu per vertex)\n",
+		vertices.size(), vertices.size()*sizeof(M3DLoader::SkinnedVertex), vertices.size()*sizeof(QuantizedSkinnedVertex),
+		sizeof(M3DLoader::SkinnedVertex), sizeof(QuantizedSkinnedVertex));
+	PrintError(error, params);
+	printf(", bone weight %.5f\n  encode %.2f ms\n", error.BoneWeight, encodeMs);
+}
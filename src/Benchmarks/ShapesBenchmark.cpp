@@ -0,0 +1,179 @@
+//***************************************************************************************
+// ShapesBenchmark.cpp
+//
+// Compares the two ways of getting GeometryGenerator shapes into an app vertex
+// layout: creating a MeshData and copying it (what the demos do), and writing
+// straight into preallocated memory with the MeshOutput overloads.  Also checks
+// that both produce the same mesh.
+//***************************************************************************************
+
+#include <cmath>
+#include "BenchmarkUtil.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Vertex layout of the lit demos.
+	struct AppVertex
+	{
+		XMFLOAT3 Pos;
+		XMFLOAT3 Normal;
+		XMFLOAT2 TexC;
+	};
+
+	struct Shape
+	{
+		const char* Name;
+		std::function<GeometryGenerator::MeshData(GeometryGenerator&)> CreateMeshData;
+		std::function<GeometryGenerator::MeshSize(GeometryGenerator&)> GetSize;
+		std::function<void(GeometryGenerator&, const GeometryGenerator::MeshOutput&)> CreateInto;
+
+		// Box and geosphere vertices come out in a different order.
+		bool SameOrder;
+	};
+
+	// Sum of the positions and of their squares, to compare meshes with different
+	// vertex orders.
+	std::pair<XMFLOAT3, XMFLOAT3> PositionMoments(const std::vector<XMFLOAT3>& positions)
+	{
+		XMVECTOR sum = XMVectorZero();
+		XMVECTOR sumSq = XMVectorZero();
+		for(const XMFLOAT3& p : positions)
+		{
+			XMVECTOR v = XMLoadFloat3(&p);
+			sum += v;
+			sumSq += v*v;
+		}
+
+		std::pair<XMFLOAT3, XMFLOAT3> result;
+		XMStoreFloat3(&result.first, sum);
+		XMStoreFloat3(&result.second, sumSq);
+		return result;
+	}
+
+	bool NearlyEqual(const XMFLOAT3& a, const XMFLOAT3& b, float tolerance)
+	{
+		return fabsf(a.x - b.x) <= tolerance && fabsf(a.y - b.y) <= tolerance && fabsf(a.z - b.z) <= tolerance;
+	}
+
+	template<typename IndexT>
+	double SurfaceArea(const std::vector<XMFLOAT3>& positions, const IndexT* indices, size_t indexCount)
+	{
+		double area = 0.0;
+		for(size_t i = 0; i < indexCount; i += 3)
+		{
+			XMVECTOR p0 = XMLoadFloat3(&positions[indices[i+0]]);
+			XMVECTOR p1 = XMLoadFloat3(&positions[indices[i+1]]);
+			XMVECTOR p2 = XMLoadFloat3(&positions[indices[i+2]]);
+			area += 0.5 * XMVectorGetX(XMVector3Length(XMVector3Cross(p1 - p0, p2 - p0)));
+		}
+		return area;
+	}
+}
+
+void RunShapesBenchmark()
+{
+	using MeshOutput = GeometryGenerator::MeshOutput;
+
+	const Shape shapes[] =
+	{
+		{ "box(5)",
+		  [](GeometryGenerator& g) { return g.CreateBox(1.5f, 0.5f, 1.5f, 5); },
+		  [](GeometryGenerator& g) { return g.GetBoxSize(5); },
+		  [](GeometryGenerator& g, const MeshOutput& o) { g.CreateBox(1.5f, 0.5f, 1.5f, 5, o); }, false },
+		{ "sphere(200x200)",
+		  [](GeometryGenerator& g) { return g.CreateSphere(0.5f, 200, 200); },
+		  [](GeometryGenerator& g) { return g.GetSphereSize(200, 200); },
+		  [](GeometryGenerator& g, const MeshOutput& o) { g.CreateSphere(0.5f, 200, 200, o); }, true },
+		{ "geosphere(6)",
+		  [](GeometryGenerator& g) { return g.CreateGeosphere(0.5f, 6); },
+		  [](GeometryGenerator& g) { return g.GetGeosphereSize(6); },
+		  [](GeometryGenerator& g, const MeshOutput& o) { g.CreateGeosphere(0.5f, 6, o); }, false },
+		{ "cylinder(200x100)",
+		  [](GeometryGenerator& g) { return g.CreateCylinder(0.5f, 0.3f, 3.0f, 200, 100); },
+		  [](GeometryGenerator& g) { return g.GetCylinderSize(200, 100); },
+		  [](GeometryGenerator& g, const MeshOutput& o) { g.CreateCylinder(0.5f, 0.3f, 3.0f, 200, 100, o); }, true },
+		{ "grid(250x250)",
+		  [](GeometryGenerator& g) { return g.CreateGrid(160.0f, 160.0f, 250, 250); },
+		  [](GeometryGenerator& g) { return g.GetGridSize(250, 250); },
+		  [](GeometryGenerator& g, const MeshOutput& o) { g.CreateGrid(160.0f, 160.0f, 250, 250, o); }, true },
+	};
+
+	GeometryGenerator geoGen;
+
+	for(const Shape& shape : shapes)
+	{
+		//
+		// What the demos do: MeshData, copy to the app layout, GetIndices16.
+		//
+
+		std::vector<AppVertex> copiedVertices;
+		std::vector<std::uint16_t> copiedIndices;
+		double copyMs = BestOfMs(5, [&]()
+		{
+			GeometryGenerator::MeshData mesh = shape.CreateMeshData(geoGen);
+
+			copiedVertices.resize(mesh.Vertices.size());
+			for(size_t i = 0; i < mesh.Vertices.size(); ++i)
+			{
+				copiedVertices[i].Pos = mesh.Vertices[i].Position;
+				copiedVertices[i].Normal = mesh.Vertices[i].Normal;
+				copiedVertices[i].TexC = mesh.Vertices[i].TexC;
+			}
+
+			copiedIndices = mesh.GetIndices16();
+		});
+
+		//
+		// Straight into (already allocated) app memory.
+		//
+
+		GeometryGenerator::MeshSize size = shape.GetSize(geoGen);
+		std::vector<AppVertex> vertices(size.VertexCount);
+		std::vector<std::uint16_t> indices(size.IndexCount);
+
+		MeshOutput output;
+		output.Positions = &vertices[0].Pos;
+		output.Normals = &vertices[0].Normal;
+		output.TexC = &vertices[0].TexC;
+		output.VertexStride = sizeof(AppVertex);
+		output.Indices16 = indices.data();
+
+		double directMs = BestOfMs(5, [&]() { shape.CreateInto(geoGen, output); });
+
+		//
+		// Check they match.
+		//
+
+		std::vector<XMFLOAT3> copiedPositions, positions;
+		for(const AppVertex& v : copiedVertices) copiedPositions.push_back(v.Pos);
+		for(const AppVertex& v : vertices) positions.push_back(v.Pos);
+
+		bool same;
+		if(shape.SameOrder)
+		{
+			same = copiedIndices == indices;
+			for(size_t i = 0; same && i < vertices.size(); ++i)
+			{
+				same = memcmp(&vertices[i], &copiedVertices[i], sizeof(AppVertex)) == 0;
+			}
+		}
+		else
+		{
+			double area0 = SurfaceArea(copiedPositions, copiedIndices.data(), copiedIndices.size());
+			double area1 = SurfaceArea(positions, indices.data(), indices.size());
+			auto moments0 = PositionMoments(copiedPositions);
+			auto moments1 = PositionMoments(positions);
+			float tolerance = 1e-5f * positions.size();
+
+			same = copiedIndices.size() == indices.size() && copiedPositions.size() == positions.size() &&
+				NearlyEqual(moments0.first, moments1.first, tolerance) &&
+				NearlyEqual(moments0.second, moments1.second, tolerance) &&
+				fabs(area0 - area1) <= 1e-5 * area0;
+		}
+
+		printf("%-18s %7u vertices %8u indices: MeshData + copy %7.2f ms, direct %7.2f ms (%.1fx), same mesh: %s\n",
+			shape.Name, size.VertexCount, size.IndexCount, copyMs, directMs, copyMs / directMs, same ? "yes" : "NO");
+	}
+}
@@ -0,0 +1,209 @@
+//***************************************************************************************
+// StreamingBenchmark.cpp
+//
+// Runs TextureResidency through a camera flight over a 32x32 grid of objects
+// textured from 256 BC1 textures of 256 to 2048 texels, with file reads simulated
+// at a fixed bandwidth.  For several budgets it reports the loads and evictions,
+// the most bytes ever resident, how sharp the requested textures were on average
+// and in the worst frame after the first second (resident texels over wanted
+// texels), and the CPU time of a frame's requests plus Update.  Also compares the
+// startup bytes of the mip tails with the bytes of every full chain.
+//***************************************************************************************
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <random>
+#include "BenchmarkUtil.h"
+#include "../Common/TextureResidency.h"
+
+namespace
+{
+	typedef std::uint32_t uint32;
+	typedef std::uint64_t uint64;
+
+	const uint32 NumTextures = 256;
+	const uint32 GridSize = 32;
+	const float GridSpacing = 10.0f;
+	const float ObjectSize = 4.0f;
+	const float ViewDistance = 150.0f;
+	const float FovY = 0.25f*3.14159265f;
+	const float ViewportHeight = 1080.0f;
+	const uint32 TailSize = 64;
+	const uint32 NumFrames = 3000;
+
+	// The worst frame is taken after the first second, once the start-up loads
+	// have had time to arrive.
+	const uint32 WarmUpFrames = 60;
+
+	// Read bandwidth per frame: 200 MB/s at 60 frames a second.
+	const uint64 BytesPerFrame = (200ull << 20) / 60;
+
+	struct SimTexture
+	{
+		uint32 Size;
+		std::vector<uint64> MipBytes;
+		uint32 TailMip;
+	};
+
+	struct SimObject
+	{
+		float X, Z;
+		uint32 Texture;
+	};
+
+	struct Result
+	{
+		uint64 Loads = 0;
+		uint64 Evictions = 0;
+		uint64 PeakBytes = 0;
+		double MeanSharpness = 0.0;
+		float WorstSharpness = 1.0f;
+		double UsPerFrame = 0.0;
+	};
+
+	std::vector<SimTexture> MakeTextures()
+	{
+		std::mt19937 rng(7);
+		std::vector<SimTexture> textures(NumTextures);
+		for(SimTexture& tex : textures)
+		{
+			tex.Size = 256u << (rng() % 4);
+			tex.TailMip = 0;
+
+			// BC1: 8 bytes per 4x4 block.
+			for(uint32 size = tex.Size; ; size /= 2)
+			{
+				uint64 blocks = (std::max)(1u, size / 4);
+				tex.MipBytes.push_back(8*blocks*blocks);
+				if(size > TailSize)
+					++tex.TailMip;
+				if(size == 1)
+					break;
+			}
+		}
+
+		return textures;
+	}
+
+	std::vector<SimObject> MakeObjects()
+	{
+		std::mt19937 rng(11);
+		std::vector<SimObject> objects;
+		for(uint32 z = 0; z < GridSize; ++z)
+		{
+			for(uint32 x = 0; x < GridSize; ++x)
+				objects.push_back({ x*GridSpacing, z*GridSpacing, (uint32)(rng() % NumTextures) });
+		}
+
+		return objects;
+	}
+
+	Result Simulate(const std::vector<SimTexture>& textures, const std::vector<SimObject>& objects, uint64 budget)
+	{
+		TextureResidency::Settings settings;
+		settings.BudgetBytes = budget;
+		settings.MaxPendingLoads = 16;
+		TextureResidency residency(settings);
+
+		for(const SimTexture& tex : textures)
+			residency.AddTexture(tex.Size, tex.Size, tex.MipBytes, tex.TailMip);
+
+		// Reads complete in order, as fast as the bandwidth allows.
+		std::deque<TextureResidency::Load> reads;
+		uint64 readCredit = 0;
+
+		std::vector<TextureResidency::Load> loads;
+		std::vector<TextureResidency::Eviction> evictions;
+
+		Result result;
+		double cpuMs = 0.0;
+		const float extent = (GridSize - 1)*GridSpacing;
+
+		for(uint32 frame = 0; frame < NumFrames; ++frame)
+		{
+			// Back and forth along a winding path across the grid, 2 m above it.
+			float t = (float)frame / NumFrames;
+			float eyeX = 0.5f*extent + 0.45f*extent*sinf(6.2831853f*t);
+			float eyeZ = extent*(0.5f - 0.5f*cosf(6.2831853f*2.0f*t));
+			const float eyeY = 2.0f;
+
+			readCredit += BytesPerFrame;
+			while(!reads.empty() && readCredit >= reads.front().Bytes)
+			{
+				readCredit -= reads.front().Bytes;
+				residency.CompleteLoad(reads.front().Texture);
+				reads.pop_front();
+			}
+			if(reads.empty())
+				readCredit = 0;
+
+			Stopwatch timer;
+			for(const SimObject& obj : objects)
+			{
+				float dx = obj.X - eyeX;
+				float dz = obj.Z - eyeZ;
+				float distance = sqrtf(dx*dx + dz*dz + eyeY*eyeY);
+				if(distance > ViewDistance)
+					continue;
+
+				float screenSize = TextureResidency::ScreenSize(ObjectSize, distance, FovY, ViewportHeight);
+				residency.Request(obj.Texture, screenSize, distance);
+			}
+
+			loads.clear();
+			evictions.clear();
+			residency.Update(loads, evictions);
+			cpuMs += timer.ElapsedMs();
+
+			reads.insert(reads.end(), loads.begin(), loads.end());
+
+			const TextureResidency::Stats& stats = residency.GetStats();
+			result.PeakBytes = (std::max)(result.PeakBytes, stats.ResidentBytes + stats.PendingBytes);
+			result.MeanSharpness += stats.Sharpness;
+			if(frame >= WarmUpFrames)
+				result.WorstSharpness = (std::min)(result.WorstSharpness, stats.Sharpness);
+		}
+
+		const TextureResidency::Stats& stats = residency.GetStats();
+		result.Loads = stats.LoadsIssued;
+		result.Evictions = stats.Evictions;
+		result.MeanSharpness /= NumFrames;
+		result.UsPerFrame = 1000.0*cpuMs / NumFrames;
+		return result;
+	}
+}
+
+void RunStreamingBenchmark()
+{
+	const std::vector<SimTexture> textures = MakeTextures();
+	const std::vector<SimObject> objects = MakeObjects();
+
+	uint64 tailBytes = 0;
+	uint64 fullBytes = 0;
+	for(const SimTexture& tex : textures)
+	{
+		for(uint32 mip = 0; mip < (uint32)tex.MipBytes.size(); ++mip)
+		{
+			fullBytes += tex.MipBytes[mip];
+			if(mip >= tex.TailMip)
+				tailBytes += tex.MipBytes[mip];
+		}
+	}
+
+	printf("%u textures, %u objects, %u frames, reads at 200 MB/s\n",
+		NumTextures, (uint32)objects.size(), NumFrames);
+	printf("Startup: mip tails %.2f MB, full chains %.1f MB\n",
+		tailBytes / 1048576.0, fullBytes / 1048576.0);
+	printf("%-10s %8s %10s %10s %10s %8s %12s\n",
+		"budget MB", "loads", "evictions", "peak MB", "sharpness", "worst", "us/frame");
+
+	const uint64 budgetsMb[] = { 16, 32, 64, 128, 1024 };
+	for(uint64 mb : budgetsMb)
+	{
+		Result r = Simulate(textures, objects, mb << 20);
+		printf("%-10llu %8llu %10llu %10.1f %9.1f%% %7.1f%% %12.1f\n",
+			(unsigned long long)mb, (unsigned long long)r.Loads, (unsigned long long)r.Evictions,
+			r.PeakBytes / 1048576.0, 100.0*r.MeanSharpness, 100.0f*r.WorstSharpness, r.UsPerFrame);
+	}
+}
@@ -0,0 +1,119 @@
+//***************************************************************************************
+// TerrainBenchmark.cpp
+//
+// Builds a large hills terrain (the GetHillsHeight function of the LandAndWaves
+// demos) as one CreateGrid MeshData and as parallel CreateGridTiles tiles, and
+// checks that the tiles are 16-bit indexable and that their bounds hold their
+// vertices.
+//***************************************************************************************
+
+#include <cmath>
+#include "BenchmarkUtil.h"
+#include "../Common/ParallelFor.h"
+
+using namespace DirectX;
+
+namespace
+{
+	struct TerrainVertex
+	{
+		XMFLOAT3 Pos;
+		XMFLOAT3 Normal;
+		XMFLOAT2 TexC;
+	};
+
+	float GetHillsHeight(float x, float z)
+	{
+		return 0.3f*(z*sinf(0.1f*x) + x*cosf(0.1f*z));
+	}
+}
+
+void RunTerrainBenchmark()
+{
+	// 2k x 2k samples keeps the benchmark quick; the tiles scale the same way to
+	// 8k x 8k.
+	const GeometryGenerator::uint32 samples = 2049;
+	const float size = 1600.0f;
+
+	GeometryGenerator geoGen;
+
+	//
+	// One MeshData, then the height applied per vertex like the demos do.
+	//
+
+	double gridMs = BestOfMs(3, [&]()
+	{
+		GeometryGenerator::MeshData grid = geoGen.CreateGrid(size, size, samples, samples);
+
+		std::vector<TerrainVertex> vertices(grid.Vertices.size());
+		for(size_t i = 0; i < grid.Vertices.size(); ++i)
+		{
+			const XMFLOAT3& p = grid.Vertices[i].Position;
+			vertices[i].Pos = XMFLOAT3(p.x, GetHillsHeight(p.x, p.z), p.z);
+			vertices[i].TexC = grid.Vertices[i].TexC;
+		}
+	});
+
+	printf("CreateGrid(%u x %u) + height: %.1f ms, %u vertices need 32-bit indices\n",
+		samples, samples, gridMs, samples*samples);
+
+	//
+	// Tiles.
+	//
+
+	GeometryGenerator::MeshSize meshSize = geoGen.GetGridTilesSize(samples, samples, GeometryGenerator::MaxGridTileQuads);
+
+	std::vector<TerrainVertex> vertices(meshSize.VertexCount);
+	std::vector<std::uint16_t> indices(meshSize.IndexCount);
+
+	GeometryGenerator::MeshOutput output;
+	output.Positions = &vertices[0].Pos;
+	output.Normals = &vertices[0].Normal;
+	output.TexC = &vertices[0].TexC;
+	output.VertexStride = sizeof(TerrainVertex);
+	output.Indices16 = indices.data();
+
+	unsigned maxThreads = ResolveThreadCount(0);
+	std::vector<GeometryGenerator::GridTile> tiles;
+
+	for(unsigned numThreads : { 1u, maxThreads })
+	{
+		double tilesMs = BestOfMs(3, [&]()
+		{
+			tiles = geoGen.CreateGridTiles(size, size, samples, samples, GeometryGenerator::MaxGridTileQuads,
+				output, GetHillsHeight, numThreads);
+		});
+
+		printf("CreateGridTiles, %u thread(s): %.1f ms, %zu tiles, %u vertices (%.2f%% duplicated on tile borders)\n",
+			numThreads, tilesMs, tiles.size(), meshSize.VertexCount,
+			100.0 * (meshSize.VertexCount - samples*samples) / (samples*samples));
+
+		if(maxThreads == 1)
+			break;
+	}
+
+	//
+	// Check the tiles.
+	//
+
+	bool indicesFit = true;
+	bool boundsHold = true;
+	float maxHeightError = 0.0f;
+	for(const GeometryGenerator::GridTile& tile : tiles)
+	{
+		indicesFit = indicesFit && tile.VertexCount <= 65536;
+
+		for(GeometryGenerator::uint32 i = 0; i < tile.IndexCount; ++i)
+			indicesFit = indicesFit && indices[tile.FirstIndex + i] < tile.VertexCount;
+
+		for(GeometryGenerator::uint32 v = 0; v < tile.VertexCount; ++v)
+		{
+			const XMFLOAT3& p = vertices[tile.FirstVertex + v].Pos;
+			boundsHold = boundsHold && tile.Bounds.Contains(XMLoadFloat3(&p)) != DISJOINT;
+			maxHeightError = std::max(maxHeightError, fabsf(p.y - GetHillsHeight(p.x, p.z)));
+		}
+	}
+
+	printf("tile indices fit in 16 bits: %s, bounds hold their vertices: %s, max height error %g\n",
+		indicesFit ? "yes" : "NO", boundsHold ? "yes" : "NO", maxHeightError);
+}
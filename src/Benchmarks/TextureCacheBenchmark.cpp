@@ -0,0 +1,345 @@
+//***************************************************************************************
+// TextureCacheBenchmark.cpp
+//
+// Runs TextureCache with an in-memory Factory, so there are no files and no
+// device.  Checks that spellings of one path share a texture, that a path
+// acquired again while it is being read is read once, that copies of a file
+// under other names share one resource but files whose hashes merely collide
+// don't, that the CPU and the GPU budget each evict unused textures least
+// recently used first and never one in use, that every resource is retired
+// exactly once, and that files that can't be read or made into textures fail.
+// Then times Acquire of cached paths.
+//***************************************************************************************
+
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+#include "BenchmarkUtil.h"
+#include "../Common/AsyncLoader.h"
+#include "../Common/TextureCache.h"
+
+namespace
+{
+	typedef TextureCache::uint8 uint8;
+	typedef TextureCache::uint64 uint64;
+
+	// Files are bytes in a map.  A texture takes the file's size in CPU bytes and
+	// twice that in GPU bytes; an empty file can't be made into one.
+	class MemoryFactory : public TextureCache::Factory
+	{
+	public:
+		std::unordered_map<std::string, std::vector<uint8>> Files;
+
+		bool Read(const std::string& path, std::vector<uint8>& bytes, std::string& error) override
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			++mReads[path];
+			mOpened.wait(lock, [this]() { return !mHeld; });
+
+			auto it = Files.find(path);
+			if(it == Files.end())
+			{
+				error = path + " not found";
+				return false;
+			}
+
+			bytes = it->second;
+			return true;
+		}
+
+		bool Create(const std::string& path, const std::vector<uint8>& bytes,
+			TextureCache::Created& created, std::string& error) override
+		{
+			if(bytes.empty())
+			{
+				error = path + " is empty";
+				return false;
+			}
+
+			created.Resource = std::make_shared<std::string>(path);
+			created.CpuBytes = bytes.size();
+			created.GpuBytes = 2*bytes.size();
+			++Creates;
+			return true;
+		}
+
+		void Retire(std::shared_ptr<void> resource) override
+		{
+			Retired.push_back(*static_cast<std::string*>(resource.get()));
+			++mRetires[resource.get()];
+		}
+
+		// Reads wait while held, so the files stay in flight.
+		void Hold()
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mHeld = true;
+		}
+
+		void Release()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mHeld = false;
+			}
+			mOpened.notify_all();
+		}
+
+		int Reads(const std::string& path)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			return mReads[path];
+		}
+
+		// No resource was retired twice.
+		bool RetiredOnce()const
+		{
+			for(const auto& entry : mRetires)
+			{
+				if(entry.second != 1)
+					return false;
+			}
+
+			return true;
+		}
+
+		int Creates = 0;
+
+		// The path each retired resource was made from, in order.
+		std::vector<std::string> Retired;
+
+	private:
+		std::mutex mMutex;
+		std::condition_variable mOpened;
+		bool mHeld = false;
+		std::unordered_map<std::string, int> mReads;
+		std::unordered_map<const void*, int> mRetires;
+	};
+
+	std::vector<uint8> FileBytes(size_t size, uint8 seed)
+	{
+		std::vector<uint8> bytes(size);
+		for(size_t i = 0; i < size; ++i)
+			bytes[i] = (uint8)(seed*31 + i*7);
+
+		return bytes;
+	}
+
+	const char* YesNo(bool b)
+	{
+		return b ? "yes" : "NO";
+	}
+
+	void CheckPaths()
+	{
+		MemoryFactory factory;
+		factory.Files["tex/bricks.dds"] = FileBytes(256, 1);
+
+		TextureCache cache(factory, nullptr, TextureCache::Settings());
+		TextureCache::Handle a = cache.Acquire("tex/bricks.dds");
+		TextureCache::Handle b = cache.Acquire("tex\\.\\bricks.dds");
+		TextureCache::Handle c = cache.Acquire("tex/sub/../bricks.dds");
+		cache.Flush();
+
+		bool ok = a == b && a == c && a->Status == TextureCache::State::Ready &&
+			factory.Reads("tex/bricks.dds") == 1 && factory.Creates == 1 &&
+			cache.GetStats().Misses == 1 && cache.GetStats().Hits == 2;
+		printf("Canonical paths share a texture: %s\n", YesNo(ok));
+	}
+
+	void CheckInFlight()
+	{
+		MemoryFactory factory;
+		factory.Files["tex/stone.dds"] = FileBytes(256, 2);
+
+		AsyncLoader loader(4);
+		TextureCache cache(factory, &loader, TextureCache::Settings());
+
+		factory.Hold();
+		std::vector<TextureCache::Handle> handles;
+		for(int i = 0; i < 8; ++i)
+			handles.push_back(cache.Acquire(i % 2 == 0 ? "tex/stone.dds" : "./tex/stone.dds"));
+
+		// Nothing has been read yet, so Update makes nothing.
+		cache.Update();
+		bool loading = handles[0]->Status == TextureCache::State::Loading && cache.GetStats().Loading == 1;
+
+		factory.Release();
+		cache.Flush();
+
+		bool ok = loading && handles[0]->Status == TextureCache::State::Ready &&
+			factory.Reads("tex/stone.dds") == 1 && factory.Creates == 1;
+		for(const TextureCache::Handle& h : handles)
+			ok = ok && h == handles[0];
+		printf("Acquires while in flight read once: %s\n", YesNo(ok));
+	}
+
+	void CheckContent()
+	{
+		MemoryFactory factory;
+		factory.Files["tex/grass.dds"] = FileBytes(512, 3);
+		factory.Files["copy/grass.dds"] = FileBytes(512, 3);
+		factory.Files["tex/sand.dds"] = FileBytes(512, 4);
+
+		TextureCache cache(factory, nullptr, TextureCache::Settings());
+		TextureCache::Handle grass = cache.Acquire("tex/grass.dds");
+		cache.Flush();
+		TextureCache::Handle copy = cache.Acquire("copy/grass.dds");
+		TextureCache::Handle sand = cache.Acquire("tex/sand.dds");
+		cache.Flush();
+
+		bool shared = grass != copy && grass->Resource == copy->Resource && sand->Resource != grass->Resource &&
+			factory.Creates == 2 && cache.GetStats().Resources == 2 && cache.GetStats().ContentHits == 1 &&
+			cache.GetStats().GpuBytes == 2*512*2;
+
+		// The resource outlives the first path that shares it.
+		grass.reset();
+		cache.Clear();
+		bool kept = factory.Retired.empty() && copy->Resource != nullptr;
+
+		copy.reset();
+		sand.reset();
+		cache.Clear();
+		bool ok = shared && kept && factory.Retired.size() == 2 && factory.RetiredOnce() &&
+			cache.GetStats().Entries == 0 && cache.GetStats().Resources == 0;
+		printf("Copies share a resource, retired once: %s\n", YesNo(ok));
+	}
+
+	// Two 8 byte files whose FNV-1a 64 hashes are both 0x4012ccf184a429a9.
+	void CheckCollision()
+	{
+		const uint64 values[] = { 0x6b8787e1c1f63a81ull, 0x50079d0fe90ff158ull };
+
+		MemoryFactory factory;
+		for(int i = 0; i < 2; ++i)
+		{
+			std::vector<uint8> bytes(8);
+			for(int b = 0; b < 8; ++b)
+				bytes[b] = (uint8)(values[i] >> (8*b));
+			factory.Files["tex/c" + std::to_string(i) + ".dds"] = bytes;
+		}
+
+		TextureCache cache(factory, nullptr, TextureCache::Settings());
+		TextureCache::Handle a = cache.Acquire("tex/c0.dds");
+		cache.Flush();
+		TextureCache::Handle b = cache.Acquire("tex/c1.dds");
+		cache.Flush();
+
+		bool ok = TextureCache::HashBytes(factory.Files["tex/c0.dds"]) == TextureCache::HashBytes(factory.Files["tex/c1.dds"]) &&
+			a->ContentHash == b->ContentHash && a->Resource != b->Resource && factory.Creates == 2 &&
+			cache.GetStats().Resources == 2 && cache.GetStats().ContentHits == 0;
+
+		a.reset();
+		b.reset();
+		cache.Clear();
+		ok = ok && factory.Retired.size() == 2 && factory.RetiredOnce() && cache.GetStats().Resources == 0;
+		printf("Colliding hashes get their own resource: %s\n", YesNo(ok));
+	}
+
+	// Six 1000 byte textures are last used in the order 3, 0, 5, 1, 4, 2, then
+	// trimmed to a budget of three while texture 0 is held.
+	bool CheckEviction(bool cpuBudget)
+	{
+		MemoryFactory factory;
+		std::vector<std::string> paths;
+		for(int i = 0; i < 6; ++i)
+		{
+			paths.push_back("tex/t" + std::to_string(i) + ".dds");
+			factory.Files[paths.back()] = FileBytes(1000, (uint8)(10 + i));
+		}
+
+		TextureCache cache(factory, nullptr, TextureCache::Settings());
+		for(const std::string& path : paths)
+			cache.Acquire(path);
+		cache.Flush();
+
+		const int order[] = { 3, 0, 5, 1, 4, 2 };
+		for(int i : order)
+			cache.Acquire(paths[i]);
+
+		TextureCache::Handle held = cache.Acquire(paths[0]);
+
+		TextureCache::Settings settings;
+		if(cpuBudget)
+			settings.CpuBudgetBytes = 3*1000;
+		else
+			settings.GpuBudgetBytes = 3*2000;
+		cache.SetSettings(settings);
+		cache.Trim();
+
+		const std::vector<std::string> expected = { paths[3], paths[5], paths[1] };
+		bool ok = factory.Retired == expected && factory.RetiredOnce() && cache.GetStats().Entries == 3 &&
+			cache.GetStats().Evictions == 3 && held->Status == TextureCache::State::Ready;
+
+		held.reset();
+		cache.Clear();
+		return ok && factory.Retired.size() == 6 && factory.RetiredOnce();
+	}
+
+	void CheckFailures()
+	{
+		MemoryFactory factory;
+		factory.Files["tex/empty.dds"] = std::vector<uint8>();
+
+		AsyncLoader loader(2);
+		TextureCache cache(factory, &loader, TextureCache::Settings());
+		TextureCache::Handle missing = cache.Acquire("tex/missing.dds");
+		TextureCache::Handle empty = cache.Acquire("tex/empty.dds");
+		cache.Flush();
+
+		bool failed = missing->Status == TextureCache::State::Failed && !missing->Error.empty() &&
+			empty->Status == TextureCache::State::Failed && !empty->Error.empty() &&
+			missing->Resource == nullptr && cache.GetStats().Failures == 2;
+
+		// A failed path stays failed until it is evicted, and isn't read again.
+		bool cached = cache.Acquire("tex/missing.dds") == missing && factory.Reads("tex/missing.dds") == 1;
+
+		missing.reset();
+		empty.reset();
+		cache.Clear();
+		bool ok = failed && cached && cache.GetStats().Entries == 0 && factory.Retired.empty();
+		printf("Unreadable and bad files fail: %s\n", YesNo(ok));
+	}
+
+	void TimeHits()
+	{
+		const int NumTextures = 1024;
+		const int Rounds = 200;
+
+		MemoryFactory factory;
+		std::vector<std::string> paths;
+		for(int i = 0; i < NumTextures; ++i)
+		{
+			paths.push_back("../../Textures/set" + std::to_string(i % 16) + "/texture" + std::to_string(i) + ".dds");
+			factory.Files[TextureCache::CanonicalPath(paths.back())] = FileBytes(64, (uint8)i);
+		}
+
+		TextureCache cache(factory, nullptr, TextureCache::Settings());
+		for(const std::string& path : paths)
+			cache.Acquire(path);
+		cache.Flush();
+
+		double ms = BestOfMs(3, [&]()
+		{
+			for(int r = 0; r < Rounds; ++r)
+			{
+				for(const std::string& path : paths)
+					cache.Acquire(path);
+			}
+		});
+
+		printf("Acquire of a cached path: %.0f ns (%d textures)\n", 1.0e6*ms / ((double)Rounds*NumTextures), NumTextures);
+	}
+}
+
+void RunTextureCacheBenchmark()
+{
+	CheckPaths();
+	CheckInFlight();
+	CheckContent();
+	CheckCollision();
+	printf("LRU eviction under the CPU budget: %s\n", YesNo(CheckEviction(true)));
+	printf("LRU eviction under the GPU budget: %s\n", YesNo(CheckEviction(false)));
+	CheckFailures();
+	TimeHits();
+}
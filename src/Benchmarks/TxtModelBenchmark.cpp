@@ -0,0 +1,160 @@
+//***************************************************************************************
+// TxtModelBenchmark.cpp
+//
+// Compares TxtModelLoader with the std::ifstream parsing the demos' BuildSkullGeometry
+// used, on Skull.txt, Car.txt and a generated model of a million vertices: load
+// time with one thread and with every hardware thread, that the vertices, indices
+// and bounds match exactly, and that malformed files are rejected.
+//***************************************************************************************
+
+#include <cstring>
+#include <fstream>
+#include "BenchmarkUtil.h"
+#include "../Common/BoundingVolumes.h"
+#include "../Common/ParallelFor.h"
+#include "../Common/TxtModelLoader.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// The loop the demos used.
+	bool IfstreamLoad(const std::string& filename, GeometryGenerator::MeshData& meshData)
+	{
+		std::ifstream fin(filename);
+		if(!fin)
+			return false;
+
+		GeometryGenerator::uint32 vcount = 0;
+		GeometryGenerator::uint32 tcount = 0;
+		std::string ignore;
+
+		fin >> ignore >> vcount;
+		fin >> ignore >> tcount;
+		fin >> ignore >> ignore >> ignore >> ignore;
+
+		meshData.Vertices.assign(vcount, GeometryGenerator::Vertex(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f));
+		for(GeometryGenerator::uint32 i = 0; i < vcount; ++i)
+		{
+			auto& v = meshData.Vertices[i];
+			fin >> v.Position.x >> v.Position.y >> v.Position.z;
+			fin >> v.Normal.x >> v.Normal.y >> v.Normal.z;
+		}
+
+		fin >> ignore;
+		fin >> ignore;
+		fin >> ignore;
+
+		meshData.Indices32.resize(3*tcount);
+		for(GeometryGenerator::uint32 i = 0; i < tcount; ++i)
+			fin >> meshData.Indices32[i*3+0] >> meshData.Indices32[i*3+1] >> meshData.Indices32[i*3+2];
+
+		return !fin.fail();
+	}
+
+	bool SameMesh(const GeometryGenerator::MeshData& a, const GeometryGenerator::MeshData& b)
+	{
+		if(a.Vertices.size() != b.Vertices.size() || a.Indices32 != b.Indices32)
+			return false;
+
+		for(size_t i = 0; i < a.Vertices.size(); ++i)
+		{
+			if(memcmp(&a.Vertices[i].Position, &b.Vertices[i].Position, sizeof(XMFLOAT3)) != 0 ||
+				memcmp(&a.Vertices[i].Normal, &b.Vertices[i].Normal, sizeof(XMFLOAT3)) != 0)
+				return false;
+		}
+
+		return true;
+	}
+
+	void RunFile(const std::string& name, const std::string& filename, int numRuns)
+	{
+		unsigned numThreads = ResolveThreadCount(0);
+
+		GeometryGenerator::MeshData reference;
+		if(!IfstreamLoad(filename, reference))
+		{
+			printf("%s not found, skipping.\n", name.c_str());
+			return;
+		}
+
+		GeometryGenerator::MeshData serial, parallel, threes;
+		BoundingBox serialBounds, parallelBounds;
+
+		double ifstreamMs = BestOfMs(numRuns, [&]() { IfstreamLoad(filename, reference); });
+		double serialMs = BestOfMs(numRuns, [&]() { TxtModelLoader::Load(filename, serial, &serialBounds, 1); });
+		double parallelMs = BestOfMs(numRuns, [&]() { TxtModelLoader::Load(filename, parallel, &parallelBounds, numThreads); });
+		TxtModelLoader::Load(filename, threes, nullptr, 3);
+
+		const auto& v = reference.Vertices;
+		BoundingBox expectedBounds = BoundingVolumes::ComputeAabb(&v[0].Position, sizeof(GeometryGenerator::Vertex), v.size());
+		bool sameBounds =
+			memcmp(&serialBounds, &expectedBounds, sizeof(BoundingBox)) == 0 &&
+			memcmp(&parallelBounds, &expectedBounds, sizeof(BoundingBox)) == 0;
+
+		printf("%s: %zu vertices, %zu triangles\n", name.c_str(), v.size(), reference.Indices32.size() / 3);
+		printf("  ifstream %.2f ms, 1 thread %.2f ms (%.1fx), %u threads %.2f ms (%.1fx)\n",
+			ifstreamMs, serialMs, ifstreamMs / serialMs, numThreads, parallelMs, ifstreamMs / parallelMs);
+		printf("  same as ifstream for 1/3/%u threads: %s, same bounds as ComputeAabb: %s\n", numThreads,
+			SameMesh(reference, serial) && SameMesh(reference, parallel) && SameMesh(reference, threes) ? "yes" : "NO",
+			sameBounds ? "yes" : "NO");
+	}
+
+	void WriteModel(const std::string& filename, const GeometryGenerator::MeshData& meshData)
+	{
+		std::ofstream fout(filename);
+		fout << "VertexCount: " << meshData.Vertices.size() << "\n";
+		fout << "TriangleCount: " << meshData.Indices32.size() / 3 << "\n";
+		fout << "VertexList (pos, normal)\n{\n";
+		for(const auto& v : meshData.Vertices)
+		{
+			fout << "\t" << v.Position.x << " " << v.Position.y << " " << v.Position.z << " "
+				<< v.Normal.x << " " << v.Normal.y << " " << v.Normal.z << "\n";
+		}
+		fout << "}\nTriangleList\n{\n";
+		for(size_t i = 0; i < meshData.Indices32.size(); i += 3)
+			fout << "\t" << meshData.Indices32[i] << " " << meshData.Indices32[i+1] << " " << meshData.Indices32[i+2] << "\n";
+		fout << "}\n";
+	}
+
+	bool Rejects(const std::string& filename, const char* contents)
+	{
+		{
+			std::ofstream fout(filename);
+			fout << contents;
+		}
+
+		GeometryGenerator::MeshData meshData;
+		return !TxtModelLoader::Load(filename, meshData);
+	}
+}
+
+void RunTxtModelBenchmark()
+{
+	const char* models[] = { "Skull.txt", "Car.txt" };
+	for(const char* name : models)
+		RunFile(name, std::string(BENCH_MODELS_DIR) + name, 10);
+
+	//
+	// A large model, written in the same format and precision as the shipped ones.
+	//
+
+	const std::string tempFile = "TxtModelBenchmark.tmp";
+
+	GeometryGenerator geoGen;
+	WriteModel(tempFile, geoGen.CreateSphere(3.0f, 1024, 1024));
+	RunFile("CreateSphere(3, 1024, 1024)", tempFile, 3);
+
+	//
+	// Malformed files.
+	//
+
+	bool rejected =
+		Rejects(tempFile, "VertexCount: 2\nTriangleCount: 0\nVertexList (pos, normal)\n{\n0 0 0 0 1 0\n}\nTriangleList\n{\n}\n") &&
+		Rejects(tempFile, "VertexCount: 1\nTriangleCount: 1\nVertexList (pos, normal)\n{\n0 0 0 0 1 0\n}\nTriangleList\n{\n0 0 1\n}\n") &&
+		Rejects(tempFile, "VertexCount: 1\nTriangleCount: 0\nVertexList (pos, normal)\n{\n0 0 x 0 1 0\n}\nTriangleList\n{\n}\n") &&
+		Rejects(tempFile, "VertexCount: 1\nTriangleCount: 0\nVertexList (pos, normal)\n{\n0 0 0 0 1 0\n");
+	printf("Malformed files rejected: %s\n", rejected ? "yes" : "NO");
+
+	remove(tempFile.c_str());
+}
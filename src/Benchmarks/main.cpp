@@ -0,0 +1,88 @@
+﻿//***************************************************************************************
+// main.cpp
+//
+// Console entry point for the CPU benchmarks.  Run with no arguments to run every
+// benchmark, or pass the names of the ones to run, e.g. "Benchmarks.exe geosphere".
+//***************************************************************************************
+
+#include <cstdio>
+#include <cstring>
+
+void RunGeosphereBenchmark();
+void RunMeshOptimizerBenchmark();
+void RunMeshletBenchmark();
+void RunLodBenchmark();
+void RunQuantizeBenchmark();
+void RunShapesBenchmark();
+void RunTerrainBenchmark();
+void RunTangentBenchmark();
+void RunBoundsBenchmark();
+void RunTxtModelBenchmark();
+void RunM3dBenchmark();
+void RunAsyncLoadBenchmark();
+void RunDdsBenchmark();
+void RunBcDecodeBenchmark();
+void RunBcEncodeBenchmark();
+void RunMipBenchmark();
+void RunStreamingBenchmark();
+void RunAtlasBenchmark();
+void RunAnimSampleBenchmark();
+void RunCrowdBenchmark();
+void RunPoseCacheBenchmark();
+void RunTextureCacheBenchmark();
+
+struct BenchmarkEntry
+{
+	const char* Name;
+	void (*Run)();
+};
+
+static const BenchmarkEntry gBenchmarks[] =
+{
+	{ "geosphere", RunGeosphereBenchmark },
+	{ "vcache",    RunMeshOptimizerBenchmark },
+	{ "meshlets",  RunMeshletBenchmark },
+	{ "lod",       RunLodBenchmark },
+	{ "quantize",  RunQuantizeBenchmark },
+	{ "shapes",    RunShapesBenchmark },
+	{ "terrain",   RunTerrainBenchmark },
+	{ "tangents",  RunTangentBenchmark },
+	{ "bounds",    RunBoundsBenchmark },
+	{ "txtmodels", RunTxtModelBenchmark },
+	{ "m3d",       RunM3dBenchmark },
+	{ "asyncload", RunAsyncLoadBenchmark },
+	{ "dds",       RunDdsBenchmark },
+	{ "bcdecode",  RunBcDecodeBenchmark },
+	{ "bcencode",  RunBcEncodeBenchmark },
+	{ "mips",      RunMipBenchmark },
+	{ "streaming", RunStreamingBenchmark },
+	{ "atlas",     RunAtlasBenchmark },
+	{ "animsample", RunAnimSampleBenchmark },
+	{ "crowd",     RunCrowdBenchmark },
+	{ "posecache", RunPoseCacheBenchmark },
+	{ "texcache",  RunTextureCacheBenchmark },
+};
+
+int main(int argc, char* argv[])
+{
+	const int numBenchmarks = sizeof(gBenchmarks) / sizeof(gBenchmarks[0]);
+
+	for(int i = 0; i < numBenchmarks; ++i)
+	{
+		bool selected = (argc <= 1);
+		for(int a = 1; a < argc; ++a)
+		{
+			if(strcmp(argv[a], gBenchmarks[i].Name) == 0)
+				selected = true;
+		}
+
+		if(!selected)
+			continue;
+
+		printf("=== %s ===\n", gBenchmarks[i].Name);
+		gBenchmarks[i].Run();
+		printf("\n");
+	}
+
+	return 0;
+}
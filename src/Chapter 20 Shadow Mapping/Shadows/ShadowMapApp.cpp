@@ -6,7 +6,12 @@
 #include "../../Common/MathHelper.h"
 #include "../../Common/UploadBuffer.h"
 #include "../../Common/GeometryGenerator.h"
+#include "../../Common/TxtModelLoader.h"
+#include "../../Common/BoundingVolumes.h"
 #include "../../Common/Camera.h"
+#include "../../Common/AsyncLoader.h"
+#include "../../Common/DdsTextureFactory.h"
+#include "../../Common/TextureCache.h"
 #include "FrameResource.h"
 #include "ShadowMap.h"
 
@@ -49,6 +54,9 @@ struct RenderItem
     UINT IndexCount = 0;
     UINT StartIndexLocation = 0;
     int BaseVertexLocation = 0;
+
+    // Local space bounds of the geometry, used to fit the shadow map to the scene.
+    BoundingBox Bounds;
 };
 
 enum class RenderLayer : int
@@ -97,6 +105,7 @@ private:
     void BuildFrameResources();
     void BuildMaterials();
     void BuildRenderItems();
+    void BuildSceneBounds();
     void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems);
     void DrawSceneToShadowMap();
 
@@ -114,7 +123,11 @@ private:
 
 	std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> mGeometries;
 	std::unordered_map<std::string, std::unique_ptr<Material>> mMaterials;
-	std::unordered_map<std::string, std::unique_ptr<Texture>> mTextures;
+	// Textures come from a cache, which reads the files on mLoader's threads.
+	std::unique_ptr<AsyncLoader> mLoader;
+	std::unique_ptr<DdsTextureFactory> mTextureFactory;
+	std::unique_ptr<TextureCache> mTextureCache;
+	std::unordered_map<std::string, TextureCache::Handle> mTextures;
 	std::unordered_map<std::string, ComPtr<ID3DBlob>> mShaders;
 	std::unordered_map<std::string, ComPtr<ID3D12PipelineState>> mPSOs;
 
@@ -187,12 +200,6 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
 ShadowMapApp::ShadowMapApp(HINSTANCE hInstance)
     : D3DApp(hInstance)
 {
-    // Estimate the scene bounding sphere manually since we know how the scene was constructed.
-    // The grid is the "widest object" with a width of 20 and depth of 30.0f, and centered at
-    // the world space origin.  In general, you need to loop over every world space vertex
-    // position and compute the bounding sphere.
-    mSceneBounds.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
-    mSceneBounds.Radius = sqrtf(10.0f*10.0f + 15.0f*15.0f);
 }
 
 ShadowMapApp::~ShadowMapApp()
@@ -222,6 +229,7 @@ bool ShadowMapApp::Initialize()
     BuildSkullGeometry();
 	BuildMaterials();
     BuildRenderItems();
+    BuildSceneBounds();
     BuildFrameResources();
     BuildPSOs();
 
@@ -621,28 +629,34 @@ void ShadowMapApp::LoadTextures()
 		"skyCubeMap"
 	};
 	
-    std::vector<std::wstring> texFilenames =
+    std::vector<std::string> texFilenames =
     {
-        L"../../Textures/bricks2.dds",
-        L"../../Textures/bricks2_nmap.dds",
-        L"../../Textures/tile.dds",
-        L"../../Textures/tile_nmap.dds",
-        L"../../Textures/white1x1.dds",
-        L"../../Textures/default_nmap.dds",
-        L"../../Textures/desertcube1024.dds"
+        "../../Textures/bricks2.dds",
+        "../../Textures/bricks2_nmap.dds",
+        "../../Textures/tile.dds",
+        "../../Textures/tile_nmap.dds",
+        "../../Textures/white1x1.dds",
+        "../../Textures/default_nmap.dds",
+        "../../Textures/desertcube1024.dds"
     };
-	
+
+	mLoader = std::make_unique<AsyncLoader>();
+	mTextureFactory = std::make_unique<DdsTextureFactory>(md3dDevice.Get());
+	mTextureFactory->SetCommandList(mCommandList.Get());
+	mTextureCache = std::make_unique<TextureCache>(*mTextureFactory, mLoader.get(), TextureCache::Settings());
+
+	// The files are read in parallel; Flush waits for them and records the
+	// uploads on mCommandList.
 	for(int i = 0; i < (int)texNames.size(); ++i)
+		mTextures[texNames[i]] = mTextureCache->Acquire(texFilenames[i]);
+
+	mTextureCache->Flush();
+
+	for(auto& e : mTextures)
 	{
-		auto texMap = std::make_unique<Texture>();
-		texMap->Name = texNames[i];
-		texMap->Filename = texFilenames[i];
-		ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-			mCommandList.Get(), texMap->Filename.c_str(),
-			texMap->Resource, texMap->UploadHeap));
-			
-		mTextures[texMap->Name] = std::move(texMap);
-	}		
+		if(e.second->Status != TextureCache::State::Ready)
+			throw DxException(E_FAIL, AnsiToWString(e.second->Error), AnsiToWString(__FILE__), __LINE__);
+	}
 }
 
 void ShadowMapApp::BuildRootSignature()
@@ -708,15 +722,15 @@ void ShadowMapApp::BuildDescriptorHeaps()
 
 	std::vector<ComPtr<ID3D12Resource>> tex2DList = 
 	{
-		mTextures["bricksDiffuseMap"]->Resource,
-		mTextures["bricksNormalMap"]->Resource,
-		mTextures["tileDiffuseMap"]->Resource,
-		mTextures["tileNormalMap"]->Resource,
-		mTextures["defaultDiffuseMap"]->Resource,
-		mTextures["defaultNormalMap"]->Resource
+		mTextures["bricksDiffuseMap"]->Get<Texture>()->Resource,
+		mTextures["bricksNormalMap"]->Get<Texture>()->Resource,
+		mTextures["tileDiffuseMap"]->Get<Texture>()->Resource,
+		mTextures["tileNormalMap"]->Get<Texture>()->Resource,
+		mTextures["defaultDiffuseMap"]->Get<Texture>()->Resource,
+		mTextures["defaultNormalMap"]->Get<Texture>()->Resource
 	};
 	
-	auto skyCubeMap = mTextures["skyCubeMap"]->Resource;
+	auto skyCubeMap = mTextures["skyCubeMap"]->Get<Texture>()->Resource;
 
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
@@ -833,26 +847,31 @@ void ShadowMapApp::BuildShapeGeometry()
 	boxSubmesh.IndexCount = (UINT)box.Indices32.size();
 	boxSubmesh.StartIndexLocation = boxIndexOffset;
 	boxSubmesh.BaseVertexLocation = boxVertexOffset;
+	boxSubmesh.Bounds = BoundingVolumes::ComputeAabb(&box.Vertices[0].Position, sizeof(GeometryGenerator::Vertex), box.Vertices.size());
 
 	SubmeshGeometry gridSubmesh;
 	gridSubmesh.IndexCount = (UINT)grid.Indices32.size();
 	gridSubmesh.StartIndexLocation = gridIndexOffset;
 	gridSubmesh.BaseVertexLocation = gridVertexOffset;
+	gridSubmesh.Bounds = BoundingVolumes::ComputeAabb(&grid.Vertices[0].Position, sizeof(GeometryGenerator::Vertex), grid.Vertices.size());
 
 	SubmeshGeometry sphereSubmesh;
 	sphereSubmesh.IndexCount = (UINT)sphere.Indices32.size();
 	sphereSubmesh.StartIndexLocation = sphereIndexOffset;
 	sphereSubmesh.BaseVertexLocation = sphereVertexOffset;
+	sphereSubmesh.Bounds = BoundingVolumes::ComputeAabb(&sphere.Vertices[0].Position, sizeof(GeometryGenerator::Vertex), sphere.Vertices.size());
 
 	SubmeshGeometry cylinderSubmesh;
 	cylinderSubmesh.IndexCount = (UINT)cylinder.Indices32.size();
 	cylinderSubmesh.StartIndexLocation = cylinderIndexOffset;
 	cylinderSubmesh.BaseVertexLocation = cylinderVertexOffset;
+	cylinderSubmesh.Bounds = BoundingVolumes::ComputeAabb(&cylinder.Vertices[0].Position, sizeof(GeometryGenerator::Vertex), cylinder.Vertices.size());
 
     SubmeshGeometry quadSubmesh;
     quadSubmesh.IndexCount = (UINT)quad.Indices32.size();
     quadSubmesh.StartIndexLocation = quadIndexOffset;
     quadSubmesh.BaseVertexLocation = quadVertexOffset;
+    quadSubmesh.Bounds = BoundingVolumes::ComputeAabb(&quad.Vertices[0].Position, sizeof(GeometryGenerator::Vertex), quad.Vertices.size());
 
 	//
 	// Extract the vertex elements we are interested in and pack the
@@ -950,38 +969,17 @@ void ShadowMapApp::BuildShapeGeometry()
 
 void ShadowMapApp::BuildSkullGeometry()
 {
-    std::ifstream fin("Models/skull.txt");
-
-    if (!fin)
+    std::vector<Vertex> vertices;
+    std::vector<std::int32_t> indices;
+    BoundingBox bounds;
+    if (!TxtModelLoader::Load("Models/skull.txt", vertices, indices, &bounds))
     {
         MessageBox(0, L"Models/skull.txt not found.", 0, 0);
         return;
     }
 
-    UINT vcount = 0;
-    UINT tcount = 0;
-    std::string ignore;
-
-    fin >> ignore >> vcount;
-    fin >> ignore >> tcount;
-    fin >> ignore >> ignore >> ignore >> ignore;
-
-    XMFLOAT3 vMinf3(+MathHelper::Infinity, +MathHelper::Infinity, +MathHelper::Infinity);
-    XMFLOAT3 vMaxf3(-MathHelper::Infinity, -MathHelper::Infinity, -MathHelper::Infinity);
-
-    XMVECTOR vMin = XMLoadFloat3(&vMinf3);
-    XMVECTOR vMax = XMLoadFloat3(&vMaxf3);
-
-    std::vector<Vertex> vertices(vcount);
-    for (UINT i = 0; i < vcount; ++i)
+    for (UINT i = 0; i < (UINT)vertices.size(); ++i)
     {
-        fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-        fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
-
-        vertices[i].TexC = { 0.0f, 0.0f };
-
-        XMVECTOR P = XMLoadFloat3(&vertices[i].Pos);
-
         XMVECTOR N = XMLoadFloat3(&vertices[i].Normal);
 
         // Generate a tangent vector so normal mapping works.  We aren't applying
@@ -999,28 +997,8 @@ void ShadowMapApp::BuildSkullGeometry()
             XMVECTOR T = XMVector3Normalize(XMVector3Cross(N, up));
             XMStoreFloat3(&vertices[i].TangentU, T);
         }
-        
-
-        vMin = XMVectorMin(vMin, P);
-        vMax = XMVectorMax(vMax, P);
-    }
-
-    BoundingBox bounds;
-    XMStoreFloat3(&bounds.Center, 0.5f*(vMin + vMax));
-    XMStoreFloat3(&bounds.Extents, 0.5f*(vMax - vMin));
-
-    fin >> ignore;
-    fin >> ignore;
-    fin >> ignore;
-
-    std::vector<std::int32_t> indices(3 * tcount);
-    for (UINT i = 0; i < tcount; ++i)
-    {
-        fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
     }
 
-    fin.close();
-
     //
     // Pack the indices of all the meshes into one index buffer.
     //
@@ -1235,6 +1213,7 @@ void ShadowMapApp::BuildRenderItems()
 	skyRitem->IndexCount = skyRitem->Geo->DrawArgs["sphere"].IndexCount;
 	skyRitem->StartIndexLocation = skyRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 	skyRitem->BaseVertexLocation = skyRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+	skyRitem->Bounds = skyRitem->Geo->DrawArgs["sphere"].Bounds;
 
 	mRitemLayer[(int)RenderLayer::Sky].push_back(skyRitem.get());
 	mAllRitems.push_back(std::move(skyRitem));
@@ -1249,6 +1228,7 @@ void ShadowMapApp::BuildRenderItems()
     quadRitem->IndexCount = quadRitem->Geo->DrawArgs["quad"].IndexCount;
     quadRitem->StartIndexLocation = quadRitem->Geo->DrawArgs["quad"].StartIndexLocation;
     quadRitem->BaseVertexLocation = quadRitem->Geo->DrawArgs["quad"].BaseVertexLocation;
+    quadRitem->Bounds = quadRitem->Geo->DrawArgs["quad"].Bounds;
 
     mRitemLayer[(int)RenderLayer::Debug].push_back(quadRitem.get());
     mAllRitems.push_back(std::move(quadRitem));
@@ -1263,6 +1243,7 @@ void ShadowMapApp::BuildRenderItems()
 	boxRitem->IndexCount = boxRitem->Geo->DrawArgs["box"].IndexCount;
 	boxRitem->StartIndexLocation = boxRitem->Geo->DrawArgs["box"].StartIndexLocation;
 	boxRitem->BaseVertexLocation = boxRitem->Geo->DrawArgs["box"].BaseVertexLocation;
+	boxRitem->Bounds = boxRitem->Geo->DrawArgs["box"].Bounds;
 
 	mRitemLayer[(int)RenderLayer::Opaque].push_back(boxRitem.get());
 	mAllRitems.push_back(std::move(boxRitem));
@@ -1277,6 +1258,7 @@ void ShadowMapApp::BuildRenderItems()
     skullRitem->IndexCount = skullRitem->Geo->DrawArgs["skull"].IndexCount;
     skullRitem->StartIndexLocation = skullRitem->Geo->DrawArgs["skull"].StartIndexLocation;
     skullRitem->BaseVertexLocation = skullRitem->Geo->DrawArgs["skull"].BaseVertexLocation;
+    skullRitem->Bounds = skullRitem->Geo->DrawArgs["skull"].Bounds;
 
     mRitemLayer[(int)RenderLayer::Opaque].push_back(skullRitem.get());
     mAllRitems.push_back(std::move(skullRitem));
@@ -1291,6 +1273,7 @@ void ShadowMapApp::BuildRenderItems()
     gridRitem->IndexCount = gridRitem->Geo->DrawArgs["grid"].IndexCount;
     gridRitem->StartIndexLocation = gridRitem->Geo->DrawArgs["grid"].StartIndexLocation;
     gridRitem->BaseVertexLocation = gridRitem->Geo->DrawArgs["grid"].BaseVertexLocation;
+    gridRitem->Bounds = gridRitem->Geo->DrawArgs["grid"].Bounds;
 
 	mRitemLayer[(int)RenderLayer::Opaque].push_back(gridRitem.get());
 	mAllRitems.push_back(std::move(gridRitem));
@@ -1319,6 +1302,7 @@ void ShadowMapApp::BuildRenderItems()
 		leftCylRitem->IndexCount = leftCylRitem->Geo->DrawArgs["cylinder"].IndexCount;
 		leftCylRitem->StartIndexLocation = leftCylRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
 		leftCylRitem->BaseVertexLocation = leftCylRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
+		leftCylRitem->Bounds = leftCylRitem->Geo->DrawArgs["cylinder"].Bounds;
 
 		XMStoreFloat4x4(&rightCylRitem->World, leftCylWorld);
 		XMStoreFloat4x4(&rightCylRitem->TexTransform, brickTexTransform);
@@ -1329,6 +1313,7 @@ void ShadowMapApp::BuildRenderItems()
 		rightCylRitem->IndexCount = rightCylRitem->Geo->DrawArgs["cylinder"].IndexCount;
 		rightCylRitem->StartIndexLocation = rightCylRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
 		rightCylRitem->BaseVertexLocation = rightCylRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
+		rightCylRitem->Bounds = rightCylRitem->Geo->DrawArgs["cylinder"].Bounds;
 
 		XMStoreFloat4x4(&leftSphereRitem->World, leftSphereWorld);
 		leftSphereRitem->TexTransform = MathHelper::Identity4x4();
@@ -1339,6 +1324,7 @@ void ShadowMapApp::BuildRenderItems()
 		leftSphereRitem->IndexCount = leftSphereRitem->Geo->DrawArgs["sphere"].IndexCount;
 		leftSphereRitem->StartIndexLocation = leftSphereRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 		leftSphereRitem->BaseVertexLocation = leftSphereRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+		leftSphereRitem->Bounds = leftSphereRitem->Geo->DrawArgs["sphere"].Bounds;
 
 		XMStoreFloat4x4(&rightSphereRitem->World, rightSphereWorld);
 		rightSphereRitem->TexTransform = MathHelper::Identity4x4();
@@ -1349,6 +1335,7 @@ void ShadowMapApp::BuildRenderItems()
 		rightSphereRitem->IndexCount = rightSphereRitem->Geo->DrawArgs["sphere"].IndexCount;
 		rightSphereRitem->StartIndexLocation = rightSphereRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 		rightSphereRitem->BaseVertexLocation = rightSphereRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+		rightSphereRitem->Bounds = rightSphereRitem->Geo->DrawArgs["sphere"].Bounds;
 
 		mRitemLayer[(int)RenderLayer::Opaque].push_back(leftCylRitem.get());
 		mRitemLayer[(int)RenderLayer::Opaque].push_back(rightCylRitem.get());
@@ -1362,6 +1349,21 @@ void ShadowMapApp::BuildRenderItems()
 	}
 }
 
+void ShadowMapApp::BuildSceneBounds()
+{
+    // The shadow map has to cover every opaque object, since they all cast and
+    // receive shadows.  Bound their world space boxes with a sphere.
+    std::vector<BoundingBox> worldBounds;
+    for(auto ri : mRitemLayer[(int)RenderLayer::Opaque])
+    {
+        BoundingBox box;
+        ri->Bounds.Transform(box, XMLoadFloat4x4(&ri->World));
+        worldBounds.push_back(box);
+    }
+
+    mSceneBounds = BoundingVolumes::EnclosingSphere(worldBounds.data(), worldBounds.size());
+}
+
 void ShadowMapApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems)
 {
     UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
@@ -5,7 +5,10 @@
 #include "../../Common/d3dApp.h"
 #include "../../Common/MathHelper.h"
 #include "../../Common/UploadBuffer.h"
+#include "../../Common/AsyncLoader.h"
 #include "../../Common/GeometryGenerator.h"
+#include "../../Common/TxtModelLoader.h"
+#include "../../Common/TangentGenerator.h"
 #include "../../Common/Camera.h"
 #include "FrameResource.h"
 #include "ShadowMap.h"
@@ -17,6 +20,15 @@ using namespace DirectX::PackedVector;
 
 const int gNumFrameResources = 3;
 
+// The skull as the loader's worker leaves it, ready to upload.
+struct SkullMesh
+{
+    bool Loaded = false;
+    std::vector<Vertex> Vertices;
+    std::vector<std::int32_t> Indices;
+    BoundingBox Bounds;
+};
+
 // Lightweight structure stores parameters to draw a shape.  This will
 // vary from app-to-app.
 struct RenderItem
@@ -89,12 +101,14 @@ private:
     void UpdateShadowPassCB(const GameTimer& gt);
     void UpdateSsaoCB(const GameTimer& gt);
 
-	void LoadTextures();
+	void LoadTextures(AsyncLoader& loader);
+	void CreateTextures();
     void BuildRootSignature();
     void BuildSsaoRootSignature();
 	void BuildDescriptorHeaps();
-    void BuildShadersAndInputLayout();
+    void BuildShadersAndInputLayout(AsyncLoader& loader);
     void BuildShapeGeometry();
+    void LoadSkull(AsyncLoader& loader);
     void BuildSkullGeometry();
     void BuildPSOs();
     void BuildFrameResources();
@@ -128,6 +142,11 @@ private:
 	std::unordered_map<std::string, ComPtr<ID3DBlob>> mShaders;
 	std::unordered_map<std::string, ComPtr<ID3D12PipelineState>> mPSOs;
 
+	// Loads in flight during Initialize.
+	std::unordered_map<std::string, std::shared_future<std::vector<std::uint8_t>>> mTextureFiles;
+	std::unordered_map<std::string, std::shared_future<ComPtr<ID3DBlob>>> mShaderLoads;
+	std::shared_future<SkullMesh> mSkullLoad;
+
     std::vector<D3D12_INPUT_ELEMENT_DESC> mInputLayout;
  
 	// List of all the render items.
@@ -234,16 +253,24 @@ bool SsaoApp::Initialize()
         mCommandList.Get(),
         mClientWidth, mClientHeight);
 
-	LoadTextures();
+	// File reads, skull parsing and shader compiles run on the loader's threads
+	// while this thread records the device work; each step waits only for the
+	// results it uses.
+	AsyncLoader loader;
+	LoadTextures(loader);
+	LoadSkull(loader);
+    BuildShadersAndInputLayout(loader);
+
     BuildRootSignature();
     BuildSsaoRootSignature();
+	CreateTextures();
 	BuildDescriptorHeaps();
-    BuildShadersAndInputLayout();
     BuildShapeGeometry();
     BuildSkullGeometry();
 	BuildMaterials();
     BuildRenderItems();
     BuildFrameResources();
+	CollectAll(mShaderLoads, mShaders);
     BuildPSOs();
 
     mSsao->SetPSOs(mPSOs["ssao"].Get(), mPSOs["ssaoBlur"].Get());
@@ -723,7 +750,7 @@ void SsaoApp::UpdateSsaoCB(const GameTimer& gt)
     currSsaoCB->CopyData(0, ssaoCB);
 }
 
-void SsaoApp::LoadTextures()
+void SsaoApp::LoadTextures(AsyncLoader& loader)
 {
 	std::vector<std::string> texNames = 
 	{
@@ -752,14 +779,27 @@ void SsaoApp::LoadTextures()
 		auto texMap = std::make_unique<Texture>();
 		texMap->Name = texNames[i];
 		texMap->Filename = texFilenames[i];
-		ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-			mCommandList.Get(), texMap->Filename.c_str(),
-			texMap->Resource, texMap->UploadHeap));
+		mTextureFiles[texMap->Name] = loader.ReadFile(texMap->Filename);
 			
 		mTextures[texMap->Name] = std::move(texMap);
 	}		
 }
 
+void SsaoApp::CreateTextures()
+{
+	for(auto& file : mTextureFiles)
+	{
+		const std::vector<std::uint8_t>& data = file.second.get();
+
+		auto& texMap = mTextures[file.first];
+		ThrowIfFailed(DirectX::CreateDDSTextureFromMemory12(md3dDevice.Get(),
+			mCommandList.Get(), data.data(), data.size(),
+			texMap->Resource, texMap->UploadHeap));
+	}
+
+	mTextureFiles.clear();
+}
+
 void SsaoApp::BuildRootSignature()
 {
 	CD3DX12_DESCRIPTOR_RANGE texTable0;
@@ -972,35 +1012,41 @@ void SsaoApp::BuildDescriptorHeaps()
         mRtvDescriptorSize);
 }
 
-void SsaoApp::BuildShadersAndInputLayout()
+void SsaoApp::BuildShadersAndInputLayout(AsyncLoader& loader)
 {
-	const D3D_SHADER_MACRO alphaTestDefines[] =
+	// Static: the compiles read it after this function returns.
+	static const D3D_SHADER_MACRO alphaTestDefines[] =
 	{
 		"ALPHA_TEST", "1",
 		NULL, NULL
 	};
 
-	mShaders["standardVS"] = d3dUtil::CompileShader(L"Shaders\\Default.hlsl", nullptr, "VS", "vs_5_1");
-	mShaders["opaquePS"] = d3dUtil::CompileShader(L"Shaders\\Default.hlsl", nullptr, "PS", "ps_5_1");
+	auto compile = [&loader](const wchar_t* filename, const D3D_SHADER_MACRO* defines, const char* entrypoint, const char* target)
+	{
+		return loader.Submit([=]() { return d3dUtil::CompileShader(filename, defines, entrypoint, target); });
+	};
+
+	mShaderLoads["standardVS"] = compile(L"Shaders\\Default.hlsl", nullptr, "VS", "vs_5_1");
+	mShaderLoads["opaquePS"] = compile(L"Shaders\\Default.hlsl", nullptr, "PS", "ps_5_1");
 
-    mShaders["shadowVS"] = d3dUtil::CompileShader(L"Shaders\\Shadows.hlsl", nullptr, "VS", "vs_5_1");
-    mShaders["shadowOpaquePS"] = d3dUtil::CompileShader(L"Shaders\\Shadows.hlsl", nullptr, "PS", "ps_5_1");
-    mShaders["shadowAlphaTestedPS"] = d3dUtil::CompileShader(L"Shaders\\Shadows.hlsl", alphaTestDefines, "PS", "ps_5_1");
+    mShaderLoads["shadowVS"] = compile(L"Shaders\\Shadows.hlsl", nullptr, "VS", "vs_5_1");
+    mShaderLoads["shadowOpaquePS"] = compile(L"Shaders\\Shadows.hlsl", nullptr, "PS", "ps_5_1");
+    mShaderLoads["shadowAlphaTestedPS"] = compile(L"Shaders\\Shadows.hlsl", alphaTestDefines, "PS", "ps_5_1");
 	
-    mShaders["debugVS"] = d3dUtil::CompileShader(L"Shaders\\ShadowDebug.hlsl", nullptr, "VS", "vs_5_1");
-    mShaders["debugPS"] = d3dUtil::CompileShader(L"Shaders\\ShadowDebug.hlsl", nullptr, "PS", "ps_5_1");
+    mShaderLoads["debugVS"] = compile(L"Shaders\\ShadowDebug.hlsl", nullptr, "VS", "vs_5_1");
+    mShaderLoads["debugPS"] = compile(L"Shaders\\ShadowDebug.hlsl", nullptr, "PS", "ps_5_1");
 
-    mShaders["drawNormalsVS"] = d3dUtil::CompileShader(L"Shaders\\DrawNormals.hlsl", nullptr, "VS", "vs_5_1");
-    mShaders["drawNormalsPS"] = d3dUtil::CompileShader(L"Shaders\\DrawNormals.hlsl", nullptr, "PS", "ps_5_1");
+    mShaderLoads["drawNormalsVS"] = compile(L"Shaders\\DrawNormals.hlsl", nullptr, "VS", "vs_5_1");
+    mShaderLoads["drawNormalsPS"] = compile(L"Shaders\\DrawNormals.hlsl", nullptr, "PS", "ps_5_1");
 
-    mShaders["ssaoVS"] = d3dUtil::CompileShader(L"Shaders\\Ssao.hlsl", nullptr, "VS", "vs_5_1");
-    mShaders["ssaoPS"] = d3dUtil::CompileShader(L"Shaders\\Ssao.hlsl", nullptr, "PS", "ps_5_1");
+    mShaderLoads["ssaoVS"] = compile(L"Shaders\\Ssao.hlsl", nullptr, "VS", "vs_5_1");
+    mShaderLoads["ssaoPS"] = compile(L"Shaders\\Ssao.hlsl", nullptr, "PS", "ps_5_1");
 
-    mShaders["ssaoBlurVS"] = d3dUtil::CompileShader(L"Shaders\\SsaoBlur.hlsl", nullptr, "VS", "vs_5_1");
-    mShaders["ssaoBlurPS"] = d3dUtil::CompileShader(L"Shaders\\SsaoBlur.hlsl", nullptr, "PS", "ps_5_1");
+    mShaderLoads["ssaoBlurVS"] = compile(L"Shaders\\SsaoBlur.hlsl", nullptr, "VS", "vs_5_1");
+    mShaderLoads["ssaoBlurPS"] = compile(L"Shaders\\SsaoBlur.hlsl", nullptr, "PS", "ps_5_1");
 
-	mShaders["skyVS"] = d3dUtil::CompileShader(L"Shaders\\Sky.hlsl", nullptr, "VS", "vs_5_1");
-	mShaders["skyPS"] = d3dUtil::CompileShader(L"Shaders\\Sky.hlsl", nullptr, "PS", "ps_5_1");
+	mShaderLoads["skyVS"] = compile(L"Shaders\\Sky.hlsl", nullptr, "VS", "vs_5_1");
+	mShaderLoads["skyPS"] = compile(L"Shaders\\Sky.hlsl", nullptr, "PS", "ps_5_1");
 
     mInputLayout =
     {
@@ -1158,78 +1204,34 @@ void SsaoApp::BuildShapeGeometry()
 	mGeometries[geo->Name] = std::move(geo);
 }
 
-void SsaoApp::BuildSkullGeometry()
+void SsaoApp::LoadSkull(AsyncLoader& loader)
 {
-    std::ifstream fin("Models/skull.txt");
-
-    if (!fin)
+    mSkullLoad = loader.Submit([]()
     {
-        MessageBox(0, L"Models/skull.txt not found.", 0, 0);
-        return;
-    }
+        SkullMesh skull;
+        skull.Loaded = TxtModelLoader::Load("Models/skull.txt", skull.Vertices, skull.Indices, &skull.Bounds);
 
-    UINT vcount = 0;
-    UINT tcount = 0;
-    std::string ignore;
+        // Generate tangent vectors so normal mapping works.  We aren't applying
+        // a texture map to the skull, so the generator just picks any tangent vector
+        // so that the math works out to give us the original interpolated vertex normal.
+        if(skull.Loaded)
+            TangentGenerator::Generate(skull.Vertices, skull.Indices);
 
-    fin >> ignore >> vcount;
-    fin >> ignore >> tcount;
-    fin >> ignore >> ignore >> ignore >> ignore;
-
-    XMFLOAT3 vMinf3(+MathHelper::Infinity, +MathHelper::Infinity, +MathHelper::Infinity);
-    XMFLOAT3 vMaxf3(-MathHelper::Infinity, -MathHelper::Infinity, -MathHelper::Infinity);
-
-    XMVECTOR vMin = XMLoadFloat3(&vMinf3);
-    XMVECTOR vMax = XMLoadFloat3(&vMaxf3);
-
-    std::vector<Vertex> vertices(vcount);
-    for (UINT i = 0; i < vcount; ++i)
-    {
-        fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-        fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
-
-        vertices[i].TexC = { 0.0f, 0.0f };
-
-        XMVECTOR P = XMLoadFloat3(&vertices[i].Pos);
-
-        XMVECTOR N = XMLoadFloat3(&vertices[i].Normal);
-
-        // Generate a tangent vector so normal mapping works.  We aren't applying
-        // a texture map to the skull, so we just need any tangent vector so that
-        // the math works out to give us the original interpolated vertex normal.
-        XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-        if (fabsf(XMVectorGetX(XMVector3Dot(N, up))) < 1.0f - 0.001f)
-        {
-            XMVECTOR T = XMVector3Normalize(XMVector3Cross(up, N));
-            XMStoreFloat3(&vertices[i].TangentU, T);
-        }
-        else
-        {
-            up = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
-            XMVECTOR T = XMVector3Normalize(XMVector3Cross(N, up));
-            XMStoreFloat3(&vertices[i].TangentU, T);
-        }
-
-
-        vMin = XMVectorMin(vMin, P);
-        vMax = XMVectorMax(vMax, P);
-    }
-
-    BoundingBox bounds;
-    XMStoreFloat3(&bounds.Center, 0.5f*(vMin + vMax));
-    XMStoreFloat3(&bounds.Extents, 0.5f*(vMax - vMin));
-
-    fin >> ignore;
-    fin >> ignore;
-    fin >> ignore;
+        return skull;
+    });
+}
 
-    std::vector<std::int32_t> indices(3 * tcount);
-    for (UINT i = 0; i < tcount; ++i)
+void SsaoApp::BuildSkullGeometry()
+{
+    const SkullMesh& skull = mSkullLoad.get();
+    if (!skull.Loaded)
     {
-        fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
+        MessageBox(0, L"Models/skull.txt not found.", 0, 0);
+        return;
     }
 
-    fin.close();
+    const std::vector<Vertex>& vertices = skull.Vertices;
+    const std::vector<std::int32_t>& indices = skull.Indices;
 
     //
     // Pack the indices of all the meshes into one index buffer.
@@ -1263,7 +1265,7 @@ void SsaoApp::BuildSkullGeometry()
     submesh.IndexCount = (UINT)indices.size();
     submesh.StartIndexLocation = 0;
     submesh.BaseVertexLocation = 0;
-    submesh.Bounds = bounds;
+    submesh.Bounds = skull.Bounds;
 
     geo->DrawArgs["skull"] = submesh;
 
@@ -0,0 +1,271 @@
+//***************************************************************************************
+// ClipSampler.cpp
+//***************************************************************************************
+
+#include "ClipSampler.h"
+#include "SkinnedData.h"
+#include <algorithm>
+#include <cmath>
+
+#if !defined(CLIP_SAMPLER_NO_SIMD) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define CLIP_SAMPLER_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace DirectX;
+
+#ifndef CLIP_SAMPLER_SSE2
+namespace
+{
+	// Coefficients of the factor correction that makes nlerp follow slerp; see
+	// Zeux Kapoulkine, "Approximating slerp".  d is |q0.q1|.
+	inline float CorrectFactor(float t, float d)
+	{
+		float a = 1.0904f + d*(-3.2452f + d*(3.55645f - d*1.43519f));
+		float b = 0.848013f + d*(-1.06021f + d*0.215638f);
+		float k = a*(t - 0.5f)*(t - 0.5f) + b;
+		return t + t*(t - 0.5f)*(t - 1.0f)*k;
+	}
+}
+#endif
+
+ClipSampler::ClipSampler(const AnimationClip& clip)
+{
+	mTrackCount = (UINT)clip.BoneAnimations.size();
+	const UINT paddedCount = (mTrackCount + 3) & ~3u;
+
+	size_t keyCount = paddedCount - mTrackCount;
+	for(const BoneAnimation& bone : clip.BoneAnimations)
+		keyCount += bone.Keyframes.size();
+
+	mFirstKey.reserve(paddedCount);
+	mKeyCount.reserve(paddedCount);
+	for(std::vector<float>* component : { &mTimes, &mTx, &mTy, &mTz, &mSx, &mSy, &mSz, &mQx, &mQy, &mQz, &mQw })
+		component->reserve(keyCount);
+
+	auto addKey = [this](const Keyframe& key)
+	{
+		mTimes.push_back(key.TimePos);
+		mTx.push_back(key.Translation.x);
+		mTy.push_back(key.Translation.y);
+		mTz.push_back(key.Translation.z);
+		mSx.push_back(key.Scale.x);
+		mSy.push_back(key.Scale.y);
+		mSz.push_back(key.Scale.z);
+		mQx.push_back(key.RotationQuat.x);
+		mQy.push_back(key.RotationQuat.y);
+		mQz.push_back(key.RotationQuat.z);
+		mQw.push_back(key.RotationQuat.w);
+	};
+
+	for(const BoneAnimation& bone : clip.BoneAnimations)
+	{
+		mFirstKey.push_back((UINT)mTimes.size());
+		mKeyCount.push_back((UINT)bone.Keyframes.size());
+		for(const Keyframe& key : bone.Keyframes)
+			addKey(key);
+	}
+
+	// Identity tracks fill the last group of four.
+	for(UINT i = mTrackCount; i < paddedCount; ++i)
+	{
+		mFirstKey.push_back((UINT)mTimes.size());
+		mKeyCount.push_back(1);
+		addKey(Keyframe());
+	}
+
+	if(mTrackCount > 0)
+	{
+		mStartTime = clip.GetClipStartTime();
+		mEndTime = clip.GetClipEndTime();
+	}
+}
+
+UINT ClipSampler::FindKey(UINT track, float t, UINT key)const
+{
+	const UINT count = mKeyCount[track];
+	if(count < 2)
+		return 0;
+
+	const float* times = &mTimes[mFirstKey[track]];
+	key = (std::min)(key, count - 2);
+
+	// Playing forward: the key is this one or a few after it.
+	if(t >= times[key])
+	{
+		for(UINT step = 0; step < MaxLinearSteps; ++step)
+		{
+			if(key == count - 2 || t < times[key + 1])
+				return key;
+			++key;
+		}
+	}
+
+	// A seek: the last key at or before t.
+	UINT after = (UINT)(std::upper_bound(times, times + count, t) - times);
+	return after == 0 ? 0 : (std::min)(after - 1, count - 2);
+}
+
+void ClipSampler::Sample(float t, Cursor& cursor, XMFLOAT4X4* toParent)const
+{
+	const UINT paddedCount = (UINT)mFirstKey.size();
+	cursor.Keys.resize(paddedCount, 0);
+
+	for(UINT group = 0; group < paddedCount; group += 4)
+	{
+		// The two keys each track interpolates between and how far t is from
+		// the first to the second; 0 before a track's first key, 1 after its last.
+		UINT k0[4];
+		UINT k1[4];
+		float f[4];
+		for(UINT j = 0; j < 4; ++j)
+		{
+			const UINT track = group + j;
+			const UINT key = FindKey(track, t, cursor.Keys[track]);
+			cursor.Keys[track] = key;
+
+			k0[j] = mFirstKey[track] + key;
+			k1[j] = k0[j] + (mKeyCount[track] > 1 ? 1 : 0);
+
+			const float span = mTimes[k1[j]] - mTimes[k0[j]];
+			f[j] = span > 0.0f ? (t - mTimes[k0[j]]) / span : 0.0f;
+			f[j] = (std::min)((std::max)(f[j], 0.0f), 1.0f);
+		}
+
+#ifdef CLIP_SAMPLER_SSE2
+		auto gather = [&](const std::vector<float>& c, const UINT* k)
+		{
+			return _mm_setr_ps(c[k[0]], c[k[1]], c[k[2]], c[k[3]]);
+		};
+		auto lerp = [&](const std::vector<float>& c, __m128 s)
+		{
+			__m128 a = gather(c, k0);
+			return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(gather(c, k1), a), s));
+		};
+
+		const __m128 s = _mm_loadu_ps(f);
+		const __m128 tx = lerp(mTx, s);
+		const __m128 ty = lerp(mTy, s);
+		const __m128 tz = lerp(mTz, s);
+		const __m128 sx = lerp(mSx, s);
+		const __m128 sy = lerp(mSy, s);
+		const __m128 sz = lerp(mSz, s);
+
+		//
+		// Rotation: nlerp the short way round, with the factor corrected as
+		// CorrectFactor does in the scalar path.
+		//
+
+		__m128 ax = gather(mQx, k0), ay = gather(mQy, k0), az = gather(mQz, k0), aw = gather(mQw, k0);
+		__m128 bx = gather(mQx, k1), by = gather(mQy, k1), bz = gather(mQz, k1), bw = gather(mQw, k1);
+
+		__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)),
+			_mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+		const __m128 sign = _mm_and_ps(d, _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000)));
+		bx = _mm_xor_ps(bx, sign);
+		by = _mm_xor_ps(by, sign);
+		bz = _mm_xor_ps(bz, sign);
+		bw = _mm_xor_ps(bw, sign);
+		d = _mm_xor_ps(d, sign);
+
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 one = _mm_set1_ps(1.0f);
+		__m128 a = _mm_add_ps(_mm_set1_ps(3.55645f), _mm_mul_ps(d, _mm_set1_ps(-1.43519f)));
+		a = _mm_add_ps(_mm_set1_ps(-3.2452f), _mm_mul_ps(d, a));
+		a = _mm_add_ps(_mm_set1_ps(1.0904f), _mm_mul_ps(d, a));
+		__m128 b = _mm_add_ps(_mm_set1_ps(-1.06021f), _mm_mul_ps(d, _mm_set1_ps(0.215638f)));
+		b = _mm_add_ps(_mm_set1_ps(0.848013f), _mm_mul_ps(d, b));
+		const __m128 c = _mm_sub_ps(s, half);
+		const __m128 k = _mm_add_ps(_mm_mul_ps(a, _mm_mul_ps(c, c)), b);
+		const __m128 u = _mm_add_ps(s, _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(s, c), _mm_sub_ps(s, one)), k));
+
+		__m128 qx = _mm_add_ps(ax, _mm_mul_ps(_mm_sub_ps(bx, ax), u));
+		__m128 qy = _mm_add_ps(ay, _mm_mul_ps(_mm_sub_ps(by, ay), u));
+		__m128 qz = _mm_add_ps(az, _mm_mul_ps(_mm_sub_ps(bz, az), u));
+		__m128 qw = _mm_add_ps(aw, _mm_mul_ps(_mm_sub_ps(bw, aw), u));
+
+		const __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)),
+			_mm_add_ps(_mm_mul_ps(qz, qz), _mm_mul_ps(qw, qw)));
+		const __m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+		qx = _mm_mul_ps(qx, invLength);
+		qy = _mm_mul_ps(qy, invLength);
+		qz = _mm_mul_ps(qz, invLength);
+		qw = _mm_mul_ps(qw, invLength);
+
+		//
+		// S*R with the translation in the last row, as XMMatrixAffineTransformation
+		// builds it, one matrix element of the four tracks per register.
+		//
+
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 x2 = _mm_mul_ps(qx, two), y2 = _mm_mul_ps(qy, two), z2 = _mm_mul_ps(qz, two);
+		const __m128 xx = _mm_mul_ps(qx, x2), yy = _mm_mul_ps(qy, y2), zz = _mm_mul_ps(qz, z2);
+		const __m128 xy = _mm_mul_ps(qx, y2), xz = _mm_mul_ps(qx, z2), yz = _mm_mul_ps(qy, z2);
+		const __m128 wx = _mm_mul_ps(qw, x2), wy = _mm_mul_ps(qw, y2), wz = _mm_mul_ps(qw, z2);
+
+		__m128 rows[4][4];
+		rows[0][0] = _mm_mul_ps(sx, _mm_sub_ps(one, _mm_add_ps(yy, zz)));
+		rows[0][1] = _mm_mul_ps(sx, _mm_add_ps(xy, wz));
+		rows[0][2] = _mm_mul_ps(sx, _mm_sub_ps(xz, wy));
+		rows[0][3] = _mm_setzero_ps();
+		rows[1][0] = _mm_mul_ps(sy, _mm_sub_ps(xy, wz));
+		rows[1][1] = _mm_mul_ps(sy, _mm_sub_ps(one, _mm_add_ps(xx, zz)));
+		rows[1][2] = _mm_mul_ps(sy, _mm_add_ps(yz, wx));
+		rows[1][3] = _mm_setzero_ps();
+		rows[2][0] = _mm_mul_ps(sz, _mm_add_ps(xz, wy));
+		rows[2][1] = _mm_mul_ps(sz, _mm_sub_ps(yz, wx));
+		rows[2][2] = _mm_mul_ps(sz, _mm_sub_ps(one, _mm_add_ps(xx, yy)));
+		rows[2][3] = _mm_setzero_ps();
+		rows[3][0] = tx;
+		rows[3][1] = ty;
+		rows[3][2] = tz;
+		rows[3][3] = one;
+
+		// Transposing a row's four elements gives that row of each track.
+		for(UINT r = 0; r < 4; ++r)
+			_MM_TRANSPOSE4_PS(rows[r][0], rows[r][1], rows[r][2], rows[r][3]);
+
+		for(UINT j = 0; j < 4 && group + j < mTrackCount; ++j)
+		{
+			float* m = &toParent[group + j].m[0][0];
+			for(UINT r = 0; r < 4; ++r)
+				_mm_storeu_ps(m + 4*r, rows[r][j]);
+		}
+#else
+		for(UINT j = 0; j < 4 && group + j < mTrackCount; ++j)
+		{
+			auto lerp = [&](const std::vector<float>& c) { return c[k0[j]] + (c[k1[j]] - c[k0[j]])*f[j]; };
+
+			const float tx = lerp(mTx), ty = lerp(mTy), tz = lerp(mTz);
+			const float sx = lerp(mSx), sy = lerp(mSy), sz = lerp(mSz);
+
+			float bx = mQx[k1[j]], by = mQy[k1[j]], bz = mQz[k1[j]], bw = mQw[k1[j]];
+			const float ax = mQx[k0[j]], ay = mQy[k0[j]], az = mQz[k0[j]], aw = mQw[k0[j]];
+			float d = ax*bx + ay*by + az*bz + aw*bw;
+			if(d < 0.0f)
+			{
+				bx = -bx; by = -by; bz = -bz; bw = -bw;
+				d = -d;
+			}
+
+			const float u = CorrectFactor(f[j], d);
+			float qx = ax + (bx - ax)*u;
+			float qy = ay + (by - ay)*u;
+			float qz = az + (bz - az)*u;
+			float qw = aw + (bw - aw)*u;
+			const float invLength = 1.0f / std::sqrt(qx*qx + qy*qy + qz*qz + qw*qw);
+			qx *= invLength; qy *= invLength; qz *= invLength; qw *= invLength;
+
+			const float xx = 2.0f*qx*qx, yy = 2.0f*qy*qy, zz = 2.0f*qz*qz;
+			const float xy = 2.0f*qx*qy, xz = 2.0f*qx*qz, yz = 2.0f*qy*qz;
+			const float wx = 2.0f*qw*qx, wy = 2.0f*qw*qy, wz = 2.0f*qw*qz;
+
+			toParent[group + j] = XMFLOAT4X4(
+				sx*(1.0f - yy - zz), sx*(xy + wz),        sx*(xz - wy),        0.0f,
+				sy*(xy - wz),        sy*(1.0f - xx - zz), sy*(yz + wx),        0.0f,
+				sz*(xz + wy),        sz*(yz - wx),        sz*(1.0f - xx - yy), 0.0f,
+				tx,                  ty,                  tz,                  1.0f);
+		}
+#endif
+	}
+}
@@ -0,0 +1,79 @@
+//***************************************************************************************
+// ClipSampler.h
+//
+// Samples every bone of an AnimationClip at once.  BoneAnimation::Interpolate
+// searches each bone's keyframes from the start on every call and reads
+// translation, scale and rotation out of interleaved Keyframe structs; a
+// ClipSampler instead keeps the clip's keys in one array per component (times,
+// translation x, y, z, ...) with each bone's track a contiguous range, and each
+// playing instance keeps a Cursor with the current key of every track:
+//   -Playing forward moves a track's cursor at most a key or two a frame, so
+//    finding the keys is O(1) per track.
+//   -Going back (a loop) or jumping more than a few keys ahead is a seek, and
+//    binary searches the track's times.
+// Tracks are sampled four at a time: the two keys of each of four bones are
+// gathered into SSE2 registers, interpolated, and turned straight into the four
+// to-parent matrices.
+//
+// Rotations use normalized lerp with a correction of the interpolation factor
+// (Zeux Kapoulkine, "Approximating slerp") rather than slerp, which needs a sine
+// and an arc cosine per bone; the result is within 1e-4 of slerp.  Otherwise
+// the matrices are the ones BoneAnimation::Interpolate gives, clamped to the
+// first and last key outside a track's time range.
+//***************************************************************************************
+
+#pragma once
+
+#include "../../Common/d3dUtil.h"
+
+struct AnimationClip;
+
+class ClipSampler
+{
+public:
+	// Where one instance is in each track.  Starts anywhere; the first Sample
+	// seeks every track.
+	struct Cursor
+	{
+		std::vector<UINT> Keys;
+	};
+
+	ClipSampler() = default;
+	explicit ClipSampler(const AnimationClip& clip);
+
+	///<summary>
+	/// Writes the to-parent transform of every track (bone) at time t, as
+	/// BoneAnimation::Interpolate does for each, to toParent[0..GetTrackCount()).
+	/// The cursor is resized for this clip if it isn't already.
+	///</summary>
+	void Sample(float t, Cursor& cursor, DirectX::XMFLOAT4X4* toParent)const;
+
+	UINT GetTrackCount()const { return mTrackCount; }
+	UINT GetKeyCount()const { return (UINT)mTimes.size(); }
+	float GetStartTime()const { return mStartTime; }
+	float GetEndTime()const { return mEndTime; }
+
+	///<summary>
+	/// Keys a cursor can move through linearly before it seeks instead.
+	///</summary>
+	static const UINT MaxLinearSteps = 4;
+
+private:
+	// The key k of track such that Times[k] <= t < Times[k + 1], starting from
+	// key, clamped to the track's first and second to last keys.
+	UINT FindKey(UINT track, float t, UINT key)const;
+
+	UINT mTrackCount = 0;
+	float mStartTime = 0.0f;
+	float mEndTime = 0.0f;
+
+	// Per track, padded with identity tracks to a multiple of 4: its first key in
+	// the arrays below and its key count.
+	std::vector<UINT> mFirstKey;
+	std::vector<UINT> mKeyCount;
+
+	std::vector<float> mTimes;
+	std::vector<float> mTx, mTy, mTz;
+	std::vector<float> mSx, mSy, mSz;
+	std::vector<float> mQx, mQy, mQz, mQw;
+};
@@ -0,0 +1,47 @@
+//***************************************************************************************
+// CrowdAnimator.cpp
+//***************************************************************************************
+
+#include "CrowdAnimator.h"
+#include <cmath>
+#include "../../Common/TaskScheduler.h"
+#include "PoseCache.h"
+
+using namespace DirectX;
+
+CrowdAnimator::CrowdAnimator(const SkinnedData& skinnedInfo, TaskScheduler& scheduler) :
+	mSkinnedInfo(skinnedInfo),
+	mScheduler(scheduler)
+{
+}
+
+UINT CrowdAnimator::AddInstance(SkinnedData::ClipHandle clip, float timePos)
+{
+	Instance instance;
+	instance.Clip = clip;
+	instance.TimePos = timePos;
+	mInstances.push_back(std::move(instance));
+
+	return (UINT)mInstances.size() - 1;
+}
+
+void CrowdAnimator::Update(float dt, BYTE* palettes, UINT paletteStride)
+{
+	mScheduler.ParallelFor(mInstances.size(), InstancesPerTask, [&](unsigned, size_t i)
+	{
+		Instance& instance = mInstances[i];
+
+		// Loop animation, keeping the time past the end so instances that started
+		// apart stay apart.
+		instance.TimePos += dt;
+		const float endTime = mSkinnedInfo.GetClipEndTime(instance.Clip);
+		if(instance.TimePos > endTime)
+			instance.TimePos = endTime > 0.0f ? std::fmod(instance.TimePos, endTime) : 0.0f;
+
+		XMFLOAT4X4* palette = reinterpret_cast<XMFLOAT4X4*>(palettes + i*paletteStride);
+		if(mPoseCache != nullptr)
+			mPoseCache->GetFinalTransforms(instance.Clip, instance.TimePos, instance.Pose, palette);
+		else
+			mSkinnedInfo.GetFinalTransforms(instance.Clip, instance.TimePos, instance.Pose, palette);
+	});
+}
@@ -0,0 +1,68 @@
+//***************************************************************************************
+// CrowdAnimator.h
+//
+// Animates many instances of one skinned model.  Each instance plays a clip from
+// its own time with its own SkinnedData::Pose; Update advances them all and
+// evaluates their poses in parallel on a TaskScheduler, writing each instance's
+// bone palette straight into its slot of per-frame upload memory (the frame's
+// skinned constant buffer), so there is no copy through a temporary.
+//
+// Instances are evaluated InstancesPerTask at a time: enough to amortize taking
+// work from a queue, few enough that a crowd of a few hundred still spreads
+// over every core.
+//
+// With a PoseCache, instances at the same point of the same clip share one
+// evaluated pose.
+//***************************************************************************************
+
+#pragma once
+
+#include "SkinnedData.h"
+
+class PoseCache;
+class TaskScheduler;
+
+class CrowdAnimator
+{
+public:
+	struct Instance
+	{
+		SkinnedData::ClipHandle Clip = SkinnedData::InvalidClip;
+		float TimePos = 0.0f;
+		SkinnedData::Pose Pose;
+	};
+
+	CrowdAnimator(const SkinnedData& skinnedInfo, TaskScheduler& scheduler);
+
+	CrowdAnimator(const CrowdAnimator& rhs) = delete;
+	CrowdAnimator& operator=(const CrowdAnimator& rhs) = delete;
+
+	///<summary>
+	/// Adds an instance playing clip from timePos and returns its index, which is
+	/// also its palette's index in Update.
+	///</summary>
+	UINT AddInstance(SkinnedData::ClipHandle clip, float timePos);
+
+	///<summary>
+	/// Takes poses from cache, which must be for the same SkinnedData, or
+	/// evaluates every instance's own if cache is nullptr.
+	///</summary>
+	void SetPoseCache(PoseCache* cache) { mPoseCache = cache; }
+
+	UINT GetInstanceCount()const { return (UINT)mInstances.size(); }
+	const Instance& GetInstance(UINT i)const { return mInstances[i]; }
+
+	///<summary>
+	/// Advances every instance by dt, looping its clip, and writes instance i's
+	/// final transforms to the BoneCount() matrices at palettes + i*paletteStride.
+	///</summary>
+	void Update(float dt, BYTE* palettes, UINT paletteStride);
+
+	static const UINT InstancesPerTask = 4;
+
+private:
+	const SkinnedData& mSkinnedInfo;
+	TaskScheduler& mScheduler;
+	PoseCache* mPoseCache = nullptr;
+	std::vector<Instance> mInstances;
+};
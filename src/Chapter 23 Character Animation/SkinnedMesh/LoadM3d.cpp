@@ -1,13 +1,43 @@
 #include "LoadM3d.h"
+#include "M3dBinary.h"
  
 using namespace DirectX;
 
+bool M3DLoader::ReadBoneCount(const std::string& filename, UINT& numBones)
+{
+	std::ifstream fin(filename);
+
+	std::string ignore;
+	UINT count = 0;
+	fin >> ignore; // file header text
+	fin >> ignore >> count; // materials
+	fin >> ignore >> count; // vertices
+	fin >> ignore >> count; // triangles
+	fin >> ignore >> numBones;
+
+	return !fin.fail();
+}
+
 bool M3DLoader::LoadM3d(const std::string& filename, 
 						std::vector<Vertex>& vertices,
 						std::vector<USHORT>& indices,
 						std::vector<Subset>& subsets,
 						std::vector<M3dMaterial>& mats)
 {
+	// Files written by M3dBinaryFile load through the same interface.
+	if(M3dBinaryFile::IsM3dBinary(filename))
+	{
+		M3dBinaryFile file;
+		if(!file.Open(filename) || file.IsSkinned())
+			return false;
+
+		vertices.assign(file.GetVertices(), file.GetVertices() + file.GetVertexCount());
+		indices.assign(file.GetIndices(), file.GetIndices() + file.GetIndexCount());
+		file.GetSubsets(subsets);
+		file.GetMaterials(mats);
+		return true;
+	}
+
 	std::ifstream fin(filename);
 
 	UINT numMaterials = 0;
@@ -44,6 +74,20 @@ bool M3DLoader::LoadM3d(const std::string& filename,
 						std::vector<M3dMaterial>& mats,
 						SkinnedData& skinInfo)
 {
+	if(M3dBinaryFile::IsM3dBinary(filename))
+	{
+		M3dBinaryFile file;
+		if(!file.Open(filename) || !file.IsSkinned())
+			return false;
+
+		vertices.assign(file.GetSkinnedVertices(), file.GetSkinnedVertices() + file.GetVertexCount());
+		indices.assign(file.GetIndices(), file.GetIndices() + file.GetIndexCount());
+		file.GetSubsets(subsets);
+		file.GetMaterials(mats);
+		file.GetSkinnedData(skinInfo);
+		return true;
+	}
+
     std::ifstream fin(filename);
 
 	UINT numMaterials = 0;
@@ -75,7 +119,7 @@ bool M3DLoader::LoadM3d(const std::string& filename,
 	    ReadBoneHierarchy(fin, numBones, boneIndexToParentIndex);
 	    ReadAnimationClips(fin, numBones, numAnimationClips, animations);
  
-		skinInfo.Set(boneIndexToParentIndex, boneOffsets, animations);
+		skinInfo.Set(std::move(boneIndexToParentIndex), std::move(boneOffsets), std::move(animations));
 
 	    return true;
 	}
@@ -224,7 +268,7 @@ void M3DLoader::ReadAnimationClips(std::ifstream& fin, UINT numBones, UINT numAn
         }
         fin >> ignore; // }
 
-        animations[clipName] = clip;
+        animations[clipName] = std::move(clip);
     }
 }
 
@@ -61,6 +61,10 @@ public:
 		std::vector<M3dMaterial>& mats,
 		SkinnedData& skinInfo);
 
+	// Bone count from the header of a text .m3d file; skinned models have bones and
+	// load with the SkinnedVertex overload.  Returns false if the header can't be read.
+	static bool ReadBoneCount(const std::string& filename, UINT& numBones);
+
 private:
 	void ReadMaterials(std::ifstream& fin, UINT numMaterials, std::vector<M3dMaterial>& mats);
 	void ReadSubsetTable(std::ifstream& fin, UINT numSubsets, std::vector<Subset>& subsets);
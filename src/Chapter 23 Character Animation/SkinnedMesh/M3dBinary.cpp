@@ -0,0 +1,448 @@
+//***************************************************************************************
+// M3dBinary.cpp
+//***************************************************************************************
+
+#include "M3dBinary.h"
+#include "../../Common/BoundingVolumes.h"
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+
+using namespace DirectX;
+
+namespace
+{
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	const size_t SectionAlignment = 16;
+
+	class StringTable
+	{
+	public:
+		uint32 Add(const std::string& s)
+		{
+			uint32 offset = (uint32)Data.size();
+			Data.insert(Data.end(), s.begin(), s.end());
+			Data.push_back('\0');
+			return offset;
+		}
+
+		std::vector<char> Data;
+	};
+
+	template<typename T>
+	M3dbSection AppendSection(std::vector<char>& file, const T* records, size_t count)
+	{
+		file.resize((file.size() + SectionAlignment - 1) & ~(SectionAlignment - 1), 0);
+
+		M3dbSection section;
+		section.Offset = file.size();
+		section.Size = count*sizeof(T);
+		if(count > 0)
+		{
+			const char* bytes = reinterpret_cast<const char*>(records);
+			file.insert(file.end(), bytes, bytes + section.Size);
+		}
+
+		return section;
+	}
+
+	template<typename T>
+	M3dbSection AppendSection(std::vector<char>& file, const std::vector<T>& records)
+	{
+		return AppendSection(file, records.data(), records.size());
+	}
+
+	bool SectionValid(const M3dbSection& section, uint64 recordCount, size_t recordSize, size_t fileSize)
+	{
+		return section.Offset % SectionAlignment == 0 &&
+			section.Offset <= fileSize &&
+			section.Size <= fileSize - section.Offset &&
+			section.Size == recordCount*recordSize;
+	}
+
+	bool WriteModel(const std::string& filename, uint32 flags, uint32 vertexStride,
+		const void* vertices, size_t vertexCount,
+		const std::vector<USHORT>& indices,
+		const std::vector<M3DLoader::Subset>& subsets,
+		const std::vector<M3DLoader::M3dMaterial>& mats,
+		const SkinnedData* skinInfo)
+	{
+		M3dbHeader header = {};
+		header.Magic = M3dBinaryFile::Magic;
+		header.Version = M3dBinaryFile::Version;
+		header.Flags = flags;
+		header.VertexStride = vertexStride;
+		header.VertexCount = (uint32)vertexCount;
+		header.IndexCount = (uint32)indices.size();
+		header.SubsetCount = (uint32)subsets.size();
+		header.MaterialCount = (uint32)mats.size();
+
+		static_assert(offsetof(M3DLoader::Vertex, Pos) == 0 && offsetof(M3DLoader::SkinnedVertex, Pos) == 0,
+			"Bounds read the positions at the start of each vertex.");
+		if(vertexCount > 0)
+			header.Bounds = BoundingVolumes::ComputeAabb(static_cast<const XMFLOAT3*>(vertices), vertexStride, vertexCount);
+
+		StringTable strings;
+
+		std::vector<M3dbSubset> fileSubsets(subsets.size());
+		for(size_t i = 0; i < subsets.size(); ++i)
+		{
+			fileSubsets[i].Id = subsets[i].Id;
+			fileSubsets[i].VertexStart = subsets[i].VertexStart;
+			fileSubsets[i].VertexCount = subsets[i].VertexCount;
+			fileSubsets[i].FaceStart = subsets[i].FaceStart;
+			fileSubsets[i].FaceCount = subsets[i].FaceCount;
+		}
+
+		std::vector<M3dbMaterial> fileMats(mats.size());
+		for(size_t i = 0; i < mats.size(); ++i)
+		{
+			fileMats[i].DiffuseAlbedo = mats[i].DiffuseAlbedo;
+			fileMats[i].FresnelR0 = mats[i].FresnelR0;
+			fileMats[i].Roughness = mats[i].Roughness;
+			fileMats[i].AlphaClip = mats[i].AlphaClip ? 1 : 0;
+			fileMats[i].Name = strings.Add(mats[i].Name);
+			fileMats[i].MaterialTypeName = strings.Add(mats[i].MaterialTypeName);
+			fileMats[i].DiffuseMapName = strings.Add(mats[i].DiffuseMapName);
+			fileMats[i].NormalMapName = strings.Add(mats[i].NormalMapName);
+		}
+
+		//
+		// Flatten the clips.  They are written in name order so converting the same
+		// model always gives the same file.
+		//
+
+		std::vector<M3dbClip> clips;
+		std::vector<M3dbBoneAnimation> boneAnimations;
+		std::vector<M3dbKeyframe> keyframes;
+		if(skinInfo != nullptr)
+		{
+			header.BoneCount = skinInfo->BoneCount();
+
+			std::vector<std::string> clipNames;
+			for(const auto& clip : skinInfo->GetAnimations())
+				clipNames.push_back(clip.first);
+			std::sort(clipNames.begin(), clipNames.end());
+
+			for(const std::string& name : clipNames)
+			{
+				const AnimationClip& clip = skinInfo->GetAnimations().at(name);
+				if(clip.BoneAnimations.size() != header.BoneCount)
+					return false;
+
+				M3dbClip fileClip;
+				fileClip.Name = strings.Add(name);
+				fileClip.FirstBoneAnimation = (uint32)boneAnimations.size();
+				clips.push_back(fileClip);
+
+				for(const BoneAnimation& boneAnimation : clip.BoneAnimations)
+				{
+					M3dbBoneAnimation fileBoneAnimation;
+					fileBoneAnimation.FirstKeyframe = (uint32)keyframes.size();
+					fileBoneAnimation.KeyframeCount = (uint32)boneAnimation.Keyframes.size();
+					boneAnimations.push_back(fileBoneAnimation);
+
+					for(const Keyframe& keyframe : boneAnimation.Keyframes)
+					{
+						M3dbKeyframe fileKeyframe;
+						fileKeyframe.TimePos = keyframe.TimePos;
+						fileKeyframe.Translation = keyframe.Translation;
+						fileKeyframe.Scale = keyframe.Scale;
+						fileKeyframe.RotationQuat = keyframe.RotationQuat;
+						keyframes.push_back(fileKeyframe);
+					}
+				}
+			}
+
+			header.ClipCount = (uint32)clips.size();
+			header.KeyframeCount = (uint32)keyframes.size();
+		}
+
+		header.StringsSize = (uint32)strings.Data.size();
+
+		//
+		// Lay out the file behind the header.
+		//
+
+		std::vector<char> file(sizeof(M3dbHeader), 0);
+		header.Vertices = AppendSection(file, static_cast<const char*>(vertices), vertexCount*vertexStride);
+		header.Indices = AppendSection(file, indices);
+		header.Subsets = AppendSection(file, fileSubsets);
+		header.Materials = AppendSection(file, fileMats);
+		if(skinInfo != nullptr)
+		{
+			header.BoneOffsets = AppendSection(file, skinInfo->GetBoneOffsets());
+			header.BoneHierarchy = AppendSection(file, skinInfo->GetBoneHierarchy());
+		}
+		else
+		{
+			header.BoneOffsets = AppendSection(file, static_cast<const XMFLOAT4X4*>(nullptr), 0);
+			header.BoneHierarchy = AppendSection(file, static_cast<const int*>(nullptr), 0);
+		}
+		header.Clips = AppendSection(file, clips);
+		header.BoneAnimations = AppendSection(file, boneAnimations);
+		header.Keyframes = AppendSection(file, keyframes);
+		header.Strings = AppendSection(file, strings.Data);
+
+		memcpy(file.data(), &header, sizeof(M3dbHeader));
+
+		std::ofstream fout(filename, std::ios::binary);
+		fout.write(file.data(), file.size());
+		return !fout.fail();
+	}
+}
+
+bool M3dBinaryFile::IsM3dBinary(const std::string& filename)
+{
+	std::ifstream fin(filename, std::ios::binary);
+
+	uint32 magic = 0;
+	fin.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+	return !fin.fail() && magic == Magic;
+}
+
+bool M3dBinaryFile::Write(const std::string& filename,
+	const std::vector<M3DLoader::SkinnedVertex>& vertices,
+	const std::vector<USHORT>& indices,
+	const std::vector<M3DLoader::Subset>& subsets,
+	const std::vector<M3DLoader::M3dMaterial>& mats,
+	const SkinnedData& skinInfo)
+{
+	return WriteModel(filename, SkinnedFlag, sizeof(M3DLoader::SkinnedVertex), vertices.data(), vertices.size(),
+		indices, subsets, mats, &skinInfo);
+}
+
+bool M3dBinaryFile::Write(const std::string& filename,
+	const std::vector<M3DLoader::Vertex>& vertices,
+	const std::vector<USHORT>& indices,
+	const std::vector<M3DLoader::Subset>& subsets,
+	const std::vector<M3DLoader::M3dMaterial>& mats)
+{
+	return WriteModel(filename, 0, sizeof(M3DLoader::Vertex), vertices.data(), vertices.size(),
+		indices, subsets, mats, nullptr);
+}
+
+bool M3dBinaryFile::Convert(const std::string& m3dFilename, const std::string& binaryFilename)
+{
+	UINT numBones = 0;
+	if(!M3DLoader::ReadBoneCount(m3dFilename, numBones))
+		return false;
+
+	M3DLoader m3dLoader;
+	std::vector<USHORT> indices;
+	std::vector<M3DLoader::Subset> subsets;
+	std::vector<M3DLoader::M3dMaterial> mats;
+
+	if(numBones > 0)
+	{
+		std::vector<M3DLoader::SkinnedVertex> vertices;
+		SkinnedData skinInfo;
+		return m3dLoader.LoadM3d(m3dFilename, vertices, indices, subsets, mats, skinInfo) &&
+			Write(binaryFilename, vertices, indices, subsets, mats, skinInfo);
+	}
+
+	std::vector<M3DLoader::Vertex> vertices;
+	return m3dLoader.LoadM3d(m3dFilename, vertices, indices, subsets, mats) &&
+		Write(binaryFilename, vertices, indices, subsets, mats);
+}
+
+bool M3dBinaryFile::Open(const std::string& filename)
+{
+	Close();
+
+	if(!mFile.Open(filename) || mFile.Size() < sizeof(M3dbHeader))
+	{
+		Close();
+		return false;
+	}
+
+	const M3dbHeader& h = *reinterpret_cast<const M3dbHeader*>(mFile.Begin());
+	size_t fileSize = mFile.Size();
+
+	bool skinned = (h.Flags & SkinnedFlag) != 0;
+	size_t vertexStride = skinned ? sizeof(M3DLoader::SkinnedVertex) : sizeof(M3DLoader::Vertex);
+
+	bool valid =
+		h.Magic == Magic && h.Version == Version &&
+		h.VertexStride == vertexStride && h.IndexCount % 3 == 0 &&
+		SectionValid(h.Vertices, h.VertexCount, vertexStride, fileSize) &&
+		SectionValid(h.Indices, h.IndexCount, sizeof(USHORT), fileSize) &&
+		SectionValid(h.Subsets, h.SubsetCount, sizeof(M3dbSubset), fileSize) &&
+		SectionValid(h.Materials, h.MaterialCount, sizeof(M3dbMaterial), fileSize) &&
+		SectionValid(h.BoneOffsets, h.BoneCount, sizeof(XMFLOAT4X4), fileSize) &&
+		SectionValid(h.BoneHierarchy, h.BoneCount, sizeof(int), fileSize) &&
+		SectionValid(h.Clips, h.ClipCount, sizeof(M3dbClip), fileSize) &&
+		SectionValid(h.BoneAnimations, (uint64)h.ClipCount*h.BoneCount, sizeof(M3dbBoneAnimation), fileSize) &&
+		SectionValid(h.Keyframes, h.KeyframeCount, sizeof(M3dbKeyframe), fileSize) &&
+		SectionValid(h.Strings, h.StringsSize, sizeof(char), fileSize) &&
+		(h.StringsSize == 0 || mFile.Begin()[h.Strings.Offset + h.StringsSize - 1] == '\0');
+
+	if(!valid)
+	{
+		Close();
+		return false;
+	}
+
+	mHeader = &h;
+
+	//
+	// The counts and offsets stored in the records must stay inside their sections.
+	//
+
+	for(UINT i = 0; i < h.SubsetCount && valid; ++i)
+	{
+		const M3dbSubset& subset = GetSection<M3dbSubset>(h.Subsets)[i];
+		valid = (uint64)subset.FaceStart + subset.FaceCount <= h.IndexCount / 3 &&
+			(uint64)subset.VertexStart + subset.VertexCount <= h.VertexCount;
+	}
+
+	// Indices are drawn with a base vertex of 0, so each must name a vertex.
+	const USHORT* indices = GetSection<USHORT>(h.Indices);
+	for(UINT i = 0; i < h.IndexCount && valid; ++i)
+		valid = indices[i] < h.VertexCount;
+
+	// The skinning shader indexes the bone palette with these.
+	if(skinned)
+	{
+		const M3DLoader::SkinnedVertex* vertices = GetSection<M3DLoader::SkinnedVertex>(h.Vertices);
+		for(UINT i = 0; i < h.VertexCount && valid; ++i)
+		{
+			for(int j = 0; j < 4 && valid; ++j)
+				valid = vertices[i].BoneIndices[j] < h.BoneCount;
+		}
+	}
+
+	for(UINT i = 0; i < h.MaterialCount && valid; ++i)
+	{
+		const M3dbMaterial& mat = GetSection<M3dbMaterial>(h.Materials)[i];
+		valid = mat.Name < h.StringsSize && mat.MaterialTypeName < h.StringsSize &&
+			mat.DiffuseMapName < h.StringsSize && mat.NormalMapName < h.StringsSize;
+	}
+
+	// GetFinalTransforms visits parents before their children.
+	for(UINT i = 0; i < h.BoneCount && valid; ++i)
+	{
+		int parent = GetSection<int>(h.BoneHierarchy)[i];
+		valid = i == 0 ? parent < 0 : (parent >= 0 && (UINT)parent < i);
+	}
+
+	for(UINT i = 0; i < h.ClipCount && valid; ++i)
+	{
+		const M3dbClip& clip = GetSection<M3dbClip>(h.Clips)[i];
+		valid = clip.Name < h.StringsSize && (uint64)clip.FirstBoneAnimation + h.BoneCount <= (uint64)h.ClipCount*h.BoneCount;
+	}
+
+	for(uint64 i = 0; i < (uint64)h.ClipCount*h.BoneCount && valid; ++i)
+	{
+		const M3dbBoneAnimation& boneAnimation = GetSection<M3dbBoneAnimation>(h.BoneAnimations)[i];
+		valid = (uint64)boneAnimation.FirstKeyframe + boneAnimation.KeyframeCount <= h.KeyframeCount;
+	}
+
+	if(!valid)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void M3dBinaryFile::Close()
+{
+	mFile.Close();
+	mHeader = nullptr;
+}
+
+const M3DLoader::SkinnedVertex* M3dBinaryFile::GetSkinnedVertices()const
+{
+	return IsSkinned() ? GetSection<M3DLoader::SkinnedVertex>(mHeader->Vertices) : nullptr;
+}
+
+const M3DLoader::Vertex* M3dBinaryFile::GetVertices()const
+{
+	return IsSkinned() ? nullptr : GetSection<M3DLoader::Vertex>(mHeader->Vertices);
+}
+
+const USHORT* M3dBinaryFile::GetIndices()const
+{
+	return GetSection<USHORT>(mHeader->Indices);
+}
+
+void M3dBinaryFile::GetSubsets(std::vector<M3DLoader::Subset>& subsets)const
+{
+	const M3dbSubset* fileSubsets = GetSection<M3dbSubset>(mHeader->Subsets);
+
+	subsets.resize(mHeader->SubsetCount);
+	for(UINT i = 0; i < mHeader->SubsetCount; ++i)
+	{
+		subsets[i].Id = fileSubsets[i].Id;
+		subsets[i].VertexStart = fileSubsets[i].VertexStart;
+		subsets[i].VertexCount = fileSubsets[i].VertexCount;
+		subsets[i].FaceStart = fileSubsets[i].FaceStart;
+		subsets[i].FaceCount = fileSubsets[i].FaceCount;
+	}
+}
+
+void M3dBinaryFile::GetMaterials(std::vector<M3DLoader::M3dMaterial>& mats)const
+{
+	const M3dbMaterial* fileMats = GetSection<M3dbMaterial>(mHeader->Materials);
+
+	mats.resize(mHeader->MaterialCount);
+	for(UINT i = 0; i < mHeader->MaterialCount; ++i)
+	{
+		mats[i].Name = GetString(fileMats[i].Name);
+		mats[i].DiffuseAlbedo = fileMats[i].DiffuseAlbedo;
+		mats[i].FresnelR0 = fileMats[i].FresnelR0;
+		mats[i].Roughness = fileMats[i].Roughness;
+		mats[i].AlphaClip = fileMats[i].AlphaClip != 0;
+		mats[i].MaterialTypeName = GetString(fileMats[i].MaterialTypeName);
+		mats[i].DiffuseMapName = GetString(fileMats[i].DiffuseMapName);
+		mats[i].NormalMapName = GetString(fileMats[i].NormalMapName);
+	}
+}
+
+void M3dBinaryFile::GetSkinnedData(SkinnedData& skinInfo)const
+{
+	const UINT numBones = mHeader->BoneCount;
+
+	const int* hierarchy = GetSection<int>(mHeader->BoneHierarchy);
+	const XMFLOAT4X4* offsets = GetSection<XMFLOAT4X4>(mHeader->BoneOffsets);
+	const M3dbClip* clips = GetSection<M3dbClip>(mHeader->Clips);
+	const M3dbBoneAnimation* boneAnimations = GetSection<M3dbBoneAnimation>(mHeader->BoneAnimations);
+	const M3dbKeyframe* keyframes = GetSection<M3dbKeyframe>(mHeader->Keyframes);
+
+	std::unordered_map<std::string, AnimationClip> animations;
+	for(UINT clipIndex = 0; clipIndex < mHeader->ClipCount; ++clipIndex)
+	{
+		AnimationClip& clip = animations[GetString(clips[clipIndex].Name)];
+		clip.BoneAnimations.resize(numBones);
+
+		for(UINT boneIndex = 0; boneIndex < numBones; ++boneIndex)
+		{
+			const M3dbBoneAnimation& boneAnimation = boneAnimations[clips[clipIndex].FirstBoneAnimation + boneIndex];
+
+			std::vector<Keyframe>& clipKeyframes = clip.BoneAnimations[boneIndex].Keyframes;
+			clipKeyframes.resize(boneAnimation.KeyframeCount);
+			for(UINT i = 0; i < boneAnimation.KeyframeCount; ++i)
+			{
+				const M3dbKeyframe& keyframe = keyframes[boneAnimation.FirstKeyframe + i];
+				clipKeyframes[i].TimePos = keyframe.TimePos;
+				clipKeyframes[i].Translation = keyframe.Translation;
+				clipKeyframes[i].Scale = keyframe.Scale;
+				clipKeyframes[i].RotationQuat = keyframe.RotationQuat;
+			}
+		}
+	}
+
+	skinInfo.Set(
+		std::vector<int>(hierarchy, hierarchy + numBones),
+		std::vector<XMFLOAT4X4>(offsets, offsets + numBones),
+		std::move(animations));
+}
+
+const char* M3dBinaryFile::GetString(std::uint32_t offset)const
+{
+	return GetSection<char>(mHeader->Strings) + offset;
+}
@@ -0,0 +1,199 @@
+//***************************************************************************************
+// M3dBinary.h
+//
+// Binary container for the content of an .m3d file: vertices, 16-bit triangles,
+// subsets, materials, bone offsets, bone hierarchy and animation clips.
+//
+// The file is a header followed by sections, each a flat array of fixed-size
+// records at a 16-byte aligned offset:
+//
+//   Vertices        M3DLoader::SkinnedVertex or M3DLoader::Vertex, exactly as
+//                   the vertex buffer wants them
+//   Indices         uint16, 3 per triangle
+//   Subsets         M3dbSubset
+//   Materials       M3dbMaterial, names as offsets into Strings
+//   BoneOffsets     XMFLOAT4X4
+//   BoneHierarchy   int32 parent index
+//   Clips           M3dbClip: name and first entry in BoneAnimations
+//   BoneAnimations  M3dbBoneAnimation, BoneCount per clip: a keyframe range
+//   Keyframes       M3dbKeyframe
+//   Strings         null-terminated UTF-8
+//
+// Numbers are stored little-endian in the in-memory layout of the structs, so a
+// mapped file is used without parsing: the vertex and index sections can be
+// handed straight to d3dUtil::CreateDefaultBuffer.  Only materials, subsets and
+// the animation data are copied out.  The header carries a version number; a
+// loader rejects files of any other version rather than guessing.
+//
+// Version 2 added the bounding box of the vertex positions (the bind pose for a
+// skinned model) to the header.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <DirectXCollision.h>
+#include <string>
+#include <vector>
+#include "../../Common/MappedFile.h"
+#include "LoadM3d.h"
+
+struct M3dbSection
+{
+	std::uint64_t Offset = 0;
+	std::uint64_t Size = 0;
+};
+
+struct M3dbHeader
+{
+	std::uint32_t Magic;
+	std::uint32_t Version;
+	std::uint32_t Flags;
+	std::uint32_t VertexStride;
+
+	std::uint32_t VertexCount;
+	std::uint32_t IndexCount;
+	std::uint32_t SubsetCount;
+	std::uint32_t MaterialCount;
+	std::uint32_t BoneCount;
+	std::uint32_t ClipCount;
+	std::uint32_t KeyframeCount;
+	std::uint32_t StringsSize;
+
+	DirectX::BoundingBox Bounds;
+
+	M3dbSection Vertices;
+	M3dbSection Indices;
+	M3dbSection Subsets;
+	M3dbSection Materials;
+	M3dbSection BoneOffsets;
+	M3dbSection BoneHierarchy;
+	M3dbSection Clips;
+	M3dbSection BoneAnimations;
+	M3dbSection Keyframes;
+	M3dbSection Strings;
+};
+
+struct M3dbSubset
+{
+	std::uint32_t Id;
+	std::uint32_t VertexStart;
+	std::uint32_t VertexCount;
+	std::uint32_t FaceStart;
+	std::uint32_t FaceCount;
+};
+
+struct M3dbMaterial
+{
+	DirectX::XMFLOAT4 DiffuseAlbedo;
+	DirectX::XMFLOAT3 FresnelR0;
+	float Roughness;
+	std::uint32_t AlphaClip;
+
+	std::uint32_t Name;
+	std::uint32_t MaterialTypeName;
+	std::uint32_t DiffuseMapName;
+	std::uint32_t NormalMapName;
+};
+
+struct M3dbClip
+{
+	std::uint32_t Name;
+	std::uint32_t FirstBoneAnimation;
+};
+
+struct M3dbBoneAnimation
+{
+	std::uint32_t FirstKeyframe;
+	std::uint32_t KeyframeCount;
+};
+
+struct M3dbKeyframe
+{
+	float TimePos;
+	DirectX::XMFLOAT3 Translation;
+	DirectX::XMFLOAT3 Scale;
+	DirectX::XMFLOAT4 RotationQuat;
+};
+
+class M3dBinaryFile
+{
+public:
+	// "M3DB"
+	static const std::uint32_t Magic = 0x4244334d;
+	static const std::uint32_t Version = 2;
+
+	// Set when the vertices are M3DLoader::SkinnedVertex.
+	static const std::uint32_t SkinnedFlag = 0x1;
+
+	///<summary>
+	/// True if filename starts with the binary header, whatever its version.
+	///</summary>
+	static bool IsM3dBinary(const std::string& filename);
+
+	///<summary>
+	/// Writes the content of a skinned or a static model to filename.
+	///</summary>
+	static bool Write(const std::string& filename,
+		const std::vector<M3DLoader::SkinnedVertex>& vertices,
+		const std::vector<USHORT>& indices,
+		const std::vector<M3DLoader::Subset>& subsets,
+		const std::vector<M3DLoader::M3dMaterial>& mats,
+		const SkinnedData& skinInfo);
+	static bool Write(const std::string& filename,
+		const std::vector<M3DLoader::Vertex>& vertices,
+		const std::vector<USHORT>& indices,
+		const std::vector<M3DLoader::Subset>& subsets,
+		const std::vector<M3DLoader::M3dMaterial>& mats);
+
+	///<summary>
+	/// Loads a text .m3d file and writes it as binary.  A model with bones is
+	/// written with skinned vertices.
+	///</summary>
+	static bool Convert(const std::string& m3dFilename, const std::string& binaryFilename);
+
+	///<summary>
+	/// Maps filename and checks the header, that every section lies inside the
+	/// file and agrees with the counts, and that subset ranges, indices and bone
+	/// indices stay inside the vertex, index and bone counts.  Returns false for
+	/// anything else, including other versions of the format.
+	///</summary>
+	bool Open(const std::string& filename);
+	void Close();
+
+	bool IsSkinned()const { return (mHeader->Flags & SkinnedFlag) != 0; }
+
+	///<summary>
+	/// The vertex and index sections, pointing into the mapped file.  They stay
+	/// valid until the file is closed.  GetSkinnedVertices/GetVertices return null
+	/// if the file holds the other vertex type.
+	///</summary>
+	const M3DLoader::SkinnedVertex* GetSkinnedVertices()const;
+	const M3DLoader::Vertex* GetVertices()const;
+	const USHORT* GetIndices()const;
+	UINT GetVertexCount()const { return mHeader->VertexCount; }
+	UINT GetIndexCount()const { return mHeader->IndexCount; }
+	UINT GetVertexStride()const { return mHeader->VertexStride; }
+	const DirectX::BoundingBox& GetBounds()const { return mHeader->Bounds; }
+
+	void GetSubsets(std::vector<M3DLoader::Subset>& subsets)const;
+	void GetMaterials(std::vector<M3DLoader::M3dMaterial>& mats)const;
+
+	///<summary>
+	/// Builds the same SkinnedData that M3DLoader::LoadM3d builds from the text
+	/// file.
+	///</summary>
+	void GetSkinnedData(SkinnedData& skinInfo)const;
+
+private:
+	template<typename T>
+	const T* GetSection(const M3dbSection& section)const
+	{
+		return reinterpret_cast<const T*>(mFile.Begin() + section.Offset);
+	}
+
+	const char* GetString(std::uint32_t offset)const;
+
+	MappedFile mFile;
+	const M3dbHeader* mHeader = nullptr;
+};
@@ -0,0 +1,105 @@
+//***************************************************************************************
+// PoseCache.cpp
+//***************************************************************************************
+
+#include "PoseCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+PoseCache::PoseCache(const SkinnedData& skinnedInfo, const Settings& settings) :
+	mSkinnedInfo(skinnedInfo),
+	mSettings(settings),
+	mBoneCount(skinnedInfo.BoneCount()),
+	mHits(0),
+	mMisses(0),
+	mEvictions(0)
+{
+	const UINT setCount = (std::max)((mSettings.MaxPoses + Ways - 1) / Ways, 1u);
+	mSettings.MaxPoses = setCount*Ways;
+	if(!(mSettings.TimeStep > 0.0f))
+		mSettings.TimeStep = Settings().TimeStep;
+
+	mSets = std::vector<Set>(setCount);
+	mPalettes.resize((size_t)mSettings.MaxPoses*mBoneCount);
+	Clear();
+}
+
+bool PoseCache::GetFinalTransforms(SkinnedData::ClipHandle clip, float timePos, SkinnedData::Pose& pose,
+	XMFLOAT4X4* finalTransforms)
+{
+	const std::uint32_t tick = (std::uint32_t)(std::max)(std::floor(timePos / mSettings.TimeStep + 0.5f), 0.0f);
+	const std::uint64_t key = ((std::uint64_t)clip << 32) | tick;
+
+	// Fibonacci hashing spreads consecutive ticks over the sets.
+	const UINT setIndex = (UINT)(((key*0x9E3779B97F4A7C15ull) >> 32) % mSets.size());
+	Set& set = mSets[setIndex];
+
+	std::lock_guard<std::mutex> lock(set.Lock);
+	++set.Clock;
+
+	UINT way = Ways;
+	for(UINT w = 0; w < Ways; ++w)
+	{
+		if(set.Keys[w] == key)
+			way = w;
+	}
+
+	const bool hit = way < Ways;
+	if(hit)
+		++mHits;
+	else
+	{
+		// Replace the least recently used pose; empty ways have never been used.
+		way = 0;
+		for(UINT w = 1; w < Ways; ++w)
+		{
+			if(set.LastUsed[w] < set.LastUsed[way])
+				way = w;
+		}
+
+		if(set.Keys[way] != EmptyKey)
+			++mEvictions;
+		++mMisses;
+
+		set.Keys[way] = key;
+		mSkinnedInfo.GetFinalTransforms(clip, tick*mSettings.TimeStep, pose,
+			&mPalettes[((size_t)setIndex*Ways + way)*mBoneCount]);
+	}
+
+	set.LastUsed[way] = set.Clock;
+	memcpy(finalTransforms, &mPalettes[((size_t)setIndex*Ways + way)*mBoneCount], mBoneCount*sizeof(XMFLOAT4X4));
+
+	return hit;
+}
+
+void PoseCache::Clear()
+{
+	for(Set& set : mSets)
+	{
+		for(UINT w = 0; w < Ways; ++w)
+		{
+			set.Keys[w] = EmptyKey;
+			set.LastUsed[w] = 0;
+		}
+		set.Clock = 0;
+	}
+}
+
+PoseCache::Stats PoseCache::GetStats()const
+{
+	Stats stats;
+	stats.Hits = mHits.load();
+	stats.Misses = mMisses.load();
+	stats.Evictions = mEvictions.load();
+	return stats;
+}
+
+void PoseCache::ResetStats()
+{
+	mHits = 0;
+	mMisses = 0;
+	mEvictions = 0;
+}
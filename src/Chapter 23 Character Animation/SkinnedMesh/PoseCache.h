@@ -0,0 +1,99 @@
+//***************************************************************************************
+// PoseCache.h
+//
+// Shares final transforms between instances of one SkinnedData that play the
+// same clip at the same time: a crowd in lockstep, or offset into a few phase
+// buckets, evaluates each distinct pose once a frame and copies it to the rest.
+//
+// Poses are keyed by clip handle and time rounded to a multiple of TimeStep, and
+// a miss evaluates the pose at that rounded time, so every instance whose time
+// rounds the same way gets exactly the same palette.  The cache has a fixed
+// number of poses, allocated up front, in sets of Ways; a miss replaces the
+// least recently used pose of its set.
+//
+// GetFinalTransforms can be called from several threads at once (e.g. from
+// CrowdAnimator's tasks).  Each set has its own lock, held while a missing pose
+// is evaluated, so threads after the same pose wait for it instead of
+// evaluating it again.
+//***************************************************************************************
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include "SkinnedData.h"
+
+class PoseCache
+{
+public:
+	struct Settings
+	{
+		// Seconds between cached times; a pose is off by at most half of it.
+		float TimeStep = 1.0f / 60.0f;
+
+		// Poses kept, rounded up to a multiple of Ways.
+		UINT MaxPoses = 256;
+	};
+
+	struct Stats
+	{
+		std::uint64_t Hits = 0;
+		std::uint64_t Misses = 0;
+		std::uint64_t Evictions = 0;
+
+		float HitRate()const { return Hits + Misses > 0 ? (float)Hits / (Hits + Misses) : 0.0f; }
+	};
+
+	PoseCache(const SkinnedData& skinnedInfo, const Settings& settings);
+
+	PoseCache(const PoseCache& rhs) = delete;
+	PoseCache& operator=(const PoseCache& rhs) = delete;
+
+	///<summary>
+	/// As SkinnedData::GetFinalTransforms, at timePos rounded to TimeStep.  pose
+	/// is only used on a miss.  Returns true on a hit.
+	///</summary>
+	bool GetFinalTransforms(SkinnedData::ClipHandle clip, float timePos, SkinnedData::Pose& pose,
+		DirectX::XMFLOAT4X4* finalTransforms);
+
+	///<summary>
+	/// Forgets every pose, e.g. after the clips change.  Not while another thread
+	/// is in GetFinalTransforms.
+	///</summary>
+	void Clear();
+
+	Stats GetStats()const;
+	void ResetStats();
+
+	const Settings& GetSettings()const { return mSettings; }
+
+	///<summary>
+	/// Bytes of the cached palettes, which is all the cache ever allocates.
+	///</summary>
+	size_t GetMemoryBytes()const { return mPalettes.size()*sizeof(DirectX::XMFLOAT4X4); }
+
+	static const UINT Ways = 4;
+
+private:
+	static const std::uint64_t EmptyKey = ~0ull;
+
+	struct Set
+	{
+		std::mutex Lock;
+		std::uint64_t Keys[Ways];
+		std::uint64_t LastUsed[Ways];
+		std::uint64_t Clock = 0;
+	};
+
+	const SkinnedData& mSkinnedInfo;
+	Settings mSettings;
+	UINT mBoneCount;
+
+	std::vector<Set> mSets;
+	std::vector<DirectX::XMFLOAT4X4> mPalettes;
+
+	std::atomic<std::uint64_t> mHits;
+	std::atomic<std::uint64_t> mMisses;
+	std::atomic<std::uint64_t> mEvictions;
+};
@@ -1,4 +1,5 @@
 #include "SkinnedData.h"
+#include <algorithm>
 
 using namespace DirectX;
 
@@ -122,18 +123,57 @@ float SkinnedData::GetClipEndTime(const std::string& clipName)const
 	return clip->second.GetClipEndTime();
 }
 
+SkinnedData::ClipHandle SkinnedData::FindClip(const std::string& clipName)const
+{
+	auto clip = mClipHandles.find(clipName);
+	return clip != mClipHandles.end() ? clip->second : InvalidClip;
+}
+
+float SkinnedData::GetClipStartTime(ClipHandle clip)const
+{
+	return mSamplers[clip].GetStartTime();
+}
+
+float SkinnedData::GetClipEndTime(ClipHandle clip)const
+{
+	return mSamplers[clip].GetEndTime();
+}
+
 UINT SkinnedData::BoneCount()const
 {
 	return mBoneHierarchy.size();
 }
 
-void SkinnedData::Set(std::vector<int>& boneHierarchy, 
-		              std::vector<XMFLOAT4X4>& boneOffsets,
-		              std::unordered_map<std::string, AnimationClip>& animations)
+void SkinnedData::Set(std::vector<int> boneHierarchy, 
+		              std::vector<XMFLOAT4X4> boneOffsets,
+		              std::unordered_map<std::string, AnimationClip> animations)
 {
-	mBoneHierarchy = boneHierarchy;
-	mBoneOffsets   = boneOffsets;
-	mAnimations    = animations;
+	mBoneHierarchy = std::move(boneHierarchy);
+	mBoneOffsets   = std::move(boneOffsets);
+	mAnimations    = std::move(animations);
+
+	// Order the bones by depth, so every parent comes before its children even
+	// if the file doesn't list them that way.
+	const UINT numBones = (UINT)mBoneHierarchy.size();
+	std::vector<UINT> depth(numBones, 0);
+	for(UINT i = 0; i < numBones; ++i)
+	{
+		for(int p = mBoneHierarchy[i]; p >= 0 && depth[i] < numBones; p = mBoneHierarchy[p])
+			++depth[i];
+	}
+
+	mBoneOrder.resize(numBones);
+	for(UINT i = 0; i < numBones; ++i)
+		mBoneOrder[i] = i;
+	std::stable_sort(mBoneOrder.begin(), mBoneOrder.end(), [&depth](UINT a, UINT b) { return depth[a] < depth[b]; });
+
+	mSamplers.clear();
+	mClipHandles.clear();
+	for(const auto& clip : mAnimations)
+	{
+		mClipHandles[clip.first] = (ClipHandle)mSamplers.size();
+		mSamplers.emplace_back(clip.second);
+	}
 }
  
 void SkinnedData::GetFinalTransforms(const std::string& clipName, float timePos,  std::vector<XMFLOAT4X4>& finalTransforms)const
@@ -177,4 +217,29 @@ void SkinnedData::GetFinalTransforms(const std::string& clipName, float timePos,
         XMMATRIX finalTransform = XMMatrixMultiply(offset, toRoot);
 		XMStoreFloat4x4(&finalTransforms[i], XMMatrixTranspose(finalTransform));
 	}
-}
\ No newline at end of file
+}
+
+void SkinnedData::GetFinalTransforms(ClipHandle clip, float timePos, Pose& pose, XMFLOAT4X4* finalTransforms)const
+{
+	const UINT numBones = (UINT)mBoneOffsets.size();
+	if(pose.Bones.size() != numBones)
+		pose.Bones.assign(numBones, MathHelper::Identity4x4());
+
+	mSamplers[clip].Sample(timePos, pose.Cursor, pose.Bones.data());
+
+	// Parents come first, so each bone's parent already holds its to-root
+	// transform when the bone is reached.
+	for(UINT i : mBoneOrder)
+	{
+		XMMATRIX toRoot = XMLoadFloat4x4(&pose.Bones[i]);
+
+		int parentIndex = mBoneHierarchy[i];
+		if(parentIndex >= 0)
+			toRoot = XMMatrixMultiply(toRoot, XMLoadFloat4x4(&pose.Bones[parentIndex]));
+
+		XMStoreFloat4x4(&pose.Bones[i], toRoot);
+
+		XMMATRIX offset = XMLoadFloat4x4(&mBoneOffsets[i]);
+		XMStoreFloat4x4(&finalTransforms[i], XMMatrixTranspose(XMMatrixMultiply(offset, toRoot)));
+	}
+}
@@ -3,6 +3,7 @@
 
 #include "../../Common/d3dUtil.h"
 #include "../../Common/MathHelper.h"
+#include "ClipSampler.h"
 
 ///<summary>
 /// A Keyframe defines the bone transformation at an instant in time.
@@ -53,27 +54,74 @@ struct AnimationClip
 class SkinnedData
 {
 public:
+	// A clip looked up by name once, so per-frame calls don't hash strings.
+	typedef UINT ClipHandle;
+	static const ClipHandle InvalidClip = 0xffffffff;
+
+	///<summary>
+	/// Per-instance state for GetFinalTransforms with a ClipHandle.  It keeps the
+	/// instance's place in the clip's keyframes and the bone transforms it
+	/// works in, so after the first call nothing is allocated.
+	///</summary>
+	struct Pose
+	{
+		ClipSampler::Cursor Cursor;
+
+		// Each bone's to-parent transform, replaced by its to-root transform as
+		// the hierarchy is walked.
+		std::vector<DirectX::XMFLOAT4X4> Bones;
+	};
 
 	UINT BoneCount()const;
 
 	float GetClipStartTime(const std::string& clipName)const;
 	float GetClipEndTime(const std::string& clipName)const;
 
+	///<summary>
+	/// The clip named clipName, or InvalidClip.
+	///</summary>
+	ClipHandle FindClip(const std::string& clipName)const;
+	float GetClipStartTime(ClipHandle clip)const;
+	float GetClipEndTime(ClipHandle clip)const;
+
+	// Takes the arrays by value so a loader can move its keyframes in instead of
+	// copying them.
 	void Set(
-		std::vector<int>& boneHierarchy, 
-		std::vector<DirectX::XMFLOAT4X4>& boneOffsets,
-		std::unordered_map<std::string, AnimationClip>& animations);
+		std::vector<int> boneHierarchy, 
+		std::vector<DirectX::XMFLOAT4X4> boneOffsets,
+		std::unordered_map<std::string, AnimationClip> animations);
+
+	const std::vector<int>& GetBoneHierarchy()const { return mBoneHierarchy; }
+	const std::vector<DirectX::XMFLOAT4X4>& GetBoneOffsets()const { return mBoneOffsets; }
+	const std::unordered_map<std::string, AnimationClip>& GetAnimations()const { return mAnimations; }
 
 	 // In a real project, you'd want to cache the result if there was a chance
 	 // that you were calling this several times with the same clipName at 
-	 // the same timePos.
+	 // the same timePos; PoseCache does, for the ClipHandle overload.
     void GetFinalTransforms(const std::string& clipName, float timePos, 
 		 std::vector<DirectX::XMFLOAT4X4>& finalTransforms)const;
 
+	///<summary>
+	/// Writes the (transposed) final transforms of every bone at timePos to
+	/// finalTransforms[0..BoneCount()), e.g. straight into a constant buffer.
+	/// Samples the clip with its ClipSampler and walks the hierarchy once,
+	/// keeping each bone's to-root transform in registers for its final
+	/// transform.  Allocates only the first time pose is used.
+	///</summary>
+	void GetFinalTransforms(ClipHandle clip, float timePos, Pose& pose,
+		DirectX::XMFLOAT4X4* finalTransforms)const;
+
 private:
     // Gives parentIndex of ith bone.
 	std::vector<int> mBoneHierarchy;
 
+	// The bones, parents before children.
+	std::vector<UINT> mBoneOrder;
+
+	// mAnimations resampled for the pose API, indexed by ClipHandle.
+	std::vector<ClipSampler> mSamplers;
+	std::unordered_map<std::string, ClipHandle> mClipHandles;
+
 	std::vector<DirectX::XMFLOAT4X4> mBoneOffsets;
    
 	std::unordered_map<std::string, AnimationClip> mAnimations;
@@ -5,13 +5,18 @@
 #include "../../Common/d3dApp.h"
 #include "../../Common/MathHelper.h"
 #include "../../Common/UploadBuffer.h"
+#include "../../Common/AsyncLoader.h"
 #include "../../Common/GeometryGenerator.h"
 #include "../../Common/Camera.h"
+#include "../../Common/TaskScheduler.h"
 #include "FrameResource.h"
 #include "ShadowMap.h"
 #include "Ssao.h"
 #include "SkinnedData.h"
+#include "CrowdAnimator.h"
+#include "PoseCache.h"
 #include "LoadM3d.h"
+#include "M3dBinary.h"
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
@@ -19,29 +24,13 @@ using namespace DirectX::PackedVector;
 
 const int gNumFrameResources = 3;
 
-struct SkinnedModelInstance
-{
-    SkinnedData* SkinnedInfo = nullptr;
-    std::vector<DirectX::XMFLOAT4X4> FinalTransforms;
-    std::string ClipName;
-    float TimePos = 0.0f;
-
-    // Called every frame and increments the time position, interpolates the 
-    // animations for each bone based on the current animation clip, and 
-    // generates the final transforms which are ultimately set to the effect
-    // for processing in the vertex shader.
-    void UpdateSkinnedAnimation(float dt)
-    {
-        TimePos += dt;
-
-        // Loop animation
-        if(TimePos > SkinnedInfo->GetClipEndTime(ClipName))
-            TimePos = 0.0f;
+// The soldiers stand in a grid down the aisle between the columns.
+const UINT gCrowdColumns = 6;
+const UINT gCrowdRows = 20;
 
-        // Compute the final transforms for this time position.
-        SkinnedInfo->GetFinalTransforms(ClipName, TimePos, FinalTransforms);
-    }
-};
+// Each soldier starts at one of this many points in the clip, so the crowd
+// doesn't march in step but evaluates only this many poses a frame.
+const UINT gCrowdPhases = 8;
 
 // Lightweight structure stores parameters to draw a shape.  This will
 // vary from app-to-app.
@@ -81,7 +70,7 @@ struct RenderItem
     UINT SkinnedCBIndex = -1;
 	
     // nullptr if this render-item is not animated by skinned mesh.
-    SkinnedModelInstance* SkinnedModelInst = nullptr;
+    const CrowdAnimator::Instance* SkinnedModelInst = nullptr;
 };
 
 enum class RenderLayer : int
@@ -123,11 +112,12 @@ private:
     void UpdateShadowPassCB(const GameTimer& gt);
     void UpdateSsaoCB(const GameTimer& gt);
 
-	void LoadTextures();
+	void LoadTextures(AsyncLoader& loader);
+	void CreateTextures();
     void BuildRootSignature();
     void BuildSsaoRootSignature();
 	void BuildDescriptorHeaps();
-    void BuildShadersAndInputLayout();
+    void BuildShadersAndInputLayout(AsyncLoader& loader);
     void BuildShapeGeometry();
 	void LoadSkinnedModel();
     void BuildPSOs();
@@ -162,6 +152,10 @@ private:
 	std::unordered_map<std::string, ComPtr<ID3DBlob>> mShaders;
 	std::unordered_map<std::string, ComPtr<ID3D12PipelineState>> mPSOs;
 
+	// Loads in flight during Initialize.
+	std::unordered_map<std::string, std::shared_future<std::vector<std::uint8_t>>> mTextureFiles;
+	std::unordered_map<std::string, std::shared_future<ComPtr<ID3DBlob>>> mShaderLoads;
+
     std::vector<D3D12_INPUT_ELEMENT_DESC> mInputLayout;
     std::vector<D3D12_INPUT_ELEMENT_DESC> mSkinnedInputLayout;
  
@@ -187,8 +181,12 @@ private:
 
     UINT mSkinnedSrvHeapStart = 0;
     std::string mSkinnedModelFilename = "Models\\soldier.m3d";
-    std::unique_ptr<SkinnedModelInstance> mSkinnedModelInst; 
+    std::string mCookedModelFilename = "..\\..\\Cooked\\Models\\soldier.m3db";
+    std::string mSkinnedClipName = "Take1";
     SkinnedData mSkinnedInfo;
+    std::unique_ptr<TaskScheduler> mScheduler;
+    std::unique_ptr<PoseCache> mPoseCache;
+    std::unique_ptr<CrowdAnimator> mCrowd;
     std::vector<M3DLoader::Subset> mSkinnedSubsets;
     std::vector<M3DLoader::M3dMaterial> mSkinnedMats;
     std::vector<std::string> mSkinnedTextureNames;
@@ -277,16 +275,23 @@ bool SkinnedMeshApp::Initialize()
         mCommandList.Get(),
         mClientWidth, mClientHeight);
 
+	// Shader compiles and texture reads run on the loader's threads while this
+	// thread records the device work.  The texture list depends on the model's
+	// materials, so the model loads first; the cooked model is mapped, not parsed.
+	AsyncLoader loader;
+    BuildShadersAndInputLayout(loader);
     LoadSkinnedModel();
-	LoadTextures();
+	LoadTextures(loader);
+
     BuildRootSignature();
     BuildSsaoRootSignature();
+	CreateTextures();
 	BuildDescriptorHeaps();
-    BuildShadersAndInputLayout();
     BuildShapeGeometry();
 	BuildMaterials();
     BuildRenderItems();
     BuildFrameResources();
+	CollectAll(mShaderLoads, mShaders);
     BuildPSOs();
 
     mSsao->SetPSOs(mPSOs["ssao"].Get(), mPSOs["ssaoBlur"].Get());
@@ -591,17 +596,10 @@ void SkinnedMeshApp::UpdateObjectCBs(const GameTimer& gt)
 void SkinnedMeshApp::UpdateSkinnedCBs(const GameTimer& gt)
 {
     auto currSkinnedCB = mCurrFrameResource->SkinnedCB.get();
-   
-    // We only have one skinned model being animated.
-    mSkinnedModelInst->UpdateSkinnedAnimation(gt.DeltaTime());
-        
-    SkinnedConstants skinnedConstants;
-    std::copy(
-        std::begin(mSkinnedModelInst->FinalTransforms),
-        std::end(mSkinnedModelInst->FinalTransforms),
-        &skinnedConstants.BoneTransforms[0]);
-
-    currSkinnedCB->CopyData(0, skinnedConstants);
+
+    // Every soldier's palette is written in place, instance i to element i of
+    // this frame's skinned constant buffer.
+    mCrowd->Update(gt.DeltaTime(), currSkinnedCB->GetMappedData(0), currSkinnedCB->GetElementByteSize());
 }
  
 void SkinnedMeshApp::UpdateMaterialBuffer(const GameTimer& gt)
@@ -784,7 +782,7 @@ void SkinnedMeshApp::UpdateSsaoCB(const GameTimer& gt)
     currSsaoCB->CopyData(0, ssaoCB);
 }
 
-void SkinnedMeshApp::LoadTextures()
+void SkinnedMeshApp::LoadTextures(AsyncLoader& loader)
 {
 	std::vector<std::string> texNames = 
 	{
@@ -838,15 +836,28 @@ void SkinnedMeshApp::LoadTextures()
             auto texMap = std::make_unique<Texture>();
             texMap->Name = texNames[i];
             texMap->Filename = texFilenames[i];
-            ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-                mCommandList.Get(), texMap->Filename.c_str(),
-                texMap->Resource, texMap->UploadHeap));
+            mTextureFiles[texMap->Name] = loader.ReadFile(texMap->Filename);
 
             mTextures[texMap->Name] = std::move(texMap);
         }
 	}		
 }
 
+void SkinnedMeshApp::CreateTextures()
+{
+	for(auto& file : mTextureFiles)
+	{
+		const std::vector<std::uint8_t>& data = file.second.get();
+
+		auto& texMap = mTextures[file.first];
+		ThrowIfFailed(DirectX::CreateDDSTextureFromMemory12(md3dDevice.Get(),
+			mCommandList.Get(), data.data(), data.size(),
+			texMap->Resource, texMap->UploadHeap));
+	}
+
+	mTextureFiles.clear();
+}
+
 void SkinnedMeshApp::BuildRootSignature()
 {
 	CD3DX12_DESCRIPTOR_RANGE texTable0;
@@ -1069,44 +1080,50 @@ void SkinnedMeshApp::BuildDescriptorHeaps()
         mRtvDescriptorSize);
 }
 
-void SkinnedMeshApp::BuildShadersAndInputLayout()
+void SkinnedMeshApp::BuildShadersAndInputLayout(AsyncLoader& loader)
 {
-	const D3D_SHADER_MACRO alphaTestDefines[] =
+	// Static: the compiles read these after this function returns.
+	static const D3D_SHADER_MACRO alphaTestDefines[] =
 	{
 		"ALPHA_TEST", "1",
 		NULL, NULL
 	};
 
-    const D3D_SHADER_MACRO skinnedDefines[] =
+    static const D3D_SHADER_MACRO skinnedDefines[] =
     {
         "SKINNED", "1",
         NULL, NULL
     };
 
-	mShaders["standardVS"] = d3dUtil::CompileShader(L"Shaders\\Default.hlsl", nullptr, "VS", "vs_5_1");
-    mShaders["skinnedVS"] = d3dUtil::CompileShader(L"Shaders\\Default.hlsl", skinnedDefines, "VS", "vs_5_1");
-	mShaders["opaquePS"] = d3dUtil::CompileShader(L"Shaders\\Default.hlsl", nullptr, "PS", "ps_5_1");
+	auto compile = [&loader](const wchar_t* filename, const D3D_SHADER_MACRO* defines, const char* entrypoint, const char* target)
+	{
+		return loader.Submit([=]() { return d3dUtil::CompileShader(filename, defines, entrypoint, target); });
+	};
 
-    mShaders["shadowVS"] = d3dUtil::CompileShader(L"Shaders\\Shadows.hlsl", nullptr, "VS", "vs_5_1");
-    mShaders["skinnedShadowVS"] = d3dUtil::CompileShader(L"Shaders\\Shadows.hlsl", skinnedDefines, "VS", "vs_5_1");
-    mShaders["shadowOpaquePS"] = d3dUtil::CompileShader(L"Shaders\\Shadows.hlsl", nullptr, "PS", "ps_5_1");
-    mShaders["shadowAlphaTestedPS"] = d3dUtil::CompileShader(L"Shaders\\Shadows.hlsl", alphaTestDefines, "PS", "ps_5_1");
+	mShaderLoads["standardVS"] = compile(L"Shaders\\Default.hlsl", nullptr, "VS", "vs_5_1");
+    mShaderLoads["skinnedVS"] = compile(L"Shaders\\Default.hlsl", skinnedDefines, "VS", "vs_5_1");
+	mShaderLoads["opaquePS"] = compile(L"Shaders\\Default.hlsl", nullptr, "PS", "ps_5_1");
+
+    mShaderLoads["shadowVS"] = compile(L"Shaders\\Shadows.hlsl", nullptr, "VS", "vs_5_1");
+    mShaderLoads["skinnedShadowVS"] = compile(L"Shaders\\Shadows.hlsl", skinnedDefines, "VS", "vs_5_1");
+    mShaderLoads["shadowOpaquePS"] = compile(L"Shaders\\Shadows.hlsl", nullptr, "PS", "ps_5_1");
+    mShaderLoads["shadowAlphaTestedPS"] = compile(L"Shaders\\Shadows.hlsl", alphaTestDefines, "PS", "ps_5_1");
 	
-    mShaders["debugVS"] = d3dUtil::CompileShader(L"Shaders\\ShadowDebug.hlsl", nullptr, "VS", "vs_5_1");
-    mShaders["debugPS"] = d3dUtil::CompileShader(L"Shaders\\ShadowDebug.hlsl", nullptr, "PS", "ps_5_1");
+    mShaderLoads["debugVS"] = compile(L"Shaders\\ShadowDebug.hlsl", nullptr, "VS", "vs_5_1");
+    mShaderLoads["debugPS"] = compile(L"Shaders\\ShadowDebug.hlsl", nullptr, "PS", "ps_5_1");
 
-    mShaders["drawNormalsVS"] = d3dUtil::CompileShader(L"Shaders\\DrawNormals.hlsl", nullptr, "VS", "vs_5_1");
-    mShaders["skinnedDrawNormalsVS"] = d3dUtil::CompileShader(L"Shaders\\DrawNormals.hlsl", skinnedDefines, "VS", "vs_5_1");
-    mShaders["drawNormalsPS"] = d3dUtil::CompileShader(L"Shaders\\DrawNormals.hlsl", nullptr, "PS", "ps_5_1");
+    mShaderLoads["drawNormalsVS"] = compile(L"Shaders\\DrawNormals.hlsl", nullptr, "VS", "vs_5_1");
+    mShaderLoads["skinnedDrawNormalsVS"] = compile(L"Shaders\\DrawNormals.hlsl", skinnedDefines, "VS", "vs_5_1");
+    mShaderLoads["drawNormalsPS"] = compile(L"Shaders\\DrawNormals.hlsl", nullptr, "PS", "ps_5_1");
 
-    mShaders["ssaoVS"] = d3dUtil::CompileShader(L"Shaders\\Ssao.hlsl", nullptr, "VS", "vs_5_1");
-    mShaders["ssaoPS"] = d3dUtil::CompileShader(L"Shaders\\Ssao.hlsl", nullptr, "PS", "ps_5_1");
+    mShaderLoads["ssaoVS"] = compile(L"Shaders\\Ssao.hlsl", nullptr, "VS", "vs_5_1");
+    mShaderLoads["ssaoPS"] = compile(L"Shaders\\Ssao.hlsl", nullptr, "PS", "ps_5_1");
 
-    mShaders["ssaoBlurVS"] = d3dUtil::CompileShader(L"Shaders\\SsaoBlur.hlsl", nullptr, "VS", "vs_5_1");
-    mShaders["ssaoBlurPS"] = d3dUtil::CompileShader(L"Shaders\\SsaoBlur.hlsl", nullptr, "PS", "ps_5_1");
+    mShaderLoads["ssaoBlurVS"] = compile(L"Shaders\\SsaoBlur.hlsl", nullptr, "VS", "vs_5_1");
+    mShaderLoads["ssaoBlurPS"] = compile(L"Shaders\\SsaoBlur.hlsl", nullptr, "PS", "ps_5_1");
 
-	mShaders["skyVS"] = d3dUtil::CompileShader(L"Shaders\\Sky.hlsl", nullptr, "VS", "vs_5_1");
-	mShaders["skyPS"] = d3dUtil::CompileShader(L"Shaders\\Sky.hlsl", nullptr, "PS", "ps_5_1");
+	mShaderLoads["skyVS"] = compile(L"Shaders\\Sky.hlsl", nullptr, "VS", "vs_5_1");
+	mShaderLoads["skyPS"] = compile(L"Shaders\\Sky.hlsl", nullptr, "PS", "ps_5_1");
 
     mInputLayout =
     {
@@ -1278,34 +1295,69 @@ void SkinnedMeshApp::LoadSkinnedModel()
 {
 	std::vector<M3DLoader::SkinnedVertex> vertices;
 	std::vector<std::uint16_t> indices;	
+
+	const void* vertexData = nullptr;
+	const void* indexData = nullptr;
+	UINT vertexCount = 0;
+	UINT indexCount = 0;
+
+	// Prefer the model AssetCooker wrote.  Its vertex and index sections are
+	// uploaded straight from the mapped file.
+	M3dBinaryFile binaryFile;
+	if(binaryFile.Open(mCookedModelFilename) && binaryFile.IsSkinned())
+	{
+		binaryFile.GetSubsets(mSkinnedSubsets);
+		binaryFile.GetMaterials(mSkinnedMats);
+		binaryFile.GetSkinnedData(mSkinnedInfo);
+
+		vertexData = binaryFile.GetSkinnedVertices();
+		indexData = binaryFile.GetIndices();
+		vertexCount = binaryFile.GetVertexCount();
+		indexCount = binaryFile.GetIndexCount();
+	}
+	else
+	{
+		M3DLoader m3dLoader;
+		m3dLoader.LoadM3d(mSkinnedModelFilename, vertices, indices, 
+			mSkinnedSubsets, mSkinnedMats, mSkinnedInfo);
+
+		vertexData = vertices.data();
+		indexData = indices.data();
+		vertexCount = (UINT)vertices.size();
+		indexCount = (UINT)indices.size();
+	}
+
+    mScheduler = std::make_unique<TaskScheduler>();
+    mPoseCache = std::make_unique<PoseCache>(mSkinnedInfo, PoseCache::Settings());
+    mCrowd = std::make_unique<CrowdAnimator>(mSkinnedInfo, *mScheduler);
+    mCrowd->SetPoseCache(mPoseCache.get());
+
+    SkinnedData::ClipHandle clip = mSkinnedInfo.FindClip(mSkinnedClipName);
+    const float clipLength = mSkinnedInfo.GetClipEndTime(clip);
+    for(UINT i = 0; i < gCrowdColumns*gCrowdRows; ++i)
+    {
+        UINT phase = (UINT)MathHelper::Rand(0, gCrowdPhases - 1);
+        mCrowd->AddInstance(clip, clipLength*phase / gCrowdPhases);
+    }
  
-	M3DLoader m3dLoader;
-	m3dLoader.LoadM3d(mSkinnedModelFilename, vertices, indices, 
-        mSkinnedSubsets, mSkinnedMats, mSkinnedInfo);
-
-    mSkinnedModelInst = std::make_unique<SkinnedModelInstance>();
-    mSkinnedModelInst->SkinnedInfo = &mSkinnedInfo;
-    mSkinnedModelInst->FinalTransforms.resize(mSkinnedInfo.BoneCount());
-    mSkinnedModelInst->ClipName = "Take1";
-    mSkinnedModelInst->TimePos = 0.0f;
- 
-	const UINT vbByteSize = (UINT)vertices.size() * sizeof(SkinnedVertex);
-    const UINT ibByteSize = (UINT)indices.size()  * sizeof(std::uint16_t);
+	static_assert(sizeof(SkinnedVertex) == sizeof(M3DLoader::SkinnedVertex), "Vertex layouts differ.");
+	const UINT vbByteSize = vertexCount * sizeof(SkinnedVertex);
+    const UINT ibByteSize = indexCount  * sizeof(std::uint16_t);
 
 	auto geo = std::make_unique<MeshGeometry>();
 	geo->Name = mSkinnedModelFilename;
 
 	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
+	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertexData, vbByteSize);
 
 	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indexData, ibByteSize);
 
 	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
+		mCommandList.Get(), vertexData, vbByteSize, geo->VertexBufferUploader);
 
 	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
+		mCommandList.Get(), indexData, ibByteSize, geo->IndexBufferUploader);
 
 	geo->VertexByteStride = sizeof(SkinnedVertex);
 	geo->VertexBufferByteSize = vbByteSize;
@@ -1540,7 +1592,7 @@ void SkinnedMeshApp::BuildFrameResources()
     {
         mFrameResources.push_back(std::make_unique<FrameResource>(md3dDevice.Get(),
             2, (UINT)mAllRitems.size(), 
-            1,
+            mCrowd->GetInstanceCount(),
             (UINT)mMaterials.size()));
     }
 }
@@ -1729,34 +1781,40 @@ void SkinnedMeshApp::BuildRenderItems()
 		mAllRitems.push_back(std::move(rightSphereRitem));
 	}
 
-    for(UINT i = 0; i < mSkinnedMats.size(); ++i)
+    for(UINT instance = 0; instance < mCrowd->GetInstanceCount(); ++instance)
     {
-        std::string submeshName = "sm_" + std::to_string(i);
-
-        auto ritem = std::make_unique<RenderItem>();
-
-        // Reflect to change coordinate system from the RHS the data was exported out as.
-        XMMATRIX modelScale = XMMatrixScaling(0.05f, 0.05f, -0.05f);
-        XMMATRIX modelRot = XMMatrixRotationY(MathHelper::Pi);
-        XMMATRIX modelOffset = XMMatrixTranslation(0.0f, 0.0f, -5.0f);
-        XMStoreFloat4x4(&ritem->World, modelScale*modelRot*modelOffset);
-
-        ritem->TexTransform = MathHelper::Identity4x4();
-        ritem->ObjCBIndex = objCBIndex++;
-        ritem->Mat = mMaterials[mSkinnedMats[i].Name].get();
-        ritem->Geo = mGeometries[mSkinnedModelFilename].get();
-        ritem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-        ritem->IndexCount = ritem->Geo->DrawArgs[submeshName].IndexCount;
-        ritem->StartIndexLocation = ritem->Geo->DrawArgs[submeshName].StartIndexLocation;
-        ritem->BaseVertexLocation = ritem->Geo->DrawArgs[submeshName].BaseVertexLocation;
-
-        // All render items for this solider.m3d instance share
-        // the same skinned model instance.
-        ritem->SkinnedCBIndex = 0;
-        ritem->SkinnedModelInst = mSkinnedModelInst.get();
-
-        mRitemLayer[(int)RenderLayer::SkinnedOpaque].push_back(ritem.get());
-        mAllRitems.push_back(std::move(ritem));
+        float x = 1.2f*((float)(instance % gCrowdColumns) - 0.5f*(gCrowdColumns - 1));
+        float z = 1.4f*((float)(instance / gCrowdColumns) - 0.5f*(gCrowdRows - 1));
+
+        for(UINT i = 0; i < mSkinnedMats.size(); ++i)
+        {
+            std::string submeshName = "sm_" + std::to_string(i);
+
+            auto ritem = std::make_unique<RenderItem>();
+
+            // Reflect to change coordinate system from the RHS the data was exported out as.
+            XMMATRIX modelScale = XMMatrixScaling(0.05f, 0.05f, -0.05f);
+            XMMATRIX modelRot = XMMatrixRotationY(MathHelper::Pi);
+            XMMATRIX modelOffset = XMMatrixTranslation(x, 0.0f, z);
+            XMStoreFloat4x4(&ritem->World, modelScale*modelRot*modelOffset);
+
+            ritem->TexTransform = MathHelper::Identity4x4();
+            ritem->ObjCBIndex = objCBIndex++;
+            ritem->Mat = mMaterials[mSkinnedMats[i].Name].get();
+            ritem->Geo = mGeometries[mSkinnedModelFilename].get();
+            ritem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+            ritem->IndexCount = ritem->Geo->DrawArgs[submeshName].IndexCount;
+            ritem->StartIndexLocation = ritem->Geo->DrawArgs[submeshName].StartIndexLocation;
+            ritem->BaseVertexLocation = ritem->Geo->DrawArgs[submeshName].BaseVertexLocation;
+
+            // All render items for one soldier share its crowd instance and
+            // its bone palette.
+            ritem->SkinnedCBIndex = instance;
+            ritem->SkinnedModelInst = &mCrowd->GetInstance(instance);
+
+            mRitemLayer[(int)RenderLayer::SkinnedOpaque].push_back(ritem.get());
+            mAllRitems.push_back(std::move(ritem));
+        }
     }
 }
 
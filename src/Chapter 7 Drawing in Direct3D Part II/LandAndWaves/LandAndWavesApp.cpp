@@ -109,6 +109,9 @@ private:
 
 	RenderItem* mWavesRitem = nullptr;
 
+	// The land is drawn one grid tile at a time.
+	UINT mLandTileCount = 0;
+
 	// List of all the render items.
 	std::vector<std::unique_ptr<RenderItem>> mAllRitems;
 
@@ -497,21 +500,34 @@ void LandAndWavesApp::BuildShadersAndInputLayout()
 void LandAndWavesApp::BuildLandGeometry()
 {
 	GeometryGenerator geoGen;
-	GeometryGenerator::MeshData grid = geoGen.CreateGrid(160.0f, 160.0f, 50, 50);
 
 	//
-	// Extract the vertex elements we are interested and apply the height function to
-	// each vertex.  In addition, color the vertices based on their height so we have
-	// sandy looking beaches, grassy low hills, and snow mountain peaks.
+	// Build the grid in tiles that each fit 16-bit indices, straight into our vertex
+	// format, with the height function applied as the tiles are generated.  Only
+	// the position is written; the color is ours to fill in.
 	//
 
-	std::vector<Vertex> vertices(grid.Vertices.size());
-	for(size_t i = 0; i < grid.Vertices.size(); ++i)
-	{
-		auto& p = grid.Vertices[i].Position;
-		vertices[i].Pos = p;
-		vertices[i].Pos.y = GetHillsHeight(p.x, p.z);
+	const UINT landSamples = 50;
+	GeometryGenerator::MeshSize landSize = geoGen.GetGridTilesSize(landSamples, landSamples, GeometryGenerator::MaxGridTileQuads);
+
+	std::vector<Vertex> vertices(landSize.VertexCount);
+	std::vector<std::uint16_t> indices(landSize.IndexCount);
+
+	GeometryGenerator::MeshOutput output;
+	output.Positions = &vertices[0].Pos;
+	output.VertexStride = sizeof(Vertex);
+	output.Indices16 = indices.data();
+
+	std::vector<GeometryGenerator::GridTile> tiles = geoGen.CreateGridTiles(160.0f, 160.0f, landSamples, landSamples,
+		GeometryGenerator::MaxGridTileQuads, output, [this](float x, float z) { return GetHillsHeight(x, z); });
+
+	//
+	// Color the vertices based on their height so we have sandy looking beaches,
+	// grassy low hills, and snow mountain peaks.
+	//
 
+	for(size_t i = 0; i < vertices.size(); ++i)
+	{
         // Color the vertex based on its height.
         if(vertices[i].Pos.y < -10.0f)
         {
@@ -565,12 +581,18 @@ void LandAndWavesApp::BuildLandGeometry()
 	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
 	geo->IndexBufferByteSize = ibByteSize;
 
-	SubmeshGeometry submesh;
-	submesh.IndexCount = (UINT)indices.size();
-	submesh.StartIndexLocation = 0;
-	submesh.BaseVertexLocation = 0;
+	for(size_t i = 0; i < tiles.size(); ++i)
+	{
+		SubmeshGeometry submesh;
+		submesh.IndexCount = tiles[i].IndexCount;
+		submesh.StartIndexLocation = tiles[i].FirstIndex;
+		submesh.BaseVertexLocation = tiles[i].FirstVertex;
+		submesh.Bounds = tiles[i].Bounds;
 
-	geo->DrawArgs["grid"] = submesh;
+		geo->DrawArgs["grid" + std::to_string(i)] = submesh;
+	}
+
+	mLandTileCount = (UINT)tiles.size();
 
 	mGeometries["landGeo"] = std::move(geo);
 }
@@ -696,19 +718,25 @@ void LandAndWavesApp::BuildRenderItems()
 
 	mRitemLayer[(int)RenderLayer::Opaque].push_back(wavesRitem.get());
 
-	auto gridRitem = std::make_unique<RenderItem>();
-	gridRitem->World = MathHelper::Identity4x4();
-	gridRitem->ObjCBIndex = 1;
-	gridRitem->Geo = mGeometries["landGeo"].get();
-	gridRitem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	gridRitem->IndexCount = gridRitem->Geo->DrawArgs["grid"].IndexCount;
-	gridRitem->StartIndexLocation = gridRitem->Geo->DrawArgs["grid"].StartIndexLocation;
-	gridRitem->BaseVertexLocation = gridRitem->Geo->DrawArgs["grid"].BaseVertexLocation;
+	mAllRitems.push_back(std::move(wavesRitem));
 
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(gridRitem.get());
+	for(UINT i = 0; i < mLandTileCount; ++i)
+	{
+		const SubmeshGeometry& tile = mGeometries["landGeo"]->DrawArgs["grid" + std::to_string(i)];
 
-	mAllRitems.push_back(std::move(wavesRitem));
-	mAllRitems.push_back(std::move(gridRitem));
+		auto gridRitem = std::make_unique<RenderItem>();
+		gridRitem->World = MathHelper::Identity4x4();
+		gridRitem->ObjCBIndex = 1 + i;
+		gridRitem->Geo = mGeometries["landGeo"].get();
+		gridRitem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+		gridRitem->IndexCount = tile.IndexCount;
+		gridRitem->StartIndexLocation = tile.StartIndexLocation;
+		gridRitem->BaseVertexLocation = tile.BaseVertexLocation;
+
+		mRitemLayer[(int)RenderLayer::Opaque].push_back(gridRitem.get());
+
+		mAllRitems.push_back(std::move(gridRitem));
+	}
 }
 
 void LandAndWavesApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems)
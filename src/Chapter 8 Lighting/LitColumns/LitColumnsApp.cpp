@@ -6,6 +6,7 @@
 #include "../../Common/MathHelper.h"
 #include "../../Common/UploadBuffer.h"
 #include "../../Common/GeometryGenerator.h"
+#include "../../Common/TxtModelLoader.h"
 #include "FrameResource.h"
 
 using Microsoft::WRL::ComPtr;
@@ -612,41 +613,14 @@ void LitColumnsApp::BuildShapeGeometry()
 
 void LitColumnsApp::BuildSkullGeometry()
 {
-	std::ifstream fin("Models/skull.txt");
-
-	if(!fin)
+	std::vector<Vertex> vertices;
+	std::vector<std::int32_t> indices;
+	if(!TxtModelLoader::Load("Models/skull.txt", vertices, indices))
 	{
 		MessageBox(0, L"Models/skull.txt not found.", 0, 0);
 		return;
 	}
 
-	UINT vcount = 0;
-	UINT tcount = 0;
-	std::string ignore;
-
-	fin >> ignore >> vcount;
-	fin >> ignore >> tcount;
-	fin >> ignore >> ignore >> ignore >> ignore;
-
-	std::vector<Vertex> vertices(vcount);
-	for(UINT i = 0; i < vcount; ++i)
-	{
-		fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-		fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
-	}
-
-	fin >> ignore;
-	fin >> ignore;
-	fin >> ignore;
-
-	std::vector<std::int32_t> indices(3 * tcount);
-	for(UINT i = 0; i < tcount; ++i)
-	{
-		fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
-	}
-
-	fin.close();
-
 	//
 	// Pack the indices of all the meshes into one index buffer.
 	//
@@ -6,6 +6,8 @@
 #include "../../Common/MathHelper.h"
 #include "../../Common/UploadBuffer.h"
 #include "../../Common/GeometryGenerator.h"
+#include "../../Common/AsyncLoader.h"
+#include "../../Common/TextureStreamer.h"
 #include "FrameResource.h"
 
 using Microsoft::WRL::ComPtr;
@@ -43,6 +45,9 @@ struct RenderItem
 	Material* Mat = nullptr;
 	MeshGeometry* Geo = nullptr;
 
+	// Local space bounds of the shape, for picking the mips its texture needs.
+	BoundingBox Bounds;
+
     // Primitive topology.
     D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 
@@ -77,6 +82,7 @@ private:
 	void UpdateObjectCBs(const GameTimer& gt);
 	void UpdateMaterialCBs(const GameTimer& gt);
 	void UpdateMainPassCB(const GameTimer& gt);
+	void RequestTextures();
 
 	void LoadTextures();
     void BuildRootSignature();
@@ -105,7 +111,17 @@ private:
 
 	std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> mGeometries;
 	std::unordered_map<std::string, std::unique_ptr<Material>> mMaterials;
-	std::unordered_map<std::string, std::unique_ptr<Texture>> mTextures;
+
+	// Streams the finer mips of the textures in as the camera gets close to them.
+	// The reads finish on the loader's thread, so it outlives the streamer.
+	std::unique_ptr<AsyncLoader> mLoader;
+	std::unique_ptr<TextureStreamer> mTextureStreamer;
+	std::unordered_map<std::string, UINT> mTextures;
+
+	// The streamed texture each material samples; its SRV moves when the
+	// texture's resident mips change.
+	std::vector<std::pair<Material*, UINT>> mMaterialTextures;
+
 	std::unordered_map<std::string, ComPtr<ID3DBlob>> mShaders;
 	std::unordered_map<std::string, ComPtr<ID3D12PipelineState>> mPSOs;
 
@@ -177,9 +193,9 @@ bool TexColumnsApp::Initialize()
     mCbvSrvDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
  
+	BuildDescriptorHeaps();
 	LoadTextures();
     BuildRootSignature();
-	BuildDescriptorHeaps();
     BuildShadersAndInputLayout();
     BuildShapeGeometry();
 	BuildMaterials();
@@ -230,6 +246,7 @@ void TexColumnsApp::Update(const GameTimer& gt)
 	UpdateObjectCBs(gt);
 	UpdateMaterialCBs(gt);
 	UpdateMainPassCB(gt);
+	RequestTextures();
 }
 
 void TexColumnsApp::Draw(const GameTimer& gt)
@@ -244,6 +261,12 @@ void TexColumnsApp::Draw(const GameTimer& gt)
     // Reusing the command list reuses memory.
     ThrowIfFailed(mCommandList->Reset(cmdListAlloc.Get(), mPSOs["opaque"].Get()));
 
+	// Upload the mips whose reads have finished before anything samples them, and
+	// point the materials at the textures' current SRVs.
+	mTextureStreamer->Update(mCommandList.Get(), mFence->GetCompletedValue(), mCurrentFence + 1);
+	for(auto& e : mMaterialTextures)
+		e.first->DiffuseSrvHeapIndex = mTextureStreamer->GetSrvHeapIndex(e.second);
+
     mCommandList->RSSetViewports(1, &mScreenViewport);
     mCommandList->RSSetScissorRects(1, &mScissorRect);
 
@@ -447,32 +470,55 @@ void TexColumnsApp::UpdateMainPassCB(const GameTimer& gt)
 	currPassCB->CopyData(0, mMainPassCB);
 }
 
+void TexColumnsApp::RequestTextures()
+{
+	// Matches the projection in OnResize.
+	const float fovY = 0.25f*MathHelper::Pi;
+	XMVECTOR eyePos = XMLoadFloat3(&mEyePos);
+
+	for(auto& e : mAllRitems)
+	{
+		BoundingBox bounds;
+		e->Bounds.Transform(bounds, XMLoadFloat4x4(&e->World));
+
+		// Distance to the nearest point of the bounds, so a large ground plane
+		// counts as near when the camera is over any part of it.
+		XMVECTOR center = XMLoadFloat3(&bounds.Center);
+		XMVECTOR extents = XMLoadFloat3(&bounds.Extents);
+		XMVECTOR nearest = XMVectorClamp(eyePos, center - extents, center + extents);
+		float distance = XMVectorGetX(XMVector3Length(eyePos - nearest));
+
+		// The texture repeats TexTransform's scale times across the object, so one
+		// repeat covers that fraction of the object's size on screen.
+		float repeats = (std::max)(e->TexTransform(0, 0), e->TexTransform(1, 1));
+		float worldSize = 2.0f*XMVectorGetX(XMVector3Length(extents)) / (std::max)(repeats, 1.0f);
+		float screenSize = TextureResidency::ScreenSize(worldSize, distance, fovY, (float)mClientHeight);
+
+		for(auto& t : mMaterialTextures)
+		{
+			if(t.first == e->Mat)
+				mTextureStreamer->Request(t.second, screenSize, distance);
+		}
+	}
+}
+
 void TexColumnsApp::LoadTextures()
 {
-	auto bricksTex = std::make_unique<Texture>();
-	bricksTex->Name = "bricksTex";
-	bricksTex->Filename = L"../../Textures/bricks.dds";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-		mCommandList.Get(), bricksTex->Filename.c_str(),
-		bricksTex->Resource, bricksTex->UploadHeap));
-
-	auto stoneTex = std::make_unique<Texture>();
-	stoneTex->Name = "stoneTex";
-	stoneTex->Filename = L"../../Textures/stone.dds";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-		mCommandList.Get(), stoneTex->Filename.c_str(),
-		stoneTex->Resource, stoneTex->UploadHeap));
-
-	auto tileTex = std::make_unique<Texture>();
-	tileTex->Name = "tileTex";
-	tileTex->Filename = L"../../Textures/tile.dds";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-		mCommandList.Get(), tileTex->Filename.c_str(),
-		tileTex->Resource, tileTex->UploadHeap));
-
-	mTextures[bricksTex->Name] = std::move(bricksTex);
-	mTextures[stoneTex->Name] = std::move(stoneTex);
-	mTextures[tileTex->Name] = std::move(tileTex);
+	const std::string names[] = { "bricks", "stone", "tile" };
+
+	for(const std::string& name : names)
+	{
+		// AssetCooker's copies have full mip chains to stream; the originals have
+		// only their top level, which is uploaded whole.
+		std::wstring cooked = L"../../Cooked/Textures/" + AnsiToWString(name) + L".dds";
+		std::wstring source = L"../../Textures/" + AnsiToWString(name) + L".dds";
+
+		UINT texture = 0;
+		if(FAILED(mTextureStreamer->AddTexture(mCommandList.Get(), cooked, texture)))
+			ThrowIfFailed(mTextureStreamer->AddTexture(mCommandList.Get(), source, texture));
+
+		mTextures[name + "Tex"] = texture;
+	}
 }
 
 void TexColumnsApp::BuildRootSignature()
@@ -521,45 +567,22 @@ void TexColumnsApp::BuildRootSignature()
 void TexColumnsApp::BuildDescriptorHeaps()
 {
 	//
-	// Create the SRV heap.
+	// Create the SRV heap.  The streamer writes each texture's SRVs into it.
 	//
 	D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
-	srvHeapDesc.NumDescriptors = 3;
+	srvHeapDesc.NumDescriptors = 3*TextureStreamer::SrvsPerTexture;
 	srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
 	srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 	ThrowIfFailed(md3dDevice->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&mSrvDescriptorHeap)));
 
-	//
-	// Fill out the heap with actual descriptors.
-	//
-	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(mSrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
-
-	auto bricksTex = mTextures["bricksTex"]->Resource;
-	auto stoneTex = mTextures["stoneTex"]->Resource;
-	auto tileTex = mTextures["tileTex"]->Resource;
-
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	srvDesc.Format = bricksTex->GetDesc().Format;
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MostDetailedMip = 0;
-	srvDesc.Texture2D.MipLevels = bricksTex->GetDesc().MipLevels;
-	srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
-	md3dDevice->CreateShaderResourceView(bricksTex.Get(), &srvDesc, hDescriptor);
-
-	// next descriptor
-	hDescriptor.Offset(1, mCbvSrvDescriptorSize);
-
-	srvDesc.Format = stoneTex->GetDesc().Format;
-	srvDesc.Texture2D.MipLevels = stoneTex->GetDesc().MipLevels;
-	md3dDevice->CreateShaderResourceView(stoneTex.Get(), &srvDesc, hDescriptor);
-
-	// next descriptor
-	hDescriptor.Offset(1, mCbvSrvDescriptorSize);
-
-	srvDesc.Format = tileTex->GetDesc().Format;
-	srvDesc.Texture2D.MipLevels = tileTex->GetDesc().MipLevels;
-	md3dDevice->CreateShaderResourceView(tileTex.Get(), &srvDesc, hDescriptor);
+	// A budget smaller than the three textures' full chains, so getting close
+	// to one column evicts the finest mips of the textures out of view.
+	TextureStreamer::Settings settings;
+	settings.Residency.BudgetBytes = 384*1024;
+
+	mLoader = std::make_unique<AsyncLoader>(1);
+	mTextureStreamer = std::make_unique<TextureStreamer>(md3dDevice.Get(), *mLoader,
+		mSrvDescriptorHeap.Get(), 0, mCbvSrvDescriptorSize, settings);
 }
 
 void TexColumnsApp::BuildShadersAndInputLayout()
@@ -668,6 +691,11 @@ void TexColumnsApp::BuildShapeGeometry()
 		vertices[k].TexC = cylinder.Vertices[i].TexC;
 	}
 
+	BoundingBox::CreateFromPoints(boxSubmesh.Bounds, box.Vertices.size(), &vertices[boxVertexOffset].Pos, sizeof(Vertex));
+	BoundingBox::CreateFromPoints(gridSubmesh.Bounds, grid.Vertices.size(), &vertices[gridVertexOffset].Pos, sizeof(Vertex));
+	BoundingBox::CreateFromPoints(sphereSubmesh.Bounds, sphere.Vertices.size(), &vertices[sphereVertexOffset].Pos, sizeof(Vertex));
+	BoundingBox::CreateFromPoints(cylinderSubmesh.Bounds, cylinder.Vertices.size(), &vertices[cylinderVertexOffset].Pos, sizeof(Vertex));
+
 	std::vector<std::uint16_t> indices;
 	indices.insert(indices.end(), std::begin(box.GetIndices16()), std::end(box.GetIndices16()));
 	indices.insert(indices.end(), std::begin(grid.GetIndices16()), std::end(grid.GetIndices16()));
@@ -752,7 +780,7 @@ void TexColumnsApp::BuildMaterials()
 	auto bricks0 = std::make_unique<Material>();
 	bricks0->Name = "bricks0";
 	bricks0->MatCBIndex = 0;
-	bricks0->DiffuseSrvHeapIndex = 0;
+	bricks0->DiffuseSrvHeapIndex = mTextureStreamer->GetSrvHeapIndex(mTextures["bricksTex"]);
 	bricks0->DiffuseAlbedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
     bricks0->FresnelR0 = XMFLOAT3(0.02f, 0.02f, 0.02f);
     bricks0->Roughness = 0.1f;
@@ -760,7 +788,7 @@ void TexColumnsApp::BuildMaterials()
 	auto stone0 = std::make_unique<Material>();
 	stone0->Name = "stone0";
 	stone0->MatCBIndex = 1;
-	stone0->DiffuseSrvHeapIndex = 1;
+	stone0->DiffuseSrvHeapIndex = mTextureStreamer->GetSrvHeapIndex(mTextures["stoneTex"]);
 	stone0->DiffuseAlbedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
     stone0->FresnelR0 = XMFLOAT3(0.05f, 0.05f, 0.05f);
     stone0->Roughness = 0.3f;
@@ -768,11 +796,15 @@ void TexColumnsApp::BuildMaterials()
 	auto tile0 = std::make_unique<Material>();
 	tile0->Name = "tile0";
 	tile0->MatCBIndex = 2;
-	tile0->DiffuseSrvHeapIndex = 2;
+	tile0->DiffuseSrvHeapIndex = mTextureStreamer->GetSrvHeapIndex(mTextures["tileTex"]);
 	tile0->DiffuseAlbedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
     tile0->FresnelR0 = XMFLOAT3(0.02f, 0.02f, 0.02f);
     tile0->Roughness = 0.3f;
 	
+	mMaterialTextures.push_back(std::make_pair(bricks0.get(), mTextures["bricksTex"]));
+	mMaterialTextures.push_back(std::make_pair(stone0.get(), mTextures["stoneTex"]));
+	mMaterialTextures.push_back(std::make_pair(tile0.get(), mTextures["tileTex"]));
+
 	mMaterials["bricks0"] = std::move(bricks0);
 	mMaterials["stone0"] = std::move(stone0);
 	mMaterials["tile0"] = std::move(tile0);
@@ -790,6 +822,7 @@ void TexColumnsApp::BuildRenderItems()
 	boxRitem->IndexCount = boxRitem->Geo->DrawArgs["box"].IndexCount;
 	boxRitem->StartIndexLocation = boxRitem->Geo->DrawArgs["box"].StartIndexLocation;
 	boxRitem->BaseVertexLocation = boxRitem->Geo->DrawArgs["box"].BaseVertexLocation;
+	boxRitem->Bounds = boxRitem->Geo->DrawArgs["box"].Bounds;
 	mAllRitems.push_back(std::move(boxRitem));
 
     auto gridRitem = std::make_unique<RenderItem>();
@@ -802,6 +835,7 @@ void TexColumnsApp::BuildRenderItems()
     gridRitem->IndexCount = gridRitem->Geo->DrawArgs["grid"].IndexCount;
     gridRitem->StartIndexLocation = gridRitem->Geo->DrawArgs["grid"].StartIndexLocation;
     gridRitem->BaseVertexLocation = gridRitem->Geo->DrawArgs["grid"].BaseVertexLocation;
+    gridRitem->Bounds = gridRitem->Geo->DrawArgs["grid"].Bounds;
 	mAllRitems.push_back(std::move(gridRitem));
 
 	XMMATRIX brickTexTransform = XMMatrixScaling(1.0f, 1.0f, 1.0f);
@@ -828,6 +862,7 @@ void TexColumnsApp::BuildRenderItems()
 		leftCylRitem->IndexCount = leftCylRitem->Geo->DrawArgs["cylinder"].IndexCount;
 		leftCylRitem->StartIndexLocation = leftCylRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
 		leftCylRitem->BaseVertexLocation = leftCylRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
+		leftCylRitem->Bounds = leftCylRitem->Geo->DrawArgs["cylinder"].Bounds;
 
 		XMStoreFloat4x4(&rightCylRitem->World, leftCylWorld);
 		XMStoreFloat4x4(&rightCylRitem->TexTransform, brickTexTransform);
@@ -838,6 +873,7 @@ void TexColumnsApp::BuildRenderItems()
 		rightCylRitem->IndexCount = rightCylRitem->Geo->DrawArgs["cylinder"].IndexCount;
 		rightCylRitem->StartIndexLocation = rightCylRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
 		rightCylRitem->BaseVertexLocation = rightCylRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
+		rightCylRitem->Bounds = rightCylRitem->Geo->DrawArgs["cylinder"].Bounds;
 
 		XMStoreFloat4x4(&leftSphereRitem->World, leftSphereWorld);
 		leftSphereRitem->TexTransform = MathHelper::Identity4x4();
@@ -848,6 +884,7 @@ void TexColumnsApp::BuildRenderItems()
 		leftSphereRitem->IndexCount = leftSphereRitem->Geo->DrawArgs["sphere"].IndexCount;
 		leftSphereRitem->StartIndexLocation = leftSphereRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 		leftSphereRitem->BaseVertexLocation = leftSphereRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+		leftSphereRitem->Bounds = leftSphereRitem->Geo->DrawArgs["sphere"].Bounds;
 
 		XMStoreFloat4x4(&rightSphereRitem->World, rightSphereWorld);
 		rightSphereRitem->TexTransform = MathHelper::Identity4x4();
@@ -858,6 +895,7 @@ void TexColumnsApp::BuildRenderItems()
 		rightSphereRitem->IndexCount = rightSphereRitem->Geo->DrawArgs["sphere"].IndexCount;
 		rightSphereRitem->StartIndexLocation = rightSphereRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 		rightSphereRitem->BaseVertexLocation = rightSphereRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+		rightSphereRitem->Bounds = rightSphereRitem->Geo->DrawArgs["sphere"].Bounds;
 
 		mAllRitems.push_back(std::move(leftCylRitem));
 		mAllRitems.push_back(std::move(rightCylRitem));
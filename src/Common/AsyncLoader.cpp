@@ -0,0 +1,83 @@
+//***************************************************************************************
+// AsyncLoader.cpp
+//***************************************************************************************
+
+#include "AsyncLoader.h"
+#include <fstream>
+#include <stdexcept>
+#include "ParallelFor.h"
+
+AsyncLoader::AsyncLoader(unsigned numThreads)
+{
+	numThreads = ResolveThreadCount(numThreads);
+
+	mThreads.reserve(numThreads);
+	for(unsigned t = 0; t < numThreads; ++t)
+		mThreads.emplace_back(&AsyncLoader::WorkerMain, this);
+}
+
+AsyncLoader::~AsyncLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mJobReady.notify_all();
+
+	for(auto& thread : mThreads)
+		thread.join();
+}
+
+std::shared_future<std::vector<std::uint8_t>> AsyncLoader::ReadFile(const std::wstring& filename)
+{
+	return Submit([filename]()
+	{
+#ifdef _WIN32
+		std::ifstream fin(filename, std::ios::binary | std::ios::ate);
+#else
+		std::ifstream fin(std::string(filename.begin(), filename.end()), std::ios::binary | std::ios::ate);
+#endif
+		if(!fin)
+			throw std::runtime_error("can't open " + std::string(filename.begin(), filename.end()));
+
+		std::vector<std::uint8_t> data((size_t)fin.tellg());
+		fin.seekg(0);
+		fin.read(reinterpret_cast<char*>(data.data()), data.size());
+		if(fin.fail())
+			throw std::runtime_error("can't read " + std::string(filename.begin(), filename.end()));
+
+		return data;
+	});
+}
+
+void AsyncLoader::Enqueue(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mJobs.push_back(std::move(job));
+	}
+	mJobReady.notify_one();
+}
+
+void AsyncLoader::WorkerMain()
+{
+	for(;;)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mJobReady.wait(lock, [this]() { return mStopping || !mJobs.empty(); });
+
+			// Queued jobs still run after the destructor starts; their futures may be
+			// waited on.
+			if(mJobs.empty())
+				return;
+
+			job = std::move(mJobs.front());
+			mJobs.pop_front();
+		}
+
+		// packaged_task stores any exception in the future.
+		job();
+	}
+}
@@ -0,0 +1,87 @@
+//***************************************************************************************
+// AsyncLoader.h
+//
+// Worker thread pool for startup work that doesn't need the device: file reads,
+// model parsing, tangent generation, shader compiles.  Submit returns a
+// std::shared_future; the main thread keeps recording device work and calls get()
+// only where it needs a result, so startup takes about as long as the slowest
+// asset instead of the sum of all of them.  Resource creation stays on the main
+// thread, which owns the command list.
+//
+// An exception thrown by a job (e.g. DxException from ThrowIfFailed) is rethrown
+// by get().  The destructor finishes every queued job before joining the workers.
+//***************************************************************************************
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class AsyncLoader
+{
+public:
+	///<summary>
+	/// Starts numThreads workers (0 = every hardware thread).
+	///</summary>
+	explicit AsyncLoader(unsigned numThreads = 0);
+	~AsyncLoader();
+
+	AsyncLoader(const AsyncLoader& rhs) = delete;
+	AsyncLoader& operator=(const AsyncLoader& rhs) = delete;
+
+	///<summary>
+	/// Queues func() and returns a handle to its result.  Jobs start in the order
+	/// they are submitted.
+	///</summary>
+	template<typename Func>
+	auto Submit(Func func) -> std::shared_future<decltype(func())>
+	{
+		using ResultT = decltype(func());
+
+		auto task = std::make_shared<std::packaged_task<ResultT()>>(std::move(func));
+		std::shared_future<ResultT> result = task->get_future().share();
+		Enqueue([task]() { (*task)(); });
+		return result;
+	}
+
+	///<summary>
+	/// Reads a whole file.  get() throws std::runtime_error if it can't be read.
+	///</summary>
+	std::shared_future<std::vector<std::uint8_t>> ReadFile(const std::wstring& filename);
+
+	unsigned GetThreadCount()const { return (unsigned)mThreads.size(); }
+
+private:
+	void Enqueue(std::function<void()> job);
+	void WorkerMain();
+
+	std::vector<std::thread> mThreads;
+	std::deque<std::function<void()>> mJobs;
+	std::mutex mMutex;
+	std::condition_variable mJobReady;
+	bool mStopping = false;
+};
+
+///<summary>
+/// Waits for every pending named result and copies it into results[name], e.g.
+/// shader compiles into mShaders.  A shared_future only hands out a const
+/// reference, so T should be cheap to copy (a ComPtr, a shared_ptr).  Empties
+/// pending.
+///</summary>
+template<typename T, typename MapT>
+void CollectAll(std::unordered_map<std::string, std::shared_future<T>>& pending, MapT& results)
+{
+	for(auto& entry : pending)
+		results[entry.first] = entry.second.get();
+
+	pending.clear();
+}
@@ -0,0 +1,694 @@
+//***************************************************************************************
+// BcDecoder.cpp
+//
+// Block layouts and interpolation follow the Direct3D 11 block compression spec.
+// Interpolated values are rounded to nearest.
+//***************************************************************************************
+
+#include "BcDecoder.h"
+#include <algorithm>
+#include <cstring>
+#include "Bc7Tables.h"
+#include "ParallelFor.h"
+
+#if !defined(BC_DECODER_NO_SIMD) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define BC_DECODER_SSE2
+#include <emmintrin.h>
+#endif
+
+using std::uint8_t;
+using std::uint16_t;
+using std::uint32_t;
+using std::uint64_t;
+
+namespace
+{
+	enum class BlockType
+	{
+		Unsupported,
+		BC1,
+		BC2,
+		BC3,
+		BC4,
+		BC4Signed,
+		BC5,
+		BC5Signed,
+		BC7
+	};
+
+	BlockType GetBlockType(DXGI_FORMAT format)
+	{
+		switch(format)
+		{
+		case DXGI_FORMAT_BC1_TYPELESS:
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			return BlockType::BC1;
+
+		case DXGI_FORMAT_BC2_TYPELESS:
+		case DXGI_FORMAT_BC2_UNORM:
+		case DXGI_FORMAT_BC2_UNORM_SRGB:
+			return BlockType::BC2;
+
+		case DXGI_FORMAT_BC3_TYPELESS:
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			return BlockType::BC3;
+
+		case DXGI_FORMAT_BC4_TYPELESS:
+		case DXGI_FORMAT_BC4_UNORM:
+			return BlockType::BC4;
+
+		case DXGI_FORMAT_BC4_SNORM:
+			return BlockType::BC4Signed;
+
+		case DXGI_FORMAT_BC5_TYPELESS:
+		case DXGI_FORMAT_BC5_UNORM:
+			return BlockType::BC5;
+
+		case DXGI_FORMAT_BC5_SNORM:
+			return BlockType::BC5Signed;
+
+		case DXGI_FORMAT_BC7_TYPELESS:
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return BlockType::BC7;
+
+		default:
+			return BlockType::Unsupported;
+		}
+	}
+
+	size_t BlockBytes(BlockType type)
+	{
+		return (type == BlockType::BC1 || type == BlockType::BC4 || type == BlockType::BC4Signed) ? 8 : 16;
+	}
+
+	// Blocks are little-endian and byte aligned at best, so read them bytewise.
+	uint32_t ReadU16(const uint8_t* p)
+	{
+		return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+	}
+
+	uint32_t ReadU32(const uint8_t* p)
+	{
+		return ReadU16(p) | (ReadU16(p + 2) << 16);
+	}
+
+	uint64_t ReadU64(const uint8_t* p)
+	{
+		return (uint64_t)ReadU32(p) | ((uint64_t)ReadU32(p + 4) << 32);
+	}
+
+	uint32_t PackRGBA(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+	{
+		return r | (g << 8) | (b << 16) | (a << 24);
+	}
+
+	//
+	// BC1 colour block; also the colour half of BC2 and BC3.
+	//
+
+	uint32_t Expand565(uint32_t c)
+	{
+		uint32_t r = (c >> 11) & 31;
+		uint32_t g = (c >> 5) & 63;
+		uint32_t b = c & 31;
+		return PackRGBA((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255);
+	}
+
+	// (wa*a + wb*b) / (wa + wb) per channel, rounded.
+	uint32_t Blend(uint32_t a, uint32_t b, uint32_t wa, uint32_t wb)
+	{
+		uint32_t sum = wa + wb;
+		uint32_t result = 0;
+		for(uint32_t shift = 0; shift < 32; shift += 8)
+		{
+			uint32_t ca = (a >> shift) & 0xFF;
+			uint32_t cb = (b >> shift) & 0xFF;
+			result |= ((wa*ca + wb*cb + sum/2) / sum) << shift;
+		}
+
+		return result;
+	}
+
+	// BC1 blocks with color0 <= color1 have three colours and transparent black.
+	// BC2 and BC3 always use four colours.
+	void DecodeColorBlock(const uint8_t* block, bool allowTransparent, uint32_t texels[16])
+	{
+		uint32_t c0 = ReadU16(block);
+		uint32_t c1 = ReadU16(block + 2);
+		uint32_t indices = ReadU32(block + 4);
+
+		uint32_t palette[4];
+		palette[0] = Expand565(c0);
+		palette[1] = Expand565(c1);
+		if(c0 > c1 || !allowTransparent)
+		{
+			palette[2] = Blend(palette[0], palette[1], 2, 1);
+			palette[3] = Blend(palette[0], palette[1], 1, 2);
+		}
+		else
+		{
+			palette[2] = Blend(palette[0], palette[1], 1, 1);
+			palette[3] = 0;
+		}
+
+#ifdef BC_DECODER_SSE2
+		// Each lane tests its own two index bits and picks from the broadcast palette.
+		const __m128i lowBit = _mm_setr_epi32(1 << 0, 1 << 2, 1 << 4, 1 << 6);
+		const __m128i highBit = _mm_setr_epi32(2 << 0, 2 << 2, 2 << 4, 2 << 6);
+		const __m128i p0 = _mm_set1_epi32((int)palette[0]);
+		const __m128i p1 = _mm_set1_epi32((int)palette[1]);
+		const __m128i p2 = _mm_set1_epi32((int)palette[2]);
+		const __m128i p3 = _mm_set1_epi32((int)palette[3]);
+		const __m128i p01 = _mm_xor_si128(p0, p1);
+		const __m128i p23 = _mm_xor_si128(p2, p3);
+
+		for(uint32_t row = 0; row < 4; ++row)
+		{
+			__m128i bits = _mm_set1_epi32((int)(indices >> (8*row)));
+			__m128i b0 = _mm_cmpeq_epi32(_mm_and_si128(bits, lowBit), lowBit);
+			__m128i b1 = _mm_cmpeq_epi32(_mm_and_si128(bits, highBit), highBit);
+
+			__m128i lo = _mm_xor_si128(p0, _mm_and_si128(p01, b0));
+			__m128i hi = _mm_xor_si128(p2, _mm_and_si128(p23, b0));
+			__m128i color = _mm_xor_si128(lo, _mm_and_si128(_mm_xor_si128(lo, hi), b1));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(texels + 4*row), color);
+		}
+#else
+		for(uint32_t i = 0; i < 16; ++i)
+			texels[i] = palette[(indices >> (2*i)) & 3];
+#endif
+	}
+
+	//
+	// BC3 alpha block; also each channel of BC4 and BC5.
+	//
+
+	void MakeUnsignedPalette(uint32_t v0, uint32_t v1, uint8_t palette[8])
+	{
+		palette[0] = (uint8_t)v0;
+		palette[1] = (uint8_t)v1;
+		if(v0 > v1)
+		{
+			for(uint32_t i = 1; i < 7; ++i)
+				palette[i + 1] = (uint8_t)(((7 - i)*v0 + i*v1 + 3) / 7);
+		}
+		else
+		{
+			for(uint32_t i = 1; i < 5; ++i)
+				palette[i + 1] = (uint8_t)(((5 - i)*v0 + i*v1 + 2) / 5);
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	int RoundedDivide(int value, int divisor)
+	{
+		return value >= 0 ? (value + divisor/2) / divisor : (value - divisor/2) / divisor;
+	}
+
+	// Signed endpoints; -128 means -1 like -127 does.
+	void MakeSignedPalette(int v0, int v1, uint8_t palette[8])
+	{
+		v0 = (std::max)(v0, -127);
+		v1 = (std::max)(v1, -127);
+
+		int values[8] = { v0, v1 };
+		if(v0 > v1)
+		{
+			for(int i = 1; i < 7; ++i)
+				values[i + 1] = RoundedDivide((7 - i)*v0 + i*v1, 7);
+		}
+		else
+		{
+			for(int i = 1; i < 5; ++i)
+				values[i + 1] = RoundedDivide((5 - i)*v0 + i*v1, 5);
+			values[6] = -127;
+			values[7] = 127;
+		}
+
+		for(int i = 0; i < 8; ++i)
+			palette[i] = (uint8_t)(int8_t)values[i];
+	}
+
+	// Looks up the 16 3-bit indices in bytes 2-7 of an alpha block.
+	void DecodeAlphaIndices(const uint8_t* block, const uint8_t palette[8], uint8_t values[16])
+	{
+		uint64_t indices = ReadU64(block) >> 16;
+		for(uint32_t i = 0; i < 16; ++i)
+			values[i] = palette[(indices >> (3*i)) & 7];
+	}
+
+	void DecodeUnsignedAlphaBlock(const uint8_t* block, uint8_t values[16])
+	{
+		uint8_t palette[8];
+		MakeUnsignedPalette(block[0], block[1], palette);
+		DecodeAlphaIndices(block, palette, values);
+	}
+
+	void DecodeSignedAlphaBlock(const uint8_t* block, uint8_t values[16])
+	{
+		uint8_t palette[8];
+		MakeSignedPalette((int8_t)block[0], (int8_t)block[1], palette);
+		DecodeAlphaIndices(block, palette, values);
+	}
+
+	// Replaces the alpha byte of every texel.
+	void MergeAlpha(const uint8_t alpha[16], uint32_t texels[16])
+	{
+#ifdef BC_DECODER_SSE2
+		// Widen the 16 alpha bytes to the top byte of 16 32-bit lanes.
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha));
+		__m128i a16[2] = { _mm_unpacklo_epi8(zero, a), _mm_unpackhi_epi8(zero, a) };
+
+		for(uint32_t half = 0; half < 2; ++half)
+		{
+			__m128i a32[2] = { _mm_unpacklo_epi16(zero, a16[half]), _mm_unpackhi_epi16(zero, a16[half]) };
+			for(uint32_t quarter = 0; quarter < 2; ++quarter)
+			{
+				__m128i* p = reinterpret_cast<__m128i*>(texels + 8*half + 4*quarter);
+				_mm_storeu_si128(p, _mm_or_si128(_mm_and_si128(_mm_loadu_si128(p), rgbMask), a32[quarter]));
+			}
+		}
+#else
+		for(uint32_t i = 0; i < 16; ++i)
+			texels[i] = (texels[i] & 0x00FFFFFF) | ((uint32_t)alpha[i] << 24);
+#endif
+	}
+
+	// Texels (r, g, 0, one) from the channel values; pass g = nullptr for BC4.
+	// Compilers vectorize this loop as well as hand-written SSE2 does.
+	void MakeRedGreenTexels(const uint8_t r[16], const uint8_t* g, uint8_t one, uint32_t texels[16])
+	{
+		for(uint32_t i = 0; i < 16; ++i)
+			texels[i] = PackRGBA(r[i], g != nullptr ? g[i] : 0, 0, one);
+	}
+
+	void DecodeBC2(const uint8_t* block, uint32_t texels[16])
+	{
+		DecodeColorBlock(block + 8, false, texels);
+
+		// 4-bit explicit alpha, two texels per byte, low nibble first.
+		uint8_t alpha[16];
+#ifdef BC_DECODER_SSE2
+		const __m128i nibble = _mm_set1_epi8(0x0F);
+		__m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(block));
+		__m128i lo = _mm_and_si128(packed, nibble);
+		__m128i hi = _mm_and_si128(_mm_srli_epi16(packed, 4), nibble);
+		__m128i a4 = _mm_unpacklo_epi8(lo, hi);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(alpha), _mm_or_si128(a4, _mm_slli_epi16(a4, 4)));
+#else
+		for(uint32_t i = 0; i < 16; ++i)
+		{
+			uint32_t a4 = (block[i/2] >> (4*(i & 1))) & 0xF;
+			alpha[i] = (uint8_t)(a4 * 17);
+		}
+#endif
+		MergeAlpha(alpha, texels);
+	}
+
+	void DecodeBC3(const uint8_t* block, uint32_t texels[16])
+	{
+		DecodeColorBlock(block + 8, false, texels);
+
+		uint8_t alpha[16];
+		DecodeUnsignedAlphaBlock(block, alpha);
+		MergeAlpha(alpha, texels);
+	}
+
+	void DecodeBC4(const uint8_t* block, bool isSigned, uint32_t texels[16])
+	{
+		uint8_t r[16];
+		if(isSigned)
+			DecodeSignedAlphaBlock(block, r);
+		else
+			DecodeUnsignedAlphaBlock(block, r);
+
+		MakeRedGreenTexels(r, nullptr, isSigned ? 127 : 255, texels);
+	}
+
+	void DecodeBC5(const uint8_t* block, bool isSigned, uint32_t texels[16])
+	{
+		uint8_t r[16];
+		uint8_t g[16];
+		if(isSigned)
+		{
+			DecodeSignedAlphaBlock(block, r);
+			DecodeSignedAlphaBlock(block + 8, g);
+		}
+		else
+		{
+			DecodeUnsignedAlphaBlock(block, r);
+			DecodeUnsignedAlphaBlock(block + 8, g);
+		}
+
+		MakeRedGreenTexels(r, g, isSigned ? 127 : 255, texels);
+	}
+
+	//
+	// BC7.
+	//
+
+	class Bc7BitReader
+	{
+	public:
+		explicit Bc7BitReader(const uint8_t* block) :
+			mLow(ReadU64(block)), mHigh(ReadU64(block + 8))
+		{
+		}
+
+		uint32_t Read(uint32_t numBits)
+		{
+			if(numBits == 0)
+				return 0;
+
+			uint64_t bits;
+			if(mPos >= 64)
+				bits = mHigh >> (mPos - 64);
+			else if(mPos + numBits <= 64)
+				bits = mLow >> mPos;
+			else
+				bits = (mLow >> mPos) | (mHigh << (64 - mPos));
+
+			mPos += numBits;
+			return (uint32_t)bits & ((1u << numBits) - 1);
+		}
+
+		void Skip(uint32_t numBits) { mPos += numBits; }
+
+	private:
+		uint64_t mLow;
+		uint64_t mHigh;
+		uint32_t mPos = 0;
+	};
+
+	uint8_t ExpandBits(uint32_t value, uint32_t numBits)
+	{
+		value <<= 8 - numBits;
+		return (uint8_t)(value | (value >> numBits));
+	}
+
+	// palette[k] = ((64 - w[k])*e0 + w[k]*e1 + 32) >> 6 per channel, for the 4, 8 or
+	// 16 weights of indexBits.
+	void InterpolateBc7(uint32_t e0, uint32_t e1, uint32_t indexBits, uint32_t* palette)
+	{
+		const uint16_t* weights = indexBits == 2 ? Bc7Weights2 : indexBits == 3 ? Bc7Weights3 : Bc7Weights4;
+		const uint32_t count = 1u << indexBits;
+
+		for(uint32_t k = 0; k < count; ++k)
+		{
+			uint32_t w1 = weights[k];
+			uint32_t w0 = 64 - w1;
+			uint32_t color = 0;
+			for(uint32_t shift = 0; shift < 32; shift += 8)
+			{
+				uint32_t c = (w0*((e0 >> shift) & 0xFF) + w1*((e1 >> shift) & 0xFF) + 32) >> 6;
+				color |= c << shift;
+			}
+			palette[k] = color;
+		}
+	}
+
+	void DecodeBC7(const uint8_t* block, uint32_t texels[16])
+	{
+		uint32_t modeIndex = 0;
+		while(modeIndex < 8 && (block[0] & (1u << modeIndex)) == 0)
+			++modeIndex;
+
+		// Reserved mode: the spec decodes it to transparent black.
+		if(modeIndex == 8)
+		{
+			memset(texels, 0, 16*sizeof(uint32_t));
+			return;
+		}
+
+		const Bc7Mode& mode = Bc7Modes[modeIndex];
+		Bc7BitReader bits(block);
+		bits.Skip(modeIndex + 1);
+
+		uint32_t partition = bits.Read(mode.PartitionBits);
+		uint32_t rotation = bits.Read(mode.RotationBits);
+		uint32_t indexSelection = bits.Read(mode.IndexSelectionBits);
+
+		// Endpoints are stored channel by channel: red of every endpoint, then green...
+		const uint32_t numEndpoints = 2u*mode.Subsets;
+		uint32_t endpoints[6][4];
+		for(uint32_t c = 0; c < 3; ++c)
+		{
+			for(uint32_t e = 0; e < numEndpoints; ++e)
+				endpoints[e][c] = bits.Read(mode.ColorBits);
+		}
+		for(uint32_t e = 0; e < numEndpoints; ++e)
+			endpoints[e][3] = bits.Read(mode.AlphaBits);
+
+		uint32_t colorBits = mode.ColorBits;
+		uint32_t alphaBits = mode.AlphaBits;
+		if(mode.EndpointPBits || mode.SharedPBits)
+		{
+			uint32_t pBits[6];
+			if(mode.EndpointPBits)
+			{
+				for(uint32_t e = 0; e < numEndpoints; ++e)
+					pBits[e] = bits.Read(1);
+			}
+			else
+			{
+				for(uint32_t s = 0; s < mode.Subsets; ++s)
+					pBits[2*s] = pBits[2*s + 1] = bits.Read(1);
+			}
+
+			for(uint32_t e = 0; e < numEndpoints; ++e)
+			{
+				for(uint32_t c = 0; c < 4; ++c)
+					endpoints[e][c] = (endpoints[e][c] << 1) | pBits[e];
+			}
+
+			++colorBits;
+			if(alphaBits)
+				++alphaBits;
+		}
+
+		uint32_t packed[6];
+		for(uint32_t e = 0; e < numEndpoints; ++e)
+		{
+			packed[e] = PackRGBA(ExpandBits(endpoints[e][0], colorBits), ExpandBits(endpoints[e][1], colorBits),
+				ExpandBits(endpoints[e][2], colorBits), alphaBits ? ExpandBits(endpoints[e][3], alphaBits) : 255);
+		}
+
+		// Subset of every texel and the anchors that lose an index bit.
+		uint8_t subsets[16] = {};
+		bool isAnchor[16] = { true };
+		if(mode.Subsets == 2)
+		{
+			for(uint32_t i = 0; i < 16; ++i)
+				subsets[i] = (uint8_t)((Bc7Partitions2[partition] >> i) & 1);
+			isAnchor[Bc7Anchors2[partition]] = true;
+		}
+		else if(mode.Subsets == 3)
+		{
+			memcpy(subsets, Bc7Partitions3[partition], sizeof(subsets));
+			isAnchor[Bc7Anchors3a[partition]] = true;
+			isAnchor[Bc7Anchors3b[partition]] = true;
+		}
+
+		uint8_t indices[16];
+		for(uint32_t i = 0; i < 16; ++i)
+			indices[i] = (uint8_t)bits.Read(mode.IndexBits - (isAnchor[i] ? 1 : 0));
+
+		// Modes 4 and 5 have a second set of indices.  In mode 4 the index selection
+		// bit decides which set colour and alpha use.
+		uint8_t secondaryIndices[16];
+		const uint8_t* colorIndices = indices;
+		const uint8_t* alphaIndices = indices;
+		uint32_t colorIndexBits = mode.IndexBits;
+		uint32_t alphaIndexBits = mode.IndexBits;
+		if(mode.SecondaryIndexBits)
+		{
+			for(uint32_t i = 0; i < 16; ++i)
+				secondaryIndices[i] = (uint8_t)bits.Read(mode.SecondaryIndexBits - (i == 0 ? 1 : 0));
+
+			if(indexSelection)
+			{
+				colorIndices = secondaryIndices;
+				colorIndexBits = mode.SecondaryIndexBits;
+			}
+			else
+			{
+				alphaIndices = secondaryIndices;
+				alphaIndexBits = mode.SecondaryIndexBits;
+			}
+		}
+
+		uint32_t palettes[3][16];
+		for(uint32_t s = 0; s < mode.Subsets; ++s)
+			InterpolateBc7(packed[2*s], packed[2*s + 1], colorIndexBits, palettes[s]);
+
+		if(mode.SecondaryIndexBits)
+		{
+			uint32_t alphaPalette[16];
+			InterpolateBc7(packed[0], packed[1], alphaIndexBits, alphaPalette);
+			for(uint32_t i = 0; i < 16; ++i)
+				texels[i] = (palettes[0][colorIndices[i]] & 0x00FFFFFF) | (alphaPalette[alphaIndices[i]] & 0xFF000000);
+		}
+		else
+		{
+			for(uint32_t i = 0; i < 16; ++i)
+				texels[i] = palettes[subsets[i]][indices[i]];
+		}
+
+		// Modes 4 and 5 can store red, green or blue in the alpha channel.
+		if(rotation != 0)
+		{
+			uint32_t shift = 8*(rotation - 1);
+			for(uint32_t i = 0; i < 16; ++i)
+			{
+				uint32_t a = texels[i] >> 24;
+				uint32_t c = (texels[i] >> shift) & 0xFF;
+				texels[i] = (texels[i] & ~(0xFFu << shift) & 0x00FFFFFF) | (a << shift) | (c << 24);
+			}
+		}
+	}
+
+	// Calls decode with the block function for type, so each format gets its own
+	// copy of the surface loop instead of a switch per block.
+	template<typename Func>
+	void DispatchBlockType(BlockType type, const Func& decode)
+	{
+		switch(type)
+		{
+		case BlockType::BC1:       decode([](const uint8_t* b, uint32_t* t) { DecodeColorBlock(b, true, t); }); break;
+		case BlockType::BC2:       decode([](const uint8_t* b, uint32_t* t) { DecodeBC2(b, t); }); break;
+		case BlockType::BC3:       decode([](const uint8_t* b, uint32_t* t) { DecodeBC3(b, t); }); break;
+		case BlockType::BC4:       decode([](const uint8_t* b, uint32_t* t) { DecodeBC4(b, false, t); }); break;
+		case BlockType::BC4Signed: decode([](const uint8_t* b, uint32_t* t) { DecodeBC4(b, true, t); }); break;
+		case BlockType::BC5:       decode([](const uint8_t* b, uint32_t* t) { DecodeBC5(b, false, t); }); break;
+		case BlockType::BC5Signed: decode([](const uint8_t* b, uint32_t* t) { DecodeBC5(b, true, t); }); break;
+		case BlockType::BC7:       decode([](const uint8_t* b, uint32_t* t) { DecodeBC7(b, t); }); break;
+		default:                   break;
+		}
+	}
+
+	void DecodeBlockTexels(BlockType type, const uint8_t* block, uint32_t texels[16])
+	{
+		DispatchBlockType(type, [&](auto decodeBlock) { decodeBlock(block, texels); });
+	}
+
+	template<typename DecodeBlockFunc>
+	void DecodeRow(const DecodeBlockFunc& decodeBlock, size_t blockBytes, const uint8_t* src,
+		uint32_t width, uint32_t rows, uint8_t* dst, size_t pixelRowPitch)
+	{
+		const uint32_t blocksWide = (width + 3) / 4;
+		for(uint32_t bx = 0; bx < blocksWide; ++bx)
+		{
+			uint32_t texels[16];
+			decodeBlock(src + bx*blockBytes, texels);
+
+			// Whole blocks copy fixed-size rows; only the right and bottom edges of
+			// sizes that aren't multiples of 4 need the general copy.
+			const uint32_t columns = (std::min)(4u, width - bx*4);
+			if(rows == 4 && columns == 4)
+			{
+				for(uint32_t y = 0; y < 4; ++y)
+					memcpy(dst + y*pixelRowPitch + bx*16, texels + 4*y, 16);
+			}
+			else
+			{
+				for(uint32_t y = 0; y < rows; ++y)
+					memcpy(dst + y*pixelRowPitch + bx*16, texels + 4*y, 4*columns);
+			}
+		}
+	}
+}
+
+bool BcDecoder::IsSupported(DXGI_FORMAT format)
+{
+	return GetBlockType(format) != BlockType::Unsupported;
+}
+
+DXGI_FORMAT BcDecoder::GetDecodedFormat(DXGI_FORMAT format)
+{
+	switch(format)
+	{
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+
+	case DXGI_FORMAT_BC4_SNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+		return DXGI_FORMAT_R8G8B8A8_SNORM;
+
+	default:
+		return IsSupported(format) ? DXGI_FORMAT_R8G8B8A8_UNORM : DXGI_FORMAT_UNKNOWN;
+	}
+}
+
+bool BcDecoder::Decode(DXGI_FORMAT format, const void* blocks, size_t rowPitch,
+	uint32 width, uint32 height, void* pixels, size_t pixelRowPitch, unsigned numThreads)
+{
+	BlockType type = GetBlockType(format);
+	if(type == BlockType::Unsupported)
+		return false;
+
+	const size_t blockBytes = BlockBytes(type);
+	const uint32 blocksHigh = (height + 3) / 4;
+
+	// One row of blocks is one work item.
+	DispatchBlockType(type, [&](auto decodeBlock)
+	{
+		ParallelFor(blocksHigh, numThreads, [&](unsigned, size_t by)
+		{
+			const uint8_t* src = static_cast<const uint8_t*>(blocks) + by*rowPitch;
+			uint8_t* dst = static_cast<uint8_t*>(pixels) + 4*by*pixelRowPitch;
+			const uint32 rows = (std::min)(4u, height - (uint32)by*4);
+			DecodeRow(decodeBlock, blockBytes, src, width, rows, dst, pixelRowPitch);
+		});
+	});
+
+	return true;
+}
+
+bool BcDecoder::Decode(const DdsFile& dds, uint32 mip, uint32 slice,
+	std::vector<uint8>& pixels, unsigned numThreads)
+{
+	if(!dds.IsValid() || !IsSupported(dds.GetFormat()) ||
+		mip >= dds.GetMipCount() || slice >= dds.GetArraySize())
+		return false;
+
+	const DdsSubresource& sub = dds.GetSubresource(mip, slice);
+	pixels.resize((size_t)sub.Width * sub.Height * 4);
+	return Decode(dds.GetFormat(), sub.Data, sub.RowPitch, sub.Width, sub.Height,
+		pixels.data(), (size_t)sub.Width * 4, numThreads);
+}
+
+bool BcDecoder::DecodeBlock(DXGI_FORMAT format, const void* block, uint8 pixels[64])
+{
+	BlockType type = GetBlockType(format);
+	if(type == BlockType::Unsupported)
+		return false;
+
+	uint32_t texels[16];
+	DecodeBlockTexels(type, static_cast<const uint8_t*>(block), texels);
+	memcpy(pixels, texels, sizeof(texels));
+	return true;
+}
+
+bool BcDecoder::DecodeTexel(DXGI_FORMAT format, const void* blocks, size_t rowPitch,
+	uint32 x, uint32 y, uint8 rgba[4])
+{
+	BlockType type = GetBlockType(format);
+	if(type == BlockType::Unsupported)
+		return false;
+
+	const uint8_t* block = static_cast<const uint8_t*>(blocks) + (y / 4)*rowPitch + (x / 4)*BlockBytes(type);
+
+	uint32_t texels[16];
+	DecodeBlockTexels(type, block, texels);
+	memcpy(rgba, &texels[(y % 4)*4 + x % 4], 4);
+	return true;
+}
@@ -0,0 +1,60 @@
+//***************************************************************************************
+// BcDecoder.h
+//
+// CPU decoder for the block-compressed formats DDSTextureLoader accepts: BC1, BC2,
+// BC3, BC4, BC5 and BC7.  Decodes to 4 bytes per pixel (R8G8B8A8) so tools can diff
+// images, sample textures on the CPU (e.g. alpha tests against treearray.dds) or
+// fall back to uncompressed textures.
+//
+// Rows of blocks are decoded in parallel.  On x86/x64 the BC1 colour lookup and the
+// BC2/BC3 alpha merge use SSE2; define BC_DECODER_NO_SIMD to build the scalar code
+// everywhere.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "DdsFile.h"
+
+class BcDecoder
+{
+public:
+	typedef std::uint8_t uint8;
+	typedef std::uint32_t uint32;
+
+	static bool IsSupported(DXGI_FORMAT format);
+
+	///<summary>
+	/// What Decode writes for format: R8G8B8A8_UNORM, R8G8B8A8_UNORM_SRGB (sRGB data
+	/// is left encoded) or R8G8B8A8_SNORM for BC4/BC5_SNORM.  Channels the format
+	/// doesn't store read as 0, and alpha as 1.
+	///</summary>
+	static DXGI_FORMAT GetDecodedFormat(DXGI_FORMAT format);
+
+	///<summary>
+	/// Decodes a width x height surface.  blocks holds rowPitch bytes per row of 4x4
+	/// blocks (DdsSubresource::RowPitch); pixels receives pixelRowPitch bytes per row
+	/// of pixels.  Uses up to numThreads threads (0 = every hardware thread).
+	/// Returns false if format isn't supported.
+	///</summary>
+	static bool Decode(DXGI_FORMAT format, const void* blocks, size_t rowPitch,
+		uint32 width, uint32 height, void* pixels, size_t pixelRowPitch, unsigned numThreads = 0);
+
+	///<summary>
+	/// Decodes one subresource of dds into tightly packed rows.
+	///</summary>
+	static bool Decode(const DdsFile& dds, uint32 mip, uint32 slice,
+		std::vector<uint8>& pixels, unsigned numThreads = 0);
+
+	///<summary>
+	/// Decodes one 4x4 block into 16 pixels, row by row.
+	///</summary>
+	static bool DecodeBlock(DXGI_FORMAT format, const void* block, uint8 pixels[64]);
+
+	///<summary>
+	/// Decodes the single texel (x, y) by decoding only the block that holds it.
+	///</summary>
+	static bool DecodeTexel(DXGI_FORMAT format, const void* blocks, size_t rowPitch,
+		uint32 x, uint32 y, uint8 rgba[4]);
+};
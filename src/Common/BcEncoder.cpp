@@ -0,0 +1,1303 @@
+//***************************************************************************************
+// BcEncoder.cpp
+//
+// Endpoints come from the principal axis of each block's (or BC7 subset's) colours
+// and are refined by least squares on the chosen indices.  Palettes are built with
+// the same rounding BcDecoder uses, so the errors compared here are the errors the
+// GPU will show.
+//***************************************************************************************
+
+#include "BcEncoder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include "Bc7Tables.h"
+#include "ParallelFor.h"
+
+using std::uint8_t;
+using std::uint32_t;
+using std::uint64_t;
+
+namespace
+{
+	typedef BcEncoder::Quality Quality;
+
+	enum class BlockType
+	{
+		Unsupported,
+		BC1,
+		BC3,
+		BC4,
+		BC5,
+		BC7
+	};
+
+	BlockType GetBlockType(DXGI_FORMAT format)
+	{
+		switch(format)
+		{
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			return BlockType::BC1;
+
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			return BlockType::BC3;
+
+		case DXGI_FORMAT_BC4_UNORM:
+			return BlockType::BC4;
+
+		case DXGI_FORMAT_BC5_UNORM:
+			return BlockType::BC5;
+
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return BlockType::BC7;
+
+		default:
+			return BlockType::Unsupported;
+		}
+	}
+
+	size_t BlockBytes(BlockType type)
+	{
+		return (type == BlockType::BC1 || type == BlockType::BC4) ? 8 : 16;
+	}
+
+	void WriteU16(uint8_t* p, uint32_t v)
+	{
+		p[0] = (uint8_t)v;
+		p[1] = (uint8_t)(v >> 8);
+	}
+
+	void WriteU32(uint8_t* p, uint32_t v)
+	{
+		WriteU16(p, v);
+		WriteU16(p + 2, v >> 16);
+	}
+
+	float Clamp255(float v)
+	{
+		return (std::min)((std::max)(v, 0.0f), 255.0f);
+	}
+
+	// Channels [first, end) of two texels.
+	uint32_t SquaredError(const uint8_t* a, const uint8_t* b, uint32_t first, uint32_t end)
+	{
+		uint32_t error = 0;
+		for(uint32_t c = first; c < end; ++c)
+		{
+			int d = (int)a[c] - (int)b[c];
+			error += (uint32_t)(d*d);
+		}
+
+		return error;
+	}
+
+	//
+	// Line fitting shared by BC1 and BC7.
+	//
+
+	// Some of a block's texels, with the position each came from.
+	struct TexelSet
+	{
+		uint8_t Texels[16][4];
+		uint8_t Positions[16];
+		uint32_t Count = 0;
+
+		void Add(const uint8_t* texel, uint32_t position)
+		{
+			memcpy(Texels[Count], texel, 4);
+			Positions[Count++] = (uint8_t)position;
+		}
+	};
+
+	// Sums of texels and of their channel products: the mean and covariance follow
+	// from them, and the moments of a subset are the sum of its texels' moments.
+	struct Moments
+	{
+		float Count = 0.0f;
+		float Sum[4] = {};
+		float Products[4][4] = {};
+
+		void Add(const uint8_t* texel)
+		{
+			Count += 1.0f;
+			for(uint32_t r = 0; r < 4; ++r)
+			{
+				Sum[r] += texel[r];
+				for(uint32_t c = r; c < 4; ++c)
+					Products[r][c] += (float)texel[r]*texel[c];
+			}
+		}
+
+		void Add(const Moments& m)
+		{
+			Count += m.Count;
+			for(uint32_t r = 0; r < 4; ++r)
+			{
+				Sum[r] += m.Sum[r];
+				for(uint32_t c = r; c < 4; ++c)
+					Products[r][c] += m.Products[r][c];
+			}
+		}
+
+		void Subtract(const Moments& m)
+		{
+			Count -= m.Count;
+			for(uint32_t r = 0; r < 4; ++r)
+			{
+				Sum[r] -= m.Sum[r];
+				for(uint32_t c = r; c < 4; ++c)
+					Products[r][c] -= m.Products[r][c];
+			}
+		}
+	};
+
+	// Finds the mean and principal axis of the first channels of the texels m sums.
+	// Returns the sum of squared distances from that line, or 0 with a zero axis if
+	// every texel is the same.
+	float PrincipalAxis(const Moments& m, uint32_t channels, uint32_t iterations, float mean[4], float axis[4])
+	{
+		for(uint32_t c = 0; c < 4; ++c)
+			mean[c] = axis[c] = 0.0f;
+
+		if(m.Count == 0.0f)
+			return 0.0f;
+
+		for(uint32_t c = 0; c < channels; ++c)
+			mean[c] = m.Sum[c] / m.Count;
+
+		float cov[4][4] = {};
+		float trace = 0.0f;
+		uint32_t largest = 0;
+		for(uint32_t r = 0; r < channels; ++r)
+		{
+			for(uint32_t c = r; c < channels; ++c)
+				cov[r][c] = cov[c][r] = m.Products[r][c] - m.Sum[r]*mean[c];
+
+			trace += cov[r][r];
+			if(cov[r][r] > cov[largest][largest])
+				largest = r;
+		}
+
+		if(cov[largest][largest] <= 0.0f)
+			return 0.0f;
+
+		// Power iteration from the row of the channel that varies most, which can't
+		// be orthogonal to the principal axis.
+		for(uint32_t c = 0; c < channels; ++c)
+			axis[c] = cov[largest][c];
+
+		for(uint32_t iteration = 0; iteration < iterations; ++iteration)
+		{
+			float next[4] = {};
+			float scale = 0.0f;
+			for(uint32_t r = 0; r < channels; ++r)
+			{
+				for(uint32_t c = 0; c < channels; ++c)
+					next[r] += cov[r][c]*axis[c];
+				scale = (std::max)(scale, std::fabs(next[r]));
+			}
+
+			if(scale <= 0.0f)
+				break;
+
+			for(uint32_t c = 0; c < channels; ++c)
+				axis[c] = next[c] / scale;
+		}
+
+		float length = 0.0f;
+		for(uint32_t c = 0; c < channels; ++c)
+			length += axis[c]*axis[c];
+		length = std::sqrt(length);
+		for(uint32_t c = 0; c < channels; ++c)
+			axis[c] /= length;
+
+		// The variance along the axis is its eigenvalue; the rest is off the line.
+		float eigenvalue = 0.0f;
+		for(uint32_t r = 0; r < channels; ++r)
+		{
+			for(uint32_t c = 0; c < channels; ++c)
+				eigenvalue += axis[r]*cov[r][c]*axis[c];
+		}
+
+		return (std::max)(0.0f, trace - eigenvalue);
+	}
+
+	// Endpoints are the texels' extreme projections onto the principal axis.
+	void FitLine(const TexelSet& set, uint32_t channels, float e0[4], float e1[4])
+	{
+		Moments moments;
+		for(uint32_t i = 0; i < set.Count; ++i)
+			moments.Add(set.Texels[i]);
+
+		float mean[4];
+		float axis[4];
+		PrincipalAxis(moments, channels, 8, mean, axis);
+
+		float tMin = 0.0f;
+		float tMax = 0.0f;
+		for(uint32_t i = 0; i < set.Count; ++i)
+		{
+			float t = 0.0f;
+			for(uint32_t c = 0; c < channels; ++c)
+				t += (set.Texels[i][c] - mean[c])*axis[c];
+
+			tMin = (std::min)(tMin, t);
+			tMax = (std::max)(tMax, t);
+		}
+
+		for(uint32_t c = 0; c < 4; ++c)
+		{
+			e0[c] = Clamp255(mean[c] + tMin*axis[c]);
+			e1[c] = Clamp255(mean[c] + tMax*axis[c]);
+		}
+	}
+
+	// Least-squares endpoints for fixed indices: minimises the sum over texels of
+	// |(1 - t)*e0 + t*e1 - texel|^2 over channels [first, end), where t =
+	// weights[index].  Returns false if the indices don't pin down two endpoints
+	// (e.g. they are all the same).
+	bool SolveEndpoints(const TexelSet& set, const uint8_t indices[16], const float* weights,
+		uint32_t first, uint32_t end, float e0[4], float e1[4])
+	{
+		float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+		float x[4] = {}, y[4] = {};
+		for(uint32_t i = 0; i < set.Count; ++i)
+		{
+			float t = weights[indices[i]];
+			float s = 1.0f - t;
+			aa += s*s;
+			bb += t*t;
+			ab += s*t;
+			for(uint32_t c = first; c < end; ++c)
+			{
+				x[c] += s*set.Texels[i][c];
+				y[c] += t*set.Texels[i][c];
+			}
+		}
+
+		float det = aa*bb - ab*ab;
+		if(std::fabs(det) < 1e-6f)
+			return false;
+
+		for(uint32_t c = first; c < end; ++c)
+		{
+			e0[c] = Clamp255((bb*x[c] - ab*y[c]) / det);
+			e1[c] = Clamp255((aa*y[c] - ab*x[c]) / det);
+		}
+
+		return true;
+	}
+
+	// Nearest entry of palette for every texel of set, comparing channels [first,
+	// end); returns the total error.
+	uint32_t AssignIndices(const TexelSet& set, const uint8_t (*palette)[4], uint32_t paletteSize,
+		uint32_t first, uint32_t end, uint8_t indices[16])
+	{
+		uint32_t total = 0;
+		for(uint32_t i = 0; i < set.Count; ++i)
+		{
+			uint32_t bestError = SquaredError(set.Texels[i], palette[0], first, end);
+			uint32_t bestIndex = 0;
+			for(uint32_t k = 1; k < paletteSize && bestError > 0; ++k)
+			{
+				uint32_t error = SquaredError(set.Texels[i], palette[k], first, end);
+				if(error < bestError)
+				{
+					bestError = error;
+					bestIndex = k;
+				}
+			}
+
+			indices[i] = (uint8_t)bestIndex;
+			total += bestError;
+		}
+
+		return total;
+	}
+
+	//
+	// BC1 colour block; also the colour half of BC3.
+	//
+
+	const float FourColorWeights[4] = { 0.0f, 1.0f, 1.0f/3.0f, 2.0f/3.0f };
+	const float ThreeColorWeights[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+
+	uint32_t Quantize565(const float c[4])
+	{
+		uint32_t r = (uint32_t)std::lround(c[0]*31.0f/255.0f);
+		uint32_t g = (uint32_t)std::lround(c[1]*63.0f/255.0f);
+		uint32_t b = (uint32_t)std::lround(c[2]*31.0f/255.0f);
+		return (r << 11) | (g << 5) | b;
+	}
+
+	void Expand565(uint32_t c, uint8_t rgba[4])
+	{
+		uint32_t r = (c >> 11) & 31;
+		uint32_t g = (c >> 5) & 63;
+		uint32_t b = c & 31;
+		rgba[0] = (uint8_t)((r << 3) | (r >> 2));
+		rgba[1] = (uint8_t)((g << 2) | (g >> 4));
+		rgba[2] = (uint8_t)((b << 3) | (b >> 2));
+		rgba[3] = 255;
+	}
+
+	// For every 8-bit value, the pair of 5 or 6-bit endpoints whose palette entry 2
+	// (2/3 of the first plus 1/3 of the second) decodes closest to it.  A solid
+	// block gets far closer through entry 2 than through a rounded endpoint.
+	struct SingleColorTable
+	{
+		uint8_t Endpoints[256][2];
+
+		explicit SingleColorTable(uint32_t bits)
+		{
+			const uint32_t count = 1u << bits;
+			for(uint32_t v = 0; v < 256; ++v)
+			{
+				int bestError = 256;
+				for(uint32_t e0 = 0; e0 < count; ++e0)
+				{
+					for(uint32_t e1 = 0; e1 < count; ++e1)
+					{
+						uint32_t a = (e0 << (8 - bits)) | (e0 >> (2*bits - 8));
+						uint32_t b = (e1 << (8 - bits)) | (e1 >> (2*bits - 8));
+						int error = std::abs((int)((2*a + b + 1) / 3) - (int)v);
+						if(error < bestError)
+						{
+							bestError = error;
+							Endpoints[v][0] = (uint8_t)e0;
+							Endpoints[v][1] = (uint8_t)e1;
+						}
+					}
+				}
+			}
+		}
+	};
+
+	struct ColorCandidate
+	{
+		uint32_t Color0 = 0;
+		uint32_t Color1 = 0;
+		bool ThreeColor = false;
+		uint8_t Indices[16] = {};
+		uint32_t Error = UINT32_MAX;
+	};
+
+	// Evaluates the 565 endpoints color0/color1 on the opaque texels and keeps them
+	// in best if they beat it.  Endpoint order is fixed up when the block is written.
+	bool TryColorEndpoints(const TexelSet& opaque, uint32_t color0, uint32_t color1, bool threeColor,
+		ColorCandidate& best)
+	{
+		uint8_t palette[4][4];
+		Expand565(color0, palette[0]);
+		Expand565(color1, palette[1]);
+		for(uint32_t c = 0; c < 3; ++c)
+		{
+			uint32_t a = palette[0][c];
+			uint32_t b = palette[1][c];
+			if(threeColor)
+			{
+				palette[2][c] = (uint8_t)((a + b + 1) / 2);
+			}
+			else
+			{
+				palette[2][c] = (uint8_t)((2*a + b + 1) / 3);
+				palette[3][c] = (uint8_t)((a + 2*b + 1) / 3);
+			}
+		}
+
+		uint8_t indices[16];
+		uint32_t error = AssignIndices(opaque, palette, threeColor ? 3 : 4, 0, 3, indices);
+		if(error >= best.Error)
+			return false;
+
+		best.Color0 = color0;
+		best.Color1 = color1;
+		best.ThreeColor = threeColor;
+		memcpy(best.Indices, indices, sizeof(indices));
+		best.Error = error;
+		return true;
+	}
+
+	// Least-squares passes on best's indices until they stop helping.
+	void RefineColorEndpoints(const TexelSet& opaque, uint32_t passes, ColorCandidate& best)
+	{
+		for(uint32_t pass = 0; pass < passes && best.Error > 0; ++pass)
+		{
+			float e0[4], e1[4];
+			const float* weights = best.ThreeColor ? ThreeColorWeights : FourColorWeights;
+			if(!SolveEndpoints(opaque, best.Indices, weights, 0, 3, e0, e1) ||
+				!TryColorEndpoints(opaque, Quantize565(e0), Quantize565(e1), best.ThreeColor, best))
+				break;
+		}
+	}
+
+	// Steps single 565 channels of the endpoints by one while that lowers the error.
+	void SearchColorEndpoints(const TexelSet& opaque, ColorCandidate& best)
+	{
+		const uint32_t shifts[3] = { 11, 5, 0 };
+		const uint32_t masks[3] = { 31, 63, 31 };
+
+		bool improved = true;
+		for(uint32_t pass = 0; pass < 4 && improved && best.Error > 0; ++pass)
+		{
+			improved = false;
+			for(uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+			{
+				for(uint32_t c = 0; c < 3; ++c)
+				{
+					for(int step = -1; step <= 1; step += 2)
+					{
+						uint32_t color = endpoint == 0 ? best.Color0 : best.Color1;
+						int value = (int)((color >> shifts[c]) & masks[c]) + step;
+						if(value < 0 || value > (int)masks[c])
+							continue;
+
+						color = (color & ~(masks[c] << shifts[c])) | ((uint32_t)value << shifts[c]);
+						uint32_t color0 = endpoint == 0 ? color : best.Color0;
+						uint32_t color1 = endpoint == 0 ? best.Color1 : color;
+						improved |= TryColorEndpoints(opaque, color0, color1, best.ThreeColor, best);
+					}
+				}
+			}
+		}
+	}
+
+	// allowTransparent is true for BC1, where texels with alpha below 128 become
+	// transparent black in a three-colour block.  BC3's colour block always has four.
+	void EncodeColorBlock(const uint8_t pixels[16][4], bool allowTransparent, Quality quality, uint8_t* block)
+	{
+		TexelSet opaque;
+		uint32_t transparentMask = 0;
+		for(uint32_t i = 0; i < 16; ++i)
+		{
+			if(allowTransparent && pixels[i][3] < 128)
+				transparentMask |= 1u << i;
+			else
+				opaque.Add(pixels[i], i);
+		}
+
+		if(opaque.Count == 0)
+		{
+			WriteU16(block, 0);
+			WriteU16(block + 2, 0);
+			WriteU32(block + 4, 0xFFFFFFFF);
+			return;
+		}
+
+		float e0[4], e1[4];
+		FitLine(opaque, 3, e0, e1);
+
+		const bool needsThreeColor = transparentMask != 0;
+		const uint32_t passes = quality == Quality::Fast ? 0 : quality == Quality::Normal ? 2 : 4;
+
+		ColorCandidate best;
+		TryColorEndpoints(opaque, Quantize565(e0), Quantize565(e1), needsThreeColor, best);
+
+		bool solid = !needsThreeColor;
+		for(uint32_t i = 1; i < opaque.Count && solid; ++i)
+			solid = memcmp(opaque.Texels[i], opaque.Texels[0], 3) == 0;
+
+		if(solid && best.Error > 0)
+		{
+			static const SingleColorTable table5(5);
+			static const SingleColorTable table6(6);
+			const uint8_t* texel = opaque.Texels[0];
+
+			uint32_t color0 = (table5.Endpoints[texel[0]][0] << 11) | (table6.Endpoints[texel[1]][0] << 5) | table5.Endpoints[texel[2]][0];
+			uint32_t color1 = (table5.Endpoints[texel[0]][1] << 11) | (table6.Endpoints[texel[1]][1] << 5) | table5.Endpoints[texel[2]][1];
+			TryColorEndpoints(opaque, color0, color1, false, best);
+		}
+
+		RefineColorEndpoints(opaque, passes, best);
+
+		// The three-colour mode's midpoint sometimes fits an opaque BC1 block better.
+		if(quality == Quality::High && allowTransparent && !needsThreeColor && best.Error > 0)
+		{
+			ColorCandidate three;
+			TryColorEndpoints(opaque, Quantize565(e0), Quantize565(e1), true, three);
+			RefineColorEndpoints(opaque, passes, three);
+			if(three.Error < best.Error)
+				best = three;
+		}
+
+		if(quality == Quality::High)
+			SearchColorEndpoints(opaque, best);
+
+		uint8_t indices[16];
+		for(uint32_t i = 0; i < 16; ++i)
+			indices[i] = 3;
+		for(uint32_t i = 0; i < opaque.Count; ++i)
+			indices[opaque.Positions[i]] = best.Indices[i];
+
+		// Four colours need color0 > color1 and three need color0 <= color1; swapping
+		// the endpoints swaps indices 0 and 1, and in four-colour mode 2 and 3 too.
+		uint32_t color0 = best.Color0;
+		uint32_t color1 = best.Color1;
+		if(best.ThreeColor ? color0 > color1 : color0 < color1)
+		{
+			std::swap(color0, color1);
+			for(uint32_t i = 0; i < 16; ++i)
+			{
+				if(!best.ThreeColor || indices[i] < 2)
+					indices[i] ^= 1;
+			}
+		}
+
+		uint32_t packed = 0;
+		for(uint32_t i = 0; i < 16; ++i)
+			packed |= (uint32_t)indices[i] << (2*i);
+
+		WriteU16(block, color0);
+		WriteU16(block + 2, color1);
+		WriteU32(block + 4, packed);
+	}
+
+	//
+	// BC3 alpha block; also each channel of BC4 and BC5.
+	//
+
+	void MakeUnsignedPalette(uint32_t v0, uint32_t v1, uint8_t palette[8])
+	{
+		palette[0] = (uint8_t)v0;
+		palette[1] = (uint8_t)v1;
+		if(v0 > v1)
+		{
+			for(uint32_t i = 1; i < 7; ++i)
+				palette[i + 1] = (uint8_t)(((7 - i)*v0 + i*v1 + 3) / 7);
+		}
+		else
+		{
+			for(uint32_t i = 1; i < 5; ++i)
+				palette[i + 1] = (uint8_t)(((5 - i)*v0 + i*v1 + 2) / 5);
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	struct AlphaCandidate
+	{
+		uint32_t Value0 = 0;
+		uint32_t Value1 = 0;
+		uint8_t Indices[16] = {};
+		uint32_t Error = UINT32_MAX;
+	};
+
+	void TryAlphaEndpoints(const uint8_t values[16], uint32_t v0, uint32_t v1, AlphaCandidate& best)
+	{
+		uint8_t palette[8];
+		MakeUnsignedPalette(v0, v1, palette);
+
+		uint8_t indices[16];
+		uint32_t error = 0;
+		for(uint32_t i = 0; i < 16 && error < best.Error; ++i)
+		{
+			uint32_t bestError = UINT32_MAX;
+			for(uint32_t k = 0; k < 8; ++k)
+			{
+				int d = (int)values[i] - (int)palette[k];
+				if((uint32_t)(d*d) < bestError)
+				{
+					bestError = (uint32_t)(d*d);
+					indices[i] = (uint8_t)k;
+				}
+			}
+			error += bestError;
+		}
+
+		if(error < best.Error)
+		{
+			best.Value0 = v0;
+			best.Value1 = v1;
+			memcpy(best.Indices, indices, sizeof(indices));
+			best.Error = error;
+		}
+	}
+
+	void EncodeAlphaBlock(const uint8_t values[16], Quality quality, uint8_t* block)
+	{
+		uint32_t minValue = 255, maxValue = 0;
+		uint32_t minInner = 255, maxInner = 0;
+		for(uint32_t i = 0; i < 16; ++i)
+		{
+			minValue = (std::min)(minValue, (uint32_t)values[i]);
+			maxValue = (std::max)(maxValue, (uint32_t)values[i]);
+			if(values[i] != 0 && values[i] != 255)
+			{
+				minInner = (std::min)(minInner, (uint32_t)values[i]);
+				maxInner = (std::max)(maxInner, (uint32_t)values[i]);
+			}
+		}
+
+		// Eight interpolated values between the extremes (v0 > v1)...
+		AlphaCandidate best;
+		if(minValue == maxValue)
+			TryAlphaEndpoints(values, minValue, minValue, best);
+		else
+			TryAlphaEndpoints(values, maxValue, minValue, best);
+
+		// ...or six between the values that aren't 0 or 255, which are exact.
+		if(quality != Quality::Fast && best.Error > 0 && minInner <= maxInner)
+			TryAlphaEndpoints(values, minInner, maxInner, best);
+
+		// Pulling the eight-value endpoints in can spread the steps better.
+		if(quality == Quality::High && best.Error > 0 && maxValue > minValue)
+		{
+			for(uint32_t d0 = 0; d0 < 4; ++d0)
+			{
+				for(uint32_t d1 = 0; d1 < 4; ++d1)
+				{
+					if(maxValue - d0 > minValue + d1)
+						TryAlphaEndpoints(values, maxValue - d0, minValue + d1, best);
+				}
+			}
+		}
+
+		uint64_t packed = 0;
+		for(uint32_t i = 0; i < 16; ++i)
+			packed |= (uint64_t)best.Indices[i] << (3*i);
+
+		block[0] = (uint8_t)best.Value0;
+		block[1] = (uint8_t)best.Value1;
+		for(uint32_t i = 0; i < 6; ++i)
+			block[2 + i] = (uint8_t)(packed >> (8*i));
+	}
+
+	void EncodeChannelBlock(const uint8_t pixels[16][4], uint32_t channel, Quality quality, uint8_t* block)
+	{
+		uint8_t values[16];
+		for(uint32_t i = 0; i < 16; ++i)
+			values[i] = pixels[i][channel];
+
+		EncodeAlphaBlock(values, quality, block);
+	}
+
+	//
+	// BC7.  Mode 6 (one subset, RGBA) suits most blocks; modes 1 and 3 (two subsets,
+	// RGB) sharpen opaque blocks with two colour groups; modes 4 and 5 code alpha
+	// apart from colour, which cutouts need; mode 7 (two subsets, RGBA) covers the
+	// rest.  The three-subset modes 0 and 2 and the channel rotations aren't searched.
+	//
+
+	struct Bc7Candidate
+	{
+		uint32_t Mode = 0;
+		uint32_t Partition = 0;
+		uint32_t Endpoints[6][4] = {};
+		uint32_t PBits[6] = {};
+		uint8_t Indices[16] = {};
+		uint8_t AlphaIndices[16] = {};
+		uint32_t Error = UINT32_MAX;
+	};
+
+	uint8_t ExpandBits(uint32_t value, uint32_t numBits)
+	{
+		value <<= 8 - numBits;
+		return (uint8_t)(value | (value >> numBits));
+	}
+
+	const uint16_t* Bc7Weights(uint32_t indexBits)
+	{
+		return indexBits == 2 ? Bc7Weights2 : indexBits == 3 ? Bc7Weights3 : Bc7Weights4;
+	}
+
+	// The value endpoint channel c decodes to.  Channels a mode doesn't store are 255.
+	uint8_t ExpandEndpoint(const Bc7Mode& mode, uint32_t value, uint32_t pBit, uint32_t c)
+	{
+		uint32_t bits = c < 3 ? mode.ColorBits : mode.AlphaBits;
+		if(bits == 0)
+			return 255;
+
+		if(mode.EndpointPBits || mode.SharedPBits)
+			return ExpandBits((value << 1) | pBit, bits + 1);
+
+		return ExpandBits(value, bits);
+	}
+
+	// The stored value nearest v for channel c with the given p-bit.
+	uint32_t QuantizeEndpoint(const Bc7Mode& mode, float v, uint32_t pBit, uint32_t c)
+	{
+		uint32_t bits = c < 3 ? mode.ColorBits : mode.AlphaBits;
+		if(bits == 0)
+			return 0;
+
+		const bool hasPBit = mode.EndpointPBits || mode.SharedPBits;
+		const uint32_t maxValue = (1u << bits) - 1;
+		const float scale = (float)((1u << (bits + (hasPBit ? 1 : 0))) - 1) / 255.0f;
+		float q = hasPBit ? (v*scale - pBit)*0.5f : v*scale;
+		int guess = (int)std::lround(q);
+
+		// Expansion replicates high bits into the low ones, so check the neighbours.
+		uint32_t best = 0;
+		float bestError = 1e30f;
+		for(int candidate = guess - 1; candidate <= guess + 1; ++candidate)
+		{
+			if(candidate < 0 || candidate > (int)maxValue)
+				continue;
+
+			float d = ExpandEndpoint(mode, (uint32_t)candidate, pBit, c) - v;
+			if(d*d < bestError)
+			{
+				bestError = d*d;
+				best = (uint32_t)candidate;
+			}
+		}
+
+		return best;
+	}
+
+	// Which channels a fit covers, [First, End), and how many index bits it has.
+	// Modes 4 and 5 fit colour and alpha separately; the others fit all four.
+	struct Bc7Channels
+	{
+		uint32_t First;
+		uint32_t End;
+		uint32_t IndexBits;
+	};
+
+	float QuantizeEndpointChannels(const Bc7Mode& mode, const Bc7Channels& channels, const float e[4],
+		uint32_t pBit, uint32_t q[4])
+	{
+		float error = 0.0f;
+		for(uint32_t c = channels.First; c < channels.End; ++c)
+		{
+			q[c] = QuantizeEndpoint(mode, e[c], pBit, c);
+			float d = ExpandEndpoint(mode, q[c], pBit, c) - e[c];
+			error += d*d;
+		}
+
+		return error;
+	}
+
+	struct Bc7SubsetFit
+	{
+		uint32_t Endpoints[2][4] = {};
+		uint32_t PBits[2] = {};
+		uint8_t Indices[16] = {};
+		uint32_t Error = UINT32_MAX;
+	};
+
+	uint32_t EvaluateBc7Subset(const Bc7Mode& mode, const Bc7Channels& channels, const TexelSet& set,
+		const uint32_t endpoints[2][4], const uint32_t pBits[2], uint8_t indices[16])
+	{
+		uint8_t e0[4], e1[4];
+		for(uint32_t c = 0; c < 4; ++c)
+		{
+			e0[c] = ExpandEndpoint(mode, endpoints[0][c], pBits[0], c);
+			e1[c] = ExpandEndpoint(mode, endpoints[1][c], pBits[1], c);
+		}
+
+		const uint16_t* weights = Bc7Weights(channels.IndexBits);
+		const uint32_t count = 1u << channels.IndexBits;
+		uint8_t palette[16][4];
+		for(uint32_t k = 0; k < count; ++k)
+		{
+			uint32_t w1 = weights[k];
+			uint32_t w0 = 64 - w1;
+			for(uint32_t c = 0; c < 4; ++c)
+				palette[k][c] = (uint8_t)((w0*e0[c] + w1*e1[c] + 32) >> 6);
+		}
+
+		return AssignIndices(set, palette, count, channels.First, channels.End, indices);
+	}
+
+	// Quantizes the float endpoints e0/e1 and keeps the result in best if it beats
+	// it.  Fast and Normal pick each p-bit by how closely it reproduces its endpoint;
+	// High evaluates every combination on the texels.  Opaque subsets of modes with
+	// alpha always set the p-bits, the only way to store alpha 255 exactly.
+	bool TryBc7Endpoints(const Bc7Mode& mode, const Bc7Channels& channels, const TexelSet& set,
+		const float e0[4], const float e1[4], Quality quality, bool opaque, Bc7SubsetFit& best)
+	{
+		uint32_t combos[4][2];
+		uint32_t comboCount = 0;
+		uint32_t q[4];
+		if(opaque && mode.AlphaBits && mode.EndpointPBits)
+		{
+			combos[comboCount][0] = combos[comboCount][1] = 1;
+			++comboCount;
+		}
+		else if(mode.SharedPBits)
+		{
+			if(quality == Quality::High)
+			{
+				combos[comboCount][0] = combos[comboCount][1] = 0; ++comboCount;
+				combos[comboCount][0] = combos[comboCount][1] = 1; ++comboCount;
+			}
+			else
+			{
+				float error0 = QuantizeEndpointChannels(mode, channels, e0, 0, q) + QuantizeEndpointChannels(mode, channels, e1, 0, q);
+				float error1 = QuantizeEndpointChannels(mode, channels, e0, 1, q) + QuantizeEndpointChannels(mode, channels, e1, 1, q);
+				combos[comboCount][0] = combos[comboCount][1] = error1 < error0 ? 1 : 0;
+				++comboCount;
+			}
+		}
+		else if(mode.EndpointPBits)
+		{
+			if(quality == Quality::High)
+			{
+				for(uint32_t p = 0; p < 4; ++p)
+				{
+					combos[comboCount][0] = p & 1;
+					combos[comboCount][1] = p >> 1;
+					++comboCount;
+				}
+			}
+			else
+			{
+				combos[comboCount][0] = QuantizeEndpointChannels(mode, channels, e0, 1, q) < QuantizeEndpointChannels(mode, channels, e0, 0, q) ? 1 : 0;
+				combos[comboCount][1] = QuantizeEndpointChannels(mode, channels, e1, 1, q) < QuantizeEndpointChannels(mode, channels, e1, 0, q) ? 1 : 0;
+				++comboCount;
+			}
+		}
+		else
+		{
+			combos[comboCount][0] = combos[comboCount][1] = 0;
+			++comboCount;
+		}
+
+		bool improved = false;
+		for(uint32_t i = 0; i < comboCount; ++i)
+		{
+			Bc7SubsetFit fit;
+			fit.PBits[0] = combos[i][0];
+			fit.PBits[1] = combos[i][1];
+			QuantizeEndpointChannels(mode, channels, e0, fit.PBits[0], fit.Endpoints[0]);
+			QuantizeEndpointChannels(mode, channels, e1, fit.PBits[1], fit.Endpoints[1]);
+			fit.Error = EvaluateBc7Subset(mode, channels, set, fit.Endpoints, fit.PBits, fit.Indices);
+			if(fit.Error < best.Error)
+			{
+				best = fit;
+				improved = true;
+			}
+		}
+
+		return improved;
+	}
+
+	Bc7SubsetFit FitBc7Subset(const Bc7Mode& mode, const Bc7Channels& channels, const TexelSet& set, Quality quality)
+	{
+		// Colour (and alpha) endpoints lie on the principal axis; alpha alone spans
+		// its range.
+		float e0[4] = { 0.0f, 0.0f, 0.0f, 255.0f };
+		float e1[4] = { 0.0f, 0.0f, 0.0f, 255.0f };
+		if(channels.First == 0)
+		{
+			FitLine(set, channels.End, e0, e1);
+			if(channels.End == 3)
+				e0[3] = e1[3] = 255.0f;
+		}
+		else
+		{
+			e0[3] = 255.0f;
+			e1[3] = 0.0f;
+			for(uint32_t i = 0; i < set.Count; ++i)
+			{
+				e0[3] = (std::min)(e0[3], (float)set.Texels[i][3]);
+				e1[3] = (std::max)(e1[3], (float)set.Texels[i][3]);
+			}
+		}
+
+		bool opaque = true;
+		for(uint32_t i = 0; i < set.Count; ++i)
+			opaque = opaque && set.Texels[i][3] == 255;
+
+		Bc7SubsetFit best;
+		TryBc7Endpoints(mode, channels, set, e0, e1, quality, opaque, best);
+
+		const uint32_t passes = quality == Quality::Fast ? 0 : quality == Quality::Normal ? 1 : 3;
+		const uint16_t* weights = Bc7Weights(channels.IndexBits);
+		float t[16];
+		for(uint32_t k = 0; k < (1u << channels.IndexBits); ++k)
+			t[k] = weights[k] / 64.0f;
+
+		for(uint32_t pass = 0; pass < passes && best.Error > 0; ++pass)
+		{
+			if(!SolveEndpoints(set, best.Indices, t, channels.First, channels.End, e0, e1) ||
+				!TryBc7Endpoints(mode, channels, set, e0, e1, quality, opaque, best))
+				break;
+		}
+
+		return best;
+	}
+
+	uint32_t Bc7Subset(const Bc7Mode& mode, uint32_t partition, uint32_t texel)
+	{
+		if(mode.Subsets == 2)
+			return (Bc7Partitions2[partition] >> texel) & 1;
+		if(mode.Subsets == 3)
+			return Bc7Partitions3[partition][texel];
+		return 0;
+	}
+
+	void TryBc7Mode(uint32_t modeIndex, uint32_t partition, const uint8_t pixels[16][4], Quality quality,
+		Bc7Candidate& best)
+	{
+		const Bc7Mode& mode = Bc7Modes[modeIndex];
+
+		TexelSet sets[3];
+		for(uint32_t i = 0; i < 16; ++i)
+			sets[Bc7Subset(mode, partition, i)].Add(pixels[i], i);
+
+		Bc7Candidate candidate;
+		candidate.Mode = modeIndex;
+		candidate.Partition = partition;
+		candidate.Error = 0;
+
+		// Modes 4 and 5: colour takes the primary indices and alpha the secondary.
+		if(mode.SecondaryIndexBits)
+		{
+			const Bc7Channels color = { 0, 3, mode.IndexBits };
+			const Bc7Channels alpha = { 3, 4, mode.SecondaryIndexBits };
+
+			Bc7SubsetFit colorFit = FitBc7Subset(mode, color, sets[0], quality);
+			candidate.Error = colorFit.Error;
+			if(candidate.Error >= best.Error)
+				return;
+
+			Bc7SubsetFit alphaFit = FitBc7Subset(mode, alpha, sets[0], quality);
+			candidate.Error += alphaFit.Error;
+			if(candidate.Error >= best.Error)
+				return;
+
+			for(uint32_t e = 0; e < 2; ++e)
+			{
+				memcpy(candidate.Endpoints[e], colorFit.Endpoints[e], 3*sizeof(uint32_t));
+				candidate.Endpoints[e][3] = alphaFit.Endpoints[e][3];
+			}
+			memcpy(candidate.Indices, colorFit.Indices, sizeof(candidate.Indices));
+			memcpy(candidate.AlphaIndices, alphaFit.Indices, sizeof(candidate.AlphaIndices));
+
+			best = candidate;
+			return;
+		}
+
+		const Bc7Channels channels = { 0, mode.AlphaBits ? 4u : 3u, mode.IndexBits };
+		for(uint32_t s = 0; s < mode.Subsets; ++s)
+		{
+			Bc7SubsetFit fit = FitBc7Subset(mode, channels, sets[s], quality);
+			for(uint32_t e = 0; e < 2; ++e)
+			{
+				memcpy(candidate.Endpoints[2*s + e], fit.Endpoints[e], sizeof(fit.Endpoints[e]));
+				candidate.PBits[2*s + e] = fit.PBits[e];
+			}
+			for(uint32_t i = 0; i < sets[s].Count; ++i)
+				candidate.Indices[sets[s].Positions[i]] = fit.Indices[i];
+
+			candidate.Error += fit.Error;
+			if(candidate.Error >= best.Error)
+				return;
+		}
+
+		best = candidate;
+	}
+
+	// The count two-subset partitions whose subsets lie closest to lines, best first.
+	// A rough axis is enough to rank them.
+	uint32_t RankBc7Partitions(const uint8_t pixels[16][4], uint32_t channels, uint32_t count, uint32_t partitions[64])
+	{
+		Moments texels[16];
+		Moments block;
+		for(uint32_t i = 0; i < 16; ++i)
+		{
+			texels[i].Add(pixels[i]);
+			block.Add(texels[i]);
+		}
+
+		std::pair<float, uint32_t> ranked[64];
+		for(uint32_t p = 0; p < 64; ++p)
+		{
+			Moments subsets[2];
+			for(uint32_t i = 0; i < 16; ++i)
+			{
+				if((Bc7Partitions2[p] >> i) & 1)
+					subsets[1].Add(texels[i]);
+			}
+			subsets[0] = block;
+			subsets[0].Subtract(subsets[1]);
+
+			float mean[4], axis[4];
+			float error = PrincipalAxis(subsets[0], channels, 3, mean, axis) + PrincipalAxis(subsets[1], channels, 3, mean, axis);
+			ranked[p] = std::make_pair(error, p);
+		}
+
+		count = (std::min)(count, 64u);
+		std::partial_sort(ranked, ranked + count, ranked + 64);
+		for(uint32_t i = 0; i < count; ++i)
+			partitions[i] = ranked[i].second;
+
+		return count;
+	}
+
+	class Bc7BitWriter
+	{
+	public:
+		void Write(uint32_t value, uint32_t numBits)
+		{
+			if(numBits == 0)
+				return;
+
+			uint64_t bits = value & ((1ull << numBits) - 1);
+			if(mPos >= 64)
+			{
+				mHigh |= bits << (mPos - 64);
+			}
+			else
+			{
+				mLow |= bits << mPos;
+				if(mPos + numBits > 64)
+					mHigh |= bits >> (64 - mPos);
+			}
+
+			mPos += numBits;
+		}
+
+		void Store(uint8_t* block)const
+		{
+			for(uint32_t i = 0; i < 8; ++i)
+			{
+				block[i] = (uint8_t)(mLow >> (8*i));
+				block[8 + i] = (uint8_t)(mHigh >> (8*i));
+			}
+		}
+
+	private:
+		uint64_t mLow = 0;
+		uint64_t mHigh = 0;
+		uint32_t mPos = 0;
+	};
+
+	// Anchor indices are stored without their top bit, which must be 0.  Swapping
+	// the endpoints' channels [first, end) and reversing the indices that use them
+	// decodes to the same texels, as the weights are symmetric.
+	void FixAnchor(uint32_t endpoints[2][4], uint32_t pBits[2], uint32_t first, uint32_t end,
+		uint32_t indexBits, uint32_t anchor, uint32_t subsetMask, uint8_t indices[16])
+	{
+		const uint32_t maxIndex = (1u << indexBits) - 1;
+		if(indices[anchor] <= maxIndex / 2)
+			return;
+
+		for(uint32_t c = first; c < end; ++c)
+			std::swap(endpoints[0][c], endpoints[1][c]);
+		std::swap(pBits[0], pBits[1]);
+
+		for(uint32_t i = 0; i < 16; ++i)
+		{
+			if((subsetMask >> i) & 1)
+				indices[i] = (uint8_t)(maxIndex - indices[i]);
+		}
+	}
+
+	void WriteBc7Block(Bc7Candidate c, uint8_t* block)
+	{
+		const Bc7Mode& mode = Bc7Modes[c.Mode];
+
+		uint32_t anchors[3] = { 0, 0, 0 };
+		if(mode.Subsets == 2)
+		{
+			anchors[1] = Bc7Anchors2[c.Partition];
+		}
+		else if(mode.Subsets == 3)
+		{
+			anchors[1] = Bc7Anchors3a[c.Partition];
+			anchors[2] = Bc7Anchors3b[c.Partition];
+		}
+
+		if(mode.SecondaryIndexBits)
+		{
+			FixAnchor(c.Endpoints, c.PBits, 0, 3, mode.IndexBits, 0, 0xFFFF, c.Indices);
+			FixAnchor(c.Endpoints, c.PBits, 3, 4, mode.SecondaryIndexBits, 0, 0xFFFF, c.AlphaIndices);
+		}
+		else
+		{
+			for(uint32_t s = 0; s < mode.Subsets; ++s)
+			{
+				uint32_t subsetMask = 0;
+				for(uint32_t i = 0; i < 16; ++i)
+					subsetMask |= (Bc7Subset(mode, c.Partition, i) == s ? 1u : 0u) << i;
+
+				FixAnchor(&c.Endpoints[2*s], &c.PBits[2*s], 0, 4, mode.IndexBits, anchors[s], subsetMask, c.Indices);
+			}
+		}
+
+		// Rotation and index selection, when the mode has them, stay 0.
+		Bc7BitWriter bits;
+		bits.Write(1u << c.Mode, c.Mode + 1);
+		bits.Write(c.Partition, mode.PartitionBits);
+		bits.Write(0, mode.RotationBits + mode.IndexSelectionBits);
+
+		const uint32_t numEndpoints = 2u*mode.Subsets;
+		for(uint32_t ch = 0; ch < 3; ++ch)
+		{
+			for(uint32_t e = 0; e < numEndpoints; ++e)
+				bits.Write(c.Endpoints[e][ch], mode.ColorBits);
+		}
+		for(uint32_t e = 0; e < numEndpoints; ++e)
+			bits.Write(c.Endpoints[e][3], mode.AlphaBits);
+
+		if(mode.EndpointPBits)
+		{
+			for(uint32_t e = 0; e < numEndpoints; ++e)
+				bits.Write(c.PBits[e], 1);
+		}
+		else if(mode.SharedPBits)
+		{
+			for(uint32_t s = 0; s < mode.Subsets; ++s)
+				bits.Write(c.PBits[2*s], 1);
+		}
+
+		for(uint32_t i = 0; i < 16; ++i)
+		{
+			bool isAnchor = i == anchors[0] || (mode.Subsets > 1 && i == anchors[1]) || (mode.Subsets > 2 && i == anchors[2]);
+			bits.Write(c.Indices[i], mode.IndexBits - (isAnchor ? 1 : 0));
+		}
+
+		if(mode.SecondaryIndexBits)
+		{
+			for(uint32_t i = 0; i < 16; ++i)
+				bits.Write(c.AlphaIndices[i], mode.SecondaryIndexBits - (i == 0 ? 1 : 0));
+		}
+
+		bits.Store(block);
+	}
+
+	void EncodeBC7(const uint8_t pixels[16][4], Quality quality, uint8_t* block)
+	{
+		bool opaque = true;
+		for(uint32_t i = 0; i < 16; ++i)
+			opaque = opaque && pixels[i][3] == 255;
+
+		Bc7Candidate best;
+		TryBc7Mode(6, 0, pixels, quality, best);
+		if(!opaque)
+			TryBc7Mode(5, 0, pixels, quality, best);
+
+		if(quality != Quality::Fast && best.Error > 0)
+		{
+			if(!opaque)
+				TryBc7Mode(4, 0, pixels, quality, best);
+
+			// Opaque blocks spend no bits on alpha in modes 1 and 3; mode 7 keeps it.
+			const uint32_t channels = opaque ? 3 : 4;
+			uint32_t partitions[64];
+			uint32_t count = RankBc7Partitions(pixels, channels, quality == Quality::High ? 16 : 4, partitions);
+
+			for(uint32_t i = 0; i < count; ++i)
+			{
+				if(opaque)
+				{
+					TryBc7Mode(1, partitions[i], pixels, quality, best);
+					TryBc7Mode(3, partitions[i], pixels, quality, best);
+				}
+				else
+				{
+					TryBc7Mode(7, partitions[i], pixels, quality, best);
+				}
+			}
+		}
+
+		WriteBc7Block(best, block);
+	}
+
+	void EncodeBlockPixels(BlockType type, const uint8_t pixels[16][4], Quality quality, uint8_t* block)
+	{
+		switch(type)
+		{
+		case BlockType::BC1:
+			EncodeColorBlock(pixels, true, quality, block);
+			break;
+
+		case BlockType::BC3:
+			EncodeChannelBlock(pixels, 3, quality, block);
+			EncodeColorBlock(pixels, false, quality, block + 8);
+			break;
+
+		case BlockType::BC4:
+			EncodeChannelBlock(pixels, 0, quality, block);
+			break;
+
+		case BlockType::BC5:
+			EncodeChannelBlock(pixels, 0, quality, block);
+			EncodeChannelBlock(pixels, 1, quality, block + 8);
+			break;
+
+		case BlockType::BC7:
+			EncodeBC7(pixels, quality, block);
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+bool BcEncoder::IsSupported(DXGI_FORMAT format)
+{
+	return GetBlockType(format) != BlockType::Unsupported;
+}
+
+bool BcEncoder::Encode(DXGI_FORMAT format, const void* pixels, size_t pixelRowPitch,
+	uint32 width, uint32 height, void* blocks, size_t blockRowPitch, Quality quality, unsigned numThreads)
+{
+	BlockType type = GetBlockType(format);
+	if(type == BlockType::Unsupported)
+		return false;
+
+	const size_t blockBytes = BlockBytes(type);
+	const uint32 blocksWide = (width + 3) / 4;
+	const uint32 blocksHigh = (height + 3) / 4;
+
+	// One row of blocks is one work item.
+	ParallelFor(blocksHigh, numThreads, [&](unsigned, size_t by)
+	{
+		const uint8_t* src = static_cast<const uint8_t*>(pixels);
+		uint8_t* dst = static_cast<uint8_t*>(blocks) + by*blockRowPitch;
+
+		for(uint32 bx = 0; bx < blocksWide; ++bx)
+		{
+			uint8_t texels[16][4];
+			for(uint32 y = 0; y < 4; ++y)
+			{
+				const uint8_t* row = src + (std::min)((uint32)by*4 + y, height - 1)*pixelRowPitch;
+				if(bx*4 + 4 <= width)
+				{
+					memcpy(texels[4*y], row + 16*bx, 16);
+					continue;
+				}
+
+				for(uint32 x = 0; x < 4; ++x)
+					memcpy(texels[4*y + x], row + 4*(std::min)(bx*4 + x, width - 1), 4);
+			}
+
+			EncodeBlockPixels(type, texels, quality, dst + bx*blockBytes);
+		}
+	});
+
+	return true;
+}
+
+bool BcEncoder::Encode(DXGI_FORMAT format, const void* pixels, uint32 width, uint32 height,
+	std::vector<uint8>& blocks, Quality quality, unsigned numThreads)
+{
+	BlockType type = GetBlockType(format);
+	if(type == BlockType::Unsupported)
+		return false;
+
+	const size_t blockRowPitch = BlockBytes(type)*((width + 3) / 4);
+	blocks.resize(blockRowPitch*((height + 3) / 4));
+	return Encode(format, pixels, 4*(size_t)width, width, height, blocks.data(), blockRowPitch, quality, numThreads);
+}
+
+bool BcEncoder::EncodeBlock(DXGI_FORMAT format, const uint8 pixels[64], void* block, Quality quality)
+{
+	BlockType type = GetBlockType(format);
+	if(type == BlockType::Unsupported)
+		return false;
+
+	uint8_t texels[16][4];
+	memcpy(texels, pixels, sizeof(texels));
+	EncodeBlockPixels(type, texels, quality, static_cast<uint8_t*>(block));
+	return true;
+}
@@ -0,0 +1,63 @@
+//***************************************************************************************
+// BcEncoder.h
+//
+// CPU encoder for the block-compressed formats the cooker writes: BC1 (opaque or
+// 1-bit alpha colour), BC3 (colour + smooth alpha), BC4/BC5 (one or two channels,
+// e.g. normal map XY) and BC7 (high quality colour with or without alpha).
+//
+// Rows of blocks are encoded in parallel; blocks are independent, so the output
+// doesn't depend on the thread count.  Quality trades time for error:
+//   -Fast:   one endpoint fit per block; BC7 uses mode 6 only.
+//   -Normal: least-squares endpoint refinement; BC7 also tries two-subset modes
+//            on the most promising partitions.
+//   -High:   more refinement and a wider search (BC1 three-colour blocks, BC3/BC4
+//            endpoint search, every BC7 p-bit combination and more partitions).
+// Error is measured on the stored values, so sRGB formats take sRGB input as is.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <dxgiformat.h>
+
+class BcEncoder
+{
+public:
+	typedef std::uint8_t uint8;
+	typedef std::uint32_t uint32;
+
+	enum class Quality
+	{
+		Fast,
+		Normal,
+		High
+	};
+
+	static bool IsSupported(DXGI_FORMAT format);
+
+	///<summary>
+	/// Encodes a width x height R8G8B8A8 image.  pixels holds pixelRowPitch bytes
+	/// per row; blocks receives blockRowPitch bytes per row of 4x4 blocks.  Blocks on
+	/// the right and bottom edges of sizes that aren't multiples of 4 repeat the last
+	/// column and row.  Uses up to numThreads threads (0 = every hardware thread).
+	/// Returns false if format isn't supported.
+	///</summary>
+	static bool Encode(DXGI_FORMAT format, const void* pixels, size_t pixelRowPitch,
+		uint32 width, uint32 height, void* blocks, size_t blockRowPitch,
+		Quality quality = Quality::Normal, unsigned numThreads = 0);
+
+	///<summary>
+	/// Encodes a tightly packed image into tightly packed blocks, the layout
+	/// DdsWriter and DdsFile use for one mip.
+	///</summary>
+	static bool Encode(DXGI_FORMAT format, const void* pixels, uint32 width, uint32 height,
+		std::vector<uint8>& blocks, Quality quality = Quality::Normal, unsigned numThreads = 0);
+
+	///<summary>
+	/// Encodes 16 pixels, row by row, into one block of 8 or 16 bytes.
+	///</summary>
+	static bool EncodeBlock(DXGI_FORMAT format, const uint8 pixels[64], void* block,
+		Quality quality = Quality::Normal);
+};
@@ -0,0 +1,736 @@
+//***************************************************************************************
+// BoundingVolumes.cpp
+//***************************************************************************************
+
+#include "BoundingVolumes.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	// Points transposed to SoA at a time, and points per ParallelFor item.  The chunk
+	// size fixes how partial results are combined, so it must not depend on the
+	// thread count.
+	const size_t BlockSize = 256;
+	const size_t ChunkSize = 64 * 1024;
+
+	// Shrink-and-regrow passes after the first Ritter sphere.
+	const int SphereRefinePasses = 4;
+
+	// Directions whose extremal points seed the sphere: the axes, the cube
+	// diagonals and the edge diagonals.
+	const int NumSphereDirections = 13;
+	const XMFLOAT3 SphereDirections[NumSphereDirections] =
+	{
+		XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f),
+		XMFLOAT3(1.0f, 1.0f, 1.0f), XMFLOAT3(1.0f, 1.0f, -1.0f), XMFLOAT3(1.0f, -1.0f, 1.0f), XMFLOAT3(1.0f, -1.0f, -1.0f),
+		XMFLOAT3(1.0f, 1.0f, 0.0f), XMFLOAT3(1.0f, -1.0f, 0.0f), XMFLOAT3(1.0f, 0.0f, 1.0f),
+		XMFLOAT3(1.0f, 0.0f, -1.0f), XMFLOAT3(0.0f, 1.0f, 1.0f), XMFLOAT3(0.0f, 1.0f, -1.0f)
+	};
+
+	// Either a strided AoS stream or SoA arrays.
+	struct PointSource
+	{
+		const XMFLOAT3* Positions = nullptr;
+		size_t Stride = 0;
+		PointStreamSoA Soa;
+		size_t Count = 0;
+
+		XMFLOAT3 Get(size_t i)const
+		{
+			if(Positions == nullptr)
+				return XMFLOAT3(Soa.X[i], Soa.Y[i], Soa.Z[i]);
+
+			return *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const char*>(Positions) + i*Stride);
+		}
+	};
+
+	PointSource MakeSource(const XMFLOAT3* positions, size_t stride, size_t count)
+	{
+		PointSource src;
+		src.Positions = positions;
+		src.Stride = stride;
+		src.Count = positions != nullptr ? count : 0;
+		return src;
+	}
+
+	PointSource MakeSource(const PointStreamSoA& points)
+	{
+		PointSource src;
+		src.Soa = points;
+		src.Count = points.Count;
+		return src;
+	}
+
+	// Scratch for transposing one block of AoS points.
+	struct BlockScratch
+	{
+		float X[BlockSize];
+		float Y[BlockSize];
+		float Z[BlockSize];
+	};
+
+	// Calls func(first, x, y, z, n) for the blocks of at most BlockSize points in
+	// [first, last), in order.  x, y and z point at the SoA coordinates of the block.
+	template<typename Func>
+	void ForEachBlock(const PointSource& src, size_t first, size_t last, const Func& func)
+	{
+		BlockScratch scratch;
+		for(size_t b = first; b < last; b += BlockSize)
+		{
+			size_t n = std::min(BlockSize, last - b);
+			if(src.Positions == nullptr)
+			{
+				func(b, src.Soa.X + b, src.Soa.Y + b, src.Soa.Z + b, n);
+				continue;
+			}
+
+			const char* p = reinterpret_cast<const char*>(src.Positions) + b*src.Stride;
+			for(size_t i = 0; i < n; ++i, p += src.Stride)
+			{
+				const XMFLOAT3& v = *reinterpret_cast<const XMFLOAT3*>(p);
+				scratch.X[i] = v.x;
+				scratch.Y[i] = v.y;
+				scratch.Z[i] = v.z;
+			}
+
+			func(b, scratch.X, scratch.Y, scratch.Z, n);
+		}
+	}
+
+	size_t ChunkCount(const PointSource& src)
+	{
+		return (src.Count + ChunkSize - 1) / ChunkSize;
+	}
+
+	// Calls func(chunk, first, last) for each chunk of ChunkSize points.
+	template<typename Func>
+	void ForEachChunk(const PointSource& src, unsigned numThreads, const Func& func)
+	{
+		ParallelFor(ChunkCount(src), numThreads, [&](unsigned, size_t chunk)
+		{
+			size_t first = chunk * ChunkSize;
+			func(chunk, first, std::min(first + ChunkSize, src.Count));
+		});
+	}
+
+	// Four consecutive values starting at p[i]; lanes past n repeat p[i], which
+	// never changes a min, max or extreme point.
+	XMVECTOR LoadLanes(const float* p, size_t i, size_t n)
+	{
+		if(i + 4 <= n)
+			return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(p + i));
+
+		float v[4];
+		for(size_t k = 0; k < 4; ++k)
+			v[k] = p[i + k < n ? i + k : i];
+		return XMVectorSet(v[0], v[1], v[2], v[3]);
+	}
+
+	float HorizontalMin(FXMVECTOR v)
+	{
+		XMFLOAT4 f;
+		XMStoreFloat4(&f, v);
+		return std::min(std::min(f.x, f.y), std::min(f.z, f.w));
+	}
+
+	float HorizontalMax(FXMVECTOR v)
+	{
+		XMFLOAT4 f;
+		XMStoreFloat4(&f, v);
+		return std::max(std::max(f.x, f.y), std::max(f.z, f.w));
+	}
+
+	struct MinMax
+	{
+		XMFLOAT3 Min = XMFLOAT3(+FLT_MAX, +FLT_MAX, +FLT_MAX);
+		XMFLOAT3 Max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	};
+
+	MinMax FindMinMax(const PointSource& src, unsigned numThreads)
+	{
+		std::vector<MinMax> chunkResults(ChunkCount(src));
+		ForEachChunk(src, numThreads, [&](size_t chunk, size_t first, size_t last)
+		{
+			XMVECTOR minX = XMVectorReplicate(+FLT_MAX), maxX = XMVectorReplicate(-FLT_MAX);
+			XMVECTOR minY = minX, maxY = maxX;
+			XMVECTOR minZ = minX, maxZ = maxX;
+
+			ForEachBlock(src, first, last, [&](size_t, const float* x, const float* y, const float* z, size_t n)
+			{
+				for(size_t i = 0; i < n; i += 4)
+				{
+					XMVECTOR X = LoadLanes(x, i, n);
+					XMVECTOR Y = LoadLanes(y, i, n);
+					XMVECTOR Z = LoadLanes(z, i, n);
+					minX = XMVectorMin(minX, X); maxX = XMVectorMax(maxX, X);
+					minY = XMVectorMin(minY, Y); maxY = XMVectorMax(maxY, Y);
+					minZ = XMVectorMin(minZ, Z); maxZ = XMVectorMax(maxZ, Z);
+				}
+			});
+
+			MinMax& r = chunkResults[chunk];
+			r.Min = XMFLOAT3(HorizontalMin(minX), HorizontalMin(minY), HorizontalMin(minZ));
+			r.Max = XMFLOAT3(HorizontalMax(maxX), HorizontalMax(maxY), HorizontalMax(maxZ));
+		});
+
+		MinMax result;
+		for(const MinMax& r : chunkResults)
+		{
+			XMStoreFloat3(&result.Min, XMVectorMin(XMLoadFloat3(&result.Min), XMLoadFloat3(&r.Min)));
+			XMStoreFloat3(&result.Max, XMVectorMax(XMLoadFloat3(&result.Max), XMLoadFloat3(&r.Max)));
+		}
+
+		return result;
+	}
+
+	// Smallest and largest projection of the points on a direction, and the first
+	// points that reach them.
+	struct Extreme
+	{
+		float Min = +FLT_MAX;
+		float Max = -FLT_MAX;
+		size_t MinIndex = 0;
+		size_t MaxIndex = 0;
+	};
+
+	void FindExtremes(const PointSource& src, const XMFLOAT3* dirs, int numDirs, unsigned numThreads, Extreme* out)
+	{
+		std::vector<Extreme> chunkResults(ChunkCount(src) * numDirs);
+		ForEachChunk(src, numThreads, [&](size_t chunk, size_t first, size_t last)
+		{
+			Extreme* ext = &chunkResults[chunk * numDirs];
+
+			ForEachBlock(src, first, last, [&](size_t base, const float* x, const float* y, const float* z, size_t n)
+			{
+				for(int d = 0; d < numDirs; ++d)
+				{
+					XMVECTOR dx = XMVectorReplicate(dirs[d].x);
+					XMVECTOR dy = XMVectorReplicate(dirs[d].y);
+					XMVECTOR dz = XMVectorReplicate(dirs[d].z);
+
+					auto project = [&](size_t i)
+					{
+						XMVECTOR p = XMVectorMultiply(LoadLanes(x, i, n), dx);
+						p = XMVectorMultiplyAdd(LoadLanes(y, i, n), dy, p);
+						return XMVectorMultiplyAdd(LoadLanes(z, i, n), dz, p);
+					};
+
+					XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+					XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+					for(size_t i = 0; i < n; i += 4)
+					{
+						XMVECTOR p = project(i);
+						vMin = XMVectorMin(vMin, p);
+						vMax = XMVectorMax(vMax, p);
+					}
+
+					// Only a block that improves on the chunk so far is searched for
+					// the point itself, with the same arithmetic.
+					bool newMin = HorizontalMin(vMin) < ext[d].Min;
+					bool newMax = HorizontalMax(vMax) > ext[d].Max;
+					if(!newMin && !newMax)
+						continue;
+
+					for(size_t i = 0; i < n; i += 4)
+					{
+						XMFLOAT4 p;
+						XMStoreFloat4(&p, project(i));
+						const float lanes[4] = { p.x, p.y, p.z, p.w };
+						for(size_t k = 0; k < 4 && i + k < n; ++k)
+						{
+							if(newMin && lanes[k] < ext[d].Min)
+							{
+								ext[d].Min = lanes[k];
+								ext[d].MinIndex = base + i + k;
+							}
+							if(newMax && lanes[k] > ext[d].Max)
+							{
+								ext[d].Max = lanes[k];
+								ext[d].MaxIndex = base + i + k;
+							}
+						}
+					}
+				}
+			});
+		});
+
+		for(int d = 0; d < numDirs; ++d)
+			out[d] = Extreme();
+
+		for(size_t chunk = 0; chunk < ChunkCount(src); ++chunk)
+		{
+			for(int d = 0; d < numDirs; ++d)
+			{
+				const Extreme& e = chunkResults[chunk * numDirs + d];
+				if(e.Min < out[d].Min)
+				{
+					out[d].Min = e.Min;
+					out[d].MinIndex = e.MinIndex;
+				}
+				if(e.Max > out[d].Max)
+				{
+					out[d].Max = e.Max;
+					out[d].MaxIndex = e.MaxIndex;
+				}
+			}
+		}
+	}
+
+	struct Sphere
+	{
+		XMFLOAT3 Center;
+		float Radius;
+	};
+
+	// Ritter's update: the smallest sphere containing s and p.
+	void GrowSphere(Sphere& s, const XMFLOAT3& p)
+	{
+		XMVECTOR c = XMLoadFloat3(&s.Center);
+		XMVECTOR d = XMLoadFloat3(&p) - c;
+		float distSq = XMVectorGetX(XMVector3LengthSq(d));
+		if(distSq <= s.Radius*s.Radius)
+			return;
+
+		float dist = sqrtf(distSq);
+		float newRadius = 0.5f*(s.Radius + dist);
+		XMStoreFloat3(&s.Center, c + d*((newRadius - s.Radius) / dist));
+		s.Radius = newRadius;
+	}
+
+	// Grows s over the points in [first, last).  Four points are tested at once;
+	// only groups with a point outside go through the scalar update.
+	void GrowSphere(Sphere& s, const PointSource& src, size_t first, size_t last)
+	{
+		ForEachBlock(src, first, last, [&](size_t, const float* x, const float* y, const float* z, size_t n)
+		{
+			XMVECTOR cx = XMVectorReplicate(s.Center.x);
+			XMVECTOR cy = XMVectorReplicate(s.Center.y);
+			XMVECTOR cz = XMVectorReplicate(s.Center.z);
+			XMVECTOR r2 = XMVectorReplicate(s.Radius*s.Radius);
+
+			for(size_t i = 0; i < n; i += 4)
+			{
+				XMVECTOR dx = LoadLanes(x, i, n) - cx;
+				XMVECTOR dy = LoadLanes(y, i, n) - cy;
+				XMVECTOR dz = LoadLanes(z, i, n) - cz;
+				XMVECTOR d2 = XMVectorMultiplyAdd(dz, dz, XMVectorMultiplyAdd(dy, dy, dx*dx));
+
+				if(!XMVector4NotEqualInt(XMVectorGreater(d2, r2), XMVectorZero()))
+					continue;
+
+				for(size_t k = i; k < i + 4 && k < n; ++k)
+					GrowSphere(s, XMFLOAT3(x[k], y[k], z[k]));
+
+				cx = XMVectorReplicate(s.Center.x);
+				cy = XMVectorReplicate(s.Center.y);
+				cz = XMVectorReplicate(s.Center.z);
+				r2 = XMVectorReplicate(s.Radius*s.Radius);
+			}
+		});
+	}
+
+	// Largest squared distance from c to the points.
+	float MaxDistanceSq(const PointSource& src, const XMFLOAT3& c, unsigned numThreads)
+	{
+		std::vector<float> chunkResults(ChunkCount(src), 0.0f);
+		ForEachChunk(src, numThreads, [&](size_t chunk, size_t first, size_t last)
+		{
+			XMVECTOR cx = XMVectorReplicate(c.x);
+			XMVECTOR cy = XMVectorReplicate(c.y);
+			XMVECTOR cz = XMVectorReplicate(c.z);
+			XMVECTOR maxD2 = XMVectorZero();
+
+			ForEachBlock(src, first, last, [&](size_t, const float* x, const float* y, const float* z, size_t n)
+			{
+				for(size_t i = 0; i < n; i += 4)
+				{
+					XMVECTOR dx = LoadLanes(x, i, n) - cx;
+					XMVECTOR dy = LoadLanes(y, i, n) - cy;
+					XMVECTOR dz = LoadLanes(z, i, n) - cz;
+					maxD2 = XMVectorMax(maxD2, XMVectorMultiplyAdd(dz, dz, XMVectorMultiplyAdd(dy, dy, dx*dx)));
+				}
+			});
+
+			chunkResults[chunk] = HorizontalMax(maxD2);
+		});
+
+		float result = 0.0f;
+		for(float d2 : chunkResults)
+			result = std::max(result, d2);
+		return result;
+	}
+
+	// Sums for the mean and covariance of the points.
+	struct Moments
+	{
+		double N = 0.0;
+		double S[3] = { 0.0, 0.0, 0.0 };
+		double Sxx = 0.0, Sxy = 0.0, Sxz = 0.0, Syy = 0.0, Syz = 0.0, Szz = 0.0;
+	};
+
+	Moments ComputeMoments(const PointSource& src, unsigned numThreads)
+	{
+		std::vector<Moments> chunkResults(ChunkCount(src));
+		ForEachChunk(src, numThreads, [&](size_t chunk, size_t first, size_t last)
+		{
+			Moments& m = chunkResults[chunk];
+			ForEachBlock(src, first, last, [&](size_t, const float* x, const float* y, const float* z, size_t n)
+			{
+				// Float sums over one block, double across blocks.
+				XMVECTOR sx = XMVectorZero(), sy = sx, sz = sx;
+				XMVECTOR sxx = sx, sxy = sx, sxz = sx, syy = sx, syz = sx, szz = sx;
+				for(size_t i = 0; i < n; i += 4)
+				{
+					XMVECTOR mask = XMVectorSet(i+0 < n ? 1.0f : 0.0f, i+1 < n ? 1.0f : 0.0f, i+2 < n ? 1.0f : 0.0f, i+3 < n ? 1.0f : 0.0f);
+					XMVECTOR X = LoadLanes(x, i, n) * mask;
+					XMVECTOR Y = LoadLanes(y, i, n) * mask;
+					XMVECTOR Z = LoadLanes(z, i, n) * mask;
+					sx += X; sy += Y; sz += Z;
+					sxx = XMVectorMultiplyAdd(X, X, sxx);
+					sxy = XMVectorMultiplyAdd(X, Y, sxy);
+					sxz = XMVectorMultiplyAdd(X, Z, sxz);
+					syy = XMVectorMultiplyAdd(Y, Y, syy);
+					syz = XMVectorMultiplyAdd(Y, Z, syz);
+					szz = XMVectorMultiplyAdd(Z, Z, szz);
+				}
+
+				auto sum = [](FXMVECTOR v)
+				{
+					XMFLOAT4 f;
+					XMStoreFloat4(&f, v);
+					return (double)f.x + f.y + f.z + f.w;
+				};
+
+				m.N += (double)n;
+				m.S[0] += sum(sx); m.S[1] += sum(sy); m.S[2] += sum(sz);
+				m.Sxx += sum(sxx); m.Sxy += sum(sxy); m.Sxz += sum(sxz);
+				m.Syy += sum(syy); m.Syz += sum(syz); m.Szz += sum(szz);
+			});
+		});
+
+		Moments result;
+		for(const Moments& m : chunkResults)
+		{
+			result.N += m.N;
+			for(int k = 0; k < 3; ++k)
+				result.S[k] += m.S[k];
+			result.Sxx += m.Sxx; result.Sxy += m.Sxy; result.Sxz += m.Sxz;
+			result.Syy += m.Syy; result.Syz += m.Syz; result.Szz += m.Szz;
+		}
+
+		return result;
+	}
+
+	// Eigenvectors of a symmetric 3x3 matrix by cyclic Jacobi rotations; returned
+	// as the columns of v.
+	void SymmetricEigenvectors(double a[3][3], double v[3][3])
+	{
+		for(int i = 0; i < 3; ++i)
+			for(int j = 0; j < 3; ++j)
+				v[i][j] = i == j ? 1.0 : 0.0;
+
+		for(int sweep = 0; sweep < 50; ++sweep)
+		{
+			double off = a[0][1]*a[0][1] + a[0][2]*a[0][2] + a[1][2]*a[1][2];
+			if(off < 1.0e-30)
+				break;
+
+			for(int p = 0; p < 2; ++p)
+			{
+				for(int q = p + 1; q < 3; ++q)
+				{
+					if(fabs(a[p][q]) < 1.0e-30)
+						continue;
+
+					double theta = (a[q][q] - a[p][p]) / (2.0*a[p][q]);
+					double t = (theta >= 0.0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta*theta + 1.0));
+					double c = 1.0 / sqrt(t*t + 1.0);
+					double s = t*c;
+
+					for(int k = 0; k < 3; ++k)
+					{
+						double akp = a[k][p], akq = a[k][q];
+						a[k][p] = c*akp - s*akq;
+						a[k][q] = s*akp + c*akq;
+					}
+					for(int k = 0; k < 3; ++k)
+					{
+						double apk = a[p][k], aqk = a[q][k];
+						a[p][k] = c*apk - s*aqk;
+						a[q][k] = s*apk + c*aqk;
+					}
+					for(int k = 0; k < 3; ++k)
+					{
+						double vkp = v[k][p], vkq = v[k][q];
+						v[k][p] = c*vkp - s*vkq;
+						v[k][q] = s*vkp + c*vkq;
+					}
+				}
+			}
+		}
+	}
+
+	BoundingSphere SphereOfPoints(const PointSource& src, unsigned numThreads)
+	{
+		BoundingSphere result;
+		result.Radius = 0.0f;
+		if(src.Count == 0)
+			return result;
+
+		//
+		// Start from the two extremal points that are farthest apart and include
+		// the other extremal points.
+		//
+
+		Extreme ext[NumSphereDirections];
+		FindExtremes(src, SphereDirections, NumSphereDirections, numThreads, ext);
+
+		int seed = 0;
+		float seedDistSq = -1.0f;
+		for(int d = 0; d < NumSphereDirections; ++d)
+		{
+			XMFLOAT3 a = src.Get(ext[d].MinIndex);
+			XMFLOAT3 b = src.Get(ext[d].MaxIndex);
+			float distSq = XMVectorGetX(XMVector3LengthSq(XMLoadFloat3(&b) - XMLoadFloat3(&a)));
+			if(distSq > seedDistSq)
+			{
+				seed = d;
+				seedDistSq = distSq;
+			}
+		}
+
+		XMFLOAT3 a = src.Get(ext[seed].MinIndex);
+		XMFLOAT3 b = src.Get(ext[seed].MaxIndex);
+
+		Sphere s;
+		XMStoreFloat3(&s.Center, 0.5f*(XMLoadFloat3(&a) + XMLoadFloat3(&b)));
+		s.Radius = 0.5f*sqrtf(seedDistSq);
+		for(int d = 0; d < NumSphereDirections; ++d)
+		{
+			GrowSphere(s, src.Get(ext[d].MinIndex));
+			GrowSphere(s, src.Get(ext[d].MaxIndex));
+		}
+
+		GrowSphere(s, src, 0, src.Count);
+
+		//
+		// Shrink the sphere a little and grow it back over the points, starting at a
+		// different point each pass; keep the smallest.
+		//
+
+		Sphere best = s;
+		for(int pass = 0; pass < SphereRefinePasses; ++pass)
+		{
+			s.Radius *= 0.95f;
+
+			size_t start = src.Count * (pass + 1) / (SphereRefinePasses + 1);
+			GrowSphere(s, src, start, src.Count);
+			GrowSphere(s, src, 0, start);
+
+			if(s.Radius < best.Radius)
+				best = s;
+		}
+
+		// The incremental updates round; the final radius is measured exactly.
+		result.Center = best.Center;
+		result.Radius = nextafterf(sqrtf(MaxDistanceSq(src, best.Center, numThreads)), FLT_MAX);
+		return result;
+	}
+
+	BoundingBox ToBoundingBox(const MinMax& mm)
+	{
+		BoundingBox box;
+		XMVECTOR vMin = XMLoadFloat3(&mm.Min);
+		XMVECTOR vMax = XMLoadFloat3(&mm.Max);
+		XMStoreFloat3(&box.Center, 0.5f*(vMin + vMax));
+		XMStoreFloat3(&box.Extents, 0.5f*(vMax - vMin));
+		return box;
+	}
+
+	BoundingBox AabbOfPoints(const PointSource& src, unsigned numThreads)
+	{
+		if(src.Count == 0)
+		{
+			BoundingBox box;
+			box.Extents = XMFLOAT3(0.0f, 0.0f, 0.0f);
+			return box;
+		}
+
+		return ToBoundingBox(FindMinMax(src, numThreads));
+	}
+
+	BoundingOrientedBox ObbOfPoints(const PointSource& src, unsigned numThreads)
+	{
+		BoundingOrientedBox obb;
+		BoundingBox aabb = AabbOfPoints(src, numThreads);
+		obb.Center = aabb.Center;
+		obb.Extents = aabb.Extents;
+		obb.Orientation = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+		if(src.Count < 3)
+			return obb;
+
+		//
+		// Principal axes of the covariance.
+		//
+
+		Moments m = ComputeMoments(src, numThreads);
+		double mean[3] = { m.S[0] / m.N, m.S[1] / m.N, m.S[2] / m.N };
+		double cov[3][3];
+		cov[0][0] = m.Sxx / m.N - mean[0]*mean[0];
+		cov[0][1] = cov[1][0] = m.Sxy / m.N - mean[0]*mean[1];
+		cov[0][2] = cov[2][0] = m.Sxz / m.N - mean[0]*mean[2];
+		cov[1][1] = m.Syy / m.N - mean[1]*mean[1];
+		cov[1][2] = cov[2][1] = m.Syz / m.N - mean[1]*mean[2];
+		cov[2][2] = m.Szz / m.N - mean[2]*mean[2];
+
+		double v[3][3];
+		SymmetricEigenvectors(cov, v);
+
+		XMVECTOR axis0 = XMVector3Normalize(XMVectorSet((float)v[0][0], (float)v[1][0], (float)v[2][0], 0.0f));
+		XMVECTOR axis1 = XMVectorSet((float)v[0][1], (float)v[1][1], (float)v[2][1], 0.0f);
+		axis1 = XMVector3Normalize(axis1 - axis0*XMVector3Dot(axis0, axis1));
+		XMVECTOR axis2 = XMVector3Cross(axis0, axis1);
+
+		XMFLOAT3 axes[3];
+		XMStoreFloat3(&axes[0], axis0);
+		XMStoreFloat3(&axes[1], axis1);
+		XMStoreFloat3(&axes[2], axis2);
+
+		Extreme ext[3];
+		FindExtremes(src, axes, 3, numThreads, ext);
+
+		float extents[3];
+		float center[3];
+		for(int k = 0; k < 3; ++k)
+		{
+			extents[k] = 0.5f*(ext[k].Max - ext[k].Min);
+			center[k] = 0.5f*(ext[k].Max + ext[k].Min);
+		}
+
+		float obbVolume = extents[0]*extents[1]*extents[2];
+		float aabbVolume = aabb.Extents.x*aabb.Extents.y*aabb.Extents.z;
+		if(obbVolume >= aabbVolume)
+			return obb;
+
+		// Rows of the rotation are the box axes: (1,0,0) in box space maps to axes[0].
+		XMMATRIX R(axis0, axis1, axis2, XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f));
+		XMStoreFloat4(&obb.Orientation, XMQuaternionNormalize(XMQuaternionRotationMatrix(R)));
+		XMStoreFloat3(&obb.Center, center[0]*axis0 + center[1]*axis1 + center[2]*axis2);
+		obb.Extents = XMFLOAT3(extents[0], extents[1], extents[2]);
+		return obb;
+	}
+}
+
+PointStreamSoA PointsSoA::GetStream()const
+{
+	PointStreamSoA stream;
+	stream.X = X.data();
+	stream.Y = Y.data();
+	stream.Z = Z.data();
+	stream.Count = X.size();
+	return stream;
+}
+
+PointsSoA BoundingVolumes::ToSoA(const XMFLOAT3* positions, size_t stride, size_t count)
+{
+	PointsSoA points;
+	points.X.resize(count);
+	points.Y.resize(count);
+	points.Z.resize(count);
+
+	const char* p = reinterpret_cast<const char*>(positions);
+	for(size_t i = 0; i < count; ++i, p += stride)
+	{
+		const XMFLOAT3& v = *reinterpret_cast<const XMFLOAT3*>(p);
+		points.X[i] = v.x;
+		points.Y[i] = v.y;
+		points.Z[i] = v.z;
+	}
+
+	return points;
+}
+
+BoundingBox BoundingVolumes::ComputeAabb(const XMFLOAT3* positions, size_t stride, size_t count, unsigned numThreads)
+{
+	return AabbOfPoints(MakeSource(positions, stride, count), numThreads);
+}
+
+BoundingBox BoundingVolumes::ComputeAabb(const PointStreamSoA& points, unsigned numThreads)
+{
+	return AabbOfPoints(MakeSource(points), numThreads);
+}
+
+BoundingSphere BoundingVolumes::ComputeSphere(const XMFLOAT3* positions, size_t stride, size_t count, unsigned numThreads)
+{
+	return SphereOfPoints(MakeSource(positions, stride, count), numThreads);
+}
+
+BoundingSphere BoundingVolumes::ComputeSphere(const PointStreamSoA& points, unsigned numThreads)
+{
+	return SphereOfPoints(MakeSource(points), numThreads);
+}
+
+BoundingOrientedBox BoundingVolumes::ComputeObb(const XMFLOAT3* positions, size_t stride, size_t count, unsigned numThreads)
+{
+	return ObbOfPoints(MakeSource(positions, stride, count), numThreads);
+}
+
+BoundingOrientedBox BoundingVolumes::ComputeObb(const PointStreamSoA& points, unsigned numThreads)
+{
+	return ObbOfPoints(MakeSource(points), numThreads);
+}
+
+BoundingBox BoundingVolumes::Merge(const BoundingBox* boxes, size_t count)
+{
+	if(count == 0)
+	{
+		BoundingBox box;
+		box.Extents = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		return box;
+	}
+
+	XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+	XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+	for(size_t i = 0; i < count; ++i)
+	{
+		XMVECTOR c = XMLoadFloat3(&boxes[i].Center);
+		XMVECTOR e = XMLoadFloat3(&boxes[i].Extents);
+		vMin = XMVectorMin(vMin, c - e);
+		vMax = XMVectorMax(vMax, c + e);
+	}
+
+	MinMax mm;
+	XMStoreFloat3(&mm.Min, vMin);
+	XMStoreFloat3(&mm.Max, vMax);
+	return ToBoundingBox(mm);
+}
+
+BoundingSphere BoundingVolumes::Merge(const BoundingSphere* spheres, size_t count)
+{
+	if(count == 0)
+	{
+		BoundingSphere sphere;
+		sphere.Radius = 0.0f;
+		return sphere;
+	}
+
+	BoundingSphere result = spheres[0];
+	for(size_t i = 1; i < count; ++i)
+		BoundingSphere::CreateMerged(result, result, spheres[i]);
+
+	return result;
+}
+
+BoundingSphere BoundingVolumes::EnclosingSphere(const BoundingBox* boxes, size_t count)
+{
+	std::vector<XMFLOAT3> corners(count * BoundingBox::CORNER_COUNT);
+	for(size_t i = 0; i < count; ++i)
+		boxes[i].GetCorners(&corners[i * BoundingBox::CORNER_COUNT]);
+
+	return ComputeSphere(corners.data(), sizeof(XMFLOAT3), corners.size());
+}
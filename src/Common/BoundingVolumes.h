@@ -0,0 +1,84 @@
+//***************************************************************************************
+// BoundingVolumes.h
+//
+// Bounding volumes for point sets of any size, built on DirectXCollision's types:
+//   -ComputeAabb: axis-aligned box.
+//   -ComputeSphere: tight sphere.  Extremal points along 13 directions seed it,
+//    Ritter's algorithm grows it over every point, and a few shrink-and-regrow
+//    passes (Ericson, "Real-Time Collision Detection" 4.3.5) tighten it.  Usually
+//    within a few percent of the minimum sphere, where Ritter alone is often 10-20%
+//    off.
+//   -ComputeObb: oriented box on the principal axes of the points, or the AABB
+//    if that is smaller.
+//   -Merge and EnclosingSphere: bounds of a submesh set or a whole scene.
+//
+// The passes over the points work four points at a time on x, y and z arrays
+// (SoA).  Points given as a strided vertex stream are transposed into SoA blocks
+// on the fly.  Large inputs are split into fixed-size chunks for ParallelFor and
+// the chunk results combined in order, so the result does not depend on the
+// thread count.
+//***************************************************************************************
+
+#pragma once
+
+#include <vector>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+// Points stored as separate x, y and z arrays.
+struct PointStreamSoA
+{
+	const float* X = nullptr;
+	const float* Y = nullptr;
+	const float* Z = nullptr;
+	size_t Count = 0;
+};
+
+struct PointsSoA
+{
+	std::vector<float> X;
+	std::vector<float> Y;
+	std::vector<float> Z;
+
+	PointStreamSoA GetStream()const;
+};
+
+class BoundingVolumes
+{
+public:
+
+	///<summary>
+	/// Copies count positions (stride bytes apart) to SoA arrays.
+	///</summary>
+	static PointsSoA ToSoA(const DirectX::XMFLOAT3* positions, size_t stride, size_t count);
+
+	///<summary>
+	/// Bounds of count positions stride bytes apart (e.g. the Pos member of a
+	/// vertex array), or of SoA points.  numThreads = 0 uses every hardware thread;
+	/// the default keeps small meshes on the calling thread.
+	///</summary>
+	static DirectX::BoundingBox ComputeAabb(const DirectX::XMFLOAT3* positions, size_t stride, size_t count, unsigned numThreads = 1);
+	static DirectX::BoundingBox ComputeAabb(const PointStreamSoA& points, unsigned numThreads = 1);
+
+	static DirectX::BoundingSphere ComputeSphere(const DirectX::XMFLOAT3* positions, size_t stride, size_t count, unsigned numThreads = 1);
+	static DirectX::BoundingSphere ComputeSphere(const PointStreamSoA& points, unsigned numThreads = 1);
+
+	static DirectX::BoundingOrientedBox ComputeObb(const DirectX::XMFLOAT3* positions, size_t stride, size_t count, unsigned numThreads = 1);
+	static DirectX::BoundingOrientedBox ComputeObb(const PointStreamSoA& points, unsigned numThreads = 1);
+
+	///<summary>
+	/// Box around all the boxes, e.g. the submeshes of a MeshGeometry.
+	///</summary>
+	static DirectX::BoundingBox Merge(const DirectX::BoundingBox* boxes, size_t count);
+
+	///<summary>
+	/// Sphere around all the spheres.
+	///</summary>
+	static DirectX::BoundingSphere Merge(const DirectX::BoundingSphere* spheres, size_t count);
+
+	///<summary>
+	/// Tight sphere around the corners of all the boxes.  For a scene, transform
+	/// each object's local box by its world matrix first.
+	///</summary>
+	static DirectX::BoundingSphere EnclosingSphere(const DirectX::BoundingBox* boxes, size_t count);
+};
@@ -25,6 +25,7 @@
 #include <wrl.h>
 #include <d3d11_1.h>
 #include "d3dx12.h"
+#include "DdsFile.h"
 
 #pragma warning(push)
 #pragma warning(disable : 4005)
@@ -46,14 +47,8 @@
 
 namespace DirectX
 {
-    enum DDS_ALPHA_MODE
-    {
-        DDS_ALPHA_MODE_UNKNOWN       = 0,
-        DDS_ALPHA_MODE_STRAIGHT      = 1,
-        DDS_ALPHA_MODE_PREMULTIPLIED = 2,
-        DDS_ALPHA_MODE_OPAQUE        = 3,
-        DDS_ALPHA_MODE_CUSTOM        = 4,
-    };
+	// The HRESULT the loaders return for a DdsFile::Open or Parse failure.
+	HRESULT HResultFromDdsStatus(_In_ DdsStatus status);
 
     // Standard version
     HRESULT CreateDDSTextureFromMemory( _In_ ID3D11Device* d3dDevice,
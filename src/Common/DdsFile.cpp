@@ -0,0 +1,839 @@
+//***************************************************************************************
+// DdsFile.cpp
+//
+// BitsPerPixel, GetSurfaceInfo, GetDXGIFormat and MakeSRGB are moved unchanged from
+// DDSTextureLoader.cpp (Copyright (c) Microsoft Corporation, see that file).
+//***************************************************************************************
+
+#include "DdsFile.h"
+#include <algorithm>
+#include <cstring>
+
+#ifndef MAKEFOURCC
+    #define MAKEFOURCC(ch0, ch1, ch2, ch3)                              \
+                ((uint32_t)(uint8_t)(ch0) | ((uint32_t)(uint8_t)(ch1) << 8) |       \
+                ((uint32_t)(uint8_t)(ch2) << 16) | ((uint32_t)(uint8_t)(ch3) << 24 ))
+#endif /* defined(MAKEFOURCC) */
+
+using std::uint8_t;
+using std::uint32_t;
+
+namespace
+{
+	// The Direct3D 12 limits DDSTextureLoader checked (D3D12_REQ_*); a file beyond
+	// them is reported as unsupported rather than trusted.
+	const uint32_t MaxMipLevels = 15;
+	const uint32_t MaxTexture1DSize = 16384;
+	const uint32_t MaxTexture2DSize = 16384;
+	const uint32_t MaxTextureCubeSize = 16384;
+	const uint32_t MaxTexture3DSize = 2048;
+	const uint32_t MaxArraySize = 2048;
+
+	uint32_t FullMipCount(uint32_t width, uint32_t height, uint32_t depth)
+	{
+		uint32_t size = (std::max)(width, (std::max)(height, depth));
+		uint32_t count = 1;
+		while(size > 1)
+		{
+			size /= 2;
+			++count;
+		}
+
+		return count;
+	}
+}
+
+DdsStatus DdsFile::Open(const std::string& filename)
+{
+	Reset();
+
+	if(!mFile.Open(filename))
+		return DdsStatus::CantOpen;
+
+	return Parse(mFile.Begin(), mFile.Size());
+}
+
+DdsStatus DdsFile::Open(const std::wstring& filename)
+{
+	Reset();
+
+	if(!mFile.Open(filename))
+		return DdsStatus::CantOpen;
+
+	return Parse(mFile.Begin(), mFile.Size());
+}
+
+DdsStatus DdsFile::Parse(const void* data, size_t size)
+{
+	// Open calls this on its own mapping, which must survive.
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	if(bytes != reinterpret_cast<const uint8_t*>(mFile.Begin()))
+		Close();
+	else
+		Reset();
+
+	if(bytes == nullptr)
+		return DdsStatus::Invalid;
+
+	size_t bitOffset = 0;
+	DdsStatus status = ParseHeaders(bytes, size, bitOffset);
+	if(status == DdsStatus::Ok)
+		status = LayOutSubresources(bytes + bitOffset, size - bitOffset);
+
+	if(status != DdsStatus::Ok)
+		Reset();
+
+	return status;
+}
+
+void DdsFile::Close()
+{
+	Reset();
+	mFile.Close();
+}
+
+void DdsFile::Reset()
+{
+	mHeader = DDS_HEADER();
+	mDx10Header = DDS_HEADER_DXT10();
+	mHasDx10Header = false;
+	mFormat = DXGI_FORMAT_UNKNOWN;
+	mDimension = DdsDimension::Texture2D;
+	mIsCubeMap = false;
+	mAlphaMode = DirectX::DDS_ALPHA_MODE_UNKNOWN;
+	mWidth = mHeight = mDepth = 0;
+	mMipCount = mArraySize = 0;
+	mSubresources.clear();
+}
+
+const char* DdsFile::StatusString(DdsStatus status)
+{
+	switch(status)
+	{
+	case DdsStatus::Ok:          return "ok";
+	case DdsStatus::CantOpen:    return "can't open file";
+	case DdsStatus::Invalid:     return "not a valid DDS file";
+	case DdsStatus::Unsupported: return "unsupported DDS format";
+	case DdsStatus::Truncated:   return "DDS file is truncated";
+	}
+
+	return "unknown";
+}
+
+bool DdsFile::IsBlockCompressed(DXGI_FORMAT fmt)
+{
+	return (fmt >= DXGI_FORMAT_BC1_TYPELESS && fmt <= DXGI_FORMAT_BC5_SNORM) ||
+		(fmt >= DXGI_FORMAT_BC6H_TYPELESS && fmt <= DXGI_FORMAT_BC7_UNORM_SRGB);
+}
+
+DdsStatus DdsFile::ParseHeaders(const uint8_t* data, size_t size, size_t& bitOffset)
+{
+	// The headers are copied out, so data needn't be aligned.
+	uint32_t magic = 0;
+	if(size < sizeof(magic) + sizeof(DDS_HEADER))
+		return size >= sizeof(magic) && memcmp(data, &DDS_MAGIC, sizeof(magic)) == 0 ? DdsStatus::Truncated : DdsStatus::Invalid;
+
+	memcpy(&magic, data, sizeof(magic));
+	memcpy(&mHeader, data + sizeof(magic), sizeof(DDS_HEADER));
+	bitOffset = sizeof(magic) + sizeof(DDS_HEADER);
+
+	if(magic != DDS_MAGIC || mHeader.size != sizeof(DDS_HEADER) || mHeader.ddspf.size != sizeof(DDS_PIXELFORMAT))
+		return DdsStatus::Invalid;
+
+	mWidth = mHeader.width;
+	mHeight = mHeader.height;
+	mDepth = mHeader.depth;
+	mMipCount = (std::max)(1u, mHeader.mipMapCount);
+	mArraySize = 1;
+
+	if((mHeader.ddspf.flags & DDS_FOURCC) && MAKEFOURCC('D', 'X', '1', '0') == mHeader.ddspf.fourCC)
+	{
+		if(size < bitOffset + sizeof(DDS_HEADER_DXT10))
+			return DdsStatus::Truncated;
+
+		memcpy(&mDx10Header, data + bitOffset, sizeof(DDS_HEADER_DXT10));
+		bitOffset += sizeof(DDS_HEADER_DXT10);
+		mHasDx10Header = true;
+
+		mArraySize = mDx10Header.arraySize;
+		if(mArraySize == 0)
+			return DdsStatus::Invalid;
+
+		switch(mDx10Header.dxgiFormat)
+		{
+		case DXGI_FORMAT_AI44:
+		case DXGI_FORMAT_IA44:
+		case DXGI_FORMAT_P8:
+		case DXGI_FORMAT_A8P8:
+			return DdsStatus::Unsupported;
+
+		default:
+			if(BitsPerPixel(mDx10Header.dxgiFormat) == 0)
+				return DdsStatus::Unsupported;
+		}
+
+		mFormat = mDx10Header.dxgiFormat;
+
+		switch(mDx10Header.resourceDimension)
+		{
+		case DDS_DIMENSION_TEXTURE1D:
+			if((mHeader.flags & DDS_HEIGHT) && mHeight != 1)
+				return DdsStatus::Invalid;
+			mHeight = mDepth = 1;
+			mDimension = DdsDimension::Texture1D;
+			break;
+
+		case DDS_DIMENSION_TEXTURE2D:
+			if(mDx10Header.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE)
+			{
+				mArraySize *= 6;
+				mIsCubeMap = true;
+			}
+			mDepth = 1;
+			mDimension = DdsDimension::Texture2D;
+			break;
+
+		case DDS_DIMENSION_TEXTURE3D:
+			if(!(mHeader.flags & DDS_HEADER_FLAGS_VOLUME))
+				return DdsStatus::Invalid;
+			if(mArraySize > 1)
+				return DdsStatus::Unsupported;
+			mDimension = DdsDimension::Texture3D;
+			break;
+
+		default:
+			return DdsStatus::Unsupported;
+		}
+
+		auto mode = static_cast<DirectX::DDS_ALPHA_MODE>(mDx10Header.miscFlags2 & DDS_MISC_FLAGS2_ALPHA_MODE_MASK);
+		if(mode <= DirectX::DDS_ALPHA_MODE_CUSTOM)
+			mAlphaMode = mode;
+	}
+	else
+	{
+		mFormat = GetDXGIFormat(mHeader.ddspf);
+		if(mFormat == DXGI_FORMAT_UNKNOWN)
+			return DdsStatus::Unsupported;
+
+		if(mHeader.flags & DDS_HEADER_FLAGS_VOLUME)
+		{
+			mDimension = DdsDimension::Texture3D;
+		}
+		else
+		{
+			if(mHeader.caps2 & DDS_CUBEMAP)
+			{
+				// Partial cube maps aren't supported.
+				if((mHeader.caps2 & DDS_CUBEMAP_ALLFACES) != DDS_CUBEMAP_ALLFACES)
+					return DdsStatus::Unsupported;
+				mArraySize = 6;
+				mIsCubeMap = true;
+			}
+
+			mDepth = 1;
+			mDimension = DdsDimension::Texture2D;
+		}
+
+		if((mHeader.ddspf.flags & DDS_FOURCC) &&
+			(MAKEFOURCC('D', 'X', 'T', '2') == mHeader.ddspf.fourCC || MAKEFOURCC('D', 'X', 'T', '4') == mHeader.ddspf.fourCC))
+			mAlphaMode = DirectX::DDS_ALPHA_MODE_PREMULTIPLIED;
+	}
+
+	if(mWidth == 0 || mHeight == 0 || mDepth == 0)
+		return DdsStatus::Invalid;
+
+	if(mMipCount > FullMipCount(mWidth, mHeight, mDepth))
+		return DdsStatus::Invalid;
+
+	// Bound sizes (for security purposes we don't trust DDS file metadata larger
+	// than the hardware requirements).
+	if(mMipCount > MaxMipLevels)
+		return DdsStatus::Unsupported;
+
+	switch(mDimension)
+	{
+	case DdsDimension::Texture1D:
+		if(mArraySize > MaxArraySize || mWidth > MaxTexture1DSize)
+			return DdsStatus::Unsupported;
+		break;
+
+	case DdsDimension::Texture2D:
+		if(mArraySize > MaxArraySize)
+			return DdsStatus::Unsupported;
+		if(mIsCubeMap && (mWidth > MaxTextureCubeSize || mHeight > MaxTextureCubeSize))
+			return DdsStatus::Unsupported;
+		if(!mIsCubeMap && (mWidth > MaxTexture2DSize || mHeight > MaxTexture2DSize))
+			return DdsStatus::Unsupported;
+		break;
+
+	case DdsDimension::Texture3D:
+		if(mWidth > MaxTexture3DSize || mHeight > MaxTexture3DSize || mDepth > MaxTexture3DSize)
+			return DdsStatus::Unsupported;
+		break;
+	}
+
+	return DdsStatus::Ok;
+}
+
+DdsStatus DdsFile::LayOutSubresources(const uint8_t* bits, size_t bitSize)
+{
+	mSubresources.resize((size_t)mMipCount*mArraySize);
+
+	size_t offset = 0;
+	size_t index = 0;
+	for(uint32_t slice = 0; slice < mArraySize; ++slice)
+	{
+		uint32_t w = mWidth;
+		uint32_t h = mHeight;
+		uint32_t d = mDepth;
+		for(uint32_t mip = 0; mip < mMipCount; ++mip)
+		{
+			DdsSubresource& sub = mSubresources[index++];
+			GetSurfaceInfo(w, h, mFormat, &sub.SlicePitch, &sub.RowPitch, &sub.NumRows);
+			sub.Width = w;
+			sub.Height = h;
+			sub.Depth = d;
+
+			// The sizes are bounded above, so this can't overflow.
+			size_t mipSize = sub.SlicePitch*d;
+			if(mipSize > bitSize - offset)
+				return DdsStatus::Truncated;
+
+			sub.Data = bits + offset;
+			offset += mipSize;
+
+			w = (std::max)(1u, w / 2);
+			h = (std::max)(1u, h / 2);
+			d = (std::max)(1u, d / 2);
+		}
+	}
+
+	return DdsStatus::Ok;
+}
+
+//--------------------------------------------------------------------------------------
+// Return the BPP for a particular format
+//--------------------------------------------------------------------------------------
+size_t DdsFile::BitsPerPixel( DXGI_FORMAT fmt )
+{
+    switch( fmt )
+    {
+    case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+    case DXGI_FORMAT_R32G32B32A32_UINT:
+    case DXGI_FORMAT_R32G32B32A32_SINT:
+        return 128;
+
+    case DXGI_FORMAT_R32G32B32_TYPELESS:
+    case DXGI_FORMAT_R32G32B32_FLOAT:
+    case DXGI_FORMAT_R32G32B32_UINT:
+    case DXGI_FORMAT_R32G32B32_SINT:
+        return 96;
+
+    case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+    case DXGI_FORMAT_R16G16B16A16_UINT:
+    case DXGI_FORMAT_R16G16B16A16_SNORM:
+    case DXGI_FORMAT_R16G16B16A16_SINT:
+    case DXGI_FORMAT_R32G32_TYPELESS:
+    case DXGI_FORMAT_R32G32_FLOAT:
+    case DXGI_FORMAT_R32G32_UINT:
+    case DXGI_FORMAT_R32G32_SINT:
+    case DXGI_FORMAT_R32G8X24_TYPELESS:
+    case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+    case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
+    case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
+    case DXGI_FORMAT_Y416:
+    case DXGI_FORMAT_Y210:
+    case DXGI_FORMAT_Y216:
+        return 64;
+
+    case DXGI_FORMAT_R10G10B10A2_TYPELESS:
+    case DXGI_FORMAT_R10G10B10A2_UNORM:
+    case DXGI_FORMAT_R10G10B10A2_UINT:
+    case DXGI_FORMAT_R11G11B10_FLOAT:
+    case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_R8G8B8A8_UINT:
+    case DXGI_FORMAT_R8G8B8A8_SNORM:
+    case DXGI_FORMAT_R8G8B8A8_SINT:
+    case DXGI_FORMAT_R16G16_TYPELESS:
+    case DXGI_FORMAT_R16G16_FLOAT:
+    case DXGI_FORMAT_R16G16_UNORM:
+    case DXGI_FORMAT_R16G16_UINT:
+    case DXGI_FORMAT_R16G16_SNORM:
+    case DXGI_FORMAT_R16G16_SINT:
+    case DXGI_FORMAT_R32_TYPELESS:
+    case DXGI_FORMAT_D32_FLOAT:
+    case DXGI_FORMAT_R32_FLOAT:
+    case DXGI_FORMAT_R32_UINT:
+    case DXGI_FORMAT_R32_SINT:
+    case DXGI_FORMAT_R24G8_TYPELESS:
+    case DXGI_FORMAT_D24_UNORM_S8_UINT:
+    case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
+    case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
+    case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+    case DXGI_FORMAT_R8G8_B8G8_UNORM:
+    case DXGI_FORMAT_G8R8_G8B8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+    case DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+    case DXGI_FORMAT_AYUV:
+    case DXGI_FORMAT_Y410:
+    case DXGI_FORMAT_YUY2:
+        return 32;
+
+    case DXGI_FORMAT_P010:
+    case DXGI_FORMAT_P016:
+        return 24;
+
+    case DXGI_FORMAT_R8G8_TYPELESS:
+    case DXGI_FORMAT_R8G8_UNORM:
+    case DXGI_FORMAT_R8G8_UINT:
+    case DXGI_FORMAT_R8G8_SNORM:
+    case DXGI_FORMAT_R8G8_SINT:
+    case DXGI_FORMAT_R16_TYPELESS:
+    case DXGI_FORMAT_R16_FLOAT:
+    case DXGI_FORMAT_D16_UNORM:
+    case DXGI_FORMAT_R16_UNORM:
+    case DXGI_FORMAT_R16_UINT:
+    case DXGI_FORMAT_R16_SNORM:
+    case DXGI_FORMAT_R16_SINT:
+    case DXGI_FORMAT_B5G6R5_UNORM:
+    case DXGI_FORMAT_B5G5R5A1_UNORM:
+    case DXGI_FORMAT_A8P8:
+    case DXGI_FORMAT_B4G4R4A4_UNORM:
+        return 16;
+
+    case DXGI_FORMAT_NV12:
+    case DXGI_FORMAT_420_OPAQUE:
+    case DXGI_FORMAT_NV11:
+        return 12;
+
+    case DXGI_FORMAT_R8_TYPELESS:
+    case DXGI_FORMAT_R8_UNORM:
+    case DXGI_FORMAT_R8_UINT:
+    case DXGI_FORMAT_R8_SNORM:
+    case DXGI_FORMAT_R8_SINT:
+    case DXGI_FORMAT_A8_UNORM:
+    case DXGI_FORMAT_AI44:
+    case DXGI_FORMAT_IA44:
+    case DXGI_FORMAT_P8:
+        return 8;
+
+    case DXGI_FORMAT_R1_UNORM:
+        return 1;
+
+    case DXGI_FORMAT_BC1_TYPELESS:
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC4_TYPELESS:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC4_SNORM:
+        return 4;
+
+    case DXGI_FORMAT_BC2_TYPELESS:
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:
+    case DXGI_FORMAT_BC3_TYPELESS:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DXGI_FORMAT_BC5_TYPELESS:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC5_SNORM:
+    case DXGI_FORMAT_BC6H_TYPELESS:
+    case DXGI_FORMAT_BC6H_UF16:
+    case DXGI_FORMAT_BC6H_SF16:
+    case DXGI_FORMAT_BC7_TYPELESS:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        return 8;
+
+    default:
+        return 0;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Get surface information for a particular format
+//--------------------------------------------------------------------------------------
+void DdsFile::GetSurfaceInfo( size_t width,
+                               size_t height,
+                               DXGI_FORMAT fmt,
+                               size_t* outNumBytes,
+                               size_t* outRowBytes,
+                               size_t* outNumRows )
+{
+    size_t numBytes = 0;
+    size_t rowBytes = 0;
+    size_t numRows = 0;
+
+    bool bc = false;
+    bool packed = false;
+    bool planar = false;
+    size_t bpe = 0;
+    switch (fmt)
+    {
+    case DXGI_FORMAT_BC1_TYPELESS:
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC4_TYPELESS:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC4_SNORM:
+        bc=true;
+        bpe = 8;
+        break;
+
+    case DXGI_FORMAT_BC2_TYPELESS:
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:
+    case DXGI_FORMAT_BC3_TYPELESS:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DXGI_FORMAT_BC5_TYPELESS:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC5_SNORM:
+    case DXGI_FORMAT_BC6H_TYPELESS:
+    case DXGI_FORMAT_BC6H_UF16:
+    case DXGI_FORMAT_BC6H_SF16:
+    case DXGI_FORMAT_BC7_TYPELESS:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        bc = true;
+        bpe = 16;
+        break;
+
+    case DXGI_FORMAT_R8G8_B8G8_UNORM:
+    case DXGI_FORMAT_G8R8_G8B8_UNORM:
+    case DXGI_FORMAT_YUY2:
+        packed = true;
+        bpe = 4;
+        break;
+
+    case DXGI_FORMAT_Y210:
+    case DXGI_FORMAT_Y216:
+        packed = true;
+        bpe = 8;
+        break;
+
+    case DXGI_FORMAT_NV12:
+    case DXGI_FORMAT_420_OPAQUE:
+        planar = true;
+        bpe = 2;
+        break;
+
+    case DXGI_FORMAT_P010:
+    case DXGI_FORMAT_P016:
+        planar = true;
+        bpe = 4;
+        break;
+    }
+
+    if (bc)
+    {
+        size_t numBlocksWide = 0;
+        if (width > 0)
+        {
+            numBlocksWide = std::max<size_t>( 1, (width + 3) / 4 );
+        }
+        size_t numBlocksHigh = 0;
+        if (height > 0)
+        {
+            numBlocksHigh = std::max<size_t>( 1, (height + 3) / 4 );
+        }
+        rowBytes = numBlocksWide * bpe;
+        numRows = numBlocksHigh;
+        numBytes = rowBytes * numBlocksHigh;
+    }
+    else if (packed)
+    {
+        rowBytes = ( ( width + 1 ) >> 1 ) * bpe;
+        numRows = height;
+        numBytes = rowBytes * height;
+    }
+    else if ( fmt == DXGI_FORMAT_NV11 )
+    {
+        rowBytes = ( ( width + 3 ) >> 2 ) * 4;
+        numRows = height * 2; // Direct3D makes this simplifying assumption, although it is larger than the 4:1:1 data
+        numBytes = rowBytes * numRows;
+    }
+    else if (planar)
+    {
+        rowBytes = ( ( width + 1 ) >> 1 ) * bpe;
+        numBytes = ( rowBytes * height ) + ( ( rowBytes * height + 1 ) >> 1 );
+        numRows = height + ( ( height + 1 ) >> 1 );
+    }
+    else
+    {
+        size_t bpp = BitsPerPixel( fmt );
+        rowBytes = ( width * bpp + 7 ) / 8; // round up to nearest byte
+        numRows = height;
+        numBytes = rowBytes * height;
+    }
+
+    if (outNumBytes)
+    {
+        *outNumBytes = numBytes;
+    }
+    if (outRowBytes)
+    {
+        *outRowBytes = rowBytes;
+    }
+    if (outNumRows)
+    {
+        *outNumRows = numRows;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+#define ISBITMASK( r,g,b,a ) ( ddpf.RBitMask == r && ddpf.GBitMask == g && ddpf.BBitMask == b && ddpf.ABitMask == a )
+
+DXGI_FORMAT DdsFile::GetDXGIFormat( const DDS_PIXELFORMAT& ddpf )
+{
+    if (ddpf.flags & DDS_RGB)
+    {
+        // Note that sRGB formats are written using the "DX10" extended header
+
+        switch (ddpf.RGBBitCount)
+        {
+        case 32:
+            if (ISBITMASK(0x000000ff,0x0000ff00,0x00ff0000,0xff000000))
+            {
+                return DXGI_FORMAT_R8G8B8A8_UNORM;
+            }
+
+            if (ISBITMASK(0x00ff0000,0x0000ff00,0x000000ff,0xff000000))
+            {
+                return DXGI_FORMAT_B8G8R8A8_UNORM;
+            }
+
+            if (ISBITMASK(0x00ff0000,0x0000ff00,0x000000ff,0x00000000))
+            {
+                return DXGI_FORMAT_B8G8R8X8_UNORM;
+            }
+
+            // No DXGI format maps to ISBITMASK(0x000000ff,0x0000ff00,0x00ff0000,0x00000000) aka D3DFMT_X8B8G8R8
+
+            // Note that many common DDS reader/writers (including D3DX) swap the
+            // the RED/BLUE masks for 10:10:10:2 formats. We assume
+            // below that the 'backwards' header mask is being used since it is most
+            // likely written by D3DX. The more robust solution is to use the 'DX10'
+            // header extension and specify the DXGI_FORMAT_R10G10B10A2_UNORM format directly
+
+            // For 'correct' writers, this should be 0x000003ff,0x000ffc00,0x3ff00000 for RGB data
+            if (ISBITMASK(0x3ff00000,0x000ffc00,0x000003ff,0xc0000000))
+            {
+                return DXGI_FORMAT_R10G10B10A2_UNORM;
+            }
+
+            // No DXGI format maps to ISBITMASK(0x000003ff,0x000ffc00,0x3ff00000,0xc0000000) aka D3DFMT_A2R10G10B10
+
+            if (ISBITMASK(0x0000ffff,0xffff0000,0x00000000,0x00000000))
+            {
+                return DXGI_FORMAT_R16G16_UNORM;
+            }
+
+            if (ISBITMASK(0xffffffff,0x00000000,0x00000000,0x00000000))
+            {
+                // Only 32-bit color channel format in D3D9 was R32F
+                return DXGI_FORMAT_R32_FLOAT; // D3DX writes this out as a FourCC of 114
+            }
+            break;
+
+        case 24:
+            // No 24bpp DXGI formats aka D3DFMT_R8G8B8
+            break;
+
+        case 16:
+            if (ISBITMASK(0x7c00,0x03e0,0x001f,0x8000))
+            {
+                return DXGI_FORMAT_B5G5R5A1_UNORM;
+            }
+            if (ISBITMASK(0xf800,0x07e0,0x001f,0x0000))
+            {
+                return DXGI_FORMAT_B5G6R5_UNORM;
+            }
+
+            // No DXGI format maps to ISBITMASK(0x7c00,0x03e0,0x001f,0x0000) aka D3DFMT_X1R5G5B5
+
+            if (ISBITMASK(0x0f00,0x00f0,0x000f,0xf000))
+            {
+                return DXGI_FORMAT_B4G4R4A4_UNORM;
+            }
+
+            // No DXGI format maps to ISBITMASK(0x0f00,0x00f0,0x000f,0x0000) aka D3DFMT_X4R4G4B4
+
+            // No 3:3:2, 3:3:2:8, or paletted DXGI formats aka D3DFMT_A8R3G3B2, D3DFMT_R3G3B2, D3DFMT_P8, D3DFMT_A8P8, etc.
+            break;
+        }
+    }
+    else if (ddpf.flags & DDS_LUMINANCE)
+    {
+        if (8 == ddpf.RGBBitCount)
+        {
+            if (ISBITMASK(0x000000ff,0x00000000,0x00000000,0x00000000))
+            {
+                return DXGI_FORMAT_R8_UNORM; // D3DX10/11 writes this out as DX10 extension
+            }
+
+            // No DXGI format maps to ISBITMASK(0x0f,0x00,0x00,0xf0) aka D3DFMT_A4L4
+        }
+
+        if (16 == ddpf.RGBBitCount)
+        {
+            if (ISBITMASK(0x0000ffff,0x00000000,0x00000000,0x00000000))
+            {
+                return DXGI_FORMAT_R16_UNORM; // D3DX10/11 writes this out as DX10 extension
+            }
+            if (ISBITMASK(0x000000ff,0x00000000,0x00000000,0x0000ff00))
+            {
+                return DXGI_FORMAT_R8G8_UNORM; // D3DX10/11 writes this out as DX10 extension
+            }
+        }
+    }
+    else if (ddpf.flags & DDS_ALPHA)
+    {
+        if (8 == ddpf.RGBBitCount)
+        {
+            return DXGI_FORMAT_A8_UNORM;
+        }
+    }
+    else if (ddpf.flags & DDS_FOURCC)
+    {
+        if (MAKEFOURCC( 'D', 'X', 'T', '1' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC1_UNORM;
+        }
+        if (MAKEFOURCC( 'D', 'X', 'T', '3' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC2_UNORM;
+        }
+        if (MAKEFOURCC( 'D', 'X', 'T', '5' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC3_UNORM;
+        }
+
+        // While pre-multiplied alpha isn't directly supported by the DXGI formats,
+        // they are basically the same as these BC formats so they can be mapped
+        if (MAKEFOURCC( 'D', 'X', 'T', '2' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC2_UNORM;
+        }
+        if (MAKEFOURCC( 'D', 'X', 'T', '4' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC3_UNORM;
+        }
+
+        if (MAKEFOURCC( 'A', 'T', 'I', '1' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC4_UNORM;
+        }
+        if (MAKEFOURCC( 'B', 'C', '4', 'U' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC4_UNORM;
+        }
+        if (MAKEFOURCC( 'B', 'C', '4', 'S' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC4_SNORM;
+        }
+
+        if (MAKEFOURCC( 'A', 'T', 'I', '2' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC5_UNORM;
+        }
+        if (MAKEFOURCC( 'B', 'C', '5', 'U' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC5_UNORM;
+        }
+        if (MAKEFOURCC( 'B', 'C', '5', 'S' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC5_SNORM;
+        }
+
+        // BC6H and BC7 are written using the "DX10" extended header
+
+        if (MAKEFOURCC( 'R', 'G', 'B', 'G' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_R8G8_B8G8_UNORM;
+        }
+        if (MAKEFOURCC( 'G', 'R', 'G', 'B' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_G8R8_G8B8_UNORM;
+        }
+
+        if (MAKEFOURCC('Y','U','Y','2') == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_YUY2;
+        }
+
+        // Check for D3DFORMAT enums being set here
+        switch( ddpf.fourCC )
+        {
+        case 36: // D3DFMT_A16B16G16R16
+            return DXGI_FORMAT_R16G16B16A16_UNORM;
+
+        case 110: // D3DFMT_Q16W16V16U16
+            return DXGI_FORMAT_R16G16B16A16_SNORM;
+
+        case 111: // D3DFMT_R16F
+            return DXGI_FORMAT_R16_FLOAT;
+
+        case 112: // D3DFMT_G16R16F
+            return DXGI_FORMAT_R16G16_FLOAT;
+
+        case 113: // D3DFMT_A16B16G16R16F
+            return DXGI_FORMAT_R16G16B16A16_FLOAT;
+
+        case 114: // D3DFMT_R32F
+            return DXGI_FORMAT_R32_FLOAT;
+
+        case 115: // D3DFMT_G32R32F
+            return DXGI_FORMAT_R32G32_FLOAT;
+
+        case 116: // D3DFMT_A32B32G32R32F
+            return DXGI_FORMAT_R32G32B32A32_FLOAT;
+        }
+    }
+
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+
+//--------------------------------------------------------------------------------------
+DXGI_FORMAT DdsFile::MakeSRGB( DXGI_FORMAT format )
+{
+    switch( format )
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+        return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+
+    case DXGI_FORMAT_BC1_UNORM:
+        return DXGI_FORMAT_BC1_UNORM_SRGB;
+
+    case DXGI_FORMAT_BC2_UNORM:
+        return DXGI_FORMAT_BC2_UNORM_SRGB;
+
+    case DXGI_FORMAT_BC3_UNORM:
+        return DXGI_FORMAT_BC3_UNORM_SRGB;
+
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+        return DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+        return DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+
+    case DXGI_FORMAT_BC7_UNORM:
+        return DXGI_FORMAT_BC7_UNORM_SRGB;
+
+    default:
+        return format;
+    }
+}
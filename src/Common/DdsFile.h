@@ -0,0 +1,265 @@
+//***************************************************************************************
+// DdsFile.h
+//
+// Platform-independent DDS parsing.  Validates the DDS header and the optional DX10
+// extension, works out the format, dimension, array size and mip count, and lays
+// out every subresource (each mip of each array slice or cube face) as a view into
+// the file's bytes.  The bytes are either a MappedFile the DdsFile owns or memory
+// the caller keeps alive, so nothing is copied.
+//
+// Needs only dxgiformat.h (the Windows SDK, or DirectX-Headers elsewhere), so tools
+// can load and check textures without a device.  DDSTextureLoader builds its D3D12
+// resources from a DdsFile.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <dxgiformat.h>
+#include "MappedFile.h"
+
+//
+// DDS file structures.  See DDS.h in the 'Texconv' sample and the 'DirectXTex' library.
+//
+
+#pragma pack(push,1)
+
+const std::uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+
+struct DDS_PIXELFORMAT
+{
+	std::uint32_t size;
+	std::uint32_t flags;
+	std::uint32_t fourCC;
+	std::uint32_t RGBBitCount;
+	std::uint32_t RBitMask;
+	std::uint32_t GBitMask;
+	std::uint32_t BBitMask;
+	std::uint32_t ABitMask;
+};
+
+struct DDS_HEADER
+{
+	std::uint32_t size;
+	std::uint32_t flags;
+	std::uint32_t height;
+	std::uint32_t width;
+	std::uint32_t pitchOrLinearSize;
+	std::uint32_t depth; // only if DDS_HEADER_FLAGS_VOLUME is set in flags
+	std::uint32_t mipMapCount;
+	std::uint32_t reserved1[11];
+	DDS_PIXELFORMAT ddspf;
+	std::uint32_t caps;
+	std::uint32_t caps2;
+	std::uint32_t caps3;
+	std::uint32_t caps4;
+	std::uint32_t reserved2;
+};
+
+struct DDS_HEADER_DXT10
+{
+	DXGI_FORMAT dxgiFormat;
+	std::uint32_t resourceDimension;
+	std::uint32_t miscFlag; // see D3D11_RESOURCE_MISC_FLAG
+	std::uint32_t arraySize;
+	std::uint32_t miscFlags2;
+};
+
+#pragma pack(pop)
+
+const std::uint32_t DDS_FOURCC      = 0x00000004; // DDPF_FOURCC
+const std::uint32_t DDS_RGB         = 0x00000040; // DDPF_RGB
+const std::uint32_t DDS_LUMINANCE   = 0x00020000; // DDPF_LUMINANCE
+const std::uint32_t DDS_ALPHA       = 0x00000002; // DDPF_ALPHA
+const std::uint32_t DDS_ALPHAPIXELS = 0x00000001; // DDPF_ALPHAPIXELS
+
+const std::uint32_t DDS_HEADER_FLAGS_TEXTURE = 0x00001007; // DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT
+const std::uint32_t DDS_HEADER_FLAGS_MIPMAP  = 0x00020000; // DDSD_MIPMAPCOUNT
+const std::uint32_t DDS_HEADER_FLAGS_PITCH   = 0x00000008; // DDSD_PITCH
+const std::uint32_t DDS_HEADER_FLAGS_VOLUME  = 0x00800000; // DDSD_DEPTH
+
+const std::uint32_t DDS_HEIGHT = 0x00000002; // DDSD_HEIGHT
+const std::uint32_t DDS_WIDTH  = 0x00000004; // DDSD_WIDTH
+
+const std::uint32_t DDS_SURFACE_FLAGS_TEXTURE = 0x00001000; // DDSCAPS_TEXTURE
+const std::uint32_t DDS_SURFACE_FLAGS_MIPMAP  = 0x00400008; // DDSCAPS_COMPLEX | DDSCAPS_MIPMAP
+
+const std::uint32_t DDS_CUBEMAP_POSITIVEX = 0x00000600; // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEX
+const std::uint32_t DDS_CUBEMAP_NEGATIVEX = 0x00000a00; // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEX
+const std::uint32_t DDS_CUBEMAP_POSITIVEY = 0x00001200; // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEY
+const std::uint32_t DDS_CUBEMAP_NEGATIVEY = 0x00002200; // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEY
+const std::uint32_t DDS_CUBEMAP_POSITIVEZ = 0x00004200; // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEZ
+const std::uint32_t DDS_CUBEMAP_NEGATIVEZ = 0x00008200; // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEZ
+
+const std::uint32_t DDS_CUBEMAP_ALLFACES = DDS_CUBEMAP_POSITIVEX | DDS_CUBEMAP_NEGATIVEX |
+                                           DDS_CUBEMAP_POSITIVEY | DDS_CUBEMAP_NEGATIVEY |
+                                           DDS_CUBEMAP_POSITIVEZ | DDS_CUBEMAP_NEGATIVEZ;
+
+const std::uint32_t DDS_CUBEMAP = 0x00000200; // DDSCAPS2_CUBEMAP
+
+// DDS_HEADER_DXT10 values; the same as D3D11_RESOURCE_DIMENSION and
+// D3D11_RESOURCE_MISC_TEXTURECUBE.
+const std::uint32_t DDS_DIMENSION_TEXTURE1D = 2;
+const std::uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+const std::uint32_t DDS_DIMENSION_TEXTURE3D = 4;
+const std::uint32_t DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+enum DDS_MISC_FLAGS2
+{
+	DDS_MISC_FLAGS2_ALPHA_MODE_MASK = 0x7L,
+};
+
+namespace DirectX
+{
+	enum DDS_ALPHA_MODE
+	{
+		DDS_ALPHA_MODE_UNKNOWN       = 0,
+		DDS_ALPHA_MODE_STRAIGHT      = 1,
+		DDS_ALPHA_MODE_PREMULTIPLIED = 2,
+		DDS_ALPHA_MODE_OPAQUE        = 3,
+		DDS_ALPHA_MODE_CUSTOM        = 4,
+	};
+}
+
+enum class DdsStatus
+{
+	Ok,
+	CantOpen,
+
+	// Not a DDS file, or a header that contradicts itself.
+	Invalid,
+
+	// A valid DDS file the demos can't use: a format with no DXGI equivalent, a
+	// partial cube map, or sizes beyond the Direct3D 12 limits.
+	Unsupported,
+
+	// The file ends before the last subresource.
+	Truncated
+};
+
+enum class DdsDimension
+{
+	Texture1D,
+	Texture2D,
+	Texture3D
+};
+
+// One mip level of one array slice, cube face or volume.
+struct DdsSubresource
+{
+	const std::uint8_t* Data = nullptr;
+
+	std::uint32_t Width = 0;
+	std::uint32_t Height = 0;
+	std::uint32_t Depth = 0;
+
+	// Bytes per row of pixels, or per row of 4x4 blocks for block-compressed
+	// formats; rows per depth slice; bytes per depth slice.
+	size_t RowPitch = 0;
+	size_t NumRows = 0;
+	size_t SlicePitch = 0;
+};
+
+class DdsFile
+{
+public:
+	DdsFile() = default;
+
+	DdsFile(const DdsFile& rhs) = delete;
+	DdsFile& operator=(const DdsFile& rhs) = delete;
+
+	///<summary>
+	/// Maps filename and parses it.  The subresource views point into the mapping
+	/// and stay valid until Close or the next Open or Parse.
+	///</summary>
+	DdsStatus Open(const std::string& filename);
+	DdsStatus Open(const std::wstring& filename);
+
+	///<summary>
+	/// Parses a DDS file already in memory.  The caller keeps data alive while
+	/// the subresource views are used.
+	///</summary>
+	DdsStatus Parse(const void* data, size_t size);
+
+	void Close();
+
+	bool IsValid()const { return !mSubresources.empty(); }
+
+	const DDS_HEADER& GetHeader()const { return mHeader; }
+	bool HasDx10Header()const { return mHasDx10Header; }
+
+	DXGI_FORMAT GetFormat()const { return mFormat; }
+	DdsDimension GetDimension()const { return mDimension; }
+	bool IsCubeMap()const { return mIsCubeMap; }
+	DirectX::DDS_ALPHA_MODE GetAlphaMode()const { return mAlphaMode; }
+
+	std::uint32_t GetWidth()const { return mWidth; }
+	std::uint32_t GetHeight()const { return mHeight; }
+	std::uint32_t GetDepth()const { return mDepth; }
+	std::uint32_t GetMipCount()const { return mMipCount; }
+
+	// Counts faces for cube maps: 6 per cube.
+	std::uint32_t GetArraySize()const { return mArraySize; }
+
+	///<summary>
+	/// Subresources in Direct3D order: every mip of slice 0, then every mip of
+	/// slice 1, and so on.
+	///</summary>
+	const std::vector<DdsSubresource>& GetSubresources()const { return mSubresources; }
+
+	const DdsSubresource& GetSubresource(std::uint32_t mip, std::uint32_t slice)const
+	{
+		return mSubresources[(size_t)slice*mMipCount + mip];
+	}
+
+	static const char* StatusString(DdsStatus status);
+
+	///<summary>
+	/// Bits per pixel of fmt, or per pixel on average for block-compressed and
+	/// planar formats.  0 for formats a DDS file can't hold.
+	///</summary>
+	static size_t BitsPerPixel(DXGI_FORMAT fmt);
+
+	static bool IsBlockCompressed(DXGI_FORMAT fmt);
+
+	///<summary>
+	/// Size of one width x height surface of fmt: total bytes, bytes per row (of
+	/// blocks for BC formats) and number of rows.
+	///</summary>
+	static void GetSurfaceInfo(size_t width, size_t height, DXGI_FORMAT fmt,
+		size_t* outNumBytes, size_t* outRowBytes, size_t* outNumRows);
+
+	///<summary>
+	/// DXGI format of a legacy (non-DX10) pixel format, or DXGI_FORMAT_UNKNOWN.
+	///</summary>
+	static DXGI_FORMAT GetDXGIFormat(const DDS_PIXELFORMAT& ddpf);
+
+	static DXGI_FORMAT MakeSRGB(DXGI_FORMAT format);
+
+private:
+	DdsStatus ParseHeaders(const std::uint8_t* data, size_t size, size_t& bitOffset);
+	DdsStatus LayOutSubresources(const std::uint8_t* bits, size_t bitSize);
+	void Reset();
+
+	MappedFile mFile;
+
+	DDS_HEADER mHeader = {};
+	DDS_HEADER_DXT10 mDx10Header = {};
+	bool mHasDx10Header = false;
+
+	DXGI_FORMAT mFormat = DXGI_FORMAT_UNKNOWN;
+	DdsDimension mDimension = DdsDimension::Texture2D;
+	bool mIsCubeMap = false;
+	DirectX::DDS_ALPHA_MODE mAlphaMode = DirectX::DDS_ALPHA_MODE_UNKNOWN;
+
+	std::uint32_t mWidth = 0;
+	std::uint32_t mHeight = 0;
+	std::uint32_t mDepth = 0;
+	std::uint32_t mMipCount = 0;
+	std::uint32_t mArraySize = 0;
+
+	std::vector<DdsSubresource> mSubresources;
+};
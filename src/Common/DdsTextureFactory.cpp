@@ -0,0 +1,73 @@
+//***************************************************************************************
+// DdsTextureFactory.cpp
+//***************************************************************************************
+
+#include "DdsTextureFactory.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include "DDSTextureLoader.h"
+
+DdsTextureFactory::DdsTextureFactory(ID3D12Device* device) :
+	mDevice(device)
+{
+}
+
+void DdsTextureFactory::Update(UINT64 completedFence, UINT64 frameFence)
+{
+	mRetired.erase(std::remove_if(mRetired.begin(), mRetired.end(),
+		[completedFence](const std::pair<UINT64, std::shared_ptr<void>>& retired) { return retired.first <= completedFence; }),
+		mRetired.end());
+
+	mFrameFence = frameFence;
+}
+
+bool DdsTextureFactory::Read(const std::string& path, std::vector<std::uint8_t>& bytes, std::string& error)
+{
+	std::ifstream fin(path, std::ios::binary | std::ios::ate);
+	if(!fin)
+	{
+		error = "can't open " + path;
+		return false;
+	}
+
+	bytes.resize((size_t)fin.tellg());
+	fin.seekg(0);
+	fin.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+	if(fin.fail())
+	{
+		error = "can't read " + path;
+		return false;
+	}
+
+	return true;
+}
+
+bool DdsTextureFactory::Create(const std::string& path, const std::vector<std::uint8_t>& bytes,
+	TextureCache::Created& created, std::string& error)
+{
+	auto texture = std::make_shared<Texture>();
+	texture->Name = path;
+	texture->Filename = AnsiToWString(path);
+
+	HRESULT hr = DirectX::CreateDDSTextureFromMemory12(mDevice, mCmdList, bytes.data(), bytes.size(),
+		texture->Resource, texture->UploadHeap);
+	if(FAILED(hr))
+	{
+		char message[64];
+		snprintf(message, sizeof(message), "CreateDDSTextureFromMemory12 failed: 0x%08x", (unsigned)hr);
+		error = message;
+		return false;
+	}
+
+	D3D12_RESOURCE_DESC desc = texture->Resource->GetDesc();
+	created.GpuBytes = mDevice->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+	created.CpuBytes = texture->UploadHeap->GetDesc().Width;
+	created.Resource = std::move(texture);
+	return true;
+}
+
+void DdsTextureFactory::Retire(std::shared_ptr<void> resource)
+{
+	mRetired.push_back({ mFrameFence, std::move(resource) });
+}
@@ -0,0 +1,49 @@
+//***************************************************************************************
+// DdsTextureFactory.h
+//
+// TextureCache::Factory for DDS files: reads them on the loader's threads and
+// creates a committed texture from the bytes with CreateDDSTextureFromMemory12,
+// recording the upload on the command list set with SetCommandList.  The cache's
+// resources are Textures (d3dUtil.h), so a handle's texture is
+// handle->Get<Texture>()->Resource.
+//
+// CPU bytes are the upload heap, which the texture keeps as apps always have;
+// GPU bytes are the device's allocation size.  An evicted texture is released
+// once the frames that may still sample it have completed.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "TextureCache.h"
+
+class DdsTextureFactory : public TextureCache::Factory
+{
+public:
+	explicit DdsTextureFactory(ID3D12Device* device);
+
+	///<summary>
+	/// The command list Create records uploads on.  It must be open whenever the
+	/// cache's Update or Flush runs.
+	///</summary>
+	void SetCommandList(ID3D12GraphicsCommandList* cmdList) { mCmdList = cmdList; }
+
+	///<summary>
+	/// completedFence is the fence value the GPU has reached and frameFence the
+	/// value the frame being recorded will signal.  Releases retired textures the
+	/// GPU is done with; textures retired from now on wait for frameFence.
+	///</summary>
+	void Update(UINT64 completedFence, UINT64 frameFence);
+
+	bool Read(const std::string& path, std::vector<std::uint8_t>& bytes, std::string& error) override;
+	bool Create(const std::string& path, const std::vector<std::uint8_t>& bytes, TextureCache::Created& created,
+		std::string& error) override;
+	void Retire(std::shared_ptr<void> resource) override;
+
+private:
+	ID3D12Device* mDevice = nullptr;
+	ID3D12GraphicsCommandList* mCmdList = nullptr;
+
+	UINT64 mFrameFence = 0;
+	std::vector<std::pair<UINT64, std::shared_ptr<void>>> mRetired;
+};
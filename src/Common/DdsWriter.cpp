@@ -0,0 +1,152 @@
+//***************************************************************************************
+// DdsWriter.cpp
+//***************************************************************************************
+
+#include "DdsWriter.h"
+#include <fstream>
+#include "DdsFile.h"
+
+namespace
+{
+	using uint32 = std::uint32_t;
+
+	uint32 FourCC(char a, char b, char c, char d)
+	{
+		return (uint32)(std::uint8_t)a | ((uint32)(std::uint8_t)b << 8) |
+			((uint32)(std::uint8_t)c << 16) | ((uint32)(std::uint8_t)d << 24);
+	}
+
+	DDS_PIXELFORMAT MaskFormat(uint32 flags, uint32 r, uint32 g, uint32 b, uint32 a)
+	{
+		DDS_PIXELFORMAT ddspf = {};
+		ddspf.size = sizeof(DDS_PIXELFORMAT);
+		ddspf.flags = flags;
+		ddspf.RGBBitCount = 32;
+		ddspf.RBitMask = r;
+		ddspf.GBitMask = g;
+		ddspf.BBitMask = b;
+		ddspf.ABitMask = a;
+		return ddspf;
+	}
+
+	// The legacy pixel format DdsFile::GetDXGIFormat maps back to format, if any.
+	bool GetLegacyFormat(DXGI_FORMAT format, DDS_PIXELFORMAT& ddspf)
+	{
+		uint32 fourCC = 0;
+		switch(format)
+		{
+		case DXGI_FORMAT_BC1_UNORM: fourCC = FourCC('D', 'X', 'T', '1'); break;
+		case DXGI_FORMAT_BC2_UNORM: fourCC = FourCC('D', 'X', 'T', '3'); break;
+		case DXGI_FORMAT_BC3_UNORM: fourCC = FourCC('D', 'X', 'T', '5'); break;
+		case DXGI_FORMAT_BC4_UNORM: fourCC = FourCC('A', 'T', 'I', '1'); break;
+		case DXGI_FORMAT_BC5_UNORM: fourCC = FourCC('A', 'T', 'I', '2'); break;
+
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+			ddspf = MaskFormat(DDS_RGB | DDS_ALPHAPIXELS, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+			return true;
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+			ddspf = MaskFormat(DDS_RGB | DDS_ALPHAPIXELS, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+			return true;
+		case DXGI_FORMAT_B8G8R8X8_UNORM:
+			ddspf = MaskFormat(DDS_RGB, 0x00ff0000, 0x0000ff00, 0x000000ff, 0x00000000);
+			return true;
+
+		default:
+			return false;
+		}
+
+		ddspf = DDS_PIXELFORMAT();
+		ddspf.size = sizeof(DDS_PIXELFORMAT);
+		ddspf.flags = DDS_FOURCC;
+		ddspf.fourCC = fourCC;
+		return true;
+	}
+}
+
+bool DdsWriter::Write(const std::string& filename, DXGI_FORMAT format, uint32 width, uint32 height,
+	const std::vector<std::vector<uint8>>& mips)
+{
+	return WriteArray(filename, format, width, height, std::vector<std::vector<std::vector<uint8>>>(1, mips));
+}
+
+bool DdsWriter::WriteArray(const std::string& filename, DXGI_FORMAT format, uint32 width, uint32 height,
+	const std::vector<std::vector<std::vector<uint8>>>& slices)
+{
+	if(slices.empty() || slices[0].empty() || width == 0 || height == 0 || DdsFile::BitsPerPixel(format) == 0)
+		return false;
+
+	const std::vector<std::vector<uint8>>& mips = slices[0];
+	size_t topRowBytes = 0;
+	for(const std::vector<std::vector<uint8>>& slice : slices)
+	{
+		if(slice.size() != mips.size())
+			return false;
+
+		for(size_t level = 0; level < slice.size(); ++level)
+		{
+			size_t numBytes = 0;
+			size_t rowBytes = 0;
+			DdsFile::GetSurfaceInfo((std::max)(1u, width >> level), (std::max)(1u, height >> level), format,
+				&numBytes, &rowBytes, nullptr);
+			if(slice[level].size() != numBytes)
+				return false;
+
+			if(level == 0)
+				topRowBytes = rowBytes;
+		}
+	}
+
+	const bool compressed = DdsFile::IsBlockCompressed(format);
+	const uint32 mipCount = (uint32)mips.size();
+	const uint32 arraySize = (uint32)slices.size();
+
+	DDS_HEADER header = {};
+	header.size = sizeof(DDS_HEADER);
+	header.flags = DDS_HEADER_FLAGS_TEXTURE | (mipCount > 1 ? DDS_HEADER_FLAGS_MIPMAP : 0);
+	header.width = width;
+	header.height = height;
+	header.mipMapCount = mipCount;
+	header.caps = DDS_SURFACE_FLAGS_TEXTURE | (mipCount > 1 ? DDS_SURFACE_FLAGS_MIPMAP : 0);
+
+	// pitchOrLinearSize is the top mip's size for compressed formats, its pitch otherwise.
+	if(compressed)
+	{
+		header.flags |= 0x00080000; // DDSD_LINEARSIZE
+		header.pitchOrLinearSize = (uint32)mips[0].size();
+	}
+	else
+	{
+		header.flags |= DDS_HEADER_FLAGS_PITCH;
+		header.pitchOrLinearSize = (uint32)topRowBytes;
+	}
+
+	// The legacy header has no array size.
+	const bool legacy = arraySize == 1 && GetLegacyFormat(format, header.ddspf);
+	DDS_HEADER_DXT10 dx10 = {};
+	if(!legacy)
+	{
+		header.ddspf = DDS_PIXELFORMAT();
+		header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+		header.ddspf.flags = DDS_FOURCC;
+		header.ddspf.fourCC = FourCC('D', 'X', '1', '0');
+
+		dx10.dxgiFormat = format;
+		dx10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+		dx10.arraySize = arraySize;
+	}
+
+	std::ofstream fout(filename, std::ios::binary);
+	fout.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(DDS_MAGIC));
+	fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	if(!legacy)
+		fout.write(reinterpret_cast<const char*>(&dx10), sizeof(dx10));
+
+	// Slice by slice, each with its whole mip chain.
+	for(const std::vector<std::vector<uint8>>& slice : slices)
+	{
+		for(const std::vector<uint8>& mip : slice)
+			fout.write(reinterpret_cast<const char*>(mip.data()), mip.size());
+	}
+
+	return !fout.fail();
+}
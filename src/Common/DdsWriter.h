@@ -0,0 +1,40 @@
+//***************************************************************************************
+// DdsWriter.h
+//
+// Writes 2D textures as DDS files that DDSTextureLoader and DdsFile read back.
+// Formats with a legacy pixel format (DXT1, DXT3, DXT5, ATI1, ATI2 and the 8-bit
+// RGBA/BGRA/BGRX masks) get a plain DDS header so older tools can open them too;
+// everything else (BC7, sRGB formats, ...) gets the DX10 extension header, as
+// does every texture array.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <dxgiformat.h>
+
+class DdsWriter
+{
+public:
+	typedef std::uint8_t uint8;
+	typedef std::uint32_t uint32;
+
+	///<summary>
+	/// Writes a width x height texture of format whose mips are given top first.
+	/// Each mip is tightly packed: rows of pixels, or rows of 4x4 blocks for block
+	/// compressed formats.  Returns false if a mip has the wrong size, format has
+	/// no DDS layout, or the file can't be written.
+	///</summary>
+	static bool Write(const std::string& filename, DXGI_FORMAT format, uint32 width, uint32 height,
+		const std::vector<std::vector<uint8>>& mips);
+
+	///<summary>
+	/// Writes a texture array: slices[i] holds slice i's mips as Write takes them,
+	/// and every slice has the same number of mips.  A single slice is written
+	/// exactly as Write would.
+	///</summary>
+	static bool WriteArray(const std::string& filename, DXGI_FORMAT format, uint32 width, uint32 height,
+		const std::vector<std::vector<std::vector<uint8>>>& slices);
+};
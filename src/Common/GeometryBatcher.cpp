@@ -0,0 +1,192 @@
+//***************************************************************************************
+// GeometryBatcher.cpp
+//***************************************************************************************
+
+#include "GeometryBatcher.h"
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	// 0xffff is the strip cut value, so 16-bit index buffers stop one short of it.
+	const std::uint32_t MaxIndex16 = 0xfffe;
+
+	UINT AlignUp(UINT value, UINT alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+GeometryBatcher::GeometryBatcher(UINT vertexByteStride, UINT positionByteOffset)
+	: mVertexByteStride(vertexByteStride), mPositionByteOffset(positionByteOffset)
+{
+	assert(positionByteOffset + sizeof(XMFLOAT3) <= vertexByteStride);
+}
+
+SubmeshGeometry GeometryBatcher::Add(const std::string& name, const void* vertices, size_t vertexCount,
+	const std::uint32_t* indices, size_t indexCount)
+{
+	BYTE* dst = AppendVertices(vertexCount);
+	if(vertexCount > 0)
+		memcpy(dst, vertices, vertexCount * mVertexByteStride);
+
+	return AppendSubmesh(name, vertexCount, indices, indexCount);
+}
+
+SubmeshGeometry GeometryBatcher::Add(const std::string& name, const void* vertices, size_t vertexCount,
+	const std::uint16_t* indices, size_t indexCount)
+{
+	BYTE* dst = AppendVertices(vertexCount);
+	if(vertexCount > 0)
+		memcpy(dst, vertices, vertexCount * mVertexByteStride);
+
+	return AppendSubmesh(name, vertexCount, indices, indexCount);
+}
+
+UINT GeometryBatcher::GetVertexCount()const
+{
+	return (UINT)(mVertices.size() / mVertexByteStride);
+}
+
+UINT GeometryBatcher::GetIndexCount()const
+{
+	return (UINT)mIndices.size();
+}
+
+DXGI_FORMAT GeometryBatcher::GetIndexFormat()const
+{
+	return mMaxIndex <= MaxIndex16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+}
+
+const BoundingBox& GeometryBatcher::GetBounds()const
+{
+	return mBounds;
+}
+
+const std::vector<std::pair<std::string, SubmeshGeometry>>& GeometryBatcher::GetSubmeshes()const
+{
+	return mSubmeshes;
+}
+
+std::unique_ptr<MeshGeometry> GeometryBatcher::CreateMeshGeometry(const std::string& name,
+	ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, bool packed)const
+{
+	const UINT indexSize = GetIndexFormat() == DXGI_FORMAT_R16_UINT ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+	const UINT vbByteSize = (UINT)mVertices.size();
+	const UINT ibByteSize = (UINT)mIndices.size() * indexSize;
+
+	auto geo = std::make_unique<MeshGeometry>();
+	geo->Name = name;
+
+	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
+	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), mVertices.data(), vbByteSize);
+
+	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
+	CopyIndices((BYTE*)geo->IndexBufferCPU->GetBufferPointer());
+
+	if(packed)
+	{
+		// Vertices first, then the indices, in one buffer.  Both views only need the
+		// offset aligned to the element size; GENERIC_READ covers both uses.
+		const UINT ibByteOffset = AlignUp(vbByteSize, 4);
+
+		std::vector<BYTE> data(ibByteOffset + ibByteSize, 0);
+		memcpy(data.data(), mVertices.data(), vbByteSize);
+		CopyIndices(data.data() + ibByteOffset);
+
+		geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(device,
+			cmdList, data.data(), data.size(), geo->VertexBufferUploader);
+
+		geo->IndexBufferGPU = geo->VertexBufferGPU;
+		geo->IndexBufferByteOffset = ibByteOffset;
+	}
+	else
+	{
+		geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(device,
+			cmdList, geo->VertexBufferCPU->GetBufferPointer(), vbByteSize, geo->VertexBufferUploader);
+
+		geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(device,
+			cmdList, geo->IndexBufferCPU->GetBufferPointer(), ibByteSize, geo->IndexBufferUploader);
+	}
+
+	geo->VertexByteStride = mVertexByteStride;
+	geo->VertexBufferByteSize = vbByteSize;
+	geo->IndexFormat = GetIndexFormat();
+	geo->IndexBufferByteSize = ibByteSize;
+
+	for(const auto& submesh : mSubmeshes)
+		geo->DrawArgs[submesh.first] = submesh.second;
+
+	return geo;
+}
+
+BYTE* GeometryBatcher::AppendVertices(size_t vertexCount)
+{
+	size_t offset = mVertices.size();
+	mVertices.resize(offset + vertexCount * mVertexByteStride);
+	return mVertices.data() + offset;
+}
+
+SubmeshGeometry GeometryBatcher::AppendSubmesh(const std::string& name, size_t vertexCount,
+	const std::uint32_t* indices, size_t indexCount)
+{
+	return AppendSubmeshImpl(name, vertexCount, indices, indexCount);
+}
+
+SubmeshGeometry GeometryBatcher::AppendSubmesh(const std::string& name, size_t vertexCount,
+	const std::uint16_t* indices, size_t indexCount)
+{
+	return AppendSubmeshImpl(name, vertexCount, indices, indexCount);
+}
+
+// Called after the vertices of the mesh have been appended.
+template<typename IndexT>
+SubmeshGeometry GeometryBatcher::AppendSubmeshImpl(const std::string& name, size_t vertexCount,
+	const IndexT* indices, size_t indexCount)
+{
+	const size_t baseVertex = GetVertexCount() - vertexCount;
+
+	SubmeshGeometry submesh;
+	submesh.IndexCount = (UINT)indexCount;
+	submesh.StartIndexLocation = (UINT)mIndices.size();
+	submesh.BaseVertexLocation = (INT)baseVertex;
+
+	mIndices.reserve(mIndices.size() + indexCount);
+	for(size_t i = 0; i < indexCount; ++i)
+	{
+		assert(indices[i] < vertexCount);
+		mIndices.push_back(indices[i]);
+		mMaxIndex = (std::max)(mMaxIndex, (std::uint32_t)indices[i]);
+	}
+
+	if(vertexCount > 0)
+	{
+		const XMFLOAT3* positions = reinterpret_cast<const XMFLOAT3*>(
+			mVertices.data() + baseVertex * mVertexByteStride + mPositionByteOffset);
+		BoundingBox::CreateFromPoints(submesh.Bounds, vertexCount, positions, mVertexByteStride);
+
+		if(mHasBounds)
+			BoundingBox::CreateMerged(mBounds, mBounds, submesh.Bounds);
+		else
+			mBounds = submesh.Bounds;
+		mHasBounds = true;
+	}
+
+	mSubmeshes.push_back(std::make_pair(name, submesh));
+	return submesh;
+}
+
+void GeometryBatcher::CopyIndices(BYTE* dst)const
+{
+	if(GetIndexFormat() == DXGI_FORMAT_R16_UINT)
+	{
+		std::uint16_t* dst16 = reinterpret_cast<std::uint16_t*>(dst);
+		for(size_t i = 0; i < mIndices.size(); ++i)
+			dst16[i] = (std::uint16_t)mIndices[i];
+	}
+	else
+	{
+		memcpy(dst, mIndices.data(), mIndices.size() * sizeof(std::uint32_t));
+	}
+}
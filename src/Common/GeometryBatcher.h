@@ -0,0 +1,122 @@
+//***************************************************************************************
+// GeometryBatcher.h
+//
+// Concatenates many meshes into one vertex buffer and one index buffer and builds
+// the MeshGeometry for them, so apps no longer compute vertex/index offsets and
+// SubmeshGeometry entries by hand.
+//
+// Every mesh keeps its own indices (relative to its first vertex) and is drawn
+// with BaseVertexLocation, so the whole batch can use 16-bit indices as long as no
+// single mesh has more than 65535 vertices; otherwise it switches to 32-bit.
+//
+// CreateMeshGeometry can place the vertices and indices in the same default heap
+// buffer, so a scene built from one batch needs a single buffer allocation and
+// binds its vertex and index buffers once.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "GeometryGenerator.h"
+
+class GeometryBatcher
+{
+public:
+
+	///<summary>
+	/// vertexByteStride is the size of the app's vertex struct and positionByteOffset
+	/// the offset of its XMFLOAT3 position, used for the submesh bounds.
+	///</summary>
+	GeometryBatcher(UINT vertexByteStride, UINT positionByteOffset = 0);
+	GeometryBatcher(const GeometryBatcher& rhs) = delete;
+	GeometryBatcher& operator=(const GeometryBatcher& rhs) = delete;
+
+	///<summary>
+	/// Appends a mesh from raw vertices (vertexByteStride bytes each) and indices
+	/// relative to the first of them.  Returns its draw arguments in the batch.
+	///</summary>
+	SubmeshGeometry Add(const std::string& name, const void* vertices, size_t vertexCount,
+		const std::uint32_t* indices, size_t indexCount);
+	SubmeshGeometry Add(const std::string& name, const void* vertices, size_t vertexCount,
+		const std::uint16_t* indices, size_t indexCount);
+
+	template<typename VertexT, typename IndexT>
+	SubmeshGeometry Add(const std::string& name, const std::vector<VertexT>& vertices, const std::vector<IndexT>& indices)
+	{
+		assert(sizeof(VertexT) == mVertexByteStride);
+		return Add(name, vertices.data(), vertices.size(), indices.data(), indices.size());
+	}
+
+	///<summary>
+	/// Appends a GeometryGenerator mesh, converting each vertex to the app's vertex
+	/// format with convert(const GeometryGenerator::Vertex&) -> Vertex.
+	///</summary>
+	template<typename ConvertFn>
+	SubmeshGeometry Add(const std::string& name, const GeometryGenerator::MeshData& meshData, ConvertFn convert)
+	{
+		using VertexT = typename std::decay<decltype(convert(meshData.Vertices[0]))>::type;
+		assert(sizeof(VertexT) == mVertexByteStride);
+
+		VertexT* dst = reinterpret_cast<VertexT*>(AppendVertices(meshData.Vertices.size()));
+		for(size_t i = 0; i < meshData.Vertices.size(); ++i)
+			dst[i] = convert(meshData.Vertices[i]);
+
+		return AppendSubmesh(name, meshData.Vertices.size(), meshData.Indices32.data(), meshData.Indices32.size());
+	}
+
+	UINT GetVertexCount()const;
+	UINT GetIndexCount()const;
+
+	///<summary>
+	/// DXGI_FORMAT_R16_UINT if every mesh in the batch fits 16-bit indices.
+	///</summary>
+	DXGI_FORMAT GetIndexFormat()const;
+
+	///<summary>
+	/// Box around every mesh added so far.
+	///</summary>
+	const DirectX::BoundingBox& GetBounds()const;
+
+	///<summary>
+	/// The draw arguments of each mesh, in the order they were added.
+	///</summary>
+	const std::vector<std::pair<std::string, SubmeshGeometry>>& GetSubmeshes()const;
+
+	///<summary>
+	/// Creates the CPU copies and GPU buffers of the batch and fills DrawArgs.  With
+	/// packed set, the index buffer follows the vertex buffer in the same resource
+	/// (and upload buffer).  The upload buffer must stay alive until the command
+	/// list has executed, as with d3dUtil::CreateDefaultBuffer.
+	///</summary>
+	std::unique_ptr<MeshGeometry> CreateMeshGeometry(const std::string& name,
+		ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, bool packed = true)const;
+
+private:
+	BYTE* AppendVertices(size_t vertexCount);
+
+	SubmeshGeometry AppendSubmesh(const std::string& name, size_t vertexCount,
+		const std::uint32_t* indices, size_t indexCount);
+	SubmeshGeometry AppendSubmesh(const std::string& name, size_t vertexCount,
+		const std::uint16_t* indices, size_t indexCount);
+
+	template<typename IndexT>
+	SubmeshGeometry AppendSubmeshImpl(const std::string& name, size_t vertexCount,
+		const IndexT* indices, size_t indexCount);
+
+	void CopyIndices(BYTE* dst)const;
+
+private:
+	UINT mVertexByteStride = 0;
+	UINT mPositionByteOffset = 0;
+
+	std::vector<BYTE> mVertices;
+	std::vector<std::uint32_t> mIndices;
+
+	// Largest index of any mesh, relative to its BaseVertexLocation.
+	std::uint32_t mMaxIndex = 0;
+
+	DirectX::BoundingBox mBounds;
+	bool mHasBounds = false;
+
+	std::vector<std::pair<std::string, SubmeshGeometry>> mSubmeshes;
+};
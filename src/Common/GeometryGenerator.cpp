@@ -3,10 +3,137 @@
 //***************************************************************************************
 
 #include "GeometryGenerator.h"
+#include "ParallelFor.h"
 #include <algorithm>
+#include <cfloat>
 
 using namespace DirectX;
 
+const GeometryGenerator::uint32 GeometryGenerator::MaxGridTileQuads;
+
+namespace
+{
+	using uint16 = GeometryGenerator::uint16;
+	using uint32 = GeometryGenerator::uint32;
+
+	template<typename T>
+	T* Attribute(T* base, size_t stride, uint32 i)
+	{
+		return reinterpret_cast<T*>(reinterpret_cast<char*>(base) + i*stride);
+	}
+
+	void WriteVertex(const GeometryGenerator::MeshOutput& output, uint32 i, const GeometryGenerator::Vertex& v)
+	{
+		if(output.Positions) *Attribute(output.Positions, output.VertexStride, i) = v.Position;
+		if(output.Normals)   *Attribute(output.Normals, output.VertexStride, i) = v.Normal;
+		if(output.TangentU)  *Attribute(output.TangentU, output.VertexStride, i) = v.TangentU;
+		if(output.TexC)      *Attribute(output.TexC, output.VertexStride, i) = v.TexC;
+	}
+
+	void WriteIndex(const GeometryGenerator::MeshOutput& output, uint32 k, uint32 vertex)
+	{
+		if(output.Indices16)
+			output.Indices16[k] = static_cast<uint16>(output.BaseVertex + vertex);
+		else
+			output.Indices32[k] = output.BaseVertex + vertex;
+	}
+
+	void WriteTriangle(const GeometryGenerator::MeshOutput& output, uint32 k, uint32 v0, uint32 v1, uint32 v2)
+	{
+		WriteIndex(output, k+0, v0);
+		WriteIndex(output, k+1, v1);
+		WriteIndex(output, k+2, v2);
+	}
+
+	const uint32 MaxBoxSubdivisions = 6;
+	const uint32 MaxGeosphereSubdivisions = 8;
+
+	// Icosahedron the geospheres are tessellated from.
+	const float IcosahedronX = 0.525731f;
+	const float IcosahedronZ = 0.850651f;
+
+	const DirectX::XMFLOAT3 IcosahedronPositions[12] =
+	{
+		DirectX::XMFLOAT3(-IcosahedronX, 0.0f, IcosahedronZ),  DirectX::XMFLOAT3(IcosahedronX, 0.0f, IcosahedronZ),
+		DirectX::XMFLOAT3(-IcosahedronX, 0.0f, -IcosahedronZ), DirectX::XMFLOAT3(IcosahedronX, 0.0f, -IcosahedronZ),
+		DirectX::XMFLOAT3(0.0f, IcosahedronZ, IcosahedronX),   DirectX::XMFLOAT3(0.0f, IcosahedronZ, -IcosahedronX),
+		DirectX::XMFLOAT3(0.0f, -IcosahedronZ, IcosahedronX),  DirectX::XMFLOAT3(0.0f, -IcosahedronZ, -IcosahedronX),
+		DirectX::XMFLOAT3(IcosahedronZ, IcosahedronX, 0.0f),   DirectX::XMFLOAT3(-IcosahedronZ, IcosahedronX, 0.0f),
+		DirectX::XMFLOAT3(IcosahedronZ, -IcosahedronX, 0.0f),  DirectX::XMFLOAT3(-IcosahedronZ, -IcosahedronX, 0.0f)
+	};
+
+	const uint32 IcosahedronIndices[60] =
+	{
+		1,4,0,  4,9,0,  4,5,9,  8,5,4,  1,8,4,
+		1,10,8, 10,3,8, 8,3,5,  3,2,5,  3,7,2,
+		3,10,7, 10,6,7, 6,11,7, 6,0,11, 6,1,0,
+		10,1,6, 11,0,9, 2,11,9, 5,2,9,  11,2,7
+	};
+
+	// Fills in the normal, tangent and texture coordinates of a geosphere vertex
+	// from its position on the unit icosahedron.
+	GeometryGenerator::Vertex GeosphereVertex(DirectX::FXMVECTOR unprojected, float radius)
+	{
+		using namespace DirectX;
+
+		GeometryGenerator::Vertex v;
+
+		// Project onto unit sphere.
+		XMVECTOR n = XMVector3Normalize(unprojected);
+
+		// Project onto sphere.
+		XMVECTOR p = radius*n;
+
+		XMStoreFloat3(&v.Position, p);
+		XMStoreFloat3(&v.Normal, n);
+
+		// Derive texture coordinates from spherical coordinates.
+		float theta = atan2f(v.Position.z, v.Position.x);
+
+		// Put in [0, 2pi].
+		if(theta < 0.0f)
+			theta += XM_2PI;
+
+		float phi = acosf(v.Position.y / radius);
+
+		v.TexC.x = theta/XM_2PI;
+		v.TexC.y = phi/XM_PI;
+
+		// Partial derivative of P with respect to theta
+		v.TangentU.x = -radius*sinf(phi)*sinf(theta);
+		v.TangentU.y = 0.0f;
+		v.TangentU.z = +radius*sinf(phi)*cosf(theta);
+
+		XMVECTOR T = XMLoadFloat3(&v.TangentU);
+		XMStoreFloat3(&v.TangentU, XMVector3Normalize(T));
+
+		return v;
+	}
+
+	// How CreateGridTiles cuts an mxn grid: tiles of TileQuads x TileQuads quads in
+	// row-major order, with smaller tiles along the last row and column.
+	struct GridTiling
+	{
+		GridTiling(uint32 m, uint32 n, uint32 tileQuads)
+		{
+			TileQuads = std::min(std::max(tileQuads, 1u), GeometryGenerator::MaxGridTileQuads);
+			QuadRows = m > 1 ? m-1 : 0;
+			QuadColumns = n > 1 ? n-1 : 0;
+			TileRows = (QuadRows + TileQuads - 1) / TileQuads;
+			TileColumns = (QuadColumns + TileQuads - 1) / TileQuads;
+		}
+
+		uint32 TileQuadRows(uint32 tileRow)const { return std::min(TileQuads, QuadRows - tileRow*TileQuads); }
+		uint32 TileQuadColumns(uint32 tileColumn)const { return std::min(TileQuads, QuadColumns - tileColumn*TileQuads); }
+
+		uint32 TileQuads;
+		uint32 QuadRows;
+		uint32 QuadColumns;
+		uint32 TileRows;
+		uint32 TileColumns;
+	};
+}
+
 GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float height, float depth, uint32 numSubdivisions)
 {
     MeshData meshData;
@@ -92,7 +219,7 @@ GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float heig
 	meshData.Indices32.assign(&i[0], &i[36]);
 
     // Put a cap on the number of subdivisions.
-    numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
+    numSubdivisions = std::min(numSubdivisions, MaxBoxSubdivisions);
 
     for(uint32 i = 0; i < numSubdivisions; ++i)
         Subdivide(meshData);
@@ -103,7 +230,13 @@ GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float heig
 GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32 sliceCount, uint32 stackCount)
 {
     MeshData meshData;
+    CreateSphere(radius, sliceCount, stackCount, AllocateMeshData(GetSphereSize(sliceCount, stackCount), meshData));
 
+    return meshData;
+}
+
+void GeometryGenerator::CreateSphere(float radius, uint32 sliceCount, uint32 stackCount, const MeshOutput& output)
+{
 	//
 	// Compute the vertices stating at the top pole and moving down the stacks.
 	//
@@ -114,15 +247,28 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 	Vertex topVertex(0.0f, +radius, 0.0f, 0.0f, +1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
 	Vertex bottomVertex(0.0f, -radius, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
 
-	meshData.Vertices.push_back( topVertex );
+	uint32 vertexCount = 0;
+	WriteVertex(output, vertexCount++, topVertex);
 
 	float phiStep   = XM_PI/stackCount;
 	float thetaStep = 2.0f*XM_PI/sliceCount;
 
+	// Every ring has the same slice angles, so their sines and cosines are
+	// computed once instead of once per vertex.
+	std::vector<float> sinTheta(sliceCount+1);
+	std::vector<float> cosTheta(sliceCount+1);
+	for(uint32 j = 0; j <= sliceCount; ++j)
+	{
+		sinTheta[j] = sinf(j*thetaStep);
+		cosTheta[j] = cosf(j*thetaStep);
+	}
+
 	// Compute vertices for each stack ring (do not count the poles as rings).
 	for(uint32 i = 1; i <= stackCount-1; ++i)
 	{
 		float phi = i*phiStep;
+		float sinPhi = sinf(phi);
+		float cosPhi = cosf(phi);
 
 		// Vertices of ring.
         for(uint32 j = 0; j <= sliceCount; ++j)
@@ -132,14 +278,14 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 			Vertex v;
 
 			// spherical to cartesian
-			v.Position.x = radius*sinf(phi)*cosf(theta);
-			v.Position.y = radius*cosf(phi);
-			v.Position.z = radius*sinf(phi)*sinf(theta);
+			v.Position.x = radius*sinPhi*cosTheta[j];
+			v.Position.y = radius*cosPhi;
+			v.Position.z = radius*sinPhi*sinTheta[j];
 
 			// Partial derivative of P with respect to theta
-			v.TangentU.x = -radius*sinf(phi)*sinf(theta);
+			v.TangentU.x = -radius*sinPhi*sinTheta[j];
 			v.TangentU.y = 0.0f;
-			v.TangentU.z = +radius*sinf(phi)*cosf(theta);
+			v.TangentU.z = +radius*sinPhi*cosTheta[j];
 
 			XMVECTOR T = XMLoadFloat3(&v.TangentU);
 			XMStoreFloat3(&v.TangentU, XMVector3Normalize(T));
@@ -150,23 +296,20 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 			v.TexC.x = theta / XM_2PI;
 			v.TexC.y = phi / XM_PI;
 
-			meshData.Vertices.push_back( v );
+			WriteVertex(output, vertexCount++, v);
 		}
 	}
 
-	meshData.Vertices.push_back( bottomVertex );
+	WriteVertex(output, vertexCount++, bottomVertex);
 
 	//
 	// Compute indices for top stack.  The top stack was written first to the vertex buffer
 	// and connects the top pole to the first ring.
 	//
 
-    for(uint32 i = 1; i <= sliceCount; ++i)
-	{
-		meshData.Indices32.push_back(0);
-		meshData.Indices32.push_back(i+1);
-		meshData.Indices32.push_back(i);
-	}
+	uint32 k = 0;
+    for(uint32 i = 1; i <= sliceCount; ++i, k += 3)
+		WriteTriangle(output, k, 0, i+1, i);
 	
 	//
 	// Compute indices for inner stacks (not connected to poles).
@@ -180,13 +323,17 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 	{
 		for(uint32 j = 0; j < sliceCount; ++j)
 		{
-			meshData.Indices32.push_back(baseIndex + i*ringVertexCount + j);
-			meshData.Indices32.push_back(baseIndex + i*ringVertexCount + j+1);
-			meshData.Indices32.push_back(baseIndex + (i+1)*ringVertexCount + j);
+			WriteTriangle(output, k,
+				baseIndex + i*ringVertexCount + j,
+				baseIndex + i*ringVertexCount + j+1,
+				baseIndex + (i+1)*ringVertexCount + j);
+
+			WriteTriangle(output, k+3,
+				baseIndex + (i+1)*ringVertexCount + j,
+				baseIndex + i*ringVertexCount + j+1,
+				baseIndex + (i+1)*ringVertexCount + j+1);
 
-			meshData.Indices32.push_back(baseIndex + (i+1)*ringVertexCount + j);
-			meshData.Indices32.push_back(baseIndex + i*ringVertexCount + j+1);
-			meshData.Indices32.push_back(baseIndex + (i+1)*ringVertexCount + j+1);
+			k += 6;
 		}
 	}
 
@@ -196,30 +343,17 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 	//
 
 	// South pole vertex was added last.
-	uint32 southPoleIndex = (uint32)meshData.Vertices.size()-1;
+	uint32 southPoleIndex = vertexCount-1;
 
 	// Offset the indices to the index of the first vertex in the last ring.
 	baseIndex = southPoleIndex - ringVertexCount;
 	
-	for(uint32 i = 0; i < sliceCount; ++i)
-	{
-		meshData.Indices32.push_back(southPoleIndex);
-		meshData.Indices32.push_back(baseIndex+i);
-		meshData.Indices32.push_back(baseIndex+i+1);
-	}
-
-    return meshData;
+	for(uint32 i = 0; i < sliceCount; ++i, k += 3)
+		WriteTriangle(output, k, southPoleIndex, baseIndex+i, baseIndex+i+1);
 }
  
 void GeometryGenerator::Subdivide(MeshData& meshData)
 {
-	// Save a copy of the input geometry.
-	MeshData inputCopy = meshData;
-
-
-	meshData.Vertices.resize(0);
-	meshData.Indices32.resize(0);
-
 	//       v1
 	//       *
 	//      / \
@@ -229,51 +363,85 @@ void GeometryGenerator::Subdivide(MeshData& meshData)
 	//  /   \ /   \
 	// *-----*-----*
 	// v0    m2     v2
+	//
+	// The input vertices are kept in place and each edge midpoint is appended
+	// once, the first time one of the triangles sharing that edge asks for it.
+	// For a closed mesh every edge is shared by two triangles, so the new vertex
+	// count is V + 3F/2 instead of 6F when every triangle gets its own copies.
+
+	std::vector<uint32> inputIndices;
+	inputIndices.swap(meshData.Indices32);
+
+	uint32 numTris = (uint32)inputIndices.size()/3;
+
+	std::unordered_map<std::uint64_t, uint32> midPointCache;
+	midPointCache.reserve(numTris*3/2);
+
+	meshData.Vertices.reserve(meshData.Vertices.size() + numTris*3/2);
+	meshData.Indices32.reserve(numTris*12);
 
-	uint32 numTris = (uint32)inputCopy.Indices32.size()/3;
 	for(uint32 i = 0; i < numTris; ++i)
 	{
-		Vertex v0 = inputCopy.Vertices[ inputCopy.Indices32[i*3+0] ];
-		Vertex v1 = inputCopy.Vertices[ inputCopy.Indices32[i*3+1] ];
-		Vertex v2 = inputCopy.Vertices[ inputCopy.Indices32[i*3+2] ];
+		uint32 v0 = inputIndices[i*3+0];
+		uint32 v1 = inputIndices[i*3+1];
+		uint32 v2 = inputIndices[i*3+2];
 
 		//
-		// Generate the midpoints.
+		// Generate (or look up) the midpoints.
 		//
 
-        Vertex m0 = MidPoint(v0, v1);
-        Vertex m1 = MidPoint(v1, v2);
-        Vertex m2 = MidPoint(v0, v2);
+		uint32 m0 = GetMidPointIndex(v0, v1, midPointCache, meshData);
+		uint32 m1 = GetMidPointIndex(v1, v2, midPointCache, meshData);
+		uint32 m2 = GetMidPointIndex(v0, v2, midPointCache, meshData);
 
 		//
 		// Add new geometry.
 		//
 
-		meshData.Vertices.push_back(v0); // 0
-		meshData.Vertices.push_back(v1); // 1
-		meshData.Vertices.push_back(v2); // 2
-		meshData.Vertices.push_back(m0); // 3
-		meshData.Vertices.push_back(m1); // 4
-		meshData.Vertices.push_back(m2); // 5
- 
-		meshData.Indices32.push_back(i*6+0);
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+5);
+		meshData.Indices32.push_back(v0);
+		meshData.Indices32.push_back(m0);
+		meshData.Indices32.push_back(m2);
 
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+4);
-		meshData.Indices32.push_back(i*6+5);
+		meshData.Indices32.push_back(m0);
+		meshData.Indices32.push_back(m1);
+		meshData.Indices32.push_back(m2);
 
-		meshData.Indices32.push_back(i*6+5);
-		meshData.Indices32.push_back(i*6+4);
-		meshData.Indices32.push_back(i*6+2);
+		meshData.Indices32.push_back(m2);
+		meshData.Indices32.push_back(m1);
+		meshData.Indices32.push_back(v2);
 
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+1);
-		meshData.Indices32.push_back(i*6+4);
+		meshData.Indices32.push_back(m0);
+		meshData.Indices32.push_back(v1);
+		meshData.Indices32.push_back(m1);
 	}
 }
 
+GeometryGenerator::uint32 GeometryGenerator::GetMidPointIndex(
+	uint32 i0, uint32 i1, 
+	std::unordered_map<std::uint64_t, uint32>& midPointCache,
+	MeshData& meshData)
+{
+	// Order the key so that edge (i0, i1) and edge (i1, i0) map to the same midpoint.
+	std::uint64_t key = i0 < i1 ?
+		((std::uint64_t)i0 << 32) | i1 :
+		((std::uint64_t)i1 << 32) | i0;
+
+	auto it = midPointCache.find(key);
+	if(it != midPointCache.end())
+		return it->second;
+
+	// Copy the endpoints; push_back may reallocate the vertex array.
+	Vertex v0 = meshData.Vertices[i0];
+	Vertex v1 = meshData.Vertices[i1];
+
+	uint32 index = (uint32)meshData.Vertices.size();
+	meshData.Vertices.push_back(MidPoint(v0, v1));
+
+	midPointCache[key] = index;
+
+	return index;
+}
+
 GeometryGenerator::Vertex GeometryGenerator::MidPoint(const Vertex& v0, const Vertex& v1)
 {
     XMVECTOR p0 = XMLoadFloat3(&v0.Position);
@@ -308,73 +476,23 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uin
 {
     MeshData meshData;
 
-	// Put a cap on the number of subdivisions.
-    numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
+	// Put a cap on the number of subdivisions.  Depth 8 is 1.3 million triangles.
+    numSubdivisions = std::min(numSubdivisions, MaxGeosphereSubdivisions);
 
 	// Approximate a sphere by tessellating an icosahedron.
 
-	const float X = 0.525731f; 
-	const float Z = 0.850651f;
-
-	XMFLOAT3 pos[12] = 
-	{
-		XMFLOAT3(-X, 0.0f, Z),  XMFLOAT3(X, 0.0f, Z),  
-		XMFLOAT3(-X, 0.0f, -Z), XMFLOAT3(X, 0.0f, -Z),    
-		XMFLOAT3(0.0f, Z, X),   XMFLOAT3(0.0f, Z, -X), 
-		XMFLOAT3(0.0f, -Z, X),  XMFLOAT3(0.0f, -Z, -X),    
-		XMFLOAT3(Z, X, 0.0f),   XMFLOAT3(-Z, X, 0.0f), 
-		XMFLOAT3(Z, -X, 0.0f),  XMFLOAT3(-Z, -X, 0.0f)
-	};
-
-    uint32 k[60] =
-	{
-		1,4,0,  4,9,0,  4,5,9,  8,5,4,  1,8,4,    
-		1,10,8, 10,3,8, 8,3,5,  3,2,5,  3,7,2,    
-		3,10,7, 10,6,7, 6,11,7, 6,0,11, 6,1,0, 
-		10,1,6, 11,0,9, 2,11,9, 5,2,9,  11,2,7 
-	};
-
     meshData.Vertices.resize(12);
-    meshData.Indices32.assign(&k[0], &k[60]);
+    meshData.Indices32.assign(&IcosahedronIndices[0], &IcosahedronIndices[60]);
 
 	for(uint32 i = 0; i < 12; ++i)
-		meshData.Vertices[i].Position = pos[i];
+		meshData.Vertices[i].Position = IcosahedronPositions[i];
 
 	for(uint32 i = 0; i < numSubdivisions; ++i)
 		Subdivide(meshData);
 
 	// Project vertices onto sphere and scale.
 	for(uint32 i = 0; i < meshData.Vertices.size(); ++i)
-	{
-		// Project onto unit sphere.
-		XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&meshData.Vertices[i].Position));
-
-		// Project onto sphere.
-		XMVECTOR p = radius*n;
-
-		XMStoreFloat3(&meshData.Vertices[i].Position, p);
-		XMStoreFloat3(&meshData.Vertices[i].Normal, n);
-
-		// Derive texture coordinates from spherical coordinates.
-        float theta = atan2f(meshData.Vertices[i].Position.z, meshData.Vertices[i].Position.x);
-
-        // Put in [0, 2pi].
-        if(theta < 0.0f)
-            theta += XM_2PI;
-
-		float phi = acosf(meshData.Vertices[i].Position.y / radius);
-
-		meshData.Vertices[i].TexC.x = theta/XM_2PI;
-		meshData.Vertices[i].TexC.y = phi/XM_PI;
-
-		// Partial derivative of P with respect to theta
-		meshData.Vertices[i].TangentU.x = -radius*sinf(phi)*sinf(theta);
-		meshData.Vertices[i].TangentU.y = 0.0f;
-		meshData.Vertices[i].TangentU.z = +radius*sinf(phi)*cosf(theta);
-
-		XMVECTOR T = XMLoadFloat3(&meshData.Vertices[i].TangentU);
-		XMStoreFloat3(&meshData.Vertices[i].TangentU, XMVector3Normalize(T));
-	}
+		meshData.Vertices[i] = GeosphereVertex(XMLoadFloat3(&meshData.Vertices[i].Position), radius);
 
     return meshData;
 }
@@ -382,7 +500,14 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uin
 GeometryGenerator::MeshData GeometryGenerator::CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount)
 {
     MeshData meshData;
+    CreateCylinder(bottomRadius, topRadius, height, sliceCount, stackCount,
+        AllocateMeshData(GetCylinderSize(sliceCount, stackCount), meshData));
+
+    return meshData;
+}
 
+void GeometryGenerator::CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, const MeshOutput& output)
+{
 	//
 	// Build Stacks.
 	// 
@@ -395,6 +520,7 @@ GeometryGenerator::MeshData GeometryGenerator::CreateCylinder(float bottomRadius
 	uint32 ringCount = stackCount+1;
 
 	// Compute vertices for each stack ring starting at the bottom and moving up.
+	uint32 vertexCount = 0;
 	for(uint32 i = 0; i < ringCount; ++i)
 	{
 		float y = -0.5f*height + i*stackHeight;
@@ -444,7 +570,7 @@ GeometryGenerator::MeshData GeometryGenerator::CreateCylinder(float bottomRadius
 			XMVECTOR N = XMVector3Normalize(XMVector3Cross(T, B));
 			XMStoreFloat3(&vertex.Normal, N);
 
-			meshData.Vertices.push_back(vertex);
+			WriteVertex(output, vertexCount++, vertex);
 		}
 	}
 
@@ -453,31 +579,33 @@ GeometryGenerator::MeshData GeometryGenerator::CreateCylinder(float bottomRadius
 	uint32 ringVertexCount = sliceCount+1;
 
 	// Compute indices for each stack.
+	uint32 k = 0;
 	for(uint32 i = 0; i < stackCount; ++i)
 	{
 		for(uint32 j = 0; j < sliceCount; ++j)
 		{
-			meshData.Indices32.push_back(i*ringVertexCount + j);
-			meshData.Indices32.push_back((i+1)*ringVertexCount + j);
-			meshData.Indices32.push_back((i+1)*ringVertexCount + j+1);
+			WriteTriangle(output, k,
+				i*ringVertexCount + j,
+				(i+1)*ringVertexCount + j,
+				(i+1)*ringVertexCount + j+1);
+
+			WriteTriangle(output, k+3,
+				i*ringVertexCount + j,
+				(i+1)*ringVertexCount + j+1,
+				i*ringVertexCount + j+1);
 
-			meshData.Indices32.push_back(i*ringVertexCount + j);
-			meshData.Indices32.push_back((i+1)*ringVertexCount + j+1);
-			meshData.Indices32.push_back(i*ringVertexCount + j+1);
+			k += 6;
 		}
 	}
 
-	BuildCylinderTopCap(bottomRadius, topRadius, height, sliceCount, stackCount, meshData);
-	BuildCylinderBottomCap(bottomRadius, topRadius, height, sliceCount, stackCount, meshData);
-
-    return meshData;
+	// Each cap adds a ring of sliceCount+1 vertices, a center vertex and sliceCount triangles.
+	BuildCylinderTopCap(topRadius, height, sliceCount, vertexCount, k, output);
+	BuildCylinderBottomCap(bottomRadius, height, sliceCount, vertexCount + sliceCount + 2, k + 3*sliceCount, output);
 }
 
-void GeometryGenerator::BuildCylinderTopCap(float bottomRadius, float topRadius, float height,
-											uint32 sliceCount, uint32 stackCount, MeshData& meshData)
+void GeometryGenerator::BuildCylinderTopCap(float topRadius, float height, uint32 sliceCount,
+											uint32 baseVertex, uint32 baseIndex, const MeshOutput& output)
 {
-	uint32 baseIndex = (uint32)meshData.Vertices.size();
-
 	float y = 0.5f*height;
 	float dTheta = 2.0f*XM_PI/sliceCount;
 
@@ -492,31 +620,26 @@ void GeometryGenerator::BuildCylinderTopCap(float bottomRadius, float topRadius,
 		float u = x/height + 0.5f;
 		float v = z/height + 0.5f;
 
-		meshData.Vertices.push_back( Vertex(x, y, z, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, u, v) );
+		WriteVertex(output, baseVertex + i, Vertex(x, y, z, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, u, v) );
 	}
 
-	// Cap center vertex.
-	meshData.Vertices.push_back( Vertex(0.0f, y, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f) );
-
 	// Index of center vertex.
-	uint32 centerIndex = (uint32)meshData.Vertices.size()-1;
+	uint32 centerIndex = baseVertex + sliceCount + 1;
+
+	// Cap center vertex.
+	WriteVertex(output, centerIndex, Vertex(0.0f, y, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f) );
 
 	for(uint32 i = 0; i < sliceCount; ++i)
-	{
-		meshData.Indices32.push_back(centerIndex);
-		meshData.Indices32.push_back(baseIndex + i+1);
-		meshData.Indices32.push_back(baseIndex + i);
-	}
+		WriteTriangle(output, baseIndex + 3*i, centerIndex, baseVertex + i+1, baseVertex + i);
 }
 
-void GeometryGenerator::BuildCylinderBottomCap(float bottomRadius, float topRadius, float height,
-											   uint32 sliceCount, uint32 stackCount, MeshData& meshData)
+void GeometryGenerator::BuildCylinderBottomCap(float bottomRadius, float height, uint32 sliceCount,
+											   uint32 baseVertex, uint32 baseIndex, const MeshOutput& output)
 {
 	// 
 	// Build bottom cap.
 	//
 
-	uint32 baseIndex = (uint32)meshData.Vertices.size();
 	float y = -0.5f*height;
 
 	// vertices of ring
@@ -531,30 +654,29 @@ void GeometryGenerator::BuildCylinderBottomCap(float bottomRadius, float topRadi
 		float u = x/height + 0.5f;
 		float v = z/height + 0.5f;
 
-		meshData.Vertices.push_back( Vertex(x, y, z, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, u, v) );
+		WriteVertex(output, baseVertex + i, Vertex(x, y, z, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, u, v) );
 	}
 
-	// Cap center vertex.
-	meshData.Vertices.push_back( Vertex(0.0f, y, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f) );
-
 	// Cache the index of center vertex.
-	uint32 centerIndex = (uint32)meshData.Vertices.size()-1;
+	uint32 centerIndex = baseVertex + sliceCount + 1;
+
+	// Cap center vertex.
+	WriteVertex(output, centerIndex, Vertex(0.0f, y, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f) );
 
 	for(uint32 i = 0; i < sliceCount; ++i)
-	{
-		meshData.Indices32.push_back(centerIndex);
-		meshData.Indices32.push_back(baseIndex + i);
-		meshData.Indices32.push_back(baseIndex + i+1);
-	}
+		WriteTriangle(output, baseIndex + 3*i, centerIndex, baseVertex + i, baseVertex + i+1);
 }
 
 GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float depth, uint32 m, uint32 n)
 {
     MeshData meshData;
+    CreateGrid(width, depth, m, n, AllocateMeshData(GetGridSize(m, n), meshData));
 
-	uint32 vertexCount = m*n;
-	uint32 faceCount   = (m-1)*(n-1)*2;
+    return meshData;
+}
 
+void GeometryGenerator::CreateGrid(float width, float depth, uint32 m, uint32 n, const MeshOutput& output)
+{
 	//
 	// Create the vertices.
 	//
@@ -568,7 +690,6 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float dep
 	float du = 1.0f / (n-1);
 	float dv = 1.0f / (m-1);
 
-	meshData.Vertices.resize(vertexCount);
 	for(uint32 i = 0; i < m; ++i)
 	{
 		float z = halfDepth - i*dz;
@@ -576,13 +697,12 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float dep
 		{
 			float x = -halfWidth + j*dx;
 
-			meshData.Vertices[i*n+j].Position = XMFLOAT3(x, 0.0f, z);
-			meshData.Vertices[i*n+j].Normal   = XMFLOAT3(0.0f, 1.0f, 0.0f);
-			meshData.Vertices[i*n+j].TangentU = XMFLOAT3(1.0f, 0.0f, 0.0f);
-
 			// Stretch texture over grid.
-			meshData.Vertices[i*n+j].TexC.x = j*du;
-			meshData.Vertices[i*n+j].TexC.y = i*dv;
+			WriteVertex(output, i*n+j, Vertex(
+				x, 0.0f, z,
+				0.0f, 1.0f, 0.0f,
+				1.0f, 0.0f, 0.0f,
+				j*du, i*dv));
 		}
 	}
  
@@ -590,68 +710,494 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float dep
 	// Create the indices.
 	//
 
-	meshData.Indices32.resize(faceCount*3); // 3 indices per face
-
 	// Iterate over each quad and compute indices.
 	uint32 k = 0;
 	for(uint32 i = 0; i < m-1; ++i)
 	{
 		for(uint32 j = 0; j < n-1; ++j)
 		{
-			meshData.Indices32[k]   = i*n+j;
-			meshData.Indices32[k+1] = i*n+j+1;
-			meshData.Indices32[k+2] = (i+1)*n+j;
-
-			meshData.Indices32[k+3] = (i+1)*n+j;
-			meshData.Indices32[k+4] = i*n+j+1;
-			meshData.Indices32[k+5] = (i+1)*n+j+1;
+			WriteTriangle(output, k,   i*n+j, i*n+j+1, (i+1)*n+j);
+			WriteTriangle(output, k+3, (i+1)*n+j, i*n+j+1, (i+1)*n+j+1);
 
 			k += 6; // next quad
 		}
 	}
-
-    return meshData;
 }
 
 GeometryGenerator::MeshData GeometryGenerator::CreateQuad(float x, float y, float w, float h, float depth)
 {
     MeshData meshData;
+    CreateQuad(x, y, w, h, depth, AllocateMeshData(GetQuadSize(), meshData));
 
-	meshData.Vertices.resize(4);
-	meshData.Indices32.resize(6);
+    return meshData;
+}
 
+void GeometryGenerator::CreateQuad(float x, float y, float w, float h, float depth, const MeshOutput& output)
+{
 	// Position coordinates specified in NDC space.
-	meshData.Vertices[0] = Vertex(
+	WriteVertex(output, 0, Vertex(
         x, y - h, depth,
 		0.0f, 0.0f, -1.0f,
 		1.0f, 0.0f, 0.0f,
-		0.0f, 1.0f);
+		0.0f, 1.0f));
 
-	meshData.Vertices[1] = Vertex(
+	WriteVertex(output, 1, Vertex(
 		x, y, depth,
 		0.0f, 0.0f, -1.0f,
 		1.0f, 0.0f, 0.0f,
-		0.0f, 0.0f);
+		0.0f, 0.0f));
 
-	meshData.Vertices[2] = Vertex(
+	WriteVertex(output, 2, Vertex(
 		x+w, y, depth,
 		0.0f, 0.0f, -1.0f,
 		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f);
+		1.0f, 0.0f));
 
-	meshData.Vertices[3] = Vertex(
+	WriteVertex(output, 3, Vertex(
 		x+w, y-h, depth,
 		0.0f, 0.0f, -1.0f,
 		1.0f, 0.0f, 0.0f,
-		1.0f, 1.0f);
+		1.0f, 1.0f));
+
+	WriteTriangle(output, 0, 0, 1, 2);
+	WriteTriangle(output, 3, 0, 2, 3);
+}
+
+void GeometryGenerator::CreateBox(float width, float height, float depth, uint32 numSubdivisions, const MeshOutput& output)
+{
+	float w2 = 0.5f*width;
+	float h2 = 0.5f*height;
+	float d2 = 0.5f*depth;
 
-	meshData.Indices32[0] = 0;
-	meshData.Indices32[1] = 1;
-	meshData.Indices32[2] = 2;
+	// Same corners as the MeshData version: four per face, in the order
+	// front, back, top, bottom, left, right.
+	const Vertex v[24] =
+	{
+		Vertex(-w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f),
+		Vertex(-w2, +h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f),
+		Vertex(+w2, +h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f),
+		Vertex(+w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f),
+
+		Vertex(-w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f),
+		Vertex(+w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f),
+		Vertex(+w2, +h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f),
+		Vertex(-w2, +h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f),
+
+		Vertex(-w2, +h2, -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f),
+		Vertex(-w2, +h2, +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f),
+		Vertex(+w2, +h2, +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f),
+		Vertex(+w2, +h2, -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f),
+
+		Vertex(-w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f),
+		Vertex(+w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f),
+		Vertex(+w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f),
+		Vertex(-w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f),
+
+		Vertex(-w2, -h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f),
+		Vertex(-w2, +h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f),
+		Vertex(-w2, +h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f),
+		Vertex(-w2, -h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f),
+
+		Vertex(+w2, -h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f),
+		Vertex(+w2, +h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f),
+		Vertex(+w2, +h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f),
+		Vertex(+w2, -h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f)
+	};
 
-	meshData.Indices32[3] = 0;
-	meshData.Indices32[4] = 2;
-	meshData.Indices32[5] = 3;
+	// Subdividing the two triangles (v0,v1,v2) and (v0,v2,v3) of a face d times
+	// gives an (N+1)x(N+1) grid of vertices with N = 2^d, split along the
+	// v0-v2 diagonal.  Vertex (a,b) is at v0 + a/N*(v3-v0) + b/N*(v1-v0).
+	uint32 N = 1u << std::min(numSubdivisions, MaxBoxSubdivisions);
+	uint32 faceVertexCount = (N+1)*(N+1);
 
-    return meshData;
+	uint32 k = 0;
+	for(uint32 face = 0; face < 6; ++face)
+	{
+		const Vertex& v0 = v[face*4+0];
+		const Vertex& v1 = v[face*4+1];
+		const Vertex& v3 = v[face*4+3];
+
+		XMVECTOR p0 = XMLoadFloat3(&v0.Position);
+		XMVECTOR t0 = XMLoadFloat2(&v0.TexC);
+		XMVECTOR dpa = (XMLoadFloat3(&v3.Position) - p0) / (float)N;
+		XMVECTOR dpb = (XMLoadFloat3(&v1.Position) - p0) / (float)N;
+		XMVECTOR dta = (XMLoadFloat2(&v3.TexC) - t0) / (float)N;
+		XMVECTOR dtb = (XMLoadFloat2(&v1.TexC) - t0) / (float)N;
+
+		uint32 baseVertex = face*faceVertexCount;
+		for(uint32 b = 0; b <= N; ++b)
+		{
+			for(uint32 a = 0; a <= N; ++a)
+			{
+				Vertex vertex = v0;
+				XMStoreFloat3(&vertex.Position, p0 + (float)a*dpa + (float)b*dpb);
+				XMStoreFloat2(&vertex.TexC, t0 + (float)a*dta + (float)b*dtb);
+
+				WriteVertex(output, baseVertex + b*(N+1) + a, vertex);
+			}
+		}
+
+		for(uint32 b = 0; b < N; ++b)
+		{
+			for(uint32 a = 0; a < N; ++a)
+			{
+				uint32 i00 = baseVertex + b*(N+1) + a;
+				uint32 i10 = i00 + 1;
+				uint32 i01 = i00 + (N+1);
+				uint32 i11 = i01 + 1;
+
+				WriteTriangle(output, k,   i00, i01, i11);
+				WriteTriangle(output, k+3, i00, i11, i10);
+				k += 6;
+			}
+		}
+	}
+}
+
+void GeometryGenerator::CreateGeosphere(float radius, uint32 numSubdivisions, const MeshOutput& output)
+{
+	// Subdividing an icosahedron face d times gives a triangular grid with N = 2^d
+	// segments per edge.  On face (c0,c1,c2) grid point (a,b), a+b <= N, is at
+	// c0 + a/N*(c1-c0) + b/N*(c2-c0).  Points on the 12 corners and 30 edges are
+	// shared between faces, so they are numbered first:
+	//   [0, 12)                          corners
+	//   [12, 12 + 30(N-1))               N-1 points per edge, from its first corner
+	//   [12 + 30(N-1), 10N^2 + 2)        (N-1)(N-2)/2 points inside each face
+	uint32 N = 1u << std::min(numSubdivisions, MaxGeosphereSubdivisions);
+
+	//
+	// Number the edges of the icosahedron.
+	//
+
+	uint32 edges[30][2];
+	uint32 faceEdges[20][3]; // edge of (c0,c1), (c0,c2), (c1,c2)
+	uint32 edgeCount = 0;
+
+	auto findEdge = [&](uint32 i0, uint32 i1)
+	{
+		for(uint32 e = 0; e < edgeCount; ++e)
+		{
+			if((edges[e][0] == i0 && edges[e][1] == i1) || (edges[e][0] == i1 && edges[e][1] == i0))
+				return e;
+		}
+
+		edges[edgeCount][0] = i0;
+		edges[edgeCount][1] = i1;
+		return edgeCount++;
+	};
+
+	for(uint32 f = 0; f < 20; ++f)
+	{
+		const uint32* c = &IcosahedronIndices[f*3];
+		faceEdges[f][0] = findEdge(c[0], c[1]);
+		faceEdges[f][1] = findEdge(c[0], c[2]);
+		faceEdges[f][2] = findEdge(c[1], c[2]);
+	}
+
+	uint32 edgeBase = 12;
+	uint32 interiorBase = edgeBase + 30*(N-1);
+	uint32 interiorPerFace = (N-1)*(N-2)/2;
+
+	// Index of the t-th point (0 < t < N) on the edge from corner `from`.
+	auto edgePoint = [&](uint32 e, uint32 from, uint32 t)
+	{
+		uint32 steps = edges[e][0] == from ? t : N - t;
+		return edgeBase + e*(N-1) + steps - 1;
+	};
+
+	auto gridIndex = [&](uint32 f, uint32 a, uint32 b)
+	{
+		const uint32* c = &IcosahedronIndices[f*3];
+
+		if(b == 0)
+		{
+			if(a == 0) return c[0];
+			if(a == N) return c[1];
+			return edgePoint(faceEdges[f][0], c[0], a);
+		}
+
+		if(a == 0)
+		{
+			if(b == N) return c[2];
+			return edgePoint(faceEdges[f][1], c[0], b);
+		}
+
+		if(a + b == N)
+			return edgePoint(faceEdges[f][2], c[1], b);
+
+		// Interior rows b = 1..N-2 hold N-1-b points each, for a = 1..N-1-b.
+		uint32 rowStart = (b-1)*(N-1) - (b-1)*b/2;
+		return interiorBase + f*interiorPerFace + rowStart + (a-1);
+	};
+
+	//
+	// Vertices.
+	//
+
+	for(uint32 i = 0; i < 12; ++i)
+		WriteVertex(output, i, GeosphereVertex(XMLoadFloat3(&IcosahedronPositions[i]), radius));
+
+	for(uint32 e = 0; e < 30; ++e)
+	{
+		XMVECTOR p0 = XMLoadFloat3(&IcosahedronPositions[edges[e][0]]);
+		XMVECTOR p1 = XMLoadFloat3(&IcosahedronPositions[edges[e][1]]);
+		for(uint32 t = 1; t < N; ++t)
+			WriteVertex(output, edgePoint(e, edges[e][0], t), GeosphereVertex(XMVectorLerp(p0, p1, (float)t/N), radius));
+	}
+
+	for(uint32 f = 0; f < 20; ++f)
+	{
+		const uint32* c = &IcosahedronIndices[f*3];
+		XMVECTOR c0 = XMLoadFloat3(&IcosahedronPositions[c[0]]);
+		XMVECTOR da = (XMLoadFloat3(&IcosahedronPositions[c[1]]) - c0) / (float)N;
+		XMVECTOR db = (XMLoadFloat3(&IcosahedronPositions[c[2]]) - c0) / (float)N;
+
+		for(uint32 b = 1; b + 1 < N; ++b)
+		{
+			for(uint32 a = 1; a + b < N; ++a)
+				WriteVertex(output, gridIndex(f, a, b), GeosphereVertex(c0 + (float)a*da + (float)b*db, radius));
+		}
+	}
+
+	//
+	// Triangles, with the same winding as the face they came from.
+	//
+
+	uint32 k = 0;
+	for(uint32 f = 0; f < 20; ++f)
+	{
+		for(uint32 b = 0; b < N; ++b)
+		{
+			for(uint32 a = 0; a + b < N; ++a)
+			{
+				WriteTriangle(output, k, gridIndex(f, a, b), gridIndex(f, a+1, b), gridIndex(f, a, b+1));
+				k += 3;
+
+				if(a + b + 1 < N)
+				{
+					WriteTriangle(output, k, gridIndex(f, a+1, b), gridIndex(f, a+1, b+1), gridIndex(f, a, b+1));
+					k += 3;
+				}
+			}
+		}
+	}
+}
+
+GeometryGenerator::MeshSize GeometryGenerator::GetGridTilesSize(uint32 m, uint32 n, uint32 tileQuads)
+{
+	GridTiling tiling(m, n, tileQuads);
+
+	// Every tile row repeats the vertex row it shares with the next one, and the
+	// same for columns.
+	MeshSize size;
+	size.VertexCount = (tiling.QuadRows + tiling.TileRows) * (tiling.QuadColumns + tiling.TileColumns);
+	size.IndexCount = 6*tiling.QuadRows*tiling.QuadColumns;
+	return size;
+}
+
+std::vector<GeometryGenerator::GridTile> GeometryGenerator::CreateGridTiles(
+	float width, float depth, uint32 m, uint32 n, uint32 tileQuads,
+	const MeshOutput& output, const std::function<float(float, float)>& heightFunc, uint32 numThreads)
+{
+	GridTiling tiling(m, n, tileQuads);
+
+	//
+	// Lay out the tiles one after the other in the output.
+	//
+
+	std::vector<GridTile> tiles(tiling.TileRows * tiling.TileColumns);
+
+	uint32 firstVertex = 0;
+	uint32 firstIndex = 0;
+	for(uint32 tz = 0; tz < tiling.TileRows; ++tz)
+	{
+		for(uint32 tx = 0; tx < tiling.TileColumns; ++tx)
+		{
+			uint32 quadRows = tiling.TileQuadRows(tz);
+			uint32 quadColumns = tiling.TileQuadColumns(tx);
+
+			GridTile& tile = tiles[tz*tiling.TileColumns + tx];
+			tile.FirstVertex = firstVertex;
+			tile.VertexCount = (quadRows+1)*(quadColumns+1);
+			tile.FirstIndex = firstIndex;
+			tile.IndexCount = 6*quadRows*quadColumns;
+
+			firstVertex += tile.VertexCount;
+			firstIndex += tile.IndexCount;
+		}
+	}
+
+	//
+	// Fill them in parallel.  Same positions and texture coordinates as CreateGrid.
+	//
+
+	float halfWidth = 0.5f*width;
+	float halfDepth = 0.5f*depth;
+
+	float dx = width / (n-1);
+	float dz = depth / (m-1);
+
+	float du = 1.0f / (n-1);
+	float dv = 1.0f / (m-1);
+
+	numThreads = ResolveThreadCount(numThreads);
+
+	// Heights of a tile plus a one vertex border, for the normals.
+	std::vector<std::vector<float>> heightScratch(numThreads);
+
+	ParallelFor(tiles.size(), numThreads, [&](unsigned threadIndex, size_t t)
+	{
+		GridTile& tile = tiles[t];
+
+		uint32 tz = (uint32)t / tiling.TileColumns;
+		uint32 tx = (uint32)t % tiling.TileColumns;
+		uint32 row0 = tz*tiling.TileQuads;
+		uint32 col0 = tx*tiling.TileQuads;
+		uint32 rows = tiling.TileQuadRows(tz) + 1;
+		uint32 cols = tiling.TileQuadColumns(tx) + 1;
+
+		std::vector<float>& heights = heightScratch[threadIndex];
+		uint32 pitch = cols + 2;
+		if(heightFunc)
+		{
+			heights.resize((rows+2)*pitch);
+			for(uint32 i = 0; i < rows+2; ++i)
+			{
+				float z = halfDepth - ((float)row0 + i - 1.0f)*dz;
+				for(uint32 j = 0; j < cols+2; ++j)
+					heights[i*pitch + j] = heightFunc(-halfWidth + ((float)col0 + j - 1.0f)*dx, z);
+			}
+		}
+
+		MeshOutput tileOutput = output;
+		tileOutput.BaseVertex = 0;
+		if(tileOutput.Indices16)
+			tileOutput.Indices16 += tile.FirstIndex;
+		else
+			tileOutput.Indices32 += tile.FirstIndex;
+
+		XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+		XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+
+		for(uint32 i = 0; i < rows; ++i)
+		{
+			float z = halfDepth - (row0 + i)*dz;
+			for(uint32 j = 0; j < cols; ++j)
+			{
+				float x = -halfWidth + (col0 + j)*dx;
+
+				Vertex v(
+					x, 0.0f, z,
+					0.0f, 1.0f, 0.0f,
+					1.0f, 0.0f, 0.0f,
+					(col0 + j)*du, (row0 + i)*dv);
+
+				if(heightFunc)
+				{
+					const float* h = &heights[(i+1)*pitch + (j+1)];
+					v.Position.y = h[0];
+
+					// Central differences.  Rows go towards -z.
+					float dhdx = (h[1] - h[-1]) / (2.0f*dx);
+					float dhdz = (h[-(int)pitch] - h[pitch]) / (2.0f*dz);
+
+					XMStoreFloat3(&v.Normal, XMVector3Normalize(XMVectorSet(-dhdx, 1.0f, -dhdz, 0.0f)));
+					XMStoreFloat3(&v.TangentU, XMVector3Normalize(XMVectorSet(1.0f, dhdx, 0.0f, 0.0f)));
+				}
+
+				XMVECTOR p = XMLoadFloat3(&v.Position);
+				vMin = XMVectorMin(vMin, p);
+				vMax = XMVectorMax(vMax, p);
+
+				WriteVertex(output, tile.FirstVertex + i*cols + j, v);
+			}
+		}
+
+		BoundingBox::CreateFromPoints(tile.Bounds, vMin, vMax);
+
+		uint32 k = 0;
+		for(uint32 i = 0; i < rows-1; ++i)
+		{
+			for(uint32 j = 0; j < cols-1; ++j)
+			{
+				WriteTriangle(tileOutput, k,   i*cols+j, i*cols+j+1, (i+1)*cols+j);
+				WriteTriangle(tileOutput, k+3, (i+1)*cols+j, i*cols+j+1, (i+1)*cols+j+1);
+
+				k += 6; // next quad
+			}
+		}
+	});
+
+	return tiles;
+}
+
+GeometryGenerator::MeshSize GeometryGenerator::GetBoxSize(uint32 numSubdivisions)
+{
+	uint32 N = 1u << std::min(numSubdivisions, MaxBoxSubdivisions);
+
+	MeshSize size;
+	size.VertexCount = 6*(N+1)*(N+1);
+	size.IndexCount = 6*6*N*N;
+	return size;
+}
+
+GeometryGenerator::MeshSize GeometryGenerator::GetSphereSize(uint32 sliceCount, uint32 stackCount)
+{
+	MeshSize size;
+	size.VertexCount = 2 + (stackCount-1)*(sliceCount+1);
+	size.IndexCount = 6*sliceCount*(stackCount-1);
+	return size;
+}
+
+GeometryGenerator::MeshSize GeometryGenerator::GetGeosphereSize(uint32 numSubdivisions)
+{
+	uint32 N = 1u << std::min(numSubdivisions, MaxGeosphereSubdivisions);
+
+	MeshSize size;
+	size.VertexCount = 10*N*N + 2;
+	size.IndexCount = 20*3*N*N;
+	return size;
+}
+
+GeometryGenerator::MeshSize GeometryGenerator::GetCylinderSize(uint32 sliceCount, uint32 stackCount)
+{
+	MeshSize size;
+	size.VertexCount = (stackCount+1)*(sliceCount+1) + 2*(sliceCount+2);
+	size.IndexCount = 6*sliceCount*stackCount + 2*3*sliceCount;
+	return size;
+}
+
+GeometryGenerator::MeshSize GeometryGenerator::GetGridSize(uint32 m, uint32 n)
+{
+	MeshSize size;
+	size.VertexCount = m*n;
+	size.IndexCount = (m-1)*(n-1)*6;
+	return size;
+}
+
+GeometryGenerator::MeshSize GeometryGenerator::GetQuadSize()
+{
+	MeshSize size;
+	size.VertexCount = 4;
+	size.IndexCount = 6;
+	return size;
+}
+
+GeometryGenerator::MeshOutput GeometryGenerator::AllocateMeshData(const MeshSize& size, MeshData& meshData)
+{
+	meshData.Vertices.resize(size.VertexCount);
+	meshData.Indices32.resize(size.IndexCount);
+
+	MeshOutput output;
+	if(size.VertexCount > 0)
+	{
+		output.Positions = &meshData.Vertices[0].Position;
+		output.Normals = &meshData.Vertices[0].Normal;
+		output.TangentU = &meshData.Vertices[0].TangentU;
+		output.TexC = &meshData.Vertices[0].TexC;
+	}
+	output.VertexStride = sizeof(Vertex);
+	output.Indices32 = meshData.Indices32.data();
+
+	return output;
 }
@@ -16,6 +16,9 @@
 
 #include <cstdint>
 #include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <functional>
+#include <unordered_map>
 #include <vector>
 
 class GeometryGenerator
@@ -76,6 +79,50 @@ public:
 		std::vector<uint16> mIndices16;
 	};
 
+	// Number of vertices and indices a Create* call will write, so the caller can
+	// size its buffers before generating the mesh.
+	struct MeshSize
+	{
+		uint32 VertexCount = 0;
+		uint32 IndexCount = 0;
+	};
+
+	// Caller-owned memory to generate a mesh into, e.g. a mapped upload buffer.
+	// Vertex attribute i is written to (char*)Attribute + i*VertexStride, so the
+	// pointers can point at the members of the first vertex of any vertex struct.
+	// Attributes with a null pointer are not written.  Exactly one of Indices16 and
+	// Indices32 should be set; BaseVertex is added to every index so several meshes
+	// can share one vertex buffer.  Nothing is read back from the output, so it is
+	// fine for it to be write-combined memory.
+	struct MeshOutput
+	{
+		DirectX::XMFLOAT3* Positions = nullptr;
+		DirectX::XMFLOAT3* Normals = nullptr;
+		DirectX::XMFLOAT3* TangentU = nullptr;
+		DirectX::XMFLOAT2* TexC = nullptr;
+		size_t VertexStride = sizeof(Vertex);
+
+		uint16* Indices16 = nullptr;
+		uint32* Indices32 = nullptr;
+		uint32 BaseVertex = 0;
+	};
+
+	// One tile of a grid built by CreateGridTiles.  Tile indices are relative to
+	// FirstVertex, so draw a tile with BaseVertexLocation = FirstVertex and
+	// StartIndexLocation = FirstIndex.
+	struct GridTile
+	{
+		uint32 FirstVertex = 0;
+		uint32 VertexCount = 0;
+		uint32 FirstIndex = 0;
+		uint32 IndexCount = 0;
+
+		DirectX::BoundingBox Bounds;
+	};
+
+	// Tiles have at most (MaxGridTileQuads+1)^2 vertices, so 16-bit indices always fit.
+	static const uint32 MaxGridTileQuads = 255;
+
 	///<summary>
 	/// Creates a box centered at the origin with the given dimensions, where each
     /// face has m rows and n columns of vertices.
@@ -90,7 +137,8 @@ public:
 
 	///<summary>
 	/// Creates a geosphere centered at the origin with the given radius.  The
-	/// depth controls the level of tessellation.
+	/// depth controls the level of tessellation.  Vertices are shared between
+	/// adjacent triangles, so a geosphere of depth d has 10*4^d+2 vertices.
 	///</summary>
     MeshData CreateGeosphere(float radius, uint32 numSubdivisions);
 
@@ -112,10 +160,53 @@ public:
 	///</summary>
     MeshData CreateQuad(float x, float y, float w, float h, float depth);
 
+	///<summary>
+	/// Sizes of the meshes the Create* functions generate for the same arguments.
+	///</summary>
+    MeshSize GetBoxSize(uint32 numSubdivisions);
+    MeshSize GetSphereSize(uint32 sliceCount, uint32 stackCount);
+    MeshSize GetGeosphereSize(uint32 numSubdivisions);
+    MeshSize GetCylinderSize(uint32 sliceCount, uint32 stackCount);
+    MeshSize GetGridSize(uint32 m, uint32 n);
+    MeshSize GetQuadSize();
+
+	///<summary>
+	/// Same meshes as above, written to caller-owned memory without allocating.
+	/// The output must have room for the matching Get*Size().  Spheres, cylinders,
+	/// grids and quads come out exactly as in MeshData; boxes and geospheres have
+	/// the same vertices and triangles in a different order, since they are built
+	/// one face grid at a time instead of by repeated subdivision.
+	///</summary>
+    void CreateBox(float width, float height, float depth, uint32 numSubdivisions, const MeshOutput& output);
+    void CreateSphere(float radius, uint32 sliceCount, uint32 stackCount, const MeshOutput& output);
+    void CreateGeosphere(float radius, uint32 numSubdivisions, const MeshOutput& output);
+    void CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, const MeshOutput& output);
+    void CreateGrid(float width, float depth, uint32 m, uint32 n, const MeshOutput& output);
+    void CreateQuad(float x, float y, float w, float h, float depth, const MeshOutput& output);
+
+	///<summary>
+	/// Creates the same mxn grid as CreateGrid, cut into tiles of at most
+	/// tileQuads x tileQuads quads.  Vertices on tile borders are duplicated so each
+	/// tile is an independent, 16-bit indexable vertex range with its own bounds,
+	/// which lets very large terrains (8k x 8k samples) be built and frustum culled
+	/// per tile.  heightFunc, if given, sets the y coordinate of every vertex (e.g.
+	/// an app's GetHillsHeight) and the normals and tangents then follow the surface.
+	/// Tiles are filled in parallel on numThreads threads (0 = all hardware threads).
+	/// The output must have room for GetGridTilesSize().
+	///</summary>
+    MeshSize GetGridTilesSize(uint32 m, uint32 n, uint32 tileQuads);
+    std::vector<GridTile> CreateGridTiles(float width, float depth, uint32 m, uint32 n, uint32 tileQuads,
+        const MeshOutput& output, const std::function<float(float, float)>& heightFunc = nullptr,
+        uint32 numThreads = 0);
+
 private:
 	void Subdivide(MeshData& meshData);
+    uint32 GetMidPointIndex(uint32 i0, uint32 i1, std::unordered_map<std::uint64_t, uint32>& midPointCache, MeshData& meshData);
     Vertex MidPoint(const Vertex& v0, const Vertex& v1);
-    void BuildCylinderTopCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, MeshData& meshData);
-    void BuildCylinderBottomCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, MeshData& meshData);
+    void BuildCylinderTopCap(float topRadius, float height, uint32 sliceCount,
+        uint32 baseVertex, uint32 baseIndex, const MeshOutput& output);
+    void BuildCylinderBottomCap(float bottomRadius, float height, uint32 sliceCount,
+        uint32 baseVertex, uint32 baseIndex, const MeshOutput& output);
+    MeshOutput AllocateMeshData(const MeshSize& size, MeshData& meshData);
 };
 
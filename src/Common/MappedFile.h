@@ -0,0 +1,162 @@
+//***************************************************************************************
+// MappedFile.h
+//
+// Read-only memory mapping of a whole file.  The loaders parse or use the mapped
+// bytes in place instead of copying the file through a stream first.  Uses
+// CreateFileMapping on Windows and mmap elsewhere, so tools built from the same
+// loaders run on either.
+//***************************************************************************************
+
+#pragma once
+
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class MappedFile
+{
+public:
+	MappedFile() = default;
+
+	explicit MappedFile(const std::string& filename)
+	{
+		Open(filename);
+	}
+
+	MappedFile(const MappedFile& rhs) = delete;
+	MappedFile& operator=(const MappedFile& rhs) = delete;
+
+	~MappedFile()
+	{
+		Close();
+	}
+
+	///<summary>
+	/// Maps filename.  Returns false if the file can't be opened or is empty.
+	///</summary>
+	bool Open(const std::string& filename)
+	{
+		Close();
+
+#ifdef _WIN32
+		mFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+#else
+		mFile = open(filename.c_str(), O_RDONLY);
+#endif
+		return MapOpenFile();
+	}
+
+	bool Open(const std::wstring& filename)
+	{
+#ifdef _WIN32
+		Close();
+
+		mFile = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		return MapOpenFile();
+#else
+		// The demos' paths are ASCII.
+		return Open(std::string(filename.begin(), filename.end()));
+#endif
+	}
+
+	void Close()
+	{
+#ifdef _WIN32
+		if(mData != nullptr)
+			UnmapViewOfFile(mData);
+		if(mMapping != nullptr)
+			CloseHandle(mMapping);
+		if(mFile != INVALID_HANDLE_VALUE)
+			CloseHandle(mFile);
+
+		mFile = INVALID_HANDLE_VALUE;
+		mMapping = nullptr;
+#else
+		if(mData != nullptr)
+			munmap(const_cast<char*>(mData), mSize);
+		if(mFile >= 0)
+			close(mFile);
+
+		mFile = -1;
+#endif
+		mData = nullptr;
+		mSize = 0;
+	}
+
+	bool IsOpen()const { return mData != nullptr; }
+
+	// The view starts on a page boundary, so data at aligned offsets in the file is
+	// aligned in memory too.
+	const char* Begin()const { return mData; }
+	const char* End()const { return mData + mSize; }
+	size_t Size()const { return mSize; }
+
+private:
+	// Maps mFile, which Open just set.
+	bool MapOpenFile()
+	{
+#ifdef _WIN32
+		if(mFile == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if(!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+		{
+			Close();
+			return false;
+		}
+
+		mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(mMapping != nullptr)
+			mData = static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+
+		if(mData == nullptr)
+		{
+			Close();
+			return false;
+		}
+
+		mSize = (size_t)size.QuadPart;
+		return true;
+#else
+		if(mFile < 0)
+			return false;
+
+		struct stat info;
+		if(fstat(mFile, &info) != 0 || info.st_size == 0)
+		{
+			Close();
+			return false;
+		}
+
+		void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, mFile, 0);
+		if(data == MAP_FAILED)
+		{
+			Close();
+			return false;
+		}
+
+		mData = static_cast<const char*>(data);
+		mSize = (size_t)info.st_size;
+		return true;
+#endif
+	}
+
+#ifdef _WIN32
+	HANDLE mFile = INVALID_HANDLE_VALUE;
+	HANDLE mMapping = nullptr;
+#else
+	int mFile = -1;
+#endif
+	const char* mData = nullptr;
+	size_t mSize = 0;
+};
@@ -0,0 +1,325 @@
+//***************************************************************************************
+// MeshOptimizer.cpp
+//***************************************************************************************
+
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+
+using uint32 = MeshOptimizer::uint32;
+
+namespace
+{
+	// Tuning constants from Tom Forsyth, "Linear-Speed Vertex Cache Optimisation".
+	const float CacheDecayPower   = 1.5f;
+	const float LastTriScore      = 0.75f;
+	const float ValenceBoostScale = 2.0f;
+	const float ValenceBoostPower = 0.5f;
+
+	const uint32 InvalidIndex = 0xffffffff;
+
+	const uint32 MaxValenceScore = 32;
+
+	// The smallest post-transform cache the reordering must not make worse.
+	const uint32 SmallCacheSize = 16;
+
+	// Vertex scores only depend on the cache position and the number of remaining
+	// triangles, so both terms are looked up instead of calling powf per vertex.
+	struct VertexScoreTable
+	{
+		VertexScoreTable(uint32 cacheSize)
+		{
+			CacheScore.resize(cacheSize);
+			for(uint32 i = 0; i < cacheSize; ++i)
+			{
+				if(i < 3)
+				{
+					// The vertex was used by the last triangle.  Give it a fixed score
+					// so the next triangle doesn't simply reuse the same edge forever.
+					CacheScore[i] = LastTriScore;
+				}
+				else
+				{
+					// Points for being high in the cache, falling off with age.
+					float scaler = 1.0f / (cacheSize - 3);
+					CacheScore[i] = powf(1.0f - (i - 3)*scaler, CacheDecayPower);
+				}
+			}
+
+			// Bonus for vertices with few triangles left, so we finish them off
+			// instead of leaving lone triangles behind that cost a full miss later.
+			ValenceScore.resize(MaxValenceScore + 1);
+			ValenceScore[0] = 0.0f;
+			for(uint32 i = 1; i <= MaxValenceScore; ++i)
+				ValenceScore[i] = ValenceBoostScale * powf((float)i, -ValenceBoostPower);
+		}
+
+		float Score(int cachePosition, uint32 remainingTris)const
+		{
+			// No triangle left to draw, so it doesn't matter where this vertex is.
+			if(remainingTris == 0)
+				return -1.0f;
+
+			float score = cachePosition >= 0 ? CacheScore[cachePosition] : 0.0f;
+			return score + ValenceScore[std::min(remainingTris, MaxValenceScore)];
+		}
+
+		std::vector<float> CacheScore;
+		std::vector<float> ValenceScore;
+	};
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::AnalyzeVertexCache(
+	const uint32* indices, size_t indexCount, size_t vertexCount,
+	uint32 cacheSize, CacheType cacheType)
+{
+	CacheStats stats;
+	stats.TriangleCount = (uint32)(indexCount / 3);
+
+	std::vector<bool> referenced(vertexCount, false);
+
+	if(cacheType == CacheType::Fifo)
+	{
+		// A vertex is in a FIFO cache if fewer than cacheSize misses happened
+		// since it was last loaded, so a timestamp per vertex is all we need.
+		std::vector<uint32> loadTime(vertexCount, 0);
+		uint32 time = cacheSize + 1;
+
+		for(size_t i = 0; i < indexCount; ++i)
+		{
+			uint32 v = indices[i];
+			referenced[v] = true;
+
+			if(time - loadTime[v] > cacheSize)
+			{
+				loadTime[v] = time++;
+				stats.Misses++;
+			}
+		}
+	}
+	else
+	{
+		// Most recently used vertex first.
+		std::vector<uint32> cache;
+		cache.reserve(cacheSize + 1);
+
+		for(size_t i = 0; i < indexCount; ++i)
+		{
+			uint32 v = indices[i];
+			referenced[v] = true;
+
+			auto it = std::find(cache.begin(), cache.end(), v);
+			if(it == cache.end())
+			{
+				stats.Misses++;
+				cache.insert(cache.begin(), v);
+				if(cache.size() > cacheSize)
+					cache.pop_back();
+			}
+			else
+			{
+				std::rotate(cache.begin(), it, it + 1);
+			}
+		}
+	}
+
+	stats.VertexCount = (uint32)std::count(referenced.begin(), referenced.end(), true);
+
+	if(stats.TriangleCount > 0)
+		stats.Acmr = (float)stats.Misses / stats.TriangleCount;
+	if(stats.VertexCount > 0)
+		stats.Atvr = (float)stats.Misses / stats.VertexCount;
+
+	return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32* indices, size_t indexCount, size_t vertexCount, uint32 cacheSize)
+{
+	uint32 triCount = (uint32)(indexCount / 3);
+	if(triCount == 0)
+		return;
+
+	cacheSize = std::max<uint32>(cacheSize, 4u);
+
+	//
+	// Build vertex to triangle adjacency.  Triangles of vertex v live in
+	// adjTris[adjOffset[v], adjOffset[v] + remainingTris[v]).
+	//
+
+	std::vector<uint32> remainingTris(vertexCount, 0);
+	for(size_t i = 0; i < indexCount; ++i)
+		remainingTris[indices[i]]++;
+
+	std::vector<uint32> adjOffset(vertexCount + 1, 0);
+	for(size_t v = 0; v < vertexCount; ++v)
+		adjOffset[v+1] = adjOffset[v] + remainingTris[v];
+
+	std::vector<uint32> adjTris(indexCount);
+	std::vector<uint32> fill(adjOffset.begin(), adjOffset.end() - 1);
+	for(uint32 t = 0; t < triCount; ++t)
+	{
+		for(uint32 k = 0; k < 3; ++k)
+		{
+			uint32 v = indices[t*3+k];
+			adjTris[fill[v]++] = t;
+		}
+	}
+
+	//
+	// Initial scores.
+	//
+
+	VertexScoreTable scoreTable(cacheSize);
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for(size_t v = 0; v < vertexCount; ++v)
+		vertexScore[v] = scoreTable.Score(-1, remainingTris[v]);
+
+	std::vector<bool> triAdded(triCount, false);
+
+	uint32 bestTri = 0;
+	float bestScore = -1.0f;
+	for(uint32 t = 0; t < triCount; ++t)
+	{
+		float score = vertexScore[indices[t*3+0]] + vertexScore[indices[t*3+1]] + vertexScore[indices[t*3+2]];
+		if(score > bestScore)
+		{
+			bestScore = score;
+			bestTri = t;
+		}
+	}
+
+	// The simulated cache holds three extra entries so the vertices just pushed
+	// out of the real cache get their scores lowered.
+	std::vector<uint32> cache;
+	std::vector<uint32> newCache;
+	cache.reserve(cacheSize + 3);
+	newCache.reserve(cacheSize + 6);
+
+	std::vector<uint32> output(triCount*3);
+	uint32 nextUnaddedTri = 0;
+
+	for(uint32 outTri = 0; outTri < triCount; ++outTri)
+	{
+		if(bestTri == InvalidIndex)
+		{
+			// Nothing in the cache touches a remaining triangle; continue with
+			// the next unused triangle in input order.
+			while(triAdded[nextUnaddedTri])
+				++nextUnaddedTri;
+			bestTri = nextUnaddedTri;
+		}
+
+		triAdded[bestTri] = true;
+
+		const uint32* tri = &indices[bestTri*3];
+		output[outTri*3+0] = tri[0];
+		output[outTri*3+1] = tri[1];
+		output[outTri*3+2] = tri[2];
+
+		// Remove the triangle from the adjacency of its vertices.
+		for(uint32 k = 0; k < 3; ++k)
+		{
+			uint32 v = tri[k];
+			uint32* begin = &adjTris[adjOffset[v]];
+			uint32* end = begin + remainingTris[v];
+			uint32* it = std::find(begin, end, bestTri);
+			*it = *(end - 1);
+			remainingTris[v]--;
+		}
+
+		// The triangle's vertices go to the front of the cache, everything else
+		// shifts back.
+		newCache.clear();
+		newCache.push_back(tri[0]);
+		if(tri[1] != tri[0])
+			newCache.push_back(tri[1]);
+		if(tri[2] != tri[0] && tri[2] != tri[1])
+			newCache.push_back(tri[2]);
+
+		for(uint32 v : cache)
+		{
+			if(v != tri[0] && v != tri[1] && v != tri[2])
+				newCache.push_back(v);
+		}
+
+		for(size_t i = cacheSize + 3; i < newCache.size(); ++i)
+		{
+			cachePosition[newCache[i]] = -1;
+			vertexScore[newCache[i]] = scoreTable.Score(-1, remainingTris[newCache[i]]);
+		}
+
+		if(newCache.size() > cacheSize + 3)
+			newCache.resize(cacheSize + 3);
+		cache.swap(newCache);
+
+		for(size_t i = 0; i < cache.size(); ++i)
+		{
+			uint32 v = cache[i];
+			cachePosition[v] = i < cacheSize ? (int)i : -1;
+			vertexScore[v] = scoreTable.Score(cachePosition[v], remainingTris[v]);
+		}
+
+		// The next triangle is the best one touching the cache.
+		bestTri = InvalidIndex;
+		bestScore = -1.0f;
+		for(uint32 v : cache)
+		{
+			for(uint32 a = adjOffset[v]; a < adjOffset[v] + remainingTris[v]; ++a)
+			{
+				uint32 t = adjTris[a];
+				float score = vertexScore[indices[t*3+0]] + vertexScore[indices[t*3+1]] + vertexScore[indices[t*3+2]];
+				if(score > bestScore)
+				{
+					bestScore = score;
+					bestTri = t;
+				}
+			}
+		}
+	}
+
+	// The scoring is a heuristic tuned for one cache size.  Scanned models often
+	// come in an order that is already near the best a small cache allows, and
+	// then the new order can miss more there, so keep the input unless the new
+	// order misses no more at both sizes (FIFO and LRU misses added up).
+	for(uint32 size : { SmallCacheSize, cacheSize })
+	{
+		uint32 before = 0;
+		uint32 after = 0;
+		for(CacheType type : { CacheType::Fifo, CacheType::Lru })
+		{
+			before += AnalyzeVertexCache(indices, indexCount, vertexCount, size, type).Misses;
+			after += AnalyzeVertexCache(output.data(), output.size(), vertexCount, size, type).Misses;
+		}
+
+		if(after > before)
+			return;
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+std::vector<uint32> MeshOptimizer::OptimizeVertexFetchRemap(uint32* indices, size_t indexCount, size_t vertexCount)
+{
+	std::vector<uint32> remap(vertexCount, InvalidIndex);
+
+	uint32 nextVertex = 0;
+	for(size_t i = 0; i < indexCount; ++i)
+	{
+		uint32 v = indices[i];
+		if(remap[v] == InvalidIndex)
+			remap[v] = nextVertex++;
+
+		indices[i] = remap[v];
+	}
+
+	// Keep unreferenced vertices so the vertex count doesn't change.
+	for(size_t v = 0; v < vertexCount; ++v)
+	{
+		if(remap[v] == InvalidIndex)
+			remap[v] = nextVertex++;
+	}
+
+	return remap;
+}
@@ -0,0 +1,104 @@
+//***************************************************************************************
+// MeshOptimizer.h
+//
+// CPU passes that reorder an indexed triangle list for the GPU without changing
+// what is drawn:
+//   -OptimizeVertexCache reorders triangles so vertices are reused while they are
+//    still in the post-transform cache (Forsyth's linear-speed algorithm).
+//   -OptimizeVertexFetch renumbers vertices in the order the index buffer first
+//    references them, so vertex fetches walk memory forward.
+//   -AnalyzeVertexCache simulates a FIFO or LRU post-transform cache and reports
+//    ACMR (misses per triangle) and ATVR (misses per referenced vertex).
+//
+// Run the cache pass first and the fetch pass second.  Both work on 32-bit indices;
+// convert 16-bit index buffers before and after.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "GeometryGenerator.h"
+
+class MeshOptimizer
+{
+public:
+
+	using uint32 = std::uint32_t;
+
+	enum class CacheType
+	{
+		Fifo,
+		Lru
+	};
+
+	struct CacheStats
+	{
+		uint32 TriangleCount = 0;
+		uint32 VertexCount = 0;  // distinct vertices referenced by the index buffer
+		uint32 Misses = 0;       // vertex shader invocations
+
+		// Average cache miss ratio: Misses / TriangleCount.  0.5 is the best
+		// possible for a large regular grid, 3.0 means no reuse at all.
+		float Acmr = 0.0f;
+
+		// Average transform to vertex ratio: Misses / VertexCount.  1.0 is perfect.
+		float Atvr = 0.0f;
+	};
+
+	///<summary>
+	/// Simulates drawing the triangle list through a post-transform cache of the
+	/// given size and replacement policy and counts the cache misses.
+	///</summary>
+	static CacheStats AnalyzeVertexCache(const uint32* indices, size_t indexCount, size_t vertexCount,
+		uint32 cacheSize, CacheType cacheType);
+
+	///<summary>
+	/// Reorders the triangles in indices (in place) to improve post-transform cache
+	/// reuse.  cacheSize is the cache size the scoring is tuned for; 32 is a good
+	/// default for current hardware.  The new order is only kept if, in caches of
+	/// 16 and of cacheSize entries, it misses no more than the input order (FIFO
+	/// and LRU misses added up); otherwise indices are left as they are.
+	///</summary>
+	static void OptimizeVertexCache(uint32* indices, size_t indexCount, size_t vertexCount, uint32 cacheSize = 32);
+
+	///<summary>
+	/// Computes the vertex renumbering that puts vertices in first-use order and
+	/// rewrites indices (in place) to use it.  remap[oldIndex] = newIndex.  Vertices
+	/// the index buffer never references are moved to the end.
+	///</summary>
+	static std::vector<uint32> OptimizeVertexFetchRemap(uint32* indices, size_t indexCount, size_t vertexCount);
+
+	///<summary>
+	/// Moves every vertex to the slot given by a remap from OptimizeVertexFetchRemap.
+	///</summary>
+	template<typename VertexT>
+	static void RemapVertices(std::vector<VertexT>& vertices, const std::vector<uint32>& remap)
+	{
+		std::vector<VertexT> remapped(vertices.size());
+		for(size_t i = 0; i < vertices.size(); ++i)
+			remapped[remap[i]] = vertices[i];
+
+		vertices.swap(remapped);
+	}
+
+	///<summary>
+	/// Reorders the indices of a vertex/index array pair for the post-transform cache
+	/// and then the vertices for fetch.  Works with any vertex struct.
+	///</summary>
+	template<typename VertexT>
+	static void OptimizeMesh(std::vector<VertexT>& vertices, std::vector<uint32>& indices, uint32 cacheSize = 32)
+	{
+		OptimizeVertexCache(indices.data(), indices.size(), vertices.size(), cacheSize);
+		RemapVertices(vertices, OptimizeVertexFetchRemap(indices.data(), indices.size(), vertices.size()));
+	}
+
+	///<summary>
+	/// Same as above for a GeometryGenerator mesh.  Call before GetIndices16(),
+	/// which caches its copy of the indices the first time it is called.
+	///</summary>
+	static void OptimizeMesh(GeometryGenerator::MeshData& meshData, uint32 cacheSize = 32)
+	{
+		OptimizeMesh(meshData.Vertices, meshData.Indices32, cacheSize);
+	}
+};
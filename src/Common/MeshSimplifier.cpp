@@ -0,0 +1,877 @@
+//***************************************************************************************
+// MeshSimplifier.cpp
+//***************************************************************************************
+
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace DirectX;
+
+namespace
+{
+	using uint32 = MeshSimplifier::uint32;
+
+	// How much a collapse across a crease costs compared to moving the surface.
+	// The penalty is NormalWeight * (1 - dot(n0, n1)) * edgeLength^2.
+	const double NormalWeight = 0.5;
+
+	const uint32 NoVertex = ~0u;
+
+	enum class VertexKind : std::uint8_t
+	{
+		Interior, // may collapse onto any neighbor
+		Border,   // on an open boundary; may only collapse along it
+		Seam,     // shares its position with other copies; they collapse together
+		Locked    // a seam vertex on a border; never moves
+	};
+
+	// Symmetric 4x4 matrix of the plane quadric sum(w*(n.p + d)^2), plus the
+	// total weight so the error can be reported as a distance.
+	struct Quadric
+	{
+		double a2 = 0, ab = 0, ac = 0, ad = 0;
+		double b2 = 0, bc = 0, bd = 0;
+		double c2 = 0, cd = 0;
+		double d2 = 0;
+		double w = 0;
+
+		static Quadric FromPlane(double a, double b, double c, double d, double weight)
+		{
+			Quadric q;
+			q.a2 = weight*a*a; q.ab = weight*a*b; q.ac = weight*a*c; q.ad = weight*a*d;
+			q.b2 = weight*b*b; q.bc = weight*b*c; q.bd = weight*b*d;
+			q.c2 = weight*c*c; q.cd = weight*c*d;
+			q.d2 = weight*d*d;
+			q.w = weight;
+			return q;
+		}
+
+		void Add(const Quadric& q)
+		{
+			a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+			b2 += q.b2; bc += q.bc; bd += q.bd;
+			c2 += q.c2; cd += q.cd;
+			d2 += q.d2;
+			w += q.w;
+		}
+
+		// Weighted mean squared distance from p to the planes.
+		double Error(const XMFLOAT3& p)const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			double e =
+				a2*x*x + 2*ab*x*y + 2*ac*x*z + 2*ad*x +
+				b2*y*y + 2*bc*y*z + 2*bd*y +
+				c2*z*z + 2*cd*z +
+				d2;
+
+			return w > 0.0 ? std::max(e, 0.0) / w : 0.0;
+		}
+	};
+
+	struct Collapse
+	{
+		uint32 From;
+		uint32 To;
+		double Cost;  // what the collapses are sorted by
+		double Error; // squared distance part of Cost
+	};
+
+	XMVECTOR TriangleNormal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2)
+	{
+		XMVECTOR a = XMLoadFloat3(&p0);
+		XMVECTOR b = XMLoadFloat3(&p1);
+		XMVECTOR c = XMLoadFloat3(&p2);
+		return XMVector3Cross(b - a, c - a);
+	}
+
+	std::uint64_t EdgeKey(uint32 a, uint32 b)
+	{
+		return ((std::uint64_t)a << 32) | b;
+	}
+
+	// Squared distance from p to the triangle abc, by the Voronoi regions of its
+	// corners and edges (Ericson, "Real-Time Collision Detection", 5.1.5).
+	double PointTriangleDistanceSq(FXMVECTOR p, FXMVECTOR a, FXMVECTOR b, GXMVECTOR c)
+	{
+		XMVECTOR ab = b - a;
+		XMVECTOR ac = c - a;
+		XMVECTOR closest;
+
+		float d1 = XMVectorGetX(XMVector3Dot(ab, p - a));
+		float d2 = XMVectorGetX(XMVector3Dot(ac, p - a));
+		float d3 = XMVectorGetX(XMVector3Dot(ab, p - b));
+		float d4 = XMVectorGetX(XMVector3Dot(ac, p - b));
+		float d5 = XMVectorGetX(XMVector3Dot(ab, p - c));
+		float d6 = XMVectorGetX(XMVector3Dot(ac, p - c));
+
+		float va = d3*d6 - d5*d4;
+		float vb = d5*d2 - d1*d6;
+		float vc = d1*d4 - d3*d2;
+
+		if(d1 <= 0.0f && d2 <= 0.0f)
+			closest = a;
+		else if(d3 >= 0.0f && d4 <= d3)
+			closest = b;
+		else if(d6 >= 0.0f && d5 <= d6)
+			closest = c;
+		else if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+			closest = a + ab*(d1 / (d1 - d3));
+		else if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+			closest = a + ac*(d2 / (d2 - d6));
+		else if(va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+			closest = b + (c - b)*((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+		else if(va + vb + vc > 0.0f)
+			closest = a + ab*(vb / (va + vb + vc)) + ac*(vc / (va + vb + vc));
+		else
+			closest = a; // degenerate
+
+		return XMVectorGetX(XMVector3LengthSq(p - closest));
+	}
+
+	// Bounding volume hierarchy over a triangle list, for the distance from a
+	// point to its nearest triangle.  Triangles are split at the median of their
+	// centers along the longest axis until a few are left.
+	class TriangleBvh
+	{
+	public:
+		TriangleBvh(const std::vector<XMFLOAT3>& positions, const std::vector<uint32>& indices) :
+			mPositions(positions), mIndices(indices)
+		{
+			size_t triCount = indices.size() / 3;
+			mTris.resize(triCount);
+			mCenters.resize(triCount);
+			for(size_t t = 0; t < triCount; ++t)
+			{
+				mTris[t] = (uint32)t;
+
+				XMVECTOR sum = XMLoadFloat3(&positions[indices[t*3+0]]) +
+					XMLoadFloat3(&positions[indices[t*3+1]]) +
+					XMLoadFloat3(&positions[indices[t*3+2]]);
+				XMStoreFloat3(&mCenters[t], sum / 3.0f);
+			}
+
+			mNodes.reserve(2*(triCount/LeafSize + 1));
+			mNodes.push_back(Node());
+			BuildNode(0, 0, (uint32)triCount);
+		}
+
+		double DistanceSq(const XMFLOAT3& point)const
+		{
+			XMVECTOR p = XMLoadFloat3(&point);
+			double best = DBL_MAX;
+
+			// Each level pushes two nodes and pops one, so the stack stays shallow.
+			uint32 stack[128];
+			int top = 0;
+			stack[top++] = 0;
+			while(top > 0)
+			{
+				const Node& node = mNodes[stack[--top]];
+				if(BoxDistanceSq(node, point) >= best)
+					continue;
+
+				if(node.Count > 0)
+				{
+					for(uint32 i = node.First; i < node.First + node.Count; ++i)
+					{
+						const uint32* tri = &mIndices[mTris[i]*3];
+						best = std::min(best, PointTriangleDistanceSq(p,
+							XMLoadFloat3(&mPositions[tri[0]]),
+							XMLoadFloat3(&mPositions[tri[1]]),
+							XMLoadFloat3(&mPositions[tri[2]])));
+					}
+					continue;
+				}
+
+				// Visit the nearer child first; it is popped first.
+				uint32 nearChild = node.First;
+				uint32 farChild = node.First + 1;
+				if(BoxDistanceSq(mNodes[farChild], point) < BoxDistanceSq(mNodes[nearChild], point))
+					std::swap(nearChild, farChild);
+
+				stack[top++] = farChild;
+				stack[top++] = nearChild;
+			}
+
+			return best;
+		}
+
+	private:
+		static const uint32 LeafSize = 4;
+
+		// A leaf holds Count triangles from mTris[First]; an inner node has
+		// Count 0 and its children at First and First+1.
+		struct Node
+		{
+			XMFLOAT3 Min;
+			XMFLOAT3 Max;
+			uint32 First = 0;
+			uint32 Count = 0;
+		};
+
+		void BuildNode(uint32 nodeIndex, uint32 begin, uint32 end)
+		{
+			Node node;
+			XMVECTOR boxMin = XMVectorReplicate(FLT_MAX);
+			XMVECTOR boxMax = XMVectorReplicate(-FLT_MAX);
+			XMVECTOR centerMin = XMVectorReplicate(FLT_MAX);
+			XMVECTOR centerMax = XMVectorReplicate(-FLT_MAX);
+			for(uint32 i = begin; i < end; ++i)
+			{
+				for(int k = 0; k < 3; ++k)
+				{
+					XMVECTOR v = XMLoadFloat3(&mPositions[mIndices[mTris[i]*3 + k]]);
+					boxMin = XMVectorMin(boxMin, v);
+					boxMax = XMVectorMax(boxMax, v);
+				}
+
+				XMVECTOR c = XMLoadFloat3(&mCenters[mTris[i]]);
+				centerMin = XMVectorMin(centerMin, c);
+				centerMax = XMVectorMax(centerMax, c);
+			}
+			XMStoreFloat3(&node.Min, boxMin);
+			XMStoreFloat3(&node.Max, boxMax);
+
+			if(end - begin <= LeafSize)
+			{
+				node.First = begin;
+				node.Count = end - begin;
+				mNodes[nodeIndex] = node;
+				return;
+			}
+
+			XMFLOAT3 extent;
+			XMStoreFloat3(&extent, centerMax - centerMin);
+			int axis = 0;
+			if(extent.y > extent.x) axis = 1;
+			if(extent.z > (&extent.x)[axis]) axis = 2;
+
+			uint32 mid = (begin + end) / 2;
+			std::nth_element(mTris.begin() + begin, mTris.begin() + mid, mTris.begin() + end,
+				[this, axis](uint32 a, uint32 b) { return (&mCenters[a].x)[axis] < (&mCenters[b].x)[axis]; });
+
+			node.First = (uint32)mNodes.size();
+			mNodes[nodeIndex] = node;
+			mNodes.push_back(Node());
+			mNodes.push_back(Node());
+
+			BuildNode(node.First, begin, mid);
+			BuildNode(node.First + 1, mid, end);
+		}
+
+		static double BoxDistanceSq(const Node& node, const XMFLOAT3& p)
+		{
+			XMVECTOR v = XMLoadFloat3(&p);
+			XMVECTOR outside = XMVectorMax(XMLoadFloat3(&node.Min) - v, v - XMLoadFloat3(&node.Max));
+			return XMVectorGetX(XMVector3LengthSq(XMVectorMax(outside, XMVectorZero())));
+		}
+
+		const std::vector<XMFLOAT3>& mPositions;
+		const std::vector<uint32>& mIndices;
+		std::vector<uint32> mTris;
+		std::vector<XMFLOAT3> mCenters;
+		std::vector<Node> mNodes;
+	};
+
+	class Simplifier
+	{
+	public:
+		Simplifier(const XMFLOAT3* positions, size_t positionStride,
+			const XMFLOAT3* normals, size_t normalStride, size_t vertexCount)
+		{
+			mPositions.resize(vertexCount);
+			for(size_t i = 0; i < vertexCount; ++i)
+				mPositions[i] = *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const char*>(positions) + i*positionStride);
+
+			if(normals != nullptr)
+			{
+				mNormals.resize(vertexCount);
+				for(size_t i = 0; i < vertexCount; ++i)
+					mNormals[i] = *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const char*>(normals) + i*normalStride);
+			}
+
+			BuildWeld();
+		}
+
+		std::vector<uint32> Run(std::vector<uint32> indices, size_t targetIndexCount, float maxError)
+		{
+			BuildEdges(indices);
+			ClassifyVertices(indices);
+			BuildQuadrics(indices);
+
+			double maxErrorSq = (double)maxError*maxError;
+
+			std::vector<uint32> remap(mPositions.size());
+			std::vector<bool> touched(mPositions.size());
+			std::vector<Collapse> collapses;
+
+			while(indices.size() > targetIndexCount)
+			{
+				BuildAdjacency(indices);
+
+				//
+				// Gather every allowed collapse with its cost, cheapest first.
+				//
+
+				collapses.clear();
+				for(size_t t = 0; t < indices.size(); t += 3)
+				{
+					for(int k = 0; k < 3; ++k)
+					{
+						uint32 a = indices[t + k];
+						uint32 b = indices[t + (k+1)%3];
+
+						// An edge shared by two triangles is seen from both; only take
+						// it once.  Each side of a border or seam edge is seen once.
+						if(a > b && mEdges.count(EdgeKey(b, a)) != 0)
+							continue;
+
+						AddCollapse(indices, a, b, collapses);
+						AddCollapse(indices, b, a, collapses);
+					}
+				}
+
+				if(collapses.empty())
+					break;
+
+				std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y)
+				{
+					if(x.Cost != y.Cost)
+						return x.Cost < y.Cost;
+					return x.From != y.From ? x.From < y.From : x.To < y.To;
+				});
+
+				//
+				// Do the cheapest independent collapses.  A collapse removes two
+				// triangles (one on a border), so don't do many more than needed.
+				//
+
+				size_t trianglesToRemove = (indices.size() - targetIndexCount) / 3;
+				size_t collapseLimit = trianglesToRemove/2 + 1;
+
+				for(size_t v = 0; v < remap.size(); ++v)
+					remap[v] = (uint32)v;
+				std::fill(touched.begin(), touched.end(), false);
+
+				size_t collapseCount = 0;
+				for(const Collapse& c : collapses)
+				{
+					if(collapseCount >= collapseLimit)
+						break;
+
+					if(c.Error > maxErrorSq)
+						continue;
+
+					// Every copy of From moves, each onto its own copy of To.
+					FindCopyPairs(indices, c.From, c.To);
+
+					bool blocked = false;
+					for(const auto& pair : mPairs)
+					{
+						if(touched[pair.first] || touched[pair.second] || FlipsTriangle(indices, pair.first, pair.second))
+						{
+							blocked = true;
+							break;
+						}
+					}
+					if(blocked)
+						continue;
+
+					for(const auto& pair : mPairs)
+					{
+						remap[pair.first] = pair.second;
+						mQuadrics[pair.second].Add(mQuadrics[pair.first]);
+					}
+
+					// Lock the one-rings so later collapses in this pass see
+					// up-to-date triangles.
+					for(const auto& pair : mPairs)
+						Touch(indices, pair.first, touched);
+
+					collapseCount++;
+				}
+
+				if(collapseCount == 0)
+					break;
+
+				//
+				// Apply the collapses and drop triangles that became degenerate.
+				//
+
+				size_t write = 0;
+				for(size_t t = 0; t < indices.size(); t += 3)
+				{
+					uint32 i0 = remap[indices[t+0]];
+					uint32 i1 = remap[indices[t+1]];
+					uint32 i2 = remap[indices[t+2]];
+
+					if(i0 == i1 || i1 == i2 || i0 == i2)
+						continue;
+
+					indices[write++] = i0;
+					indices[write++] = i1;
+					indices[write++] = i2;
+				}
+				indices.resize(write);
+				BuildEdges(indices);
+			}
+
+			return indices;
+		}
+
+		// Largest distance from a vertex of source to the nearest triangle of
+		// indices, or FLT_MAX if source has triangles and indices has none.
+		float Deviation(const uint32* source, size_t sourceCount, const std::vector<uint32>& indices)const
+		{
+			if(sourceCount == 0)
+				return 0.0f;
+			if(indices.empty())
+				return FLT_MAX;
+
+			TriangleBvh bvh(mPositions, indices);
+
+			std::vector<bool> measured(mPositions.size(), false);
+			double maxDistSq = 0.0;
+			for(size_t i = 0; i < sourceCount; ++i)
+			{
+				uint32 v = source[i];
+				if(measured[v])
+					continue;
+				measured[v] = true;
+
+				maxDistSq = std::max(maxDistSq, bvh.DistanceSq(mPositions[v]));
+			}
+
+			return (float)sqrt(maxDistSq);
+		}
+
+	private:
+		// Vertices with bitwise equal positions are the copies of one split vertex.
+		void BuildWeld()
+		{
+			struct PositionHash
+			{
+				size_t operator()(const XMFLOAT3& p)const
+				{
+					std::uint32_t h[3];
+					memcpy(h, &p, sizeof(h));
+					return (h[0]*73856093u) ^ (h[1]*19349663u) ^ (h[2]*83492791u);
+				}
+			};
+			struct PositionEqual
+			{
+				bool operator()(const XMFLOAT3& a, const XMFLOAT3& b)const
+				{
+					return a.x == b.x && a.y == b.y && a.z == b.z;
+				}
+			};
+
+			std::unordered_map<XMFLOAT3, uint32, PositionHash, PositionEqual> firstVertex;
+			firstVertex.reserve(mPositions.size());
+
+			mWeld.resize(mPositions.size());
+			for(uint32 v = 0; v < (uint32)mPositions.size(); ++v)
+				mWeld[v] = firstVertex.insert({ mPositions[v], v }).first->second;
+		}
+
+		// The directed edges of the current mesh, as they are and welded.
+		void BuildEdges(const std::vector<uint32>& indices)
+		{
+			mEdges.clear();
+			mWeldedEdges.clear();
+			mEdges.reserve(indices.size());
+			mWeldedEdges.reserve(indices.size());
+			for(size_t t = 0; t < indices.size(); t += 3)
+			{
+				for(int k = 0; k < 3; ++k)
+				{
+					uint32 a = indices[t+k];
+					uint32 b = indices[t+(k+1)%3];
+					mEdges.insert(EdgeKey(a, b));
+					mWeldedEdges.insert(EdgeKey(mWeld[a], mWeld[b]));
+				}
+			}
+		}
+
+		// A directed edge is on a border if no triangle uses it in the opposite
+		// direction.  Welded indices are used so seams don't look like borders.
+		bool IsBorderEdge(uint32 a, uint32 b)const
+		{
+			return mWeldedEdges.find(EdgeKey(mWeld[b], mWeld[a])) == mWeldedEdges.end();
+		}
+
+		// A directed edge is on a seam if the triangle across it uses other copies
+		// of its vertices.
+		bool IsSeamEdge(uint32 a, uint32 b)const
+		{
+			return !IsBorderEdge(a, b) && mEdges.find(EdgeKey(b, a)) == mEdges.end();
+		}
+
+		void ClassifyVertices(const std::vector<uint32>& indices)
+		{
+			// Link the copies of each position the mesh uses into a ring.
+			std::vector<bool> used(mPositions.size(), false);
+			for(uint32 i : indices)
+				used[i] = true;
+
+			std::vector<uint32> copies(mPositions.size(), 0);
+			std::vector<uint32> lastCopy(mPositions.size(), NoVertex);
+			mNextCopy.resize(mPositions.size());
+			for(uint32 v = 0; v < (uint32)mPositions.size(); ++v)
+			{
+				mNextCopy[v] = v;
+				if(!used[v])
+					continue;
+
+				uint32 w = mWeld[v];
+				if(copies[w]++ != 0)
+				{
+					mNextCopy[v] = mNextCopy[lastCopy[w]];
+					mNextCopy[lastCopy[w]] = v;
+				}
+				lastCopy[w] = v;
+			}
+
+			mKind.assign(mPositions.size(), VertexKind::Interior);
+			for(size_t t = 0; t < indices.size(); t += 3)
+			{
+				for(int k = 0; k < 3; ++k)
+				{
+					uint32 a = indices[t+k];
+					uint32 b = indices[t+(k+1)%3];
+					if(IsBorderEdge(a, b))
+					{
+						if(mKind[a] == VertexKind::Interior) mKind[a] = VertexKind::Border;
+						if(mKind[b] == VertexKind::Interior) mKind[b] = VertexKind::Border;
+					}
+				}
+			}
+
+			// Where a seam meets a border, the copies can't move together along
+			// both.
+			std::vector<bool> border(mPositions.size(), false);
+			for(size_t v = 0; v < mPositions.size(); ++v)
+			{
+				if(mKind[v] == VertexKind::Border)
+					border[mWeld[v]] = true;
+			}
+
+			for(size_t v = 0; v < mPositions.size(); ++v)
+			{
+				uint32 w = mWeld[v];
+				if(used[v] && copies[w] > 1)
+					mKind[v] = border[w] ? VertexKind::Locked : VertexKind::Seam;
+			}
+		}
+
+		void BuildQuadrics(const std::vector<uint32>& indices)
+		{
+			mQuadrics.assign(mPositions.size(), Quadric());
+
+			for(size_t t = 0; t < indices.size(); t += 3)
+			{
+				uint32 i0 = indices[t+0], i1 = indices[t+1], i2 = indices[t+2];
+
+				XMVECTOR n = TriangleNormal(mPositions[i0], mPositions[i1], mPositions[i2]);
+				float length = XMVectorGetX(XMVector3Length(n));
+				if(length <= 0.0f)
+					continue;
+
+				// The cross product length is twice the area; weigh planes by area
+				// so big triangles dominate over slivers.
+				float area = 0.5f*length;
+				n = n / length;
+
+				XMFLOAT3 nf;
+				XMStoreFloat3(&nf, n);
+				double d = -(nf.x*mPositions[i0].x + nf.y*mPositions[i0].y + nf.z*mPositions[i0].z);
+
+				Quadric q = Quadric::FromPlane(nf.x, nf.y, nf.z, d, area);
+				mQuadrics[i0].Add(q);
+				mQuadrics[i1].Add(q);
+				mQuadrics[i2].Add(q);
+
+				// Border and seam edges get a plane perpendicular to the triangle
+				// through the edge, so moving the border or seam away from its line
+				// costs error too.
+				for(int k = 0; k < 3; ++k)
+				{
+					uint32 a = indices[t+k];
+					uint32 b = indices[t+(k+1)%3];
+					if(!IsBorderEdge(a, b) && !IsSeamEdge(a, b))
+						continue;
+
+					XMVECTOR pa = XMLoadFloat3(&mPositions[a]);
+					XMVECTOR pb = XMLoadFloat3(&mPositions[b]);
+					XMVECTOR edge = pb - pa;
+					float edgeLength = XMVectorGetX(XMVector3Length(edge));
+					if(edgeLength <= 0.0f)
+						continue;
+
+					XMVECTOR bn = XMVector3Normalize(XMVector3Cross(edge, n));
+					XMFLOAT3 bnf;
+					XMStoreFloat3(&bnf, bn);
+					double bd = -(bnf.x*mPositions[a].x + bnf.y*mPositions[a].y + bnf.z*mPositions[a].z);
+
+					Quadric bq = Quadric::FromPlane(bnf.x, bnf.y, bnf.z, bd, edgeLength*edgeLength);
+					mQuadrics[a].Add(bq);
+					mQuadrics[b].Add(bq);
+				}
+			}
+		}
+
+		void BuildAdjacency(const std::vector<uint32>& indices)
+		{
+			size_t vertexCount = mPositions.size();
+			mAdjOffset.assign(vertexCount + 1, 0);
+			for(uint32 i : indices)
+				mAdjOffset[i+1]++;
+			for(size_t v = 0; v < vertexCount; ++v)
+				mAdjOffset[v+1] += mAdjOffset[v];
+
+			mAdjTris.resize(indices.size());
+			std::vector<uint32> fill(mAdjOffset.begin(), mAdjOffset.end() - 1);
+			for(size_t i = 0; i < indices.size(); ++i)
+				mAdjTris[fill[indices[i]]++] = (uint32)(i / 3);
+		}
+
+		// Marks the one-ring of v, so later collapses in this pass see up-to-date
+		// triangles.
+		void Touch(const std::vector<uint32>& indices, uint32 v, std::vector<bool>& touched)const
+		{
+			for(uint32 a = mAdjOffset[v]; a < mAdjOffset[v+1]; ++a)
+			{
+				const uint32* tri = &indices[mAdjTris[a]*3];
+				touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+			}
+		}
+
+		// The copy of to's position that v has an edge to.
+		uint32 FindCopyNeighbor(const std::vector<uint32>& indices, uint32 v, uint32 to)const
+		{
+			for(uint32 a = mAdjOffset[v]; a < mAdjOffset[v+1]; ++a)
+			{
+				const uint32* tri = &indices[mAdjTris[a]*3];
+				for(int k = 0; k < 3; ++k)
+				{
+					if(mWeld[tri[k]] == mWeld[to])
+						return tri[k];
+				}
+			}
+
+			return NoVertex;
+		}
+
+		// Fills mPairs with from and to, then each other copy of from the mesh
+		// still uses and the copy of to it has an edge to.  False if one of them
+		// has none: the collapse would tear the copies apart.
+		bool FindCopyPairs(const std::vector<uint32>& indices, uint32 from, uint32 to)
+		{
+			mPairs.clear();
+			mPairs.push_back({ from, to });
+			for(uint32 v = mNextCopy[from]; v != from; v = mNextCopy[v])
+			{
+				if(mAdjOffset[v] == mAdjOffset[v+1])
+					continue;
+
+				uint32 copyTo = FindCopyNeighbor(indices, v, to);
+				if(copyTo == NoVertex)
+					return false;
+
+				mPairs.push_back({ v, copyTo });
+			}
+
+			return true;
+		}
+
+		double CreaseCost(uint32 from, uint32 to)const
+		{
+			if(mNormals.empty())
+				return 0.0;
+
+			XMVECTOR n0 = XMLoadFloat3(&mNormals[from]);
+			XMVECTOR n1 = XMLoadFloat3(&mNormals[to]);
+			XMVECTOR edge = XMLoadFloat3(&mPositions[to]) - XMLoadFloat3(&mPositions[from]);
+			double crease = 1.0 - XMVectorGetX(XMVector3Dot(n0, n1));
+			return NormalWeight * std::max(crease, 0.0) * XMVectorGetX(XMVector3LengthSq(edge));
+		}
+
+		void AddCollapse(const std::vector<uint32>& indices, uint32 from, uint32 to, std::vector<Collapse>& collapses)
+		{
+			VertexKind kind = mKind[from];
+			if(kind == VertexKind::Locked)
+				return;
+
+			// Border vertices slide along the border only.
+			if(kind == VertexKind::Border && !(IsBorderEdge(from, to) || IsBorderEdge(to, from)))
+				return;
+
+			// Seam vertices slide along a seam only, and every other copy slides
+			// onto the copy of to on its side of it, so the sides stay joined.
+			if(kind == VertexKind::Seam && !(IsSeamEdge(from, to) || IsSeamEdge(to, from)))
+				return;
+
+			if(!FindCopyPairs(indices, from, to))
+				return;
+
+			// The copies of to can repeat, so only add each quadric once.
+			Quadric q;
+			double cost = 0.0;
+			for(size_t i = 0; i < mPairs.size(); ++i)
+			{
+				q.Add(mQuadrics[mPairs[i].first]);
+				cost += CreaseCost(mPairs[i].first, mPairs[i].second);
+
+				bool seen = false;
+				for(size_t j = 0; j < i; ++j)
+					seen = seen || mPairs[j].second == mPairs[i].second;
+				if(!seen)
+					q.Add(mQuadrics[mPairs[i].second]);
+			}
+
+			double error = q.Error(mPositions[to]);
+			cost += error;
+
+			collapses.push_back({ from, to, cost, error });
+		}
+
+		bool FlipsTriangle(const std::vector<uint32>& indices, uint32 from, uint32 to)const
+		{
+			for(uint32 a = mAdjOffset[from]; a < mAdjOffset[from+1]; ++a)
+			{
+				const uint32* tri = &indices[mAdjTris[a]*3];
+
+				// This triangle disappears with the collapse.
+				if(tri[0] == to || tri[1] == to || tri[2] == to)
+					continue;
+
+				XMFLOAT3 p[3];
+				for(int k = 0; k < 3; ++k)
+					p[k] = mPositions[tri[k] == from ? to : tri[k]];
+
+				XMVECTOR before = TriangleNormal(mPositions[tri[0]], mPositions[tri[1]], mPositions[tri[2]]);
+				XMVECTOR after = TriangleNormal(p[0], p[1], p[2]);
+
+				if(XMVectorGetX(XMVector3Dot(before, after)) <= 0.0f)
+					return true;
+			}
+
+			return false;
+		}
+
+		std::vector<XMFLOAT3> mPositions;
+		std::vector<XMFLOAT3> mNormals;
+		std::vector<uint32> mWeld;
+		std::vector<uint32> mNextCopy;
+		std::vector<VertexKind> mKind;
+		std::vector<Quadric> mQuadrics;
+
+		std::vector<uint32> mAdjOffset;
+		std::vector<uint32> mAdjTris;
+
+		// Directed edges of the current mesh, for border and seam tests.
+		std::unordered_set<std::uint64_t> mEdges;
+		std::unordered_set<std::uint64_t> mWeldedEdges;
+
+		// The (from, to) pairs of the collapse being looked at.
+		std::vector<std::pair<uint32, uint32>> mPairs;
+	};
+}
+
+std::vector<uint32> MeshSimplifier::Simplify(
+	const XMFLOAT3* positions, size_t positionStride,
+	const XMFLOAT3* normals, size_t normalStride,
+	size_t vertexCount,
+	const uint32* indices, size_t indexCount,
+	size_t targetIndexCount, float maxError, float* resultError)
+{
+	Simplifier simplifier(positions, positionStride, normals, normalStride, vertexCount);
+	std::vector<uint32> result = simplifier.Run(
+		std::vector<uint32>(indices, indices + indexCount), targetIndexCount, maxError);
+
+	if(resultError != nullptr)
+		*resultError = simplifier.Deviation(indices, indexCount, result);
+
+	return result;
+}
+
+std::vector<MeshLod> MeshSimplifier::BuildLodChain(
+	const XMFLOAT3* positions, size_t positionStride,
+	const XMFLOAT3* normals, size_t normalStride,
+	size_t vertexCount,
+	const uint32* indices, size_t indexCount,
+	const std::vector<float>& triangleRatios)
+{
+	std::vector<MeshLod> lods;
+	lods.reserve(triangleRatios.size());
+
+	// The welding and vertex copies are shared by every level.
+	Simplifier simplifier(positions, positionStride, normals, normalStride, vertexCount);
+
+	std::vector<uint32> current(indices, indices + indexCount);
+	float error = 0.0f;
+
+	for(float ratio : triangleRatios)
+	{
+		size_t targetTriangles = (size_t)(ratio * (indexCount / 3));
+		if(current.size() > targetTriangles*3)
+		{
+			current = simplifier.Run(std::move(current), targetTriangles*3, FLT_MAX);
+
+			// Each level starts from the previous one but is measured against the
+			// source.  A coarser level can happen to land closer; it still gets
+			// at least the finer level's error so SelectLod sees them in order.
+			error = std::max(error, simplifier.Deviation(indices, indexCount, current));
+		}
+
+		MeshLod lod;
+		lod.Indices = current;
+		lod.TargetRatio = ratio;
+		lod.TriangleCount = (uint32)(current.size() / 3);
+		lod.Ratio = indexCount > 0 ? (float)current.size() / indexCount : 1.0f;
+		lod.Error = error;
+
+		MeshOptimizer::OptimizeVertexCache(lod.Indices.data(), lod.Indices.size(), vertexCount);
+
+		lods.push_back(std::move(lod));
+	}
+
+	return lods;
+}
+
+std::vector<MeshLod> MeshSimplifier::BuildLodChain(const GeometryGenerator::MeshData& meshData,
+	const std::vector<float>& triangleRatios)
+{
+	if(meshData.Vertices.empty())
+		return std::vector<MeshLod>(triangleRatios.size());
+
+	return BuildLodChain(
+		&meshData.Vertices[0].Position, sizeof(GeometryGenerator::Vertex),
+		&meshData.Vertices[0].Normal, sizeof(GeometryGenerator::Vertex),
+		meshData.Vertices.size(),
+		meshData.Indices32.data(), meshData.Indices32.size(),
+		triangleRatios);
+}
+
+size_t MeshSimplifier::SelectLod(const std::vector<MeshLod>& lods, float distance,
+	float fovY, float screenHeight, float maxPixelError)
+{
+	// Pixels per object space unit at this distance.
+	float pixelsPerUnit = screenHeight / (2.0f * std::max(distance, 1e-6f) * tanf(0.5f*fovY));
+
+	size_t selected = 0;
+	for(size_t i = 0; i < lods.size(); ++i)
+	{
+		if(lods[i].Error * pixelsPerUnit <= maxPixelError)
+			selected = i;
+	}
+
+	return selected;
+}
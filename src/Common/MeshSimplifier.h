@@ -0,0 +1,92 @@
+//***************************************************************************************
+// MeshSimplifier.h
+//
+// Level of detail generation by edge collapse with quadric error metrics (Garland
+// and Heckbert, "Surface Simplification Using Quadric Error Metrics").
+//
+// Vertices are only ever collapsed onto other existing vertices, so every LOD is
+// just a new index buffer over the original vertex buffer; normals, texture
+// coordinates, tangents and bone weights are kept exactly.  To keep texture seams
+// intact, vertices that share a position with other vertices (the split vertices
+// along a UV or normal seam) only move along a seam, and all the copies move
+// together, each onto the copy of the target on its side of the seam.  A copy
+// with no such neighbor (where three or more seams meet at a corner) holds the
+// others in place.  Vertices on an open border only move along the border, and
+// seam vertices on a border never move.
+//
+// Each LOD records how far it strays from the source in object space so the app
+// can pick the coarsest LOD whose error projects to less than a pixel or so
+// (SelectLod).
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include "GeometryGenerator.h"
+
+struct MeshLod
+{
+	// Indices into the source vertex buffer.
+	std::vector<std::uint32_t> Indices;
+
+	// Fraction of the source triangles this LOD was asked for, and what it got.
+	// Ratio stays above TargetRatio when seams and borders stop the collapses
+	// short of the target.
+	float TargetRatio = 1.0f;
+	float Ratio = 1.0f;
+	std::uint32_t TriangleCount = 0;
+
+	// Largest distance (object space units) from a source vertex to the nearest
+	// triangle of this LOD, and never less than the finer LODs' errors.  Only
+	// source vertices are measured; the surface between them can stray a little
+	// further.
+	float Error = 0.0f;
+};
+
+class MeshSimplifier
+{
+public:
+
+	using uint32 = std::uint32_t;
+
+	///<summary>
+	/// Simplifies a triangle list down to targetIndexCount indices or as close as it
+	/// can get without tearing seams or borders or flipping triangles.  normals
+	/// is optional; when given, collapses across creases cost more.  Stops early if
+	/// the next collapse's quadric error (the RMS distance from its vertex to the
+	/// planes it merges) would exceed maxError.  Returns the new index buffer and
+	/// writes its distance from the source, as MeshLod::Error, to *resultError.
+	///</summary>
+	static std::vector<uint32> Simplify(
+		const DirectX::XMFLOAT3* positions, size_t positionStride,
+		const DirectX::XMFLOAT3* normals, size_t normalStride,
+		size_t vertexCount,
+		const uint32* indices, size_t indexCount,
+		size_t targetIndexCount, float maxError, float* resultError);
+
+	///<summary>
+	/// Builds one LOD per entry of triangleRatios (e.g. 1, 0.5, 0.25, 0.125), each
+	/// simplified from the previous one.  The indices of each LOD are also optimized
+	/// for the post-transform vertex cache.
+	///</summary>
+	static std::vector<MeshLod> BuildLodChain(
+		const DirectX::XMFLOAT3* positions, size_t positionStride,
+		const DirectX::XMFLOAT3* normals, size_t normalStride,
+		size_t vertexCount,
+		const uint32* indices, size_t indexCount,
+		const std::vector<float>& triangleRatios);
+
+	static std::vector<MeshLod> BuildLodChain(const GeometryGenerator::MeshData& meshData,
+		const std::vector<float>& triangleRatios);
+
+	///<summary>
+	/// Returns the index of the coarsest LOD whose error covers at most maxPixelError
+	/// pixels at the given view distance, for a perspective projection with vertical
+	/// field of view fovY (radians) and a viewport screenHeight pixels high.  lods
+	/// must be ordered from finest to coarsest, as BuildLodChain returns them.
+	///</summary>
+	static size_t SelectLod(const std::vector<MeshLod>& lods, float distance,
+		float fovY, float screenHeight, float maxPixelError = 1.0f);
+};
@@ -0,0 +1,273 @@
+//***************************************************************************************
+// MeshletBuilder.cpp
+//***************************************************************************************
+
+#include "MeshletBuilder.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	using uint32 = MeshletBuilder::uint32;
+
+	const uint32 InvalidIndex = 0xffffffff;
+
+	// Triangles per parallel work item.  Fixed (not derived from the thread count)
+	// so that the meshlets are identical no matter how many threads run.
+	const uint32 TrianglesPerChunk = 8192;
+
+	struct ChunkResult
+	{
+		std::vector<Meshlet> Meshlets;
+		std::vector<uint32> VertexIndices;
+		std::vector<std::uint8_t> PrimitiveIndices;
+	};
+
+	// Per-thread scratch memory reused across chunks.
+	struct Scratch
+	{
+		std::vector<uint32> LocalIndex; // source vertex -> meshlet-local vertex, or InvalidIndex
+		std::vector<XMFLOAT3> Points;
+	};
+
+	const XMFLOAT3& GetPosition(const XMFLOAT3* positions, size_t stride, uint32 i)
+	{
+		return *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const char*>(positions) + i*stride);
+	}
+
+	void ComputeMeshletBounds(Meshlet& meshlet, const ChunkResult& chunk,
+		const XMFLOAT3* positions, size_t stride, Scratch& scratch)
+	{
+		//
+		// Bounding sphere.
+		//
+
+		scratch.Points.resize(meshlet.VertexCount);
+		for(uint32 i = 0; i < meshlet.VertexCount; ++i)
+			scratch.Points[i] = GetPosition(positions, stride, chunk.VertexIndices[meshlet.VertexOffset + i]);
+
+		BoundingSphere::CreateFromPoints(meshlet.Bounds, scratch.Points.size(), scratch.Points.data(), sizeof(XMFLOAT3));
+
+		//
+		// Normal cone.  The axis is the average of the unit triangle normals and the
+		// cone is widened until it contains every normal.
+		//
+
+		const std::uint8_t* prims = &chunk.PrimitiveIndices[meshlet.TriangleOffset*3];
+
+		XMVECTOR normalSum = XMVectorZero();
+		for(uint32 t = 0; t < meshlet.TriangleCount; ++t)
+		{
+			XMVECTOR p0 = XMLoadFloat3(&scratch.Points[prims[t*3+0]]);
+			XMVECTOR p1 = XMLoadFloat3(&scratch.Points[prims[t*3+1]]);
+			XMVECTOR p2 = XMLoadFloat3(&scratch.Points[prims[t*3+2]]);
+
+			XMVECTOR n = XMVector3Cross(p1 - p0, p2 - p0);
+			if(XMVectorGetX(XMVector3LengthSq(n)) > 0.0f)
+				normalSum += XMVector3Normalize(n);
+		}
+
+		meshlet.ConeAxis = XMFLOAT3(0.0f, 0.0f, 1.0f);
+		meshlet.ConeCutoff = 1.0f;
+
+		if(XMVectorGetX(XMVector3LengthSq(normalSum)) <= 1e-12f)
+			return;
+
+		XMVECTOR axis = XMVector3Normalize(normalSum);
+
+		float minDot = 1.0f;
+		for(uint32 t = 0; t < meshlet.TriangleCount; ++t)
+		{
+			XMVECTOR p0 = XMLoadFloat3(&scratch.Points[prims[t*3+0]]);
+			XMVECTOR p1 = XMLoadFloat3(&scratch.Points[prims[t*3+1]]);
+			XMVECTOR p2 = XMLoadFloat3(&scratch.Points[prims[t*3+2]]);
+
+			XMVECTOR n = XMVector3Cross(p1 - p0, p2 - p0);
+			if(XMVectorGetX(XMVector3LengthSq(n)) > 0.0f)
+				minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(XMVector3Normalize(n), axis)));
+		}
+
+		XMStoreFloat3(&meshlet.ConeAxis, axis);
+
+		// Normals spread over (nearly) a hemisphere or more; the cone would never
+		// pass the culling test so leave it disabled.
+		if(minDot <= 0.1f)
+			return;
+
+		meshlet.ConeCutoff = sqrtf(1.0f - minDot*minDot);
+	}
+
+	template<typename IndexT>
+	void BuildChunk(ChunkResult& chunk, uint32 firstTri, uint32 triCount,
+		const XMFLOAT3* positions, size_t stride, const IndexT* indices,
+		uint32 maxVertices, uint32 maxTriangles, Scratch& scratch)
+	{
+		Meshlet current;
+		std::vector<uint32> used; // source vertices of the current meshlet
+
+		auto flush = [&]()
+		{
+			if(current.TriangleCount == 0)
+				return;
+
+			for(uint32 v : used)
+				scratch.LocalIndex[v] = InvalidIndex;
+			used.clear();
+
+			chunk.Meshlets.push_back(current);
+
+			current = Meshlet();
+			current.VertexOffset = (uint32)chunk.VertexIndices.size();
+			current.TriangleOffset = (uint32)chunk.PrimitiveIndices.size() / 3;
+		};
+
+		for(uint32 t = firstTri; t < firstTri + triCount; ++t)
+		{
+			uint32 v[3] = { indices[t*3+0], indices[t*3+1], indices[t*3+2] };
+
+			uint32 newVertices = 0;
+			for(uint32 k = 0; k < 3; ++k)
+			{
+				if(scratch.LocalIndex[v[k]] == InvalidIndex &&
+				   (k < 1 || v[k] != v[0]) && (k < 2 || v[k] != v[1]))
+					newVertices++;
+			}
+
+			if(current.VertexCount + newVertices > maxVertices || current.TriangleCount + 1 > maxTriangles)
+				flush();
+
+			for(uint32 k = 0; k < 3; ++k)
+			{
+				uint32& local = scratch.LocalIndex[v[k]];
+				if(local == InvalidIndex)
+				{
+					local = current.VertexCount++;
+					chunk.VertexIndices.push_back(v[k]);
+					used.push_back(v[k]);
+				}
+
+				chunk.PrimitiveIndices.push_back((std::uint8_t)local);
+			}
+
+			current.TriangleCount++;
+		}
+
+		flush();
+
+		for(Meshlet& meshlet : chunk.Meshlets)
+			ComputeMeshletBounds(meshlet, chunk, positions, stride, scratch);
+	}
+
+	template<typename IndexT>
+	MeshletData BuildMeshlets(
+		const XMFLOAT3* positions, size_t stride, size_t vertexCount,
+		const IndexT* indices, size_t indexCount,
+		uint32 maxVertices, uint32 maxTriangles, uint32 numThreads)
+	{
+		// Local vertex numbers are stored in bytes, and a triangle can add 3 vertices.
+		maxVertices = std::min(std::max(maxVertices, 3u), 256u);
+		maxTriangles = std::max(maxTriangles, 1u);
+
+		uint32 triCount = (uint32)(indexCount / 3);
+		uint32 chunkCount = (triCount + TrianglesPerChunk - 1) / TrianglesPerChunk;
+
+		std::vector<ChunkResult> chunks(chunkCount);
+
+		numThreads = ResolveThreadCount(numThreads);
+		std::vector<Scratch> scratch(numThreads);
+
+		ParallelFor(chunkCount, numThreads, [&](unsigned threadIndex, size_t c)
+		{
+			Scratch& s = scratch[threadIndex];
+			if(s.LocalIndex.empty())
+				s.LocalIndex.assign(vertexCount, InvalidIndex);
+
+			uint32 firstTri = (uint32)c * TrianglesPerChunk;
+			uint32 count = std::min(TrianglesPerChunk, triCount - firstTri);
+
+			BuildChunk(chunks[c], firstTri, count, positions, stride, indices, maxVertices, maxTriangles, s);
+		});
+
+		//
+		// Join the chunks in order.
+		//
+
+		MeshletData result;
+
+		size_t meshletCount = 0, vertexIndexCount = 0, primitiveIndexCount = 0;
+		for(const ChunkResult& chunk : chunks)
+		{
+			meshletCount += chunk.Meshlets.size();
+			vertexIndexCount += chunk.VertexIndices.size();
+			primitiveIndexCount += chunk.PrimitiveIndices.size();
+		}
+
+		result.Meshlets.reserve(meshletCount);
+		result.VertexIndices.reserve(vertexIndexCount);
+		result.PrimitiveIndices.reserve(primitiveIndexCount);
+
+		for(const ChunkResult& chunk : chunks)
+		{
+			uint32 vertexBase = (uint32)result.VertexIndices.size();
+			uint32 triangleBase = (uint32)result.PrimitiveIndices.size() / 3;
+
+			for(Meshlet meshlet : chunk.Meshlets)
+			{
+				meshlet.VertexOffset += vertexBase;
+				meshlet.TriangleOffset += triangleBase;
+				result.Meshlets.push_back(meshlet);
+			}
+
+			result.VertexIndices.insert(result.VertexIndices.end(), chunk.VertexIndices.begin(), chunk.VertexIndices.end());
+			result.PrimitiveIndices.insert(result.PrimitiveIndices.end(), chunk.PrimitiveIndices.begin(), chunk.PrimitiveIndices.end());
+		}
+
+		return result;
+	}
+}
+
+MeshletData MeshletBuilder::Build(
+	const XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+	const uint32* indices, size_t indexCount,
+	uint32 maxVertices, uint32 maxTriangles, uint32 numThreads)
+{
+	return BuildMeshlets(positions, positionStride, vertexCount, indices, indexCount,
+		maxVertices, maxTriangles, numThreads);
+}
+
+MeshletData MeshletBuilder::Build(
+	const XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+	const uint16* indices, size_t indexCount,
+	uint32 maxVertices, uint32 maxTriangles, uint32 numThreads)
+{
+	return BuildMeshlets(positions, positionStride, vertexCount, indices, indexCount,
+		maxVertices, maxTriangles, numThreads);
+}
+
+MeshletData MeshletBuilder::Build(const GeometryGenerator::MeshData& meshData,
+	uint32 maxVertices, uint32 maxTriangles, uint32 numThreads)
+{
+	if(meshData.Vertices.empty())
+		return MeshletData();
+
+	return BuildMeshlets(&meshData.Vertices[0].Position, sizeof(GeometryGenerator::Vertex), meshData.Vertices.size(),
+		meshData.Indices32.data(), meshData.Indices32.size(),
+		maxVertices, maxTriangles, numThreads);
+}
+
+bool MeshletBuilder::IsBackfacing(const Meshlet& meshlet, FXMVECTOR eyePos)
+{
+	// Conservative test against the whole bounding sphere, so it holds for every
+	// point of the meshlet and not just its center.
+	XMVECTOR center = XMLoadFloat3(&meshlet.Bounds.Center);
+	XMVECTOR axis = XMLoadFloat3(&meshlet.ConeAxis);
+
+	XMVECTOR toCenter = center - eyePos;
+	float d = XMVectorGetX(XMVector3Dot(toCenter, axis));
+	float len = XMVectorGetX(XMVector3Length(toCenter));
+
+	return d >= meshlet.ConeCutoff*len + meshlet.Bounds.Radius;
+}
@@ -0,0 +1,91 @@
+//***************************************************************************************
+// MeshletBuilder.h
+//
+// Splits an indexed triangle list into meshlets (small clusters of at most 64
+// vertices and 124 triangles by default) so big meshes can be culled per cluster
+// instead of with a single SubmeshGeometry::Bounds test.  Each meshlet stores:
+//   -A bounding sphere for frustum culling (BoundingFrustum::Contains).
+//   -A normal cone for backface culling the whole cluster (IsBackfacing).
+//
+// Meshlets are built greedily in index buffer order, so run
+// MeshOptimizer::OptimizeVertexCache first to get tighter clusters.  The index
+// buffer is cut into fixed-size chunks that are processed in parallel and joined
+// in order, so the result is the same for any number of threads.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include "GeometryGenerator.h"
+
+struct Meshlet
+{
+	// Range in MeshletData::VertexIndices.
+	std::uint32_t VertexOffset = 0;
+	std::uint32_t VertexCount = 0;
+
+	// Range in MeshletData::PrimitiveIndices, in triangles (3 entries each).
+	std::uint32_t TriangleOffset = 0;
+	std::uint32_t TriangleCount = 0;
+
+	DirectX::BoundingSphere Bounds;
+
+	// Every triangle normal n satisfies dot(n, ConeAxis) >= cos(a) for the cone
+	// half-angle a, and ConeCutoff = sin(a).  ConeCutoff = 1 means the normals
+	// spread too far for the meshlet to ever be backface culled.
+	DirectX::XMFLOAT3 ConeAxis = { 0.0f, 0.0f, 1.0f };
+	float ConeCutoff = 1.0f;
+};
+
+struct MeshletData
+{
+	std::vector<Meshlet> Meshlets;
+
+	// Maps meshlet-local vertex numbers to indices in the source vertex buffer.
+	std::vector<std::uint32_t> VertexIndices;
+
+	// Three meshlet-local vertex numbers per triangle.
+	std::vector<std::uint8_t> PrimitiveIndices;
+};
+
+class MeshletBuilder
+{
+public:
+
+	using uint16 = std::uint16_t;
+	using uint32 = std::uint32_t;
+
+	static const uint32 DefaultMaxVertices  = 64;
+	static const uint32 DefaultMaxTriangles = 124;
+
+	///<summary>
+	/// Builds meshlets for a triangle list.  positions points at the first vertex
+	/// position and positionStride is the vertex size, so the vertex arrays of any
+	/// app or of M3DLoader can be passed without copying.  numThreads = 0 uses every
+	/// hardware thread.  maxVertices can't be larger than 256.
+	///</summary>
+	static MeshletData Build(
+		const DirectX::XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+		const uint32* indices, size_t indexCount,
+		uint32 maxVertices = DefaultMaxVertices, uint32 maxTriangles = DefaultMaxTriangles,
+		uint32 numThreads = 0);
+
+	static MeshletData Build(
+		const DirectX::XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+		const uint16* indices, size_t indexCount,
+		uint32 maxVertices = DefaultMaxVertices, uint32 maxTriangles = DefaultMaxTriangles,
+		uint32 numThreads = 0);
+
+	static MeshletData Build(const GeometryGenerator::MeshData& meshData,
+		uint32 maxVertices = DefaultMaxVertices, uint32 maxTriangles = DefaultMaxTriangles,
+		uint32 numThreads = 0);
+
+	///<summary>
+	/// Returns true if every triangle of the meshlet faces away from an eye at
+	/// eyePos.  Both must be in the same space (usually object space).
+	///</summary>
+	static bool IsBackfacing(const Meshlet& meshlet, DirectX::FXMVECTOR eyePos);
+};
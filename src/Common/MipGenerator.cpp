@@ -0,0 +1,496 @@
+//***************************************************************************************
+// MipGenerator.cpp
+//
+// Each level is two separable passes, rows then columns.  The taps of a pass only
+// depend on the source and destination sizes, so they are built once per level
+// and shared by every row.
+//***************************************************************************************
+
+#include "MipGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "ParallelFor.h"
+
+#if !defined(MIP_GENERATOR_NO_SIMD) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define MIP_GENERATOR_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	using uint8 = std::uint8_t;
+	using uint32 = std::uint32_t;
+	using Filter = MipGenerator::Filter;
+
+	const float Pi = 3.14159265f;
+
+	// Half-widths, in destination texels, of the windowed sinc filters.
+	const float KaiserWidth = 3.0f;
+	const float KaiserAlpha = 4.0f;
+	const float LanczosWidth = 3.0f;
+
+	// Levels smaller than this aren't worth starting threads for.
+	const size_t MinParallelTexels = 64*1024;
+
+	//
+	// sRGB conversion.
+	//
+
+	struct SrgbTables
+	{
+		static const uint32 LinearSteps = 65535;
+
+		float ToLinear[256];
+		float ToUnorm[256];
+		uint8 ToSrgb[LinearSteps + 1];
+
+		SrgbTables()
+		{
+			for(uint32 i = 0; i < 256; ++i)
+			{
+				float s = i / 255.0f;
+				ToLinear[i] = s <= 0.04045f ? s / 12.92f : std::pow((s + 0.055f) / 1.055f, 2.4f);
+				ToUnorm[i] = s;
+			}
+
+			for(uint32 i = 0; i <= LinearSteps; ++i)
+			{
+				float l = (float)i / LinearSteps;
+				float s = l <= 0.0031308f ? 12.92f*l : 1.055f*std::pow(l, 1.0f / 2.4f) - 0.055f;
+				ToSrgb[i] = (uint8)(s*255.0f + 0.5f);
+			}
+		}
+	};
+
+	const SrgbTables& GetSrgbTables()
+	{
+		static const SrgbTables tables;
+		return tables;
+	}
+
+	float Saturate(float x)
+	{
+		return x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x);
+	}
+
+	// One level in linear float: four floats per texel, rows tightly packed.
+	struct LinearImage
+	{
+		uint32 Width = 0;
+		uint32 Height = 0;
+		std::vector<float> Texels;
+
+		void Resize(uint32 width, uint32 height)
+		{
+			Width = width;
+			Height = height;
+			Texels.resize(4*(size_t)width*height);
+		}
+
+		float* Row(uint32 y) { return &Texels[4*(size_t)Width*y]; }
+		const float* Row(uint32 y)const { return &Texels[4*(size_t)Width*y]; }
+	};
+
+	unsigned LevelThreads(size_t texels, unsigned numThreads)
+	{
+		return texels < MinParallelTexels ? 1u : numThreads;
+	}
+
+	//
+	// Filter kernels, as functions of the distance in destination texels.
+	//
+
+	float Sinc(float x)
+	{
+		if(std::fabs(x) < 1.0e-6f)
+			return 1.0f;
+
+		x *= Pi;
+		return std::sin(x) / x;
+	}
+
+	// Modified Bessel function of the first kind, order 0, by its power series.
+	float BesselI0(float x)
+	{
+		float sum = 1.0f;
+		float term = 1.0f;
+		const float halfX = 0.5f*x;
+		for(int k = 1; k < 64 && term > 1.0e-8f*sum; ++k)
+		{
+			float t = halfX / k;
+			term *= t*t;
+			sum += term;
+		}
+
+		return sum;
+	}
+
+	float FilterRadius(Filter filter)
+	{
+		switch(filter)
+		{
+		case Filter::Kaiser:  return KaiserWidth;
+		case Filter::Lanczos: return LanczosWidth;
+		default:              return 0.5f;
+		}
+	}
+
+	float EvaluateKernel(Filter filter, float t)
+	{
+		const float radius = FilterRadius(filter);
+		if(std::fabs(t) >= radius)
+			return 0.0f;
+
+		if(filter == Filter::Kaiser)
+		{
+			float r = t / KaiserWidth;
+			return Sinc(t) * BesselI0(KaiserAlpha*std::sqrt(1.0f - r*r)) / BesselI0(KaiserAlpha);
+		}
+
+		return Sinc(t) * Sinc(t / LanczosWidth);
+	}
+
+	//
+	// Taps for one direction: destination texel i reads source texels
+	// Indices[Offsets[i] .. Offsets[i + 1]) with matching Weights, which sum to 1.
+	//
+
+	struct FilterTaps
+	{
+		std::vector<uint32> Offsets;
+		std::vector<uint32> Indices;
+		std::vector<float> Weights;
+	};
+
+	uint32 MapEdge(int s, uint32 size, bool wrap)
+	{
+		if(wrap)
+			return (uint32)(((s % (int)size) + (int)size) % (int)size);
+
+		return (uint32)(std::min)((std::max)(s, 0), (int)size - 1);
+	}
+
+	FilterTaps BuildTaps(uint32 srcSize, uint32 dstSize, Filter filter, bool wrap)
+	{
+		FilterTaps taps;
+		taps.Offsets.reserve(dstSize + 1);
+		taps.Offsets.push_back(0);
+
+		const float scale = (float)srcSize / dstSize;
+		for(uint32 d = 0; d < dstSize; ++d)
+		{
+			const size_t first = taps.Weights.size();
+			const float center = (d + 0.5f)*scale;
+
+			if(srcSize == dstSize)
+			{
+				taps.Indices.push_back(d);
+				taps.Weights.push_back(1.0f);
+			}
+			else if(filter == Filter::Box)
+			{
+				// Weight by how much of each source texel the destination texel covers.
+				const float lo = center - 0.5f*scale;
+				const float hi = center + 0.5f*scale;
+				for(int s = (int)std::floor(lo); s < (int)std::ceil(hi); ++s)
+				{
+					float w = (std::min)(s + 1.0f, hi) - (std::max)((float)s, lo);
+					if(w <= 0.0f)
+						continue;
+
+					taps.Indices.push_back(MapEdge(s, srcSize, wrap));
+					taps.Weights.push_back(w);
+				}
+			}
+			else
+			{
+				const float support = FilterRadius(filter)*scale;
+				for(int s = (int)std::floor(center - support); s <= (int)std::ceil(center + support); ++s)
+				{
+					float w = EvaluateKernel(filter, (s + 0.5f - center) / scale);
+					if(w == 0.0f)
+						continue;
+
+					taps.Indices.push_back(MapEdge(s, srcSize, wrap));
+					taps.Weights.push_back(w);
+				}
+			}
+
+			float sum = 0.0f;
+			for(size_t k = first; k < taps.Weights.size(); ++k)
+				sum += taps.Weights[k];
+			for(size_t k = first; k < taps.Weights.size(); ++k)
+				taps.Weights[k] /= sum;
+
+			taps.Offsets.push_back((uint32)taps.Weights.size());
+		}
+
+		return taps;
+	}
+
+	//
+	// The two passes.
+	//
+
+	void FilterRow(const float* src, float* dst, uint32 dstWidth, const FilterTaps& taps)
+	{
+		for(uint32 d = 0; d < dstWidth; ++d)
+		{
+			const uint32 begin = taps.Offsets[d];
+			const uint32 end = taps.Offsets[d + 1];
+
+#ifdef MIP_GENERATOR_SSE2
+			__m128 sum = _mm_setzero_ps();
+			for(uint32 k = begin; k < end; ++k)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(taps.Weights[k]), _mm_loadu_ps(src + 4*taps.Indices[k])));
+			_mm_storeu_ps(dst + 4*d, sum);
+#else
+			float sum[4] = {};
+			for(uint32 k = begin; k < end; ++k)
+			{
+				const float* texel = src + 4*taps.Indices[k];
+				for(int c = 0; c < 4; ++c)
+					sum[c] += taps.Weights[k]*texel[c];
+			}
+			memcpy(dst + 4*d, sum, sizeof(sum));
+#endif
+		}
+	}
+
+	// Destination row y is the weighted sum of whole source rows.
+	void FilterColumn(const LinearImage& src, LinearImage& dst, uint32 y, const FilterTaps& taps)
+	{
+		float* out = dst.Row(y);
+		const size_t count = 4*(size_t)dst.Width;
+		std::fill(out, out + count, 0.0f);
+
+		for(uint32 k = taps.Offsets[y]; k < taps.Offsets[y + 1]; ++k)
+		{
+			const float* in = src.Row(taps.Indices[k]);
+			const float w = taps.Weights[k];
+
+#ifdef MIP_GENERATOR_SSE2
+			const __m128 vw = _mm_set1_ps(w);
+			for(size_t i = 0; i < count; i += 4)
+				_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(vw, _mm_loadu_ps(in + i))));
+#else
+			for(size_t i = 0; i < count; ++i)
+				out[i] += w*in[i];
+#endif
+		}
+	}
+
+	// sourceRow(threadIndex, y) returns row y of the srcWidth x srcHeight source as
+	// linear floats.
+	template<typename RowFunc>
+	void Downsample(uint32 srcWidth, uint32 srcHeight, const RowFunc& sourceRow, LinearImage& temp, LinearImage& dst,
+		const MipGenerator::Options& options, unsigned threads)
+	{
+		const uint32 width = (std::max)(1u, srcWidth / 2);
+		const uint32 height = (std::max)(1u, srcHeight / 2);
+		const FilterTaps rowTaps = BuildTaps(srcWidth, width, options.Kernel, options.WrapEdges);
+		const FilterTaps columnTaps = BuildTaps(srcHeight, height, options.Kernel, options.WrapEdges);
+
+		temp.Resize(width, srcHeight);
+		dst.Resize(width, height);
+
+		ParallelFor(srcHeight, threads, [&](unsigned threadIndex, size_t y)
+		{
+			FilterRow(sourceRow(threadIndex, (uint32)y), temp.Row((uint32)y), width, rowTaps);
+		});
+
+		ParallelFor(height, threads, [&](unsigned, size_t y)
+		{
+			FilterColumn(temp, dst, (uint32)y, columnTaps);
+		});
+	}
+
+	//
+	// Conversion to and from bytes.
+	//
+
+	void ToLinear(const uint8* src, uint32 width, bool srgb, float* dst)
+	{
+		const SrgbTables& tables = GetSrgbTables();
+		const float* color = srgb ? tables.ToLinear : tables.ToUnorm;
+
+		for(uint32 x = 0; x < width; ++x)
+		{
+			dst[4*x + 0] = color[src[4*x + 0]];
+			dst[4*x + 1] = color[src[4*x + 1]];
+			dst[4*x + 2] = color[src[4*x + 2]];
+			dst[4*x + 3] = tables.ToUnorm[src[4*x + 3]];
+		}
+	}
+
+	void ToBytes(const LinearImage& image, bool srgb, float alphaScale, const MipGenerator::MipTarget& target,
+		unsigned numThreads)
+	{
+		const SrgbTables& tables = GetSrgbTables();
+
+		ParallelFor(image.Height, LevelThreads(image.Texels.size() / 4, numThreads), [&](unsigned, size_t y)
+		{
+			const float* src = image.Row((uint32)y);
+			uint8* dst = static_cast<uint8*>(target.Data) + y*target.RowPitch;
+			for(uint32 x = 0; x < image.Width; ++x)
+			{
+				for(uint32 c = 0; c < 3; ++c)
+				{
+					float v = Saturate(src[4*x + c]);
+					dst[4*x + c] = srgb ? tables.ToSrgb[(uint32)(v*SrgbTables::LinearSteps + 0.5f)] : (uint8)(v*255.0f + 0.5f);
+				}
+
+				dst[4*x + 3] = (uint8)(Saturate(src[4*x + 3]*alphaScale)*255.0f + 0.5f);
+			}
+		});
+	}
+
+	//
+	// Alpha coverage.
+	//
+
+	float Coverage(const uint8* pixels, size_t rowPitch, uint32 width, uint32 height, float reference)
+	{
+		const SrgbTables& tables = GetSrgbTables();
+
+		size_t passing = 0;
+		for(uint32 y = 0; y < height; ++y)
+		{
+			const uint8* row = pixels + y*rowPitch;
+			for(uint32 x = 0; x < width; ++x)
+				passing += tables.ToUnorm[row[4*x + 3]] > reference;
+		}
+
+		return (float)passing / ((size_t)width*height);
+	}
+
+	float Coverage(const LinearImage& image, float reference, float scale)
+	{
+		size_t passing = 0;
+		for(size_t i = 3; i < image.Texels.size(); i += 4)
+			passing += image.Texels[i]*scale > reference;
+
+		return (float)passing / (image.Texels.size() / 4);
+	}
+
+	// The alpha scale, found by bisection, that brings image's coverage closest to
+	// target.  Coverage only grows with the scale.
+	float FindAlphaScale(const LinearImage& image, float reference, float target)
+	{
+		float lo = 0.0f;
+		float hi = 4.0f;
+		float best = 1.0f;
+		float bestError = std::fabs(Coverage(image, reference, 1.0f) - target);
+
+		for(int i = 0; i < 12 && bestError > 0.0f; ++i)
+		{
+			float scale = 0.5f*(lo + hi);
+			float coverage = Coverage(image, reference, scale);
+			float error = std::fabs(coverage - target);
+			if(error < bestError)
+			{
+				bestError = error;
+				best = scale;
+			}
+
+			if(coverage < target)
+				lo = scale;
+			else
+				hi = scale;
+		}
+
+		return best;
+	}
+}
+
+MipGenerator::uint32 MipGenerator::FullMipCount(uint32 width, uint32 height)
+{
+	uint32 count = 1;
+	while(width > 1 || height > 1)
+	{
+		width = (std::max)(1u, width / 2);
+		height = (std::max)(1u, height / 2);
+		++count;
+	}
+
+	return count;
+}
+
+void MipGenerator::Generate(const void* pixels, size_t rowPitch, uint32 width, uint32 height,
+	const MipTarget* targets, uint32 numTargets, const Options& options)
+{
+	if(numTargets == 0 || width == 0 || height == 0)
+		return;
+
+	const unsigned numThreads = ResolveThreadCount(options.NumThreads);
+	const bool preserveCoverage = options.AlphaReference > 0.0f && options.AlphaReference < 1.0f;
+
+	const uint8* top = static_cast<const uint8*>(pixels);
+	const float targetCoverage = preserveCoverage ? Coverage(top, rowPitch, width, height, options.AlphaReference) : 0.0f;
+
+	// The top level is converted a row at a time as the first pass reads it, rather
+	// than into a float copy four times its size.
+	std::vector<std::vector<float>> rows(numThreads, std::vector<float>(4*(size_t)width));
+	auto topRow = [&](unsigned threadIndex, uint32 y)
+	{
+		float* row = rows[threadIndex].data();
+		ToLinear(top + y*rowPitch, width, options.Srgb, row);
+		return static_cast<const float*>(row);
+	};
+
+	LinearImage src;
+	LinearImage temp;
+	LinearImage dst;
+	for(uint32 level = 0; level < numTargets; ++level)
+	{
+		const uint32 srcWidth = level == 0 ? width : src.Width;
+		const uint32 srcHeight = level == 0 ? height : src.Height;
+		const unsigned threads = LevelThreads((size_t)srcWidth*srcHeight, numThreads);
+
+		if(level == 0)
+		{
+			Downsample(srcWidth, srcHeight, topRow, temp, dst, options, threads);
+		}
+		else
+		{
+			Downsample(srcWidth, srcHeight, [&](unsigned, uint32 y) { return static_cast<const float*>(src.Row(y)); },
+				temp, dst, options, threads);
+		}
+
+		// Only the written alpha is scaled; the next level filters the unscaled one.
+		float alphaScale = preserveCoverage ? FindAlphaScale(dst, options.AlphaReference, targetCoverage) : 1.0f;
+		ToBytes(dst, options.Srgb, alphaScale, targets[level], numThreads);
+
+		std::swap(src, dst);
+	}
+}
+
+void MipGenerator::Generate(const RgbaImage& image, const Options& options, std::vector<RgbaImage>& mips)
+{
+	const uint32 mipCount = FullMipCount(image.Width, image.Height);
+	mips.resize(mipCount);
+	mips[0] = image;
+
+	std::vector<MipTarget> targets(mipCount - 1);
+	for(uint32 level = 1; level < mipCount; ++level)
+	{
+		RgbaImage& mip = mips[level];
+		mip.Width = (std::max)(1u, image.Width >> level);
+		mip.Height = (std::max)(1u, image.Height >> level);
+		mip.Pixels.resize(4*(size_t)mip.Width*mip.Height);
+
+		targets[level - 1].Data = mip.Pixels.data();
+		targets[level - 1].RowPitch = mip.RowPitch();
+	}
+
+	Generate(image.Pixels.data(), image.RowPitch(), image.Width, image.Height, targets.data(), mipCount - 1, options);
+}
+
+float MipGenerator::AlphaCoverage(const RgbaImage& image, float alphaReference)
+{
+	if(image.Pixels.empty())
+		return 0.0f;
+
+	return Coverage(image.Pixels.data(), image.RowPitch(), image.Width, image.Height, alphaReference);
+}
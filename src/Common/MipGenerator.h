@@ -0,0 +1,90 @@
+//***************************************************************************************
+// MipGenerator.h
+//
+// Builds mip chains for 8-bit RGBA images on the CPU.  Each level is filtered from
+// the one above it in linear float, so rounding doesn't compound down the chain:
+//   -Box averages the source area each texel covers (2x2 for even sizes).
+//   -Kaiser and Lanczos are windowed sinc filters that keep more detail in the
+//    smaller mips, at the cost of slight ringing at hard edges.
+// sRGB images are converted to linear light before filtering and back after, so
+// mips of high contrast detail don't darken.  Alpha is always linear.
+//
+// Cutout textures (alpha tested, like WireFence.dds) lose coverage as alpha is
+// averaged down the chain and fade out in the distance; with an alpha reference
+// each level's alpha is scaled so the fraction of texels passing the test matches
+// the top level.
+//
+// Rows are filtered in parallel, four channels at a time with SSE2 where available.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "RgbaImage.h"
+
+class MipGenerator
+{
+public:
+	typedef std::uint8_t uint8;
+	typedef std::uint32_t uint32;
+
+	enum class Filter
+	{
+		Box,
+		Kaiser,
+		Lanczos
+	};
+
+	struct Options
+	{
+		Filter Kernel = Filter::Box;
+
+		// Channels 0-2 hold sRGB encoded colour.
+		bool Srgb = false;
+
+		// Sample across the opposite edge, for tiling textures; otherwise the edge
+		// texels repeat.
+		bool WrapEdges = false;
+
+		// Alpha test threshold in (0, 1) whose coverage every level keeps; 0 turns
+		// coverage preservation off.
+		float AlphaReference = 0.0f;
+
+		// 0 uses every hardware thread.
+		unsigned NumThreads = 0;
+	};
+
+	// Where one level is written: rows of 4-byte pixels RowPitch bytes apart, e.g.
+	// a subresource's footprint in a mapped upload buffer.
+	struct MipTarget
+	{
+		void* Data;
+		size_t RowPitch;
+	};
+
+	///<summary>
+	/// Levels in a full chain down to 1x1, the top level included.
+	///</summary>
+	static uint32 FullMipCount(uint32 width, uint32 height);
+
+	///<summary>
+	/// Generates the numTargets levels below a width x height image whose rows are
+	/// rowPitch bytes apart; level i (1 based) is max(1, width >> i) wide and is
+	/// written to targets[i - 1].  The targets are only written, never read, so
+	/// they can be write-combined memory.
+	///</summary>
+	static void Generate(const void* pixels, size_t rowPitch, uint32 width, uint32 height,
+		const MipTarget* targets, uint32 numTargets, const Options& options);
+
+	///<summary>
+	/// Fills mips with the full chain of image, mips[0] being a copy of image.
+	///</summary>
+	static void Generate(const RgbaImage& image, const Options& options, std::vector<RgbaImage>& mips);
+
+	///<summary>
+	/// Fraction of texels whose alpha is above alphaReference (in [0, 1]).
+	///</summary>
+	static float AlphaCoverage(const RgbaImage& image, float alphaReference);
+};
@@ -0,0 +1,61 @@
+//***************************************************************************************
+// ParallelFor.h
+//
+// Minimal data-parallel loop on std::thread.  Work items are handed out one at a
+// time from a shared counter, so uneven items balance across threads.  Callers
+// that need deterministic output write item i's result to slot i and combine the
+// slots afterwards in order.
+//***************************************************************************************
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+///<summary>
+/// Returns numThreads, or the number of hardware threads if numThreads is 0.
+///</summary>
+inline unsigned ResolveThreadCount(unsigned numThreads)
+{
+	if(numThreads == 0)
+		numThreads = (std::max)(1u, std::thread::hardware_concurrency());
+
+	return numThreads;
+}
+
+///<summary>
+/// Calls func(threadIndex, i) for every i in [0, count) using up to numThreads
+/// threads (0 = every hardware thread).  threadIndex is in [0, numThreads) and lets
+/// func use per-thread scratch memory.  The calling thread does work too.
+///</summary>
+template<typename Func>
+void ParallelFor(size_t count, unsigned numThreads, const Func& func)
+{
+	numThreads = (unsigned)std::min<size_t>(ResolveThreadCount(numThreads), count);
+
+	if(numThreads <= 1)
+	{
+		for(size_t i = 0; i < count; ++i)
+			func(0u, i);
+		return;
+	}
+
+	std::atomic<size_t> next(0);
+	auto worker = [&](unsigned threadIndex)
+	{
+		for(size_t i = next++; i < count; i = next++)
+			func(threadIndex, i);
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads - 1);
+	for(unsigned t = 1; t < numThreads; ++t)
+		threads.emplace_back(worker, t);
+
+	worker(0);
+
+	for(auto& thread : threads)
+		thread.join();
+}
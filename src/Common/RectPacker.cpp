@@ -0,0 +1,180 @@
+//***************************************************************************************
+// RectPacker.cpp
+//***************************************************************************************
+
+#include "RectPacker.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+	typedef RectPacker::Rect Rect;
+	typedef std::uint32_t uint32;
+
+	bool Contains(const Rect& outer, const Rect& inner)
+	{
+		return inner.X >= outer.X && inner.Y >= outer.Y &&
+			inner.X + inner.Width <= outer.X + outer.Width &&
+			inner.Y + inner.Height <= outer.Y + outer.Height;
+	}
+
+	bool Overlaps(const Rect& a, const Rect& b)
+	{
+		return a.X < b.X + b.Width && b.X < a.X + a.Width &&
+			a.Y < b.Y + b.Height && b.Y < a.Y + a.Height;
+	}
+}
+
+RectPacker::RectPacker(uint32 width, uint32 height)
+{
+	Reset(width, height);
+}
+
+void RectPacker::Reset(uint32 width, uint32 height)
+{
+	mWidth = width;
+	mHeight = height;
+	mUsedArea = 0;
+
+	mFreeRects.clear();
+	if(width > 0 && height > 0)
+		mFreeRects.push_back({ 0, 0, width, height });
+}
+
+bool RectPacker::Insert(uint32 width, uint32 height, Rect& placed)
+{
+	if(width == 0 || height == 0)
+		return false;
+
+	// Best short side fit, ties broken by the long side.
+	uint32 bestShort = (std::numeric_limits<uint32>::max)();
+	uint32 bestLong = (std::numeric_limits<uint32>::max)();
+	const Rect* best = nullptr;
+	for(const Rect& free : mFreeRects)
+	{
+		if(free.Width < width || free.Height < height)
+			continue;
+
+		uint32 leftoverX = free.Width - width;
+		uint32 leftoverY = free.Height - height;
+		uint32 shortSide = (std::min)(leftoverX, leftoverY);
+		uint32 longSide = (std::max)(leftoverX, leftoverY);
+		if(shortSide < bestShort || (shortSide == bestShort && longSide < bestLong))
+		{
+			bestShort = shortSide;
+			bestLong = longSide;
+			best = &free;
+		}
+	}
+
+	if(best == nullptr)
+		return false;
+
+	placed = { best->X, best->Y, width, height };
+	SplitFreeRects(placed);
+	mUsedArea += (std::uint64_t)width*height;
+	return true;
+}
+
+uint32 RectPacker::Pack(const std::vector<Rect>& sizes, std::vector<Rect>& placed)
+{
+	std::vector<uint32> order(sizes.size());
+	std::iota(order.begin(), order.end(), 0u);
+	std::stable_sort(order.begin(), order.end(), [&sizes](uint32 a, uint32 b)
+	{
+		uint32 sideA = (std::max)(sizes[a].Width, sizes[a].Height);
+		uint32 sideB = (std::max)(sizes[b].Width, sizes[b].Height);
+		if(sideA != sideB)
+			return sideA > sideB;
+		return (std::uint64_t)sizes[a].Width*sizes[a].Height > (std::uint64_t)sizes[b].Width*sizes[b].Height;
+	});
+
+	placed.assign(sizes.size(), Rect());
+	uint32 count = 0;
+	for(uint32 i : order)
+	{
+		if(Insert(sizes[i].Width, sizes[i].Height, placed[i]))
+			++count;
+	}
+
+	return count;
+}
+
+float RectPacker::Occupancy()const
+{
+	std::uint64_t area = (std::uint64_t)mWidth*mHeight;
+	return area > 0 ? (float)((double)mUsedArea / area) : 0.0f;
+}
+
+void RectPacker::SplitFreeRects(const Rect& used)
+{
+	// Replace every free rectangle used overlaps with the maximal rectangles left
+	// on each side of it.
+	mNewFreeRects.clear();
+	for(size_t i = 0; i < mFreeRects.size(); )
+	{
+		const Rect free = mFreeRects[i];
+		if(!Overlaps(free, used))
+		{
+			++i;
+			continue;
+		}
+
+		if(used.X > free.X)
+			mNewFreeRects.push_back({ free.X, free.Y, used.X - free.X, free.Height });
+		if(used.X + used.Width < free.X + free.Width)
+			mNewFreeRects.push_back({ used.X + used.Width, free.Y, free.X + free.Width - (used.X + used.Width), free.Height });
+		if(used.Y > free.Y)
+			mNewFreeRects.push_back({ free.X, free.Y, free.Width, used.Y - free.Y });
+		if(used.Y + used.Height < free.Y + free.Height)
+			mNewFreeRects.push_back({ free.X, used.Y + used.Height, free.Width, free.Y + free.Height - (used.Y + used.Height) });
+
+		mFreeRects[i] = mFreeRects.back();
+		mFreeRects.pop_back();
+	}
+
+	PruneFreeRects();
+}
+
+void RectPacker::PruneFreeRects()
+{
+	// The untouched free rectangles were maximal and can't lie inside a piece of
+	// one that was split, so only the new pieces need checking: against each other
+	// and against the old ones.
+	for(size_t i = 0; i < mNewFreeRects.size(); ++i)
+	{
+		const Rect& piece = mNewFreeRects[i];
+		bool redundant = false;
+
+		for(const Rect& free : mFreeRects)
+		{
+			if(Contains(free, piece))
+			{
+				redundant = true;
+				break;
+			}
+		}
+
+		for(size_t j = 0; j < mNewFreeRects.size() && !redundant; ++j)
+		{
+			if(j == i || !Contains(mNewFreeRects[j], piece))
+				continue;
+
+			// Of two identical pieces keep the first.
+			const Rect& other = mNewFreeRects[j];
+			bool identical = other.X == piece.X && other.Y == piece.Y &&
+				other.Width == piece.Width && other.Height == piece.Height;
+			redundant = !identical || j < i;
+		}
+
+		if(redundant)
+			mNewFreeRects[i].Width = 0;
+	}
+
+	for(const Rect& piece : mNewFreeRects)
+	{
+		if(piece.Width > 0)
+			mFreeRects.push_back(piece);
+	}
+}
@@ -0,0 +1,71 @@
+//***************************************************************************************
+// RectPacker.h
+//
+// Places rectangles in a fixed size bin with the MaxRects algorithm (Jukka Jylanki,
+// "A Thousand Ways to Pack the Bin").  The packer keeps the list of maximal free
+// rectangles, which may overlap; each rectangle goes in the free rectangle that
+// leaves the shortest leftover side (best short side fit), and every free
+// rectangle it overlaps is split into the up to four maximal pieces around it.
+//
+// Packing the largest rectangles first gives the tightest results, so Pack sorts
+// a whole set before inserting it.  Rectangles are never rotated: texture atlases
+// would need their UVs rotated too.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class RectPacker
+{
+public:
+	typedef std::uint32_t uint32;
+
+	struct Rect
+	{
+		uint32 X = 0;
+		uint32 Y = 0;
+		uint32 Width = 0;
+		uint32 Height = 0;
+	};
+
+	RectPacker() = default;
+	RectPacker(uint32 width, uint32 height);
+
+	///<summary>
+	/// Empties the bin and resizes it.
+	///</summary>
+	void Reset(uint32 width, uint32 height);
+
+	///<summary>
+	/// Places a width x height rectangle and returns true, or returns false if it
+	/// doesn't fit anywhere.
+	///</summary>
+	bool Insert(uint32 width, uint32 height, Rect& placed);
+
+	///<summary>
+	/// Places sizes[i] at placed[i], largest first, and returns how many fit.
+	/// Those that don't fit get a zero sized Rect.
+	///</summary>
+	uint32 Pack(const std::vector<Rect>& sizes, std::vector<Rect>& placed);
+
+	uint32 GetWidth()const { return mWidth; }
+	uint32 GetHeight()const { return mHeight; }
+
+	///<summary>
+	/// Fraction of the bin covered by placed rectangles.
+	///</summary>
+	float Occupancy()const;
+
+private:
+	void SplitFreeRects(const Rect& used);
+	void PruneFreeRects();
+
+	uint32 mWidth = 0;
+	uint32 mHeight = 0;
+	std::uint64_t mUsedArea = 0;
+
+	std::vector<Rect> mFreeRects;
+	std::vector<Rect> mNewFreeRects;
+};
@@ -0,0 +1,202 @@
+//***************************************************************************************
+// RgbaImage.cpp
+//***************************************************************************************
+
+#include "RgbaImage.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include "BcDecoder.h"
+#include "DdsFile.h"
+#include "MappedFile.h"
+
+namespace
+{
+	using uint8 = std::uint8_t;
+	using uint16 = std::uint16_t;
+	using uint32 = std::uint32_t;
+	using int32 = std::int32_t;
+
+	//
+	// The parts of the BMP file structures the loader reads.
+	//
+
+#pragma pack(push,1)
+
+	struct BMP_FILEHEADER
+	{
+		uint16 type;
+		uint32 size;
+		uint16 reserved1;
+		uint16 reserved2;
+		uint32 offBits;
+	};
+
+	struct BMP_INFOHEADER
+	{
+		uint32 size;
+		int32 width;
+		int32 height;
+		uint16 planes;
+		uint16 bitCount;
+		uint32 compression;
+		uint32 sizeImage;
+		int32 xPelsPerMeter;
+		int32 yPelsPerMeter;
+		uint32 clrUsed;
+		uint32 clrImportant;
+	};
+
+#pragma pack(pop)
+
+	const uint32 BMP_RGB = 0; // BI_RGB
+}
+
+bool RgbaImage::HasAlpha()const
+{
+	for(size_t i = 3; i < Pixels.size(); i += 4)
+	{
+		if(Pixels[i] != 255)
+			return true;
+	}
+
+	return false;
+}
+
+bool RgbaImage::LoadBmp(const std::string& filename, RgbaImage& image, std::string& error)
+{
+	MappedFile file;
+	if(!file.Open(filename) || file.Size() < sizeof(BMP_FILEHEADER) + sizeof(BMP_INFOHEADER))
+	{
+		error = "can't read bitmap";
+		return false;
+	}
+
+	BMP_FILEHEADER fileHeader;
+	BMP_INFOHEADER info;
+	memcpy(&fileHeader, file.Begin(), sizeof(fileHeader));
+	memcpy(&info, file.Begin() + sizeof(fileHeader), sizeof(info));
+
+	if(fileHeader.type != 0x4d42 || info.size < sizeof(BMP_INFOHEADER) || info.planes != 1 ||
+		info.compression != BMP_RGB || (info.bitCount != 24 && info.bitCount != 32) ||
+		info.width <= 0 || info.height == 0)
+	{
+		error = "only uncompressed 24 and 32-bit bitmaps are supported";
+		return false;
+	}
+
+	// Rows are padded to 4 bytes and stored bottom-up unless the height is negative.
+	const uint32 width = (uint32)info.width;
+	const uint32 height = (uint32)(info.height < 0 ? -(std::int64_t)info.height : info.height);
+	const uint32 bytesPerPixel = info.bitCount / 8;
+	const size_t rowPitch = ((size_t)width*bytesPerPixel + 3) & ~(size_t)3;
+	if(fileHeader.offBits > file.Size() || rowPitch*height > file.Size() - fileHeader.offBits)
+	{
+		error = "bitmap is truncated";
+		return false;
+	}
+
+	image.Width = width;
+	image.Height = height;
+	image.Pixels.resize(4*(size_t)width*height);
+
+	// BMP stores blue, green, red (, alpha).
+	bool anyAlpha = false;
+	for(uint32 y = 0; y < height; ++y)
+	{
+		uint32 srcRow = info.height > 0 ? height - 1 - y : y;
+		const uint8* src = reinterpret_cast<const uint8*>(file.Begin()) + fileHeader.offBits + rowPitch*srcRow;
+		uint8* dst = &image.Pixels[4*(size_t)width*y];
+
+		for(uint32 x = 0; x < width; ++x)
+		{
+			dst[4*x + 0] = src[bytesPerPixel*x + 2];
+			dst[4*x + 1] = src[bytesPerPixel*x + 1];
+			dst[4*x + 2] = src[bytesPerPixel*x + 0];
+			dst[4*x + 3] = bytesPerPixel == 4 ? src[4*x + 3] : 255;
+			anyAlpha = anyAlpha || dst[4*x + 3] != 0;
+		}
+	}
+
+	if(!anyAlpha)
+	{
+		for(size_t i = 3; i < image.Pixels.size(); i += 4)
+			image.Pixels[i] = 255;
+	}
+
+	return true;
+}
+
+bool RgbaImage::LoadDds(const std::string& filename, RgbaImage& image, std::string& error)
+{
+	DdsFile dds;
+	DdsStatus status = dds.Open(filename);
+	if(status != DdsStatus::Ok)
+	{
+		error = DdsFile::StatusString(status);
+		return false;
+	}
+
+	if(dds.GetDimension() != DdsDimension::Texture2D)
+	{
+		error = "only 2D textures are supported";
+		return false;
+	}
+
+	const DdsSubresource& top = dds.GetSubresource(0, 0);
+	image.Width = top.Width;
+	image.Height = top.Height;
+	image.Pixels.resize(4*(size_t)top.Width*top.Height);
+
+	const DXGI_FORMAT format = dds.GetFormat();
+	if(BcDecoder::IsSupported(format) && BcDecoder::GetDecodedFormat(format) != DXGI_FORMAT_R8G8B8A8_SNORM)
+	{
+		BcDecoder::Decode(format, top.Data, top.RowPitch, top.Width, top.Height, image.Pixels.data(), image.RowPitch());
+		return true;
+	}
+
+	const bool isRgba = format == DXGI_FORMAT_R8G8B8A8_UNORM || format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+	const bool isBgra = format == DXGI_FORMAT_B8G8R8A8_UNORM || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+	const bool isBgrx = format == DXGI_FORMAT_B8G8R8X8_UNORM || format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+	if(!isRgba && !isBgra && !isBgrx)
+	{
+		error = "only 8-bit RGBA/BGRA and BC1-BC5/BC7 textures are supported";
+		return false;
+	}
+
+	for(uint32 y = 0; y < top.Height; ++y)
+	{
+		const uint8* src = top.Data + y*top.RowPitch;
+		uint8* dst = &image.Pixels[y*image.RowPitch()];
+		if(isRgba)
+		{
+			memcpy(dst, src, image.RowPitch());
+			continue;
+		}
+
+		for(uint32 x = 0; x < top.Width; ++x)
+		{
+			dst[4*x + 0] = src[4*x + 2];
+			dst[4*x + 1] = src[4*x + 1];
+			dst[4*x + 2] = src[4*x + 0];
+			dst[4*x + 3] = isBgrx ? 255 : src[4*x + 3];
+		}
+	}
+
+	return true;
+}
+
+bool RgbaImage::Load(const std::string& filename, RgbaImage& image, std::string& error)
+{
+	std::string extension = filename.substr((std::min)(filename.size(), filename.find_last_of('.')));
+	for(char& c : extension)
+		c = (char)tolower((unsigned char)c);
+
+	if(extension == ".bmp")
+		return LoadBmp(filename, image, error);
+	if(extension == ".dds")
+		return LoadDds(filename, image, error);
+
+	error = "unknown image type " + extension;
+	return false;
+}
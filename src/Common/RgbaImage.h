@@ -0,0 +1,46 @@
+//***************************************************************************************
+// RgbaImage.h
+//
+// An 8-bit R, G, B, A image in memory, and loaders for the source formats the
+// texture tools accept: uncompressed 24 and 32-bit .bmp files, and .dds files with
+// 8-bit channels or any format BcDecoder decodes.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct RgbaImage
+{
+	typedef std::uint8_t uint8;
+	typedef std::uint32_t uint32;
+
+	uint32 Width = 0;
+	uint32 Height = 0;
+
+	// 4 bytes per pixel in R, G, B, A order; rows top to bottom, tightly packed.
+	std::vector<uint8> Pixels;
+
+	size_t RowPitch()const { return 4*(size_t)Width; }
+
+	// True if any pixel's alpha is below 255.
+	bool HasAlpha()const;
+
+	///<summary>
+	/// Loads an uncompressed 24 or 32-bit bitmap.  A 32-bit bitmap whose fourth
+	/// bytes are all zero is read as opaque, as BI_RGB leaves them unused.
+	///</summary>
+	static bool LoadBmp(const std::string& filename, RgbaImage& image, std::string& error);
+
+	///<summary>
+	/// Loads the top mip of the first slice of a DDS file.
+	///</summary>
+	static bool LoadDds(const std::string& filename, RgbaImage& image, std::string& error);
+
+	///<summary>
+	/// Loads a .bmp or .dds file by extension.
+	///</summary>
+	static bool Load(const std::string& filename, RgbaImage& image, std::string& error);
+};
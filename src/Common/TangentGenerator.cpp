@@ -0,0 +1,272 @@
+//***************************************************************************************
+// TangentGenerator.cpp
+//***************************************************************************************
+
+#include "TangentGenerator.h"
+#include "ParallelFor.h"
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	using uint32 = std::uint32_t;
+
+	// Triangles and vertices are handed to the threads in blocks this size.
+	const size_t BlockSize = 1024;
+
+	template<typename T>
+	const T& StreamElement(const T* base, size_t stride, size_t i)
+	{
+		return *reinterpret_cast<const T*>(reinterpret_cast<const char*>(base) + i*stride);
+	}
+
+	// Texture mapping derivatives of one triangle: the directions in which u and v
+	// increase.  Both are zero if the triangle has no usable mapping.
+	struct TriangleFrame
+	{
+		XMFLOAT3 T;
+		XMFLOAT3 B;
+	};
+
+	// A vertex's frame, or the two frames of a vertex that is split.
+	struct VertexFrame
+	{
+		XMFLOAT4 Tangent;
+		XMFLOAT4 SplitTangent;
+		bool Split;
+	};
+
+	template<typename Func>
+	void ParallelForBlocks(size_t count, unsigned numThreads, const Func& func)
+	{
+		size_t numBlocks = (count + BlockSize - 1) / BlockSize;
+		ParallelFor(numBlocks, numThreads, [&](unsigned, size_t block)
+		{
+			size_t first = block * BlockSize;
+			size_t last = std::min(first + BlockSize, count);
+			for(size_t i = first; i < last; ++i)
+				func(i);
+		});
+	}
+
+	// Any unit vector perpendicular to n.
+	XMVECTOR PerpendicularTangent(FXMVECTOR n)
+	{
+		XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+		if(fabsf(XMVectorGetX(XMVector3Dot(n, up))) < 1.0f - 0.001f)
+			return XMVector3Normalize(XMVector3Cross(up, n));
+
+		up = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+		return XMVector3Normalize(XMVector3Cross(n, up));
+	}
+
+	// Removes the normal component of t and normalizes; falls back to an arbitrary
+	// tangent if nothing is left.
+	XMFLOAT4 OrthogonalTangent(FXMVECTOR n, FXMVECTOR t, float handedness)
+	{
+		XMVECTOR tn = t - n * XMVector3Dot(n, t);
+		tn = XMVectorGetX(XMVector3LengthSq(tn)) > 1.0e-12f ? XMVector3Normalize(tn) : PerpendicularTangent(n);
+
+		XMFLOAT4 result;
+		XMStoreFloat4(&result, XMVectorSetW(tn, handedness));
+		return result;
+	}
+
+	float CornerAngle(FXMVECTOR p0, FXMVECTOR p1, FXMVECTOR p2)
+	{
+		XMVECTOR e1 = p1 - p0;
+		XMVECTOR e2 = p2 - p0;
+		float lenSq = XMVectorGetX(XMVector3LengthSq(e1)) * XMVectorGetX(XMVector3LengthSq(e2));
+		if(lenSq <= 0.0f)
+			return 0.0f;
+
+		float c = XMVectorGetX(XMVector3Dot(e1, e2)) / sqrtf(lenSq);
+		return acosf(std::min(std::max(c, -1.0f), 1.0f));
+	}
+}
+
+TangentFrames TangentGenerator::Generate(
+	const XMFLOAT3* positions, size_t positionStride,
+	const XMFLOAT3* normals, size_t normalStride,
+	const XMFLOAT2* texC, size_t texCStride,
+	size_t vertexCount,
+	const uint32* indices, size_t indexCount,
+	unsigned numThreads)
+{
+	const size_t triangleCount = indexCount / 3;
+
+	//
+	// Texture mapping derivatives of every triangle.
+	//
+
+	std::vector<TriangleFrame> triangleFrames(triangleCount);
+	ParallelForBlocks(triangleCount, numThreads, [&](size_t t)
+	{
+		uint32 i0 = indices[t*3+0];
+		uint32 i1 = indices[t*3+1];
+		uint32 i2 = indices[t*3+2];
+
+		XMVECTOR p0 = XMLoadFloat3(&StreamElement(positions, positionStride, i0));
+		XMVECTOR e1 = XMLoadFloat3(&StreamElement(positions, positionStride, i1)) - p0;
+		XMVECTOR e2 = XMLoadFloat3(&StreamElement(positions, positionStride, i2)) - p0;
+
+		const XMFLOAT2& uv0 = StreamElement(texC, texCStride, i0);
+		const XMFLOAT2& uv1 = StreamElement(texC, texCStride, i1);
+		const XMFLOAT2& uv2 = StreamElement(texC, texCStride, i2);
+		float du1 = uv1.x - uv0.x, dv1 = uv1.y - uv0.y;
+		float du2 = uv2.x - uv0.x, dv2 = uv2.y - uv0.y;
+
+		XMVECTOR T = XMVectorZero();
+		XMVECTOR B = XMVectorZero();
+
+		// The determinant only decides the orientation; its magnitude would just
+		// scale both directions, which are normalized.
+		float det = du1*dv2 - du2*dv1;
+		if(fabsf(det) > 1.0e-20f)
+		{
+			float r = det > 0.0f ? 1.0f : -1.0f;
+			T = (e1*dv2 - e2*dv1) * r;
+			B = (e2*du1 - e1*du2) * r;
+
+			T = XMVectorGetX(XMVector3LengthSq(T)) > 0.0f ? XMVector3Normalize(T) : XMVectorZero();
+			B = XMVectorGetX(XMVector3LengthSq(B)) > 0.0f ? XMVector3Normalize(B) : XMVectorZero();
+		}
+
+		XMStoreFloat3(&triangleFrames[t].T, T);
+		XMStoreFloat3(&triangleFrames[t].B, B);
+	});
+
+	//
+	// Triangle corners around each vertex, in index buffer order.
+	//
+
+	std::vector<uint32> cornerStart(vertexCount + 1, 0);
+	for(size_t c = 0; c < triangleCount*3; ++c)
+		cornerStart[indices[c] + 1]++;
+	for(size_t v = 0; v < vertexCount; ++v)
+		cornerStart[v + 1] += cornerStart[v];
+
+	std::vector<uint32> vertexCorners(triangleCount*3);
+	{
+		std::vector<uint32> fill(cornerStart.begin(), cornerStart.end() - 1);
+		for(size_t c = 0; c < triangleCount*3; ++c)
+			vertexCorners[fill[indices[c]]++] = (uint32)c;
+	}
+
+	//
+	// Average the triangle tangents around every vertex, separately for each
+	// handedness, and split the vertex if both are present.  splitCorner marks the
+	// corners that move to the split copy.
+	//
+
+	std::vector<VertexFrame> vertexFrames(vertexCount);
+	std::vector<std::uint8_t> splitCorner(triangleCount*3, 0);
+	ParallelForBlocks(vertexCount, numThreads, [&](size_t v)
+	{
+		XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&StreamElement(normals, normalStride, v)));
+
+		XMVECTOR sum[2] = { XMVectorZero(), XMVectorZero() };
+		float weight[2] = { 0.0f, 0.0f };
+
+		for(uint32 k = cornerStart[v]; k < cornerStart[v + 1]; ++k)
+		{
+			uint32 c = vertexCorners[k];
+			const TriangleFrame& frame = triangleFrames[c / 3];
+
+			XMVECTOR T = XMLoadFloat3(&frame.T);
+			XMVECTOR B = XMLoadFloat3(&frame.B);
+			if(XMVector3Equal(T, XMVectorZero()))
+				continue;
+
+			uint32 tri = c - c % 3;
+			XMVECTOR p0 = XMLoadFloat3(&StreamElement(positions, positionStride, indices[c]));
+			XMVECTOR p1 = XMLoadFloat3(&StreamElement(positions, positionStride, indices[tri + (c + 1) % 3]));
+			XMVECTOR p2 = XMLoadFloat3(&StreamElement(positions, positionStride, indices[tri + (c + 2) % 3]));
+			float angle = CornerAngle(p0, p1, p2);
+
+			int side = XMVectorGetX(XMVector3Dot(XMVector3Cross(n, T), B)) < 0.0f ? 1 : 0;
+			sum[side] += T * angle;
+			weight[side] += angle;
+		}
+
+		// The side with more weight keeps the vertex.
+		int keep = weight[1] > weight[0] ? 1 : 0;
+		int other = 1 - keep;
+
+		VertexFrame& frame = vertexFrames[v];
+		frame.Tangent = OrthogonalTangent(n, sum[keep], keep == 0 ? 1.0f : -1.0f);
+		frame.Split = weight[keep] > 0.0f && weight[other] > 0.0f;
+		if(!frame.Split)
+			return;
+
+		frame.SplitTangent = OrthogonalTangent(n, sum[other], other == 0 ? 1.0f : -1.0f);
+
+		for(uint32 k = cornerStart[v]; k < cornerStart[v + 1]; ++k)
+		{
+			uint32 c = vertexCorners[k];
+			const TriangleFrame& tf = triangleFrames[c / 3];
+
+			XMVECTOR T = XMLoadFloat3(&tf.T);
+			if(XMVector3Equal(T, XMVectorZero()))
+				continue;
+
+			int side = XMVectorGetX(XMVector3Dot(XMVector3Cross(n, T), XMLoadFloat3(&tf.B))) < 0.0f ? 1 : 0;
+			splitCorner[c] = side == other ? 1 : 0;
+		}
+	});
+
+	//
+	// Number the split copies after the source vertices, in vertex order.
+	//
+
+	TangentFrames result;
+	result.Tangents.resize(vertexCount);
+	result.Remap.resize(vertexCount);
+
+	std::vector<uint32> splitIndex(vertexCount, 0);
+	for(size_t v = 0; v < vertexCount; ++v)
+	{
+		result.Tangents[v] = vertexFrames[v].Tangent;
+		result.Remap[v] = (uint32)v;
+
+		if(vertexFrames[v].Split)
+		{
+			splitIndex[v] = (uint32)result.Remap.size();
+			result.Tangents.push_back(vertexFrames[v].SplitTangent);
+			result.Remap.push_back((uint32)v);
+		}
+	}
+
+	result.Indices.assign(indices, indices + indexCount);
+	ParallelForBlocks(triangleCount*3, numThreads, [&](size_t c)
+	{
+		if(splitCorner[c])
+			result.Indices[c] = splitIndex[indices[c]];
+	});
+
+	return result;
+}
+
+void TangentGenerator::Generate(GeometryGenerator::MeshData& meshData, unsigned numThreads)
+{
+	if(meshData.Vertices.empty())
+		return;
+
+	const GeometryGenerator::Vertex& v = meshData.Vertices[0];
+	TangentFrames frames = Generate(
+		&v.Position, sizeof(GeometryGenerator::Vertex),
+		&v.Normal, sizeof(GeometryGenerator::Vertex),
+		&v.TexC, sizeof(GeometryGenerator::Vertex),
+		meshData.Vertices.size(), meshData.Indices32.data(), meshData.Indices32.size(), numThreads);
+
+	auto& vertices = meshData.Vertices;
+	vertices.reserve(frames.Remap.size());
+	for(size_t i = vertices.size(); i < frames.Remap.size(); ++i)
+		vertices.push_back(vertices[frames.Remap[i]]);
+
+	for(size_t i = 0; i < vertices.size(); ++i)
+		vertices[i].TangentU = XMFLOAT3(frames.Tangents[i].x, frames.Tangents[i].y, frames.Tangents[i].z);
+
+	meshData.Indices32 = std::move(frames.Indices);
+}
@@ -0,0 +1,114 @@
+//***************************************************************************************
+// TangentGenerator.h
+//
+// Computes per-vertex tangent frames for indexed triangle meshes from their
+// positions, normals and texture coordinates, for models that don't ship with
+// tangents (Skull.txt, Car.txt, ...).
+//
+// Each triangle gets the tangent and bitangent of its texture mapping (Lengyel,
+// "Computing Tangent Space Basis Vectors for an Arbitrary Mesh"); each vertex
+// averages the tangents of its triangles weighted by the corner angle and
+// orthogonalizes the result against its normal.  Where the triangles around a
+// vertex disagree about the handedness of the mapping (a mirrored UV seam), the
+// vertex is split in two so each side gets its own frame instead of an average
+// that cancels out.  Vertices with no usable texture mapping get an arbitrary
+// tangent perpendicular to the normal, which is enough for normal mapping to
+// reproduce the interpolated vertex normal.
+//
+// The triangle and vertex passes run on ParallelFor.  Every vertex sums its
+// triangles in index buffer order, so the output is bit-identical for any
+// thread count.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <DirectXMath.h>
+#include "GeometryGenerator.h"
+
+struct TangentFrames
+{
+	// One per output vertex.  xyz: unit tangent orthogonal to the normal, w: +1 or
+	// -1, the sign of the bitangent relative to cross(normal, tangent).
+	std::vector<DirectX::XMFLOAT4> Tangents;
+
+	// Source vertex of each output vertex.  The first vertexCount entries are the
+	// source vertices themselves; split vertices are appended after them.
+	std::vector<std::uint32_t> Remap;
+
+	// The source indices with split vertices substituted.
+	std::vector<std::uint32_t> Indices;
+};
+
+class TangentGenerator
+{
+public:
+
+	using uint32 = std::uint32_t;
+
+	///<summary>
+	/// Computes the tangent frames of a triangle list.  numThreads = 0 uses every
+	/// hardware thread; the result does not depend on it.
+	///</summary>
+	static TangentFrames Generate(
+		const DirectX::XMFLOAT3* positions, size_t positionStride,
+		const DirectX::XMFLOAT3* normals, size_t normalStride,
+		const DirectX::XMFLOAT2* texC, size_t texCStride,
+		size_t vertexCount,
+		const uint32* indices, size_t indexCount,
+		unsigned numThreads = 0);
+
+	///<summary>
+	/// Fills in TangentU of meshData, appending the split vertices and updating the
+	/// indices.  MeshData has no handedness, so mirrored halves rely on the split.
+	///</summary>
+	static void Generate(GeometryGenerator::MeshData& meshData, unsigned numThreads = 0);
+
+	///<summary>
+	/// Same for an app vertex struct with Pos, Normal, TexC and TangentU (XMFLOAT3,
+	/// or XMFLOAT4 to keep the handedness in w) members, as loaded from a model file.
+	/// Returns false, leaving the mesh untouched, if the split vertices would not fit
+	/// in IndexT (e.g. a 16-bit indexed mesh pushed past 65535 vertices).
+	///</summary>
+	template<typename VertexT, typename IndexT>
+	static bool Generate(std::vector<VertexT>& vertices, std::vector<IndexT>& indices, unsigned numThreads = 0)
+	{
+		if(vertices.empty())
+			return true;
+
+		std::vector<uint32> indices32(indices.begin(), indices.end());
+
+		const VertexT& v = vertices[0];
+		TangentFrames frames = Generate(
+			&v.Pos, sizeof(VertexT), &v.Normal, sizeof(VertexT), &v.TexC, sizeof(VertexT),
+			vertices.size(), indices32.data(), indices32.size(), numThreads);
+
+		if(frames.Remap.size() - 1 > (size_t)(std::numeric_limits<IndexT>::max)())
+			return false;
+
+		vertices.reserve(frames.Remap.size());
+		for(size_t i = vertices.size(); i < frames.Remap.size(); ++i)
+			vertices.push_back(vertices[frames.Remap[i]]);
+
+		for(size_t i = 0; i < vertices.size(); ++i)
+			StoreTangent(vertices[i].TangentU, frames.Tangents[i]);
+
+		for(size_t i = 0; i < indices.size(); ++i)
+			indices[i] = (IndexT)frames.Indices[i];
+
+		return true;
+	}
+
+private:
+	static void StoreTangent(DirectX::XMFLOAT3& dst, const DirectX::XMFLOAT4& t)
+	{
+		dst = DirectX::XMFLOAT3(t.x, t.y, t.z);
+	}
+
+	static void StoreTangent(DirectX::XMFLOAT4& dst, const DirectX::XMFLOAT4& t)
+	{
+		dst = t;
+	}
+};
@@ -0,0 +1,161 @@
+//***************************************************************************************
+// TaskScheduler.cpp
+//***************************************************************************************
+
+#include "TaskScheduler.h"
+#include <algorithm>
+#include "ParallelFor.h"
+
+TaskScheduler::TaskScheduler(unsigned numThreads) :
+	mThreadCount(ResolveThreadCount(numThreads)),
+	mQueues(mThreadCount),
+	mSteals(0)
+{
+	mThreads.reserve(mThreadCount - 1);
+	for(unsigned t = 1; t < mThreadCount; ++t)
+		mThreads.emplace_back(&TaskScheduler::WorkerMain, this, t);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mWake.notify_all();
+
+	for(auto& thread : mThreads)
+		thread.join();
+}
+
+void TaskScheduler::Run(size_t count, size_t grainSize, RangeFunc func, const void* context)
+{
+	grainSize = (std::max)(grainSize, (size_t)1);
+	if(count == 0)
+		return;
+
+	if(mThreadCount == 1 || count <= grainSize)
+	{
+		func(context, 0, 0, count);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mFunc = func;
+		mContext = context;
+		mGrainSize = grainSize;
+
+		for(unsigned t = 0; t < mThreadCount; ++t)
+		{
+			std::lock_guard<std::mutex> queueLock(mQueues[t].Lock);
+			mQueues[t].Begin = count*t / mThreadCount;
+			mQueues[t].End = count*(t + 1) / mThreadCount;
+		}
+
+		mBusy = mThreadCount - 1;
+		++mGeneration;
+	}
+	mWake.notify_all();
+
+	Work(0);
+
+	// The loop's state lives on the caller's stack; no worker may still be in it.
+	std::unique_lock<std::mutex> lock(mMutex);
+	mDone.wait(lock, [this]() { return mBusy == 0; });
+}
+
+void TaskScheduler::WorkerMain(unsigned threadIndex)
+{
+	std::uint64_t generation = 0;
+	for(;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWake.wait(lock, [&]() { return mStopping || mGeneration != generation; });
+			if(mStopping)
+				return;
+
+			generation = mGeneration;
+		}
+
+		Work(threadIndex);
+
+		bool last;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			last = --mBusy == 0;
+		}
+		if(last)
+			mDone.notify_one();
+	}
+}
+
+void TaskScheduler::Work(unsigned threadIndex)
+{
+	Queue& own = mQueues[threadIndex];
+	for(;;)
+	{
+		size_t begin;
+		size_t end;
+		{
+			std::lock_guard<std::mutex> lock(own.Lock);
+			begin = own.Begin;
+			end = (std::min)(begin + mGrainSize, own.End);
+			own.Begin = end;
+		}
+
+		if(begin < end)
+			mFunc(mContext, threadIndex, begin, end);
+		else if(!Steal(threadIndex))
+			return;
+	}
+}
+
+bool TaskScheduler::Steal(unsigned threadIndex)
+{
+	// The thread with the most left is the likeliest to finish last.
+	unsigned victim = threadIndex;
+	size_t most = 0;
+	for(unsigned t = 0; t < mThreadCount; ++t)
+	{
+		if(t == threadIndex)
+			continue;
+
+		std::lock_guard<std::mutex> lock(mQueues[t].Lock);
+		size_t left = mQueues[t].End - mQueues[t].Begin;
+		if(left > most)
+		{
+			most = left;
+			victim = t;
+		}
+	}
+
+	if(victim == threadIndex)
+		return false;
+
+	size_t begin;
+	size_t end;
+	{
+		std::lock_guard<std::mutex> lock(mQueues[victim].Lock);
+		Queue& queue = mQueues[victim];
+
+		// It may have worked through some of its range since it was counted.
+		size_t left = queue.End - queue.Begin;
+		if(left == 0)
+			return true;
+
+		end = queue.End;
+		begin = queue.End - (left + 1) / 2;
+		queue.End = begin;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mQueues[threadIndex].Lock);
+		mQueues[threadIndex].Begin = begin;
+		mQueues[threadIndex].End = end;
+	}
+
+	++mSteals;
+	return true;
+}
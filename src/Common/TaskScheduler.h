@@ -0,0 +1,102 @@
+//***************************************************************************************
+// TaskScheduler.h
+//
+// Persistent worker threads for per-frame data-parallel loops.  ParallelFor (in
+// ParallelFor.h) starts and joins its threads on every call, which is fine for
+// tools and startup but costs more than the work itself when a loop runs every
+// frame; a TaskScheduler's workers sleep between loops instead.
+//
+// A loop's items are split evenly between the threads up front.  Each thread
+// takes grainSize items at a time from the front of its own range, so the
+// common case touches no shared data.  A thread that runs out steals the back
+// half of the largest range left, and can be stolen from in turn, so a thread
+// that falls behind (preempted, or given expensive items) doesn't hold up the
+// loop.
+//
+// One loop runs at a time, called from one thread, which works on it too.  The
+// loop body must not throw.
+//***************************************************************************************
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskScheduler
+{
+public:
+	///<summary>
+	/// numThreads counts the calling thread (0 = every hardware thread), so one
+	/// starts no workers and runs loops inline.
+	///</summary>
+	explicit TaskScheduler(unsigned numThreads = 0);
+	~TaskScheduler();
+
+	TaskScheduler(const TaskScheduler& rhs) = delete;
+	TaskScheduler& operator=(const TaskScheduler& rhs) = delete;
+
+	///<summary>
+	/// Calls func(threadIndex, i) for every i in [0, count) and returns when all
+	/// calls have.  threadIndex is in [0, GetThreadCount()), 0 being the calling
+	/// thread, for per-thread scratch memory.
+	///</summary>
+	template<typename Func>
+	void ParallelFor(size_t count, size_t grainSize, const Func& func)
+	{
+		auto range = [](const void* context, unsigned threadIndex, size_t begin, size_t end)
+		{
+			const Func& f = *static_cast<const Func*>(context);
+			for(size_t i = begin; i < end; ++i)
+				f(threadIndex, i);
+		};
+
+		Run(count, grainSize, range, &func);
+	}
+
+	unsigned GetThreadCount()const { return mThreadCount; }
+
+	///<summary>
+	/// Ranges taken from another thread since construction.
+	///</summary>
+	std::uint64_t GetStealCount()const { return mSteals.load(); }
+
+private:
+	typedef void (*RangeFunc)(const void* context, unsigned threadIndex, size_t begin, size_t end);
+
+	// The items a thread has left, [Begin, End).  Padded so two threads' ranges
+	// don't share a cache line.
+	struct Queue
+	{
+		std::mutex Lock;
+		size_t Begin = 0;
+		size_t End = 0;
+		char Padding[64];
+	};
+
+	void Run(size_t count, size_t grainSize, RangeFunc func, const void* context);
+	void WorkerMain(unsigned threadIndex);
+	void Work(unsigned threadIndex);
+	bool Steal(unsigned threadIndex);
+
+	unsigned mThreadCount;
+	std::vector<Queue> mQueues;
+	std::vector<std::thread> mThreads;
+
+	std::mutex mMutex;
+	std::condition_variable mWake;
+	std::condition_variable mDone;
+	std::uint64_t mGeneration = 0;
+	unsigned mBusy = 0;
+	bool mStopping = false;
+
+	// The loop being run.
+	RangeFunc mFunc = nullptr;
+	const void* mContext = nullptr;
+	size_t mGrainSize = 1;
+
+	std::atomic<std::uint64_t> mSteals;
+};
@@ -0,0 +1,326 @@
+//***************************************************************************************
+// TextureAtlas.cpp
+//***************************************************************************************
+
+#include "TextureAtlas.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include "RectPacker.h"
+
+namespace
+{
+	typedef std::uint8_t uint8;
+	typedef std::uint32_t uint32;
+
+	uint32 RoundUp(uint32 value, uint32 multiple)
+	{
+		return (value + multiple - 1) / multiple * multiple;
+	}
+
+	uint32 NextPowerOfTwo(uint32 value)
+	{
+		uint32 p = 1;
+		while(p < value)
+			p *= 2;
+		return p;
+	}
+
+	// The next page size to try after size: twice as large for powers of two,
+	// otherwise an eighth larger.
+	uint32 GrowSize(uint32 size, const TextureAtlas::Options& options)
+	{
+		if(options.PowerOfTwo)
+			return size*2;
+		return RoundUp(size + (std::max)(size / 8, 1u), options.BlockAlign);
+	}
+
+	uint32 PageSize(uint32 size, const TextureAtlas::Options& options)
+	{
+		size = RoundUp((std::max)(size, 1u), options.BlockAlign);
+		return options.PowerOfTwo ? NextPowerOfTwo(size) : size;
+	}
+
+	// Fills the rectangle (x0, y0, width, height) of slice with image placed at
+	// (imageX, imageY), repeating its edge texels outside it.
+	void Extrude(const RgbaImage& image, uint32 imageX, uint32 imageY,
+		uint32 x0, uint32 y0, uint32 width, uint32 height, RgbaImage& slice)
+	{
+		for(uint32 y = y0; y < y0 + height; ++y)
+		{
+			int64_t sy = (int64_t)y - imageY;
+			sy = (std::min)((std::max)(sy, (int64_t)0), (int64_t)image.Height - 1);
+
+			const uint8* srcRow = &image.Pixels[(size_t)sy*image.RowPitch()];
+			uint8* dstRow = &slice.Pixels[(size_t)y*slice.RowPitch()];
+
+			for(uint32 x = x0; x < x0 + width; ++x)
+			{
+				int64_t sx = (int64_t)x - imageX;
+				sx = (std::min)((std::max)(sx, (int64_t)0), (int64_t)image.Width - 1);
+				memcpy(dstRow + 4*(size_t)x, srcRow + 4*sx, 4);
+			}
+		}
+	}
+
+	TextureAtlas::Placement MakePlacement(const TextureAtlas::Source& source, uint32 slice,
+		uint32 x, uint32 y, uint32 width, uint32 height)
+	{
+		TextureAtlas::Placement placement;
+		placement.Name = source.Name;
+		placement.Slice = slice;
+		placement.X = x;
+		placement.Y = y;
+		placement.Width = source.Image.Width;
+		placement.Height = source.Image.Height;
+		placement.ScaleU = (float)source.Image.Width / width;
+		placement.ScaleV = (float)source.Image.Height / height;
+		placement.OffsetU = (float)x / width;
+		placement.OffsetV = (float)y / height;
+		return placement;
+	}
+
+	void NewSlice(uint32 width, uint32 height, std::vector<RgbaImage>& slices)
+	{
+		slices.emplace_back();
+		slices.back().Width = width;
+		slices.back().Height = height;
+		slices.back().Pixels.assign(4*(size_t)width*height, 0);
+	}
+
+	uint32 MipCount(uint32 width, uint32 height)
+	{
+		uint32 count = 1;
+		while(width > 1 || height > 1)
+		{
+			width = (std::max)(1u, width / 2);
+			height = (std::max)(1u, height / 2);
+			++count;
+		}
+		return count;
+	}
+
+	void BuildArray(const std::vector<TextureAtlas::Source>& sources, const TextureAtlas::Options& options,
+		TextureAtlas::Result& result)
+	{
+		uint32 width = 0;
+		uint32 height = 0;
+		for(const TextureAtlas::Source& source : sources)
+		{
+			width = (std::max)(width, source.Image.Width);
+			height = (std::max)(height, source.Image.Height);
+		}
+
+		result.Width = PageSize(width, options);
+		result.Height = PageSize(height, options);
+		result.CleanMipCount = MipCount(result.Width, result.Height);
+
+		for(uint32 i = 0; i < (uint32)sources.size(); ++i)
+		{
+			NewSlice(result.Width, result.Height, result.Slices);
+			Extrude(sources[i].Image, 0, 0, 0, 0, result.Width, result.Height, result.Slices.back());
+			result.Placements.push_back(MakePlacement(sources[i], i, 0, 0, result.Width, result.Height));
+		}
+	}
+
+	void BuildAtlas(const std::vector<TextureAtlas::Source>& sources, const TextureAtlas::Options& options,
+		TextureAtlas::Result& result)
+	{
+		const uint32 guard = RoundUp(options.GuardBand, options.BlockAlign);
+
+		// Each image's rectangle with its guard band on every side.
+		std::vector<RectPacker::Rect> sizes(sources.size());
+		uint64_t area = 0;
+		uint32 widest = 0;
+		uint32 tallest = 0;
+		for(size_t i = 0; i < sources.size(); ++i)
+		{
+			sizes[i].Width = RoundUp(sources[i].Image.Width + 2*guard, options.BlockAlign);
+			sizes[i].Height = RoundUp(sources[i].Image.Height + 2*guard, options.BlockAlign);
+			area += (uint64_t)sizes[i].Width*sizes[i].Height;
+			widest = (std::max)(widest, sizes[i].Width);
+			tallest = (std::max)(tallest, sizes[i].Height);
+		}
+
+		//
+		// The smallest page that holds everything: start from a square of the
+		// total area and grow the shorter side until it all fits or the page
+		// reaches MaxSize.
+		//
+
+		uint32 side = (uint32)std::ceil(std::sqrt((double)area));
+		uint32 width = (std::min)(PageSize((std::max)(side, widest), options), options.MaxSize);
+		uint32 height = (uint32)(std::min)((area + width - 1) / width, (uint64_t)options.MaxSize);
+		height = (std::min)(PageSize((std::max)(height, tallest), options), options.MaxSize);
+
+		RectPacker packer;
+		std::vector<RectPacker::Rect> placed;
+		for(;;)
+		{
+			packer.Reset(width, height);
+			if(packer.Pack(sizes, placed) == (uint32)sizes.size())
+				break;
+
+			if(width == options.MaxSize && height == options.MaxSize)
+				break;
+
+			if(width <= height && width < options.MaxSize)
+				width = (std::min)(GrowSize(width, options), options.MaxSize);
+			else
+				height = (std::min)(GrowSize(height, options), options.MaxSize);
+		}
+
+		result.Width = width;
+		result.Height = height;
+		result.Placements.resize(sources.size());
+
+		//
+		// Fill pages until every image is placed.  A page at MaxSize takes the
+		// largest images that fit and leaves the rest for the next one.
+		//
+
+		std::vector<uint32> remaining(sources.size());
+		for(uint32 i = 0; i < (uint32)sources.size(); ++i)
+			remaining[i] = i;
+
+		while(!remaining.empty())
+		{
+			std::vector<RectPacker::Rect> pageSizes;
+			for(uint32 i : remaining)
+				pageSizes.push_back(sizes[i]);
+
+			packer.Reset(width, height);
+			packer.Pack(pageSizes, placed);
+
+			const uint32 slice = (uint32)result.Slices.size();
+			NewSlice(width, height, result.Slices);
+
+			std::vector<uint32> next;
+			for(size_t r = 0; r < remaining.size(); ++r)
+			{
+				const RectPacker::Rect& rect = placed[r];
+				const TextureAtlas::Source& source = sources[remaining[r]];
+				if(rect.Width == 0)
+				{
+					next.push_back(remaining[r]);
+					continue;
+				}
+
+				Extrude(source.Image, rect.X + guard, rect.Y + guard, rect.X, rect.Y, rect.Width, rect.Height,
+					result.Slices.back());
+				result.Placements[remaining[r]] = MakePlacement(source, slice, rect.X + guard, rect.Y + guard, width, height);
+			}
+
+			remaining.swap(next);
+		}
+
+		// Level k averages 2^k x 2^k blocks, which start on image boundaries while
+		// 2^k divides BlockAlign, and bilinear filtering reaches 2^(k+1) - 1 texels
+		// past an image's edge.
+		result.CleanMipCount = 1;
+		for(uint32 k = 1; k < 32; ++k)
+		{
+			uint32 block = 1u << k;
+			if(options.BlockAlign % block != 0 || 2*block - 1 > guard)
+				break;
+			result.CleanMipCount = k + 1;
+		}
+		result.CleanMipCount = (std::min)(result.CleanMipCount, MipCount(width, height));
+	}
+}
+
+bool TextureAtlas::Build(const std::vector<Source>& sources, const Options& options, Result& result, std::string& error)
+{
+	result = Result();
+	if(sources.empty())
+	{
+		error = "no images";
+		return false;
+	}
+
+	Options checked = options;
+	checked.BlockAlign = (std::max)(checked.BlockAlign, 1u);
+
+	const uint32 guard = checked.Kind == Layout::Atlas ? RoundUp(checked.GuardBand, checked.BlockAlign) : 0;
+	for(const Source& source : sources)
+	{
+		if(source.Image.Width == 0 || source.Image.Height == 0)
+		{
+			error = source.Name + " is empty";
+			return false;
+		}
+
+		if(RoundUp(source.Image.Width + 2*guard, checked.BlockAlign) > checked.MaxSize ||
+			RoundUp(source.Image.Height + 2*guard, checked.BlockAlign) > checked.MaxSize)
+		{
+			error = source.Name + " doesn't fit in " + std::to_string(checked.MaxSize) + " texels";
+			return false;
+		}
+	}
+
+	if(checked.Kind == Layout::Array)
+		BuildArray(sources, checked, result);
+	else
+		BuildAtlas(sources, checked, result);
+
+	uint64_t covered = 0;
+	for(const Source& source : sources)
+		covered += (uint64_t)source.Image.Width*source.Image.Height;
+	result.Occupancy = (float)((double)covered / ((double)result.Width*result.Height*result.Slices.size()));
+
+	return true;
+}
+
+bool TextureAtlas::SaveLayout(const std::string& filename, const std::vector<Placement>& placements)
+{
+	std::ofstream fout(filename);
+	fout << "# TextureAtlas layout: image <name> <slice> <x> <y> <width> <height> <scaleU> <scaleV> <offsetU> <offsetV>\n";
+	fout.precision(9);
+	for(const Placement& p : placements)
+	{
+		fout << "image " << p.Name << " " << p.Slice << " " << p.X << " " << p.Y << " " << p.Width << " " << p.Height
+			<< " " << p.ScaleU << " " << p.ScaleV << " " << p.OffsetU << " " << p.OffsetV << "\n";
+	}
+
+	return !fout.fail();
+}
+
+bool TextureAtlas::LoadLayout(const std::string& filename, std::vector<Placement>& placements)
+{
+	std::ifstream fin(filename);
+	if(!fin)
+		return false;
+
+	placements.clear();
+	std::string line;
+	while(std::getline(fin, line))
+	{
+		if(line.empty() || line[0] == '#')
+			continue;
+
+		std::istringstream in(line);
+		std::string keyword;
+		Placement p;
+		in >> keyword >> p.Name >> p.Slice >> p.X >> p.Y >> p.Width >> p.Height
+			>> p.ScaleU >> p.ScaleV >> p.OffsetU >> p.OffsetV;
+		if(keyword != "image" || in.fail())
+			return false;
+
+		placements.push_back(p);
+	}
+
+	return true;
+}
+
+const TextureAtlas::Placement* TextureAtlas::Find(const std::vector<Placement>& placements, const std::string& name)
+{
+	for(const Placement& p : placements)
+	{
+		if(p.Name == name)
+			return &p;
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,123 @@
+//***************************************************************************************
+// TextureAtlas.h
+//
+// Packs many small images into few textures, so draws that used one texture (and
+// one SRV) each can share a resource and a descriptor table:
+//   -Atlas: images are placed with RectPacker on pages no larger than MaxSize.
+//    Each image is surrounded by a guard band of its own edge texels repeated,
+//    so bilinear filtering and the first mips don't pick up its neighbours.  If
+//    everything doesn't fit on one page the pages become the slices of a
+//    texture array.
+//   -Array: one image per slice, each in the top-left corner of a slice as large
+//    as the largest image, its edges repeated over the rest of the slice.
+//
+// Either way every image gets a UV transform, scale then offset, that maps its
+// own [0,1] texture coordinates into the packed texture, and a slice index.  An
+// app applies it through the material's MatTransform (and a Texture2DArray when
+// there are several slices).  Images that tile (wrap addressing) can't be
+// packed without changing the shader to wrap inside the image's rectangle.
+//
+// A layout is saved next to the packed DDS file as text, one line per image:
+//   image <name> <slice> <x> <y> <width> <height> <scaleU> <scaleV> <offsetU> <offsetV>
+// Names can't contain spaces.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "RgbaImage.h"
+
+class TextureAtlas
+{
+public:
+	typedef std::uint32_t uint32;
+
+	enum class Layout
+	{
+		Atlas,
+		Array
+	};
+
+	struct Options
+	{
+		Layout Kind = Layout::Atlas;
+
+		// Largest page (or slice) width and height.
+		uint32 MaxSize = 4096;
+
+		// Texels of repeated edge around each image in an atlas.  Rounded up to a
+		// multiple of BlockAlign.
+		uint32 GuardBand = 8;
+
+		// Images start on multiples of this, so 4 keeps every image on whole
+		// BC blocks and none shares a block with a neighbour.
+		uint32 BlockAlign = 4;
+
+		// Round page sizes up to powers of two.
+		bool PowerOfTwo = true;
+	};
+
+	struct Source
+	{
+		std::string Name;
+		RgbaImage Image;
+	};
+
+	// Where one image went.  Texture coordinate t in the image's own [0,1] space
+	// is t*Scale + Offset in the packed texture.
+	struct Placement
+	{
+		std::string Name;
+		uint32 Slice = 0;
+
+		// Texel rectangle of the image itself, without its guard band.
+		uint32 X = 0;
+		uint32 Y = 0;
+		uint32 Width = 0;
+		uint32 Height = 0;
+
+		float ScaleU = 1.0f;
+		float ScaleV = 1.0f;
+		float OffsetU = 0.0f;
+		float OffsetV = 0.0f;
+	};
+
+	struct Result
+	{
+		// Every slice is Width x Height.
+		uint32 Width = 0;
+		uint32 Height = 0;
+		std::vector<RgbaImage> Slices;
+
+		// One per source, in the same order.
+		std::vector<Placement> Placements;
+
+		// Mips whose filtering never reaches a neighbouring image: level k is clean
+		// while the 2^k texel blocks it averages start on image boundaries and the
+		// 2^(k+1) - 1 texels bilinear filtering can reach past an image's edge stay
+		// in its guard band.  Array slices hold one image each, so every mip is.
+		uint32 CleanMipCount = 0;
+
+		// Fraction of the slices' texels covered by images.
+		float Occupancy = 0.0f;
+	};
+
+	///<summary>
+	/// Packs sources.  Returns false with error set if an image is empty or larger
+	/// than MaxSize with its guard band.
+	///</summary>
+	static bool Build(const std::vector<Source>& sources, const Options& options, Result& result, std::string& error);
+
+	///<summary>
+	/// Writes and reads the text layout of the placements described above.
+	///</summary>
+	static bool SaveLayout(const std::string& filename, const std::vector<Placement>& placements);
+	static bool LoadLayout(const std::string& filename, std::vector<Placement>& placements);
+
+	///<summary>
+	/// The placement named name, or nullptr.
+	///</summary>
+	static const Placement* Find(const std::vector<Placement>& placements, const std::string& name);
+};
@@ -0,0 +1,318 @@
+//***************************************************************************************
+// TextureCache.cpp
+//***************************************************************************************
+
+#include "TextureCache.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include "AsyncLoader.h"
+
+TextureCache::TextureCache(Factory& factory, AsyncLoader* loader, const Settings& settings) :
+	mFactory(factory),
+	mLoader(loader),
+	mSettings(settings)
+{
+}
+
+TextureCache::~TextureCache()
+{
+	// Reads in flight call into mFactory and this; let them finish first.
+	for(auto& entry : mSlots)
+	{
+		if(entry.second.Pending.valid())
+			entry.second.Pending.wait();
+	}
+}
+
+TextureCache::Handle TextureCache::Acquire(const std::string& path)
+{
+	const std::string key = CanonicalPath(path);
+	++mClock;
+
+	auto it = mSlots.find(key);
+	if(it != mSlots.end())
+	{
+		++mStats.Hits;
+		it->second.LastUsed = mClock;
+		return it->second.Texture;
+	}
+
+	++mStats.Misses;
+	Slot& slot = mSlots[key];
+	slot.Texture = std::make_shared<Entry>();
+	slot.Texture->Path = key;
+	slot.LastUsed = mClock;
+
+	if(mLoader != nullptr)
+		slot.Pending = mLoader->Submit([this, key]() { return Read(key); });
+	else
+	{
+		std::promise<ReadResult> read;
+		read.set_value(Read(key));
+		slot.Pending = read.get_future().share();
+	}
+
+	UpdateStats();
+	return slot.Texture;
+}
+
+void TextureCache::Update()
+{
+	for(auto& entry : mSlots)
+	{
+		Slot& slot = entry.second;
+		if(slot.Pending.valid() && slot.Pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+			Finish(slot);
+	}
+
+	Trim();
+}
+
+void TextureCache::Flush()
+{
+	for(auto& entry : mSlots)
+	{
+		if(entry.second.Pending.valid())
+			Finish(entry.second);
+	}
+
+	Trim();
+}
+
+void TextureCache::Trim()
+{
+	// A texture someone holds a handle to is in use now.
+	++mClock;
+	std::vector<std::pair<uint64, std::string>> unused;
+	for(auto& entry : mSlots)
+	{
+		Slot& slot = entry.second;
+		if(slot.Texture.use_count() > 1)
+			slot.LastUsed = mClock;
+		else if(slot.Texture->Status != State::Loading)
+			unused.push_back({ slot.LastUsed, entry.first });
+	}
+
+	UpdateStats();
+	if(mStats.CpuBytes <= mSettings.CpuBudgetBytes && mStats.GpuBytes <= mSettings.GpuBudgetBytes)
+		return;
+
+	std::sort(unused.begin(), unused.end());
+	for(const auto& victim : unused)
+	{
+		if(mStats.CpuBytes <= mSettings.CpuBudgetBytes && mStats.GpuBytes <= mSettings.GpuBudgetBytes)
+			break;
+
+		Evict(victim.second);
+		UpdateStats();
+	}
+}
+
+void TextureCache::Clear()
+{
+	std::vector<std::string> unused;
+	for(auto& entry : mSlots)
+	{
+		if(entry.second.Texture.use_count() == 1 && entry.second.Texture->Status != State::Loading)
+			unused.push_back(entry.first);
+	}
+
+	for(const std::string& path : unused)
+		Evict(path);
+
+	UpdateStats();
+}
+
+TextureCache::ReadResult TextureCache::Read(const std::string& path)
+{
+	ReadResult result;
+	result.Ok = mFactory.Read(path, result.Bytes, result.Error);
+	if(result.Ok)
+		result.Hash = HashBytes(result.Bytes);
+
+	return result;
+}
+
+void TextureCache::Finish(Slot& slot)
+{
+	std::shared_future<ReadResult> pending = std::move(slot.Pending);
+	slot.Pending = std::shared_future<ReadResult>();
+	const ReadResult& result = pending.get();
+
+	Entry& texture = *slot.Texture;
+	if(!result.Ok)
+	{
+		texture.Status = State::Failed;
+		texture.Error = result.Error;
+		++mStats.Failures;
+		return;
+	}
+
+	// Another file with the same bytes shares its resource.
+	Content* shared = nullptr;
+	auto candidates = mContents.equal_range(result.Hash);
+	for(auto it = candidates.first; it != candidates.second && shared == nullptr; ++it)
+	{
+		if(SameBytes(it->second, result.Bytes))
+			shared = &it->second;
+	}
+
+	if(shared != nullptr)
+		++mStats.ContentHits;
+	else
+	{
+		Created created;
+		std::string error;
+		if(!mFactory.Create(texture.Path, result.Bytes, created, error))
+		{
+			texture.Status = State::Failed;
+			texture.Error = error;
+			++mStats.Failures;
+			return;
+		}
+
+		Content content;
+		content.Resource = std::move(created.Resource);
+		content.Path = texture.Path;
+		content.Size = result.Bytes.size();
+		content.CpuBytes = created.CpuBytes;
+		content.GpuBytes = created.GpuBytes;
+		shared = &mContents.emplace(result.Hash, std::move(content))->second;
+	}
+
+	++shared->Users;
+
+	slot.Shared = shared;
+	texture.ContentHash = result.Hash;
+	texture.CpuBytes = shared->CpuBytes;
+	texture.GpuBytes = shared->GpuBytes;
+	texture.Resource = shared->Resource;
+	texture.Status = State::Ready;
+}
+
+bool TextureCache::SameBytes(const Content& content, const std::vector<uint8>& bytes)
+{
+	if(content.Size != bytes.size())
+		return false;
+
+	// Only the hash of the content's file was kept, so read it again.  This
+	// happens once per copy of a loaded file, which is rare.
+	std::vector<uint8> contentBytes;
+	std::string error;
+	return mFactory.Read(content.Path, contentBytes, error) && contentBytes == bytes;
+}
+
+void TextureCache::Evict(const std::string& path)
+{
+	auto it = mSlots.find(path);
+	const bool ready = it->second.Texture->Status == State::Ready;
+	const uint64 hash = it->second.Texture->ContentHash;
+	Content* shared = it->second.Shared;
+
+	// The entry goes first, so the factory gets the last reference.
+	mSlots.erase(it);
+	++mStats.Evictions;
+
+	if(!ready || --shared->Users > 0)
+		return;
+
+	mFactory.Retire(std::move(shared->Resource));
+
+	auto candidates = mContents.equal_range(hash);
+	for(auto content = candidates.first; content != candidates.second; ++content)
+	{
+		if(&content->second == shared)
+		{
+			mContents.erase(content);
+			break;
+		}
+	}
+}
+
+void TextureCache::UpdateStats()
+{
+	mStats.Entries = (std::uint32_t)mSlots.size();
+	mStats.Resources = (std::uint32_t)mContents.size();
+	mStats.Loading = 0;
+	for(const auto& entry : mSlots)
+	{
+		if(entry.second.Texture->Status == State::Loading)
+			++mStats.Loading;
+	}
+
+	mStats.CpuBytes = 0;
+	mStats.GpuBytes = 0;
+	for(const auto& entry : mContents)
+	{
+		mStats.CpuBytes += entry.second.CpuBytes;
+		mStats.GpuBytes += entry.second.GpuBytes;
+	}
+}
+
+std::string TextureCache::CanonicalPath(const std::string& path)
+{
+	std::string root;
+	std::string rest = path;
+	std::replace(rest.begin(), rest.end(), '\\', '/');
+
+	// Keep a drive ("C:") and a leading '/'; ".." can't climb above them.
+	if(rest.size() >= 2 && rest[1] == ':')
+	{
+		root = rest.substr(0, 2);
+		rest = rest.substr(2);
+	}
+	if(!rest.empty() && rest[0] == '/')
+	{
+		root += '/';
+		rest = rest.substr(1);
+	}
+
+	std::vector<std::string> parts;
+	size_t start = 0;
+	while(start <= rest.size())
+	{
+		size_t end = rest.find('/', start);
+		if(end == std::string::npos)
+			end = rest.size();
+
+		std::string part = rest.substr(start, end - start);
+		start = end + 1;
+
+		if(part.empty() || part == ".")
+			continue;
+
+		if(part == ".." && !parts.empty() && parts.back() != "..")
+			parts.pop_back();
+		else if(part != ".." || root.empty())
+			parts.push_back(part);
+	}
+
+	std::string canonical = root;
+	for(size_t i = 0; i < parts.size(); ++i)
+	{
+		if(i > 0)
+			canonical += '/';
+		canonical += parts[i];
+	}
+
+#ifdef _WIN32
+	// Windows file names aren't case sensitive.
+	std::transform(canonical.begin(), canonical.end(), canonical.begin(),
+		[](char c) { return (char)std::tolower((unsigned char)c); });
+#endif
+
+	return canonical;
+}
+
+TextureCache::uint64 TextureCache::HashBytes(const std::vector<uint8>& bytes)
+{
+	uint64 h = 0xcbf29ce484222325ull;
+	for(uint8 b : bytes)
+	{
+		h ^= b;
+		h *= 0x100000001b3ull;
+	}
+
+	return h;
+}
@@ -0,0 +1,236 @@
+//***************************************************************************************
+// TextureCache.h
+//
+// Loads each texture file once and shares it between everyone who names it:
+//   -Files are keyed by canonical path, so "../../Textures/bricks.dds" and
+//    "..\..\Textures\.\bricks.dds" are the same texture (and, on Windows,
+//    "../../textures/Bricks.dds" too).
+//   -Acquire returns a shared handle at once.  If the file is already loaded or
+//    loading, the handle is the existing one; otherwise the file is read on the
+//    AsyncLoader's workers and turned into a texture on the next Update.
+//   -Files are hashed once read, and a file whose bytes match a texture already
+//    in the cache (a copy under another name) shares that texture.  The hash
+//    only finds candidates; the candidate's file is read again and compared, so
+//    a hash collision gets a texture of its own.
+//   -The CPU and GPU bytes of every texture are tracked against budgets.  When a
+//    budget is exceeded, textures nobody holds a handle to are evicted, least
+//    recently used first.  Textures in use are never evicted, so the budgets
+//    can be overrun by what is actually drawn.
+//
+// The cache doesn't know what a texture is: a Factory reads files and makes
+// textures from their bytes, and the handle holds whatever it made.
+// DdsTextureFactory makes D3D12 textures from DDS files; a stub factory lets the
+// cache run with no device.
+//
+// Acquire, Update, Flush and Trim are called from one thread, the one that owns
+// the command list.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class AsyncLoader;
+
+class TextureCache
+{
+public:
+	typedef std::uint8_t uint8;
+	typedef std::uint64_t uint64;
+
+	struct Settings
+	{
+		uint64 CpuBudgetBytes = 256ull << 20;
+		uint64 GpuBudgetBytes = 512ull << 20;
+	};
+
+	// What a Factory made from a file.
+	struct Created
+	{
+		std::shared_ptr<void> Resource;
+
+		// System memory the texture keeps (e.g. its upload heap) and video memory
+		// it takes.
+		uint64 CpuBytes = 0;
+		uint64 GpuBytes = 0;
+	};
+
+	class Factory
+	{
+	public:
+		virtual ~Factory() = default;
+
+		///<summary>
+		/// Reads the file at path.  Called on a loader thread, several at once, and
+		/// from Update or Flush to compare a file with another of the same hash.
+		///</summary>
+		virtual bool Read(const std::string& path, std::vector<uint8>& bytes, std::string& error) = 0;
+
+		///<summary>
+		/// Makes a texture from the bytes of the file at path.  Called from Update
+		/// or Flush.
+		///</summary>
+		virtual bool Create(const std::string& path, const std::vector<uint8>& bytes, Created& created, std::string& error) = 0;
+
+		///<summary>
+		/// Takes an evicted texture, which no handle refers to any more.  A GPU
+		/// resource may still be in use by frames in flight, so a device factory
+		/// keeps it until they finish.
+		///</summary>
+		virtual void Retire(std::shared_ptr<void>) {}
+	};
+
+	enum class State
+	{
+		Loading,
+		Ready,
+		Failed
+	};
+
+	// What a handle refers to.  Only the cache changes it.
+	struct Entry
+	{
+		std::string Path;
+		State Status = State::Loading;
+		std::string Error;
+
+		uint64 ContentHash = 0;
+		uint64 CpuBytes = 0;
+		uint64 GpuBytes = 0;
+
+		std::shared_ptr<void> Resource;
+
+		// The resource as the type the factory made, or nullptr until Ready.
+		template<typename T>
+		T* Get()const { return static_cast<T*>(Resource.get()); }
+	};
+
+	typedef std::shared_ptr<const Entry> Handle;
+
+	struct Stats
+	{
+		// Textures in the cache, loading ones included, and distinct resources.
+		std::uint32_t Entries = 0;
+		std::uint32_t Resources = 0;
+		std::uint32_t Loading = 0;
+
+		uint64 CpuBytes = 0;
+		uint64 GpuBytes = 0;
+
+		// Totals since construction.  A hit finds the path in the cache (loaded
+		// or still loading); a content hit finds a file's bytes already loaded
+		// under another path.
+		uint64 Hits = 0;
+		uint64 Misses = 0;
+		uint64 ContentHits = 0;
+		uint64 Evictions = 0;
+		uint64 Failures = 0;
+	};
+
+	///<summary>
+	/// With no loader, files are read inside Acquire.
+	///</summary>
+	TextureCache(Factory& factory, AsyncLoader* loader, const Settings& settings);
+	~TextureCache();
+
+	TextureCache(const TextureCache& rhs) = delete;
+	TextureCache& operator=(const TextureCache& rhs) = delete;
+
+	///<summary>
+	/// The texture at path, loading it if it isn't cached.  The handle is Loading
+	/// until an Update or Flush after the file has been read.
+	///</summary>
+	Handle Acquire(const std::string& path);
+
+	///<summary>
+	/// Makes textures from the files that have finished reading, without waiting
+	/// for the others, then evicts down to the budgets.  Call once a frame.
+	///</summary>
+	void Update();
+
+	///<summary>
+	/// Waits for every file being read and makes its texture, e.g. at the end of
+	/// startup, then evicts down to the budgets.
+	///</summary>
+	void Flush();
+
+	///<summary>
+	/// Evicts unused textures, least recently used first, until both budgets are
+	/// met or nothing unused is left.
+	///</summary>
+	void Trim();
+
+	///<summary>
+	/// Evicts every unused texture.
+	///</summary>
+	void Clear();
+
+	void SetSettings(const Settings& settings) { mSettings = settings; }
+	const Settings& GetSettings()const { return mSettings; }
+	const Stats& GetStats()const { return mStats; }
+
+	///<summary>
+	/// path with '\' as '/', "." and "dir/.." removed and, on Windows, lower case.
+	/// Relative paths stay relative to the working directory.
+	///</summary>
+	static std::string CanonicalPath(const std::string& path);
+
+	///<summary>
+	/// FNV-1a 64 of bytes, as CookManifest hashes source files.
+	///</summary>
+	static uint64 HashBytes(const std::vector<uint8>& bytes);
+
+private:
+	struct ReadResult
+	{
+		bool Ok = false;
+		std::string Error;
+		std::vector<uint8> Bytes;
+		uint64 Hash = 0;
+	};
+
+	// One distinct resource, shared by every path whose file has its bytes.
+	struct Content
+	{
+		std::shared_ptr<void> Resource;
+
+		// The file it was made from, to compare other files with the same hash to.
+		std::string Path;
+		uint64 Size = 0;
+		uint64 CpuBytes = 0;
+		uint64 GpuBytes = 0;
+		std::uint32_t Users = 0;
+	};
+
+	struct Slot
+	{
+		std::shared_ptr<Entry> Texture;
+		std::shared_future<ReadResult> Pending;
+		uint64 LastUsed = 0;
+
+		// The resource's Content once Ready.  Elements of mContents don't move.
+		Content* Shared = nullptr;
+	};
+
+	ReadResult Read(const std::string& path);
+	void Finish(Slot& slot);
+	bool SameBytes(const Content& content, const std::vector<uint8>& bytes);
+	void Evict(const std::string& path);
+	void UpdateStats();
+
+	Factory& mFactory;
+	AsyncLoader* mLoader;
+	Settings mSettings;
+	Stats mStats;
+
+	std::unordered_map<std::string, Slot> mSlots;
+
+	// By content hash; files with different bytes can share a hash.
+	std::unordered_multimap<uint64, Content> mContents;
+	uint64 mClock = 0;
+};
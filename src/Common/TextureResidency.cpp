@@ -0,0 +1,227 @@
+//***************************************************************************************
+// TextureResidency.cpp
+//***************************************************************************************
+
+#include "TextureResidency.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+	double MipTexels(std::uint32_t width, std::uint32_t height, std::uint32_t mip)
+	{
+		return (double)(std::max)(1u, width >> mip) * (double)(std::max)(1u, height >> mip);
+	}
+}
+
+TextureResidency::TextureResidency(const Settings& settings)
+	: mSettings(settings)
+{
+}
+
+TextureResidency::uint32 TextureResidency::AddTexture(uint32 width, uint32 height,
+	const std::vector<uint64>& mipBytes, uint32 tailMip)
+{
+	assert(!mipBytes.empty());
+
+	Texture tex;
+	tex.Width = width;
+	tex.Height = height;
+	tex.MipBytes = mipBytes;
+	tex.TailMip = (std::min)(tailMip, (uint32)mipBytes.size() - 1);
+	tex.ResidentMip = tex.TailMip;
+	tex.WantedMip = tex.TailMip;
+
+	for(uint32 mip = tex.TailMip; mip < (uint32)mipBytes.size(); ++mip)
+		mStats.ResidentBytes += mipBytes[mip];
+
+	mTextures.push_back(std::move(tex));
+	return (uint32)mTextures.size() - 1;
+}
+
+float TextureResidency::ScreenSize(float worldSize, float distance, float fovY, float viewportHeight)
+{
+	float viewHeight = 2.0f*(std::max)(distance, 1e-3f)*tanf(0.5f*fovY);
+	return worldSize / viewHeight * viewportHeight;
+}
+
+TextureResidency::uint32 TextureResidency::DesiredMip(uint32 width, uint32 height, float screenSize)
+{
+	float size = (float)(std::max)(width, height);
+	if(screenSize >= size)
+		return 0;
+
+	// Mip m spans size / 2^m texels; keep the smallest m with at least screenSize.
+	float mip = floorf(log2f(size / (std::max)(screenSize, 1.0f)));
+	return (uint32)mip;
+}
+
+float TextureResidency::Priority(float screenSize, float distance)
+{
+	return screenSize / (1.0f + (std::max)(distance, 0.0f));
+}
+
+void TextureResidency::Request(uint32 texture, float screenSize, float distance)
+{
+	Texture& tex = mTextures[texture];
+
+	uint32 wanted = (std::min)(DesiredMip(tex.Width, tex.Height, screenSize), tex.TailMip);
+	float priority = Priority(screenSize, distance);
+
+	if(!IsRequested(tex))
+	{
+		tex.RequestFrame = mFrame;
+		tex.WantedMip = wanted;
+		tex.Priority = priority;
+	}
+	else
+	{
+		tex.WantedMip = (std::min)(tex.WantedMip, wanted);
+		tex.Priority = (std::max)(tex.Priority, priority);
+	}
+
+	tex.LastUsed = mFrame;
+}
+
+TextureResidency::uint32 TextureResidency::EvictionFloor(const Texture& tex)const
+{
+	return IsRequested(tex) ? tex.WantedMip : tex.TailMip;
+}
+
+void TextureResidency::Evict(uint32 texture, std::vector<Eviction>& evictions)
+{
+	Texture& tex = mTextures[texture];
+	assert(!tex.Pending && tex.ResidentMip < tex.TailMip);
+
+	mStats.ResidentBytes -= tex.MipBytes[tex.ResidentMip];
+	++tex.ResidentMip;
+	++mStats.Evictions;
+
+	// One entry per texture per update, holding where it ended up.
+	if(!evictions.empty() && evictions.back().Texture == texture)
+		evictions.back().Mip = tex.ResidentMip;
+	else
+		evictions.push_back({ texture, tex.ResidentMip });
+}
+
+void TextureResidency::Update(std::vector<Load>& loads, std::vector<Eviction>& evictions)
+{
+	//
+	// How much of what was asked for is resident.
+	//
+
+	double wantedTexels = 0.0;
+	double residentTexels = 0.0;
+	for(const Texture& tex : mTextures)
+	{
+		if(!IsRequested(tex))
+			continue;
+
+		double wanted = MipTexels(tex.Width, tex.Height, tex.WantedMip);
+		wantedTexels += wanted;
+		residentTexels += (std::min)(wanted, MipTexels(tex.Width, tex.Height, tex.ResidentMip));
+	}
+	mStats.Sharpness = wantedTexels > 0.0 ? (float)(residentTexels / wantedTexels) : 1.0f;
+	mStats.Deferred = 0;
+
+	//
+	// Textures that want a finer mip, most important first.  Mips go up one level
+	// per load, so a texture that wants several waits its turn for each.
+	//
+
+	mCandidates.clear();
+	for(uint32 i = 0; i < (uint32)mTextures.size(); ++i)
+	{
+		const Texture& tex = mTextures[i];
+		if(IsRequested(tex) && !tex.Pending && tex.WantedMip < tex.ResidentMip)
+			mCandidates.push_back(i);
+	}
+
+	std::sort(mCandidates.begin(), mCandidates.end(), [this](uint32 a, uint32 b)
+	{
+		const Texture& ta = mTextures[a];
+		const Texture& tb = mTextures[b];
+		if(ta.Priority != tb.Priority)
+			return ta.Priority > tb.Priority;
+		return a < b;
+	});
+
+	//
+	// Textures that can give up mips: least recently used first, the lowest
+	// priority first among those used in the same frame.  A texture requested this
+	// frame only gives up mips finer than it wants.
+	//
+
+	mVictims.clear();
+	for(uint32 i = 0; i < (uint32)mTextures.size(); ++i)
+	{
+		const Texture& tex = mTextures[i];
+		if(!tex.Pending && tex.ResidentMip < EvictionFloor(tex))
+			mVictims.push_back(i);
+	}
+
+	std::sort(mVictims.begin(), mVictims.end(), [this](uint32 a, uint32 b)
+	{
+		const Texture& ta = mTextures[a];
+		const Texture& tb = mTextures[b];
+		if(ta.LastUsed != tb.LastUsed)
+			return ta.LastUsed < tb.LastUsed;
+		if(ta.Priority != tb.Priority)
+			return ta.Priority < tb.Priority;
+		return a < b;
+	});
+
+	size_t nextVictim = 0;
+	for(size_t c = 0; c < mCandidates.size(); ++c)
+	{
+		if(mPendingLoads >= mSettings.MaxPendingLoads)
+			break;
+
+		const uint32 id = mCandidates[c];
+		Texture& tex = mTextures[id];
+		const uint32 mip = tex.ResidentMip - 1;
+		const uint64 bytes = tex.MipBytes[mip];
+
+		while(mStats.ResidentBytes + mStats.PendingBytes + bytes > mSettings.BudgetBytes &&
+			nextVictim < mVictims.size())
+		{
+			uint32 victim = mVictims[nextVictim];
+			if(mTextures[victim].ResidentMip < EvictionFloor(mTextures[victim]))
+				Evict(victim, evictions);
+			else
+				++nextVictim;
+		}
+
+		// Nothing left to evict: lower priority textures don't get to load either,
+		// or they would take the room the ones above them need next.
+		if(mStats.ResidentBytes + mStats.PendingBytes + bytes > mSettings.BudgetBytes)
+		{
+			mStats.Deferred = (uint32)(mCandidates.size() - c);
+			break;
+		}
+
+		tex.Pending = true;
+		++mPendingLoads;
+		mStats.PendingBytes += bytes;
+		++mStats.LoadsIssued;
+		loads.push_back({ id, mip, bytes });
+	}
+
+	++mFrame;
+}
+
+void TextureResidency::CompleteLoad(uint32 texture)
+{
+	Texture& tex = mTextures[texture];
+	assert(tex.Pending && tex.ResidentMip > 0);
+
+	const uint64 bytes = tex.MipBytes[tex.ResidentMip - 1];
+	mStats.PendingBytes -= bytes;
+	mStats.ResidentBytes += bytes;
+	--tex.ResidentMip;
+	tex.Pending = false;
+
+	--mPendingLoads;
+	++mStats.LoadsCompleted;
+}
@@ -0,0 +1,172 @@
+//***************************************************************************************
+// TextureResidency.h
+//
+// Decides which mips of a set of streamed textures are resident, with no device
+// involved, so it runs (and can be checked) anywhere.  Each texture keeps its mip
+// tail, the smallest mips that are loaded with it, and the finest resident mip
+// moves up or down the chain one level at a time:
+//   -Each frame the app calls Request for every texture it draws, with the size
+//    it covers on screen and its distance from the eye.  The screen size gives
+//    the mip that is wanted; size and distance give the priority.
+//   -Update issues loads of the next finer mip for the textures furthest from the
+//    mip they want, highest priority first, up to a number in flight at a time.
+//   -When a load would take the resident bytes over the budget, mips are evicted
+//    from the least recently used textures first, and then from textures that
+//    have more resident than they now want.  Mips a texture still needs this
+//    frame are never evicted to make room for another texture's.
+//
+// Loads complete asynchronously: the caller reads the mip and calls CompleteLoad.
+// TextureStreamer drives this for D3D12 textures.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class TextureResidency
+{
+public:
+	typedef std::uint32_t uint32;
+	typedef std::uint64_t uint64;
+
+	struct Settings
+	{
+		// Bytes all the streamed textures may have resident, tails included.
+		uint64 BudgetBytes = 64ull << 20;
+
+		// Loads in flight at once.
+		uint32 MaxPendingLoads = 8;
+	};
+
+	// Mip Mip of texture Texture should be read; it is the finest resident mip once
+	// CompleteLoad(Texture) is called.
+	struct Load
+	{
+		uint32 Texture;
+		uint32 Mip;
+		uint64 Bytes;
+	};
+
+	// Texture's finest resident mip is now Mip; the ones above it can be freed.
+	struct Eviction
+	{
+		uint32 Texture;
+		uint32 Mip;
+	};
+
+	struct Stats
+	{
+		uint64 ResidentBytes = 0;
+		uint64 PendingBytes = 0;
+
+		// Requested texels that are resident, as a fraction of every texel that
+		// was requested in the last Update (1 when everything is as sharp as wanted).
+		float Sharpness = 1.0f;
+
+		// Totals since construction.
+		uint64 LoadsIssued = 0;
+		uint64 LoadsCompleted = 0;
+		uint64 Evictions = 0;
+
+		// Loads that didn't fit in the budget in the last Update.
+		uint32 Deferred = 0;
+	};
+
+	explicit TextureResidency(const Settings& settings);
+
+	TextureResidency(const TextureResidency& rhs) = delete;
+	TextureResidency& operator=(const TextureResidency& rhs) = delete;
+
+	///<summary>
+	/// Adds a width x height texture whose mip i takes mipBytes[i].  Mips tailMip
+	/// and below are resident from the start and never evicted.  Returns its id.
+	///</summary>
+	uint32 AddTexture(uint32 width, uint32 height, const std::vector<uint64>& mipBytes, uint32 tailMip);
+
+	///<summary>
+	/// Pixels covered on screen by an object worldSize units across at distance
+	/// units from the eye, for a vertical field of view fovY (radians) and a
+	/// viewport viewportHeight pixels high.
+	///</summary>
+	static float ScreenSize(float worldSize, float distance, float fovY, float viewportHeight);
+
+	///<summary>
+	/// The coarsest mip of a width x height texture that still has a texel per
+	/// pixel when the texture spans screenSize pixels.
+	///</summary>
+	static uint32 DesiredMip(uint32 width, uint32 height, float screenSize);
+
+	///<summary>
+	/// Larger is loaded first: big on screen and near the eye.
+	///</summary>
+	static float Priority(float screenSize, float distance);
+
+	///<summary>
+	/// The texture is drawn this frame spanning screenSize pixels (multiplied by
+	/// how often it repeats) at distance units.  Can be called several times a
+	/// frame; the sharpest request wins.
+	///</summary>
+	void Request(uint32 texture, float screenSize, float distance);
+
+	///<summary>
+	/// Ends the frame: appends the loads to issue and the evictions made to fit
+	/// them in the budget.  Requests start over for the next frame.
+	///</summary>
+	void Update(std::vector<Load>& loads, std::vector<Eviction>& evictions);
+
+	///<summary>
+	/// The load issued for texture has finished.
+	///</summary>
+	void CompleteLoad(uint32 texture);
+
+	uint32 GetTextureCount()const { return (uint32)mTextures.size(); }
+	uint32 GetMipCount(uint32 texture)const { return (uint32)mTextures[texture].MipBytes.size(); }
+	uint32 GetTailMip(uint32 texture)const { return mTextures[texture].TailMip; }
+	uint32 GetResidentMip(uint32 texture)const { return mTextures[texture].ResidentMip; }
+	uint32 GetWantedMip(uint32 texture)const { return mTextures[texture].WantedMip; }
+	bool IsLoadPending(uint32 texture)const { return mTextures[texture].Pending; }
+
+	uint64 GetBudget()const { return mSettings.BudgetBytes; }
+	const Stats& GetStats()const { return mStats; }
+
+private:
+	struct Texture
+	{
+		uint32 Width = 0;
+		uint32 Height = 0;
+		std::vector<uint64> MipBytes;
+		uint32 TailMip = 0;
+
+		uint32 ResidentMip = 0;
+		bool Pending = false;
+
+		// This frame's request, valid when RequestFrame is the current frame.
+		uint32 WantedMip = 0;
+		float Priority = 0.0f;
+		uint64 RequestFrame = 0;
+
+		// Last frame the texture was requested; 0 if never.
+		uint64 LastUsed = 0;
+	};
+
+	bool IsRequested(const Texture& tex)const { return tex.RequestFrame == mFrame; }
+
+	// The coarsest mip tex must keep: what it wants this frame, else its tail.
+	uint32 EvictionFloor(const Texture& tex)const;
+
+	void Evict(uint32 texture, std::vector<Eviction>& evictions);
+
+	Settings mSettings;
+	std::vector<Texture> mTextures;
+
+	// Frames start at 1 so LastUsed 0 means never.
+	uint64 mFrame = 1;
+	uint32 mPendingLoads = 0;
+
+	Stats mStats;
+
+	// Scratch kept between updates.
+	std::vector<uint32> mCandidates;
+	std::vector<uint32> mVictims;
+};
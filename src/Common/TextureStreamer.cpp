@@ -0,0 +1,335 @@
+//***************************************************************************************
+// TextureStreamer.cpp
+//***************************************************************************************
+
+#include "TextureStreamer.h"
+#include <cstring>
+
+using Microsoft::WRL::ComPtr;
+
+TextureStreamer::TextureStreamer(ID3D12Device* device, AsyncLoader& loader, ID3D12DescriptorHeap* srvHeap,
+	UINT firstSrvIndex, UINT srvDescriptorSize, const Settings& settings)
+	: mDevice(device),
+	mLoader(loader),
+	mSrvHeap(srvHeap),
+	mFirstSrvIndex(firstSrvIndex),
+	mSrvDescriptorSize(srvDescriptorSize),
+	mSettings(settings),
+	mResidency(settings.Residency)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	// The workers read from the mapped files.
+	for(auto& tex : mTextures)
+	{
+		if(tex->PendingRead.valid())
+			tex->PendingRead.wait();
+	}
+}
+
+HRESULT TextureStreamer::AddTexture(ID3D12GraphicsCommandList* cmdList, const std::wstring& filename, UINT& texture)
+{
+	auto tex = std::make_unique<StreamedTexture>();
+	HRESULT hr = DirectX::HResultFromDdsStatus(tex->File.Open(filename));
+	if(FAILED(hr))
+		return hr;
+
+	const DdsFile& file = tex->File;
+	if(file.GetDimension() != DdsDimension::Texture2D || file.GetArraySize() != 1)
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+	const UINT mipCount = file.GetMipCount();
+	std::vector<UINT64> mipBytes(mipCount);
+	for(UINT mip = 0; mip < mipCount; ++mip)
+		mipBytes[mip] = file.GetSubresource(mip, 0).SlicePitch;
+
+	// The tail starts at the first mip no larger than TailSize.  Block-compressed
+	// resources must be a multiple of 4 texels across, so the tail can't start
+	// below a level that couldn't be a top level.
+	const bool isBlockCompressed = DdsFile::IsBlockCompressed(file.GetFormat());
+	UINT tailMip = 0;
+	while(tailMip + 1 < mipCount)
+	{
+		const DdsSubresource& mip = file.GetSubresource(tailMip, 0);
+		if((std::max)(mip.Width, mip.Height) <= mSettings.TailSize)
+			break;
+
+		const DdsSubresource& next = file.GetSubresource(tailMip + 1, 0);
+		if(isBlockCompressed && (next.Width % 4 != 0 || next.Height % 4 != 0))
+			break;
+
+		++tailMip;
+	}
+
+	tex->Id = (UINT)mTextures.size();
+	hr = Recreate(*tex, cmdList, tailMip, 0);
+	if(FAILED(hr))
+		return hr;
+
+	UINT id = mResidency.AddTexture(file.GetWidth(), file.GetHeight(), mipBytes, tailMip);
+	assert(id == tex->Id);
+
+	mTextures.push_back(std::move(tex));
+	texture = id;
+	return S_OK;
+}
+
+void TextureStreamer::Request(UINT texture, float screenSize, float distance)
+{
+	mResidency.Request(texture, screenSize, distance);
+}
+
+void TextureStreamer::Update(ID3D12GraphicsCommandList* cmdList, UINT64 completedFence, UINT64 frameFence)
+{
+	//
+	// Release the resources and upload buffers the GPU is done with.
+	//
+
+	for(auto& retired : mRetired)
+	{
+		if(retired.first == 0)
+			retired.first = frameFence;
+	}
+
+	mRetired.erase(std::remove_if(mRetired.begin(), mRetired.end(),
+		[completedFence](const std::pair<UINT64, ComPtr<ID3D12Resource>>& retired)
+		{
+			return retired.first <= completedFence;
+		}), mRetired.end());
+
+	//
+	// Finish the mips whose staging is done.  get() rethrows anything a worker threw.
+	//
+
+	for(auto& tex : mTextures)
+	{
+		if(tex->PendingRead.valid() &&
+			tex->PendingRead.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		{
+			tex->PendingRead.get();
+			tex->PendingRead = std::shared_future<void>();
+			tex->StagedMips.push_back(std::move(tex->PendingMip));
+			tex->PendingMip = StagedMip();
+			mResidency.CompleteLoad(tex->Id);
+		}
+	}
+
+	//
+	// Start staging the next loads.
+	//
+
+	mLoads.clear();
+	mEvictions.clear();
+	mResidency.Update(mLoads, mEvictions);
+
+	for(const TextureResidency::Load& load : mLoads)
+		ThrowIfFailed(Stage(*mTextures[load.Texture], load.Mip));
+
+	//
+	// Recreate the textures whose resident mips changed, loads and evictions alike.
+	//
+
+	for(auto& tex : mTextures)
+	{
+		UINT residentMip = mResidency.GetResidentMip(tex->Id);
+		if(residentMip != tex->TopMip && completedFence >= tex->SlotFence)
+			ThrowIfFailed(Recreate(*tex, cmdList, residentMip, frameFence));
+	}
+}
+
+UINT TextureStreamer::GetSrvHeapIndex(UINT texture)const
+{
+	return mFirstSrvIndex + texture*SrvsPerTexture + mTextures[texture]->Slot;
+}
+
+HRESULT TextureStreamer::Stage(StreamedTexture& tex, UINT mip)
+{
+	const DdsSubresource& sub = tex.File.GetSubresource(mip, 0);
+
+	// Lay the mip out the way CopyTextureRegion reads it from a buffer.
+	CD3DX12_RESOURCE_DESC mipDesc = CD3DX12_RESOURCE_DESC::Tex2D(tex.File.GetFormat(),
+		sub.Width, sub.Height, 1, 1);
+
+	StagedMip staged;
+	staged.Mip = mip;
+
+	UINT numRows = 0;
+	UINT64 rowBytes = 0;
+	UINT64 totalBytes = 0;
+	mDevice->GetCopyableFootprints(&mipDesc, 0, 1, 0, &staged.Footprint, &numRows, &rowBytes, &totalBytes);
+
+	CD3DX12_HEAP_PROPERTIES uploadHeap(D3D12_HEAP_TYPE_UPLOAD);
+	CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(totalBytes);
+
+	HRESULT hr = mDevice->CreateCommittedResource(&uploadHeap, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&staged.Upload));
+	if(FAILED(hr))
+		return hr;
+
+	// The buffer is created here, with the rest of the device work, and filled on
+	// a worker, which also takes the page faults of the mapped file.
+	ComPtr<ID3D12Resource> upload = staged.Upload;
+	const D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = staged.Footprint;
+	const std::uint8_t* data = sub.Data;
+	const size_t srcRowPitch = sub.RowPitch;
+
+	tex.PendingRead = mLoader.Submit([upload, footprint, data, srcRowPitch, numRows, rowBytes]()
+	{
+		std::uint8_t* mapped = nullptr;
+		CD3DX12_RANGE readRange(0, 0);
+		ThrowIfFailed(upload->Map(0, &readRange, reinterpret_cast<void**>(&mapped)));
+
+		for(UINT row = 0; row < numRows; ++row)
+		{
+			memcpy(mapped + footprint.Offset + row*footprint.Footprint.RowPitch,
+				data + row*srcRowPitch, (size_t)rowBytes);
+		}
+
+		upload->Unmap(0, nullptr);
+	});
+
+	tex.PendingMip = std::move(staged);
+	return S_OK;
+}
+
+HRESULT TextureStreamer::Recreate(StreamedTexture& tex, ID3D12GraphicsCommandList* cmdList, UINT topMip, UINT64 frameFence)
+{
+	const DdsFile& file = tex.File;
+	const DdsSubresource& top = file.GetSubresource(topMip, 0);
+	const UINT mipLevels = file.GetMipCount() - topMip;
+
+	auto findStaged = [&tex](UINT mip) -> const StagedMip*
+	{
+		for(const StagedMip& staged : tex.StagedMips)
+		{
+			if(staged.Mip == mip)
+				return &staged;
+		}
+		return nullptr;
+	};
+
+	//
+	// Where each mip comes from.  The mips the old resource holds are copied from
+	// it, and the staged mips just above them from their upload buffers.  Loads
+	// complete one level at a time, so only the mips above those, all of them
+	// for a new texture, still have to be uploaded from the file.
+	//
+
+	ID3D12Resource* old = tex.Resource.Get();
+
+	UINT firstCopiedMip = old ? (std::max)(topMip, tex.TopMip) : file.GetMipCount();
+	while(firstCopiedMip > topMip && findStaged(firstCopiedMip - 1) != nullptr)
+		--firstCopiedMip;
+
+	const UINT uploadedLevels = firstCopiedMip - topMip;
+
+	CD3DX12_HEAP_PROPERTIES defaultHeap(D3D12_HEAP_TYPE_DEFAULT);
+	CD3DX12_RESOURCE_DESC texDesc = CD3DX12_RESOURCE_DESC::Tex2D(file.GetFormat(),
+		top.Width, top.Height, 1, (UINT16)mipLevels);
+
+	ComPtr<ID3D12Resource> resource;
+	HRESULT hr = mDevice->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &texDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&resource));
+	if(FAILED(hr))
+		return hr;
+
+	if(uploadedLevels > 0)
+	{
+		CD3DX12_HEAP_PROPERTIES uploadHeap(D3D12_HEAP_TYPE_UPLOAD);
+		CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(
+			GetRequiredIntermediateSize(resource.Get(), 0, uploadedLevels));
+
+		ComPtr<ID3D12Resource> upload;
+		hr = mDevice->CreateCommittedResource(&uploadHeap, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+			D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&upload));
+		if(FAILED(hr))
+			return hr;
+
+		std::vector<D3D12_SUBRESOURCE_DATA> initData(uploadedLevels);
+		for(UINT i = 0; i < uploadedLevels; ++i)
+		{
+			const DdsSubresource& sub = file.GetSubresource(topMip + i, 0);
+			initData[i].pData = sub.Data;
+			initData[i].RowPitch = static_cast<LONG_PTR>(sub.RowPitch);
+			initData[i].SlicePitch = static_cast<LONG_PTR>(sub.SlicePitch);
+		}
+
+		UpdateSubresources(cmdList, resource.Get(), upload.Get(), 0, 0, uploadedLevels, initData.data());
+		Retire(upload, frameFence);
+	}
+
+	// The old resource is retired below, so it is left in the copy source state.
+	if(old)
+	{
+		cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(old,
+			D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE));
+	}
+
+	for(UINT i = uploadedLevels; i < mipLevels; ++i)
+	{
+		const UINT mip = topMip + i;
+		CD3DX12_TEXTURE_COPY_LOCATION dst(resource.Get(), i);
+
+		if(old && mip >= tex.TopMip)
+		{
+			CD3DX12_TEXTURE_COPY_LOCATION src(old, mip - tex.TopMip);
+			cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+		}
+		else
+		{
+			const StagedMip* staged = findStaged(mip);
+			CD3DX12_TEXTURE_COPY_LOCATION src(staged->Upload.Get(), staged->Footprint);
+			cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+		}
+	}
+
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(resource.Get(),
+		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+
+	// The staged mips copied above are released with the upload buffers; the ones
+	// evicted before they were ever copied can go now.
+	for(StagedMip& staged : tex.StagedMips)
+	{
+		if(staged.Mip >= topMip)
+			Retire(staged.Upload, frameFence);
+	}
+	tex.StagedMips.clear();
+
+	//
+	// Point the free SRV slot at it.  The first resource takes slot 0.
+	//
+
+	const UINT slot = tex.Resource ? 1 - tex.Slot : tex.Slot;
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Format = file.GetFormat();
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MostDetailedMip = 0;
+	srvDesc.Texture2D.MipLevels = mipLevels;
+	srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
+
+	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(mSrvHeap->GetCPUDescriptorHandleForHeapStart(),
+		mFirstSrvIndex + tex.Id*SrvsPerTexture + slot, mSrvDescriptorSize);
+	mDevice->CreateShaderResourceView(resource.Get(), &srvDesc, hDescriptor);
+
+	// Frames before frameFence may still sample the old resource through the old
+	// slot; neither is touched again until they have completed.
+	if(tex.Resource)
+	{
+		Retire(tex.Resource, frameFence);
+		tex.SlotFence = frameFence;
+	}
+
+	tex.Resource = resource;
+	tex.Slot = slot;
+	tex.TopMip = topMip;
+	return S_OK;
+}
+
+void TextureStreamer::Retire(ComPtr<ID3D12Resource> resource, UINT64 fence)
+{
+	mRetired.push_back(std::make_pair(fence, std::move(resource)));
+}
@@ -0,0 +1,154 @@
+//***************************************************************************************
+// TextureStreamer.h
+//
+// Streams the mips of DDS textures into D3D12 resources under a memory budget.
+// AddTexture uploads only the mip tail (the mips up to TailSize texels across), so
+// startup reads a small fraction of each file.  Each frame the app requests the
+// textures it draws with their screen size and distance, and Update:
+//   -finishes loads whose file reads are done,
+//   -lets TextureResidency pick the next loads and the evictions that keep the
+//    resident bytes under the budget,
+//   -creates an upload buffer for each load and has an AsyncLoader worker copy
+//    the mip into it from the mapped file, off the main thread,
+//   -recreates the resource of each texture whose resident mips changed, with
+//    its new top mip and everything below it, on the app's command list.  The
+//    mips the old resource already holds are copied on the GPU and a newly
+//    loaded mip is copied from its upload buffer, so nothing is re-uploaded.
+//
+// Each texture has two SRVs in the app's heap.  A new resource's SRV goes in the
+// slot the GPU isn't using, and the old resource is released once the frames that
+// may still sample it have completed, so nothing waits on the GPU.  A texture is
+// not recreated again until the slot it gave up is free.
+//
+// Only 2D textures without arrays are supported.  One with a single mip is
+// uploaded whole and never changes, and a block-compressed one only streams the
+// mips that can be a top level (a multiple of 4 texels across).  The budget counts
+// the file's mip sizes, not the device's allocation sizes, and while a texture is
+// recreated its old and new resources are both alive for a few frames.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "AsyncLoader.h"
+#include "DdsFile.h"
+#include "TextureResidency.h"
+
+class TextureStreamer
+{
+public:
+	struct Settings
+	{
+		TextureResidency::Settings Residency;
+
+		// Mips no wider or taller than this are the tail, loaded by AddTexture and
+		// never evicted.
+		UINT TailSize = 64;
+	};
+
+	// SRV heap descriptors each texture uses.
+	static const UINT SrvsPerTexture = 2;
+
+	///<summary>
+	/// Textures get SRVs in srvHeap from firstSrvIndex on, SrvsPerTexture each.
+	/// loader runs the file reads and must outlive the streamer.
+	///</summary>
+	TextureStreamer(ID3D12Device* device, AsyncLoader& loader, ID3D12DescriptorHeap* srvHeap,
+		UINT firstSrvIndex, UINT srvDescriptorSize, const Settings& settings);
+	~TextureStreamer();
+
+	TextureStreamer(const TextureStreamer& rhs) = delete;
+	TextureStreamer& operator=(const TextureStreamer& rhs) = delete;
+
+	///<summary>
+	/// Maps filename and records the upload of its mip tail on cmdList.  The file
+	/// stays mapped while the streamer lives.  The upload buffer is released by an
+	/// Update after cmdList has executed.
+	///</summary>
+	HRESULT AddTexture(ID3D12GraphicsCommandList* cmdList, const std::wstring& filename, UINT& texture);
+
+	///<summary>
+	/// See TextureResidency::Request.  Call for every texture drawn this frame,
+	/// before Update.
+	///</summary>
+	void Request(UINT texture, float screenSize, float distance);
+
+	///<summary>
+	/// Streams as described above.  completedFence is the fence value the GPU has
+	/// reached and frameFence the value cmdList's frame will signal.  Call after
+	/// the command list is reset and before it references any texture's SRV.
+	///</summary>
+	void Update(ID3D12GraphicsCommandList* cmdList, UINT64 completedFence, UINT64 frameFence);
+
+	///<summary>
+	/// Index in the SRV heap of the texture's current SRV.  Changes when Update
+	/// recreates the texture.
+	///</summary>
+	UINT GetSrvHeapIndex(UINT texture)const;
+
+	ID3D12Resource* GetResource(UINT texture)const { return mTextures[texture]->Resource.Get(); }
+
+	///<summary>
+	/// Mip of the file that is mip 0 of the texture's resource.
+	///</summary>
+	UINT GetTopMip(UINT texture)const { return mTextures[texture]->TopMip; }
+
+	UINT GetTextureCount()const { return (UINT)mTextures.size(); }
+	const TextureResidency& GetResidency()const { return mResidency; }
+
+private:
+	// A mip a worker has copied (or is copying) into an upload buffer, laid out
+	// for CopyTextureRegion.
+	struct StagedMip
+	{
+		UINT Mip = 0;
+		Microsoft::WRL::ComPtr<ID3D12Resource> Upload;
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT Footprint = {};
+	};
+
+	struct StreamedTexture
+	{
+		DdsFile File;
+		UINT Id = 0;
+
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		UINT TopMip = 0;
+
+		// SRV slot in use and the fence after which the other one is free.
+		UINT Slot = 0;
+		UINT64 SlotFence = 0;
+
+		// The mip PendingRead is staging, and the staged mips the resource doesn't
+		// hold yet.
+		std::shared_future<void> PendingRead;
+		StagedMip PendingMip;
+		std::vector<StagedMip> StagedMips;
+	};
+
+	// Creates mip's upload buffer and starts the worker that copies the mip into it.
+	HRESULT Stage(StreamedTexture& tex, UINT mip);
+
+	// Creates tex's resource holding mips topMip and below and points the unused
+	// SRV slot at it.  Mips are copied on cmdList from the old resource or a
+	// staged upload buffer where possible and uploaded from the file otherwise.
+	HRESULT Recreate(StreamedTexture& tex, ID3D12GraphicsCommandList* cmdList, UINT topMip, UINT64 frameFence);
+
+	// Keeps resource alive until the GPU reaches fence; 0 means the fence of the
+	// next Update.
+	void Retire(Microsoft::WRL::ComPtr<ID3D12Resource> resource, UINT64 fence);
+
+	ID3D12Device* mDevice = nullptr;
+	AsyncLoader& mLoader;
+	ID3D12DescriptorHeap* mSrvHeap = nullptr;
+	UINT mFirstSrvIndex = 0;
+	UINT mSrvDescriptorSize = 0;
+	Settings mSettings;
+
+	TextureResidency mResidency;
+	std::vector<std::unique_ptr<StreamedTexture>> mTextures;
+
+	std::vector<std::pair<UINT64, Microsoft::WRL::ComPtr<ID3D12Resource>>> mRetired;
+
+	std::vector<TextureResidency::Load> mLoads;
+	std::vector<TextureResidency::Eviction> mEvictions;
+};
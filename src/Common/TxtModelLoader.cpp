@@ -0,0 +1,454 @@
+//***************************************************************************************
+// TxtModelLoader.cpp
+//***************************************************************************************
+
+#include "TxtModelLoader.h"
+#include "MappedFile.h"
+#include "ParallelFor.h"
+#include <cfloat>
+#include <cstdlib>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+	using uint16 = std::uint16_t;
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	// Sections are handed to the threads in chunks of about this many bytes.
+	const size_t ChunkSize = 64*1024;
+
+	// The characters isspace accepts in the "C" locale, as a table so the scanning
+	// loops don't branch on each of them.
+	struct SpaceTable
+	{
+		bool Table[256] = {};
+
+		SpaceTable()
+		{
+			for(unsigned char c : { ' ', '\n', '\r', '\t', '\v', '\f' })
+				Table[c] = true;
+		}
+	};
+
+	const SpaceTable gSpaceTable;
+
+	bool IsSpace(char c)
+	{
+		return gSpaceTable.Table[(unsigned char)c];
+	}
+
+	const char* SkipSpace(const char* p, const char* last)
+	{
+		while(p != last && IsSpace(*p))
+			++p;
+		return p;
+	}
+
+	const char* TokenEnd(const char* p, const char* last)
+	{
+		while(p != last && !IsSpace(*p))
+			++p;
+		return p;
+	}
+
+	// Parses an unsigned decimal integer that makes up all of [first, last).
+	bool ParseUint(const char* first, const char* last, uint32& value)
+	{
+		if(first == last)
+			return false;
+
+		uint64 v = 0;
+		for(const char* p = first; p != last; ++p)
+		{
+			unsigned d = (unsigned)(*p - '0');
+			if(d > 9)
+				return false;
+
+			v = v*10 + d;
+			if(v > 0xffffffffu)
+				return false;
+		}
+
+		value = (uint32)v;
+		return true;
+	}
+
+	// Parses a float that makes up all of [first, last), rounding the same way
+	// strtof (and so std::ifstream) does.  A number with at most 7 significant
+	// digits and a small exponent is an exact float times or divided by an exact
+	// power of ten, so one correctly rounded float operation gives the correctly
+	// rounded result (Clinger's fast path).  That covers every number the models
+	// contain; anything else goes to strtof.
+	bool ParseFloat(const char* first, const char* last, float& value)
+	{
+		static const float PowersOf10[] =
+		{
+			1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+		};
+
+		const char* p = first;
+		bool negative = false;
+		if(p != last && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			++p;
+		}
+
+		// Significant digits beyond the 19th can't be held in the mantissa; they only
+		// matter for the slow path, which rereads the token.
+		uint64 mantissa = 0;
+		int exponent = 0;
+		int numDigits = 0;
+		bool anyDigits = false;
+
+		for(; p != last && (unsigned)(*p - '0') <= 9; ++p)
+		{
+			anyDigits = true;
+			if(numDigits < 19)
+			{
+				mantissa = mantissa*10 + (unsigned)(*p - '0');
+				numDigits += mantissa != 0 ? 1 : 0;
+			}
+			else
+			{
+				++exponent;
+				++numDigits;
+			}
+		}
+
+		if(p != last && *p == '.')
+		{
+			for(++p; p != last && (unsigned)(*p - '0') <= 9; ++p)
+			{
+				anyDigits = true;
+				if(numDigits < 19)
+				{
+					mantissa = mantissa*10 + (unsigned)(*p - '0');
+					numDigits += mantissa != 0 ? 1 : 0;
+					--exponent;
+				}
+				else
+				{
+					++numDigits;
+				}
+			}
+		}
+
+		if(anyDigits && p != last && (*p == 'e' || *p == 'E'))
+		{
+			++p;
+			bool negativeExponent = false;
+			if(p != last && (*p == '-' || *p == '+'))
+			{
+				negativeExponent = *p == '-';
+				++p;
+			}
+
+			int e = 0;
+			bool anyExponentDigits = false;
+			for(; p != last && (unsigned)(*p - '0') <= 9; ++p)
+			{
+				e = (std::min)(e*10 + (*p - '0'), 100000);
+				anyExponentDigits = true;
+			}
+
+			if(!anyExponentDigits)
+				return false;
+
+			exponent += negativeExponent ? -e : e;
+		}
+
+		if(anyDigits && p == last && numDigits <= 19 && mantissa <= (1u << 24) && exponent >= -10 && exponent <= 10)
+		{
+			float f = (float)mantissa;
+			f = exponent < 0 ? f / PowersOf10[-exponent] : f * PowersOf10[exponent];
+			value = negative ? -f : f;
+			return true;
+		}
+
+		// Slow path: long mantissas, large exponents, inf and nan.
+		char buffer[128];
+		size_t length = (size_t)(last - first);
+		if(length >= sizeof(buffer))
+			return false;
+
+		memcpy(buffer, first, length);
+		buffer[length] = '\0';
+
+		char* end = nullptr;
+		value = strtof(buffer, &end);
+		return end == buffer + length;
+	}
+
+	// A byte range of a section and the numbers that start in it.
+	struct Chunk
+	{
+		const char* Begin = nullptr;
+		const char* End = nullptr;
+		size_t FirstNumber = 0;
+		size_t NumberCount = 0;
+	};
+
+	// Splits [first, last) into chunks and numbers the whitespace separated tokens
+	// in them.  A token belongs to the chunk its first character is in.  Returns the
+	// total number of tokens.
+	size_t CountNumbers(const char* first, const char* last, unsigned numThreads, std::vector<Chunk>& chunks)
+	{
+		size_t size = (size_t)(last - first);
+		size_t numChunks = std::max<size_t>(1, (size + ChunkSize - 1) / ChunkSize);
+
+		chunks.resize(numChunks);
+		for(size_t c = 0; c < numChunks; ++c)
+		{
+			chunks[c].Begin = first + c*ChunkSize;
+			chunks[c].End = first + (std::min)(size, (c + 1)*ChunkSize);
+		}
+
+		ParallelFor(numChunks, numThreads, [&](unsigned, size_t c)
+		{
+			Chunk& chunk = chunks[c];
+			bool previousSpace = chunk.Begin == first || IsSpace(chunk.Begin[-1]);
+
+			size_t count = 0;
+			for(const char* p = chunk.Begin; p != chunk.End; ++p)
+			{
+				bool space = IsSpace(*p);
+				count += previousSpace && !space ? 1 : 0;
+				previousSpace = space;
+			}
+
+			chunk.NumberCount = count;
+		});
+
+		size_t total = 0;
+		for(Chunk& chunk : chunks)
+		{
+			chunk.FirstNumber = total;
+			total += chunk.NumberCount;
+		}
+
+		return total;
+	}
+
+	// Calls func(numberIndex, tokenBegin, tokenEnd) for the numbers of every record
+	// (recordSize consecutive numbers: a vertex or a triangle) that starts in the
+	// chunk, stopping at the first number func rejects.  A record that straddles
+	// two chunks is parsed by the chunk it starts in.
+	template<typename Func>
+	bool ForEachRecord(const Chunk& chunk, size_t recordSize, const char* first, const char* last, const Func& func)
+	{
+		const char* p = chunk.Begin;
+
+		// The token straddling the start of the chunk belongs to the previous chunk.
+		if(p != first && !IsSpace(p[-1]))
+			p = TokenEnd(p, last);
+
+		size_t n = chunk.FirstNumber;
+		size_t end = chunk.FirstNumber + chunk.NumberCount;
+		for(p = SkipSpace(p, last); p != last; p = SkipSpace(p, last))
+		{
+			if(n >= end && n % recordSize == 0)
+				break;
+
+			const char* tokenEnd = TokenEnd(p, last);
+			if(n % recordSize != 0 && n - n % recordSize < chunk.FirstNumber)
+			{
+				// Rest of the previous chunk's last record.
+			}
+			else if(!func(n, p, tokenEnd))
+			{
+				return false;
+			}
+
+			++n;
+			p = tokenEnd;
+		}
+
+		return true;
+	}
+
+	// Finds the body of the next "{ ... }" section at or after p.
+	bool FindSection(const char*& p, const char* last, const char*& bodyBegin, const char*& bodyEnd)
+	{
+		const char* open = static_cast<const char*>(memchr(p, '{', (size_t)(last - p)));
+		if(open == nullptr)
+			return false;
+
+		const char* close = static_cast<const char*>(memchr(open + 1, '}', (size_t)(last - open - 1)));
+		if(close == nullptr)
+			return false;
+
+		bodyBegin = open + 1;
+		bodyEnd = close;
+		p = close + 1;
+		return true;
+	}
+
+	// Reads "<label> <count>".
+	bool ReadCount(const char*& p, const char* last, uint32& count)
+	{
+		p = TokenEnd(SkipSpace(p, last), last);
+		const char* begin = SkipSpace(p, last);
+		p = TokenEnd(begin, last);
+		return ParseUint(begin, p, count);
+	}
+}
+
+bool TxtModelLoader::Load(const std::string& filename,
+	const std::function<GeometryGenerator::MeshOutput(uint32 vertexCount, uint32 triangleCount)>& allocate,
+	BoundingBox* bounds, unsigned numThreads)
+{
+	MappedFile file(filename);
+	if(!file.IsOpen())
+		return false;
+
+	const char* first = file.Begin();
+	const char* last = file.End();
+	const char* p = first;
+
+	uint32 vcount = 0;
+	uint32 tcount = 0;
+	if(!ReadCount(p, last, vcount) || !ReadCount(p, last, tcount))
+		return false;
+
+	const char* vertexBegin;
+	const char* vertexEnd;
+	const char* triangleBegin;
+	const char* triangleEnd;
+	if(!FindSection(p, last, vertexBegin, vertexEnd) || !FindSection(p, last, triangleBegin, triangleEnd))
+		return false;
+
+	numThreads = ResolveThreadCount(numThreads);
+
+	std::vector<Chunk> vertexChunks;
+	std::vector<Chunk> triangleChunks;
+	if(CountNumbers(vertexBegin, vertexEnd, numThreads, vertexChunks) != 6*(size_t)vcount ||
+		CountNumbers(triangleBegin, triangleEnd, numThreads, triangleChunks) != 3*(size_t)tcount)
+	{
+		return false;
+	}
+
+	GeometryGenerator::MeshOutput output = allocate(vcount, tcount);
+	if(output.Indices16 != nullptr && vcount > 0 && (uint64)output.BaseVertex + vcount - 1 > 0xffff)
+		return false;
+
+	//
+	// Vertices.  Each chunk keeps the box around the positions it parsed.
+	//
+
+	struct ChunkBounds
+	{
+		XMFLOAT3 Min;
+		XMFLOAT3 Max;
+		bool Ok;
+	};
+
+	std::vector<ChunkBounds> chunkBounds(vertexChunks.size());
+	ParallelFor(vertexChunks.size(), numThreads, [&](unsigned, size_t c)
+	{
+		float vMin[3] = { +FLT_MAX, +FLT_MAX, +FLT_MAX };
+		float vMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		float v[6];
+		chunkBounds[c].Ok = ForEachRecord(vertexChunks[c], 6, vertexBegin, vertexEnd,
+			[&](size_t n, const char* tokenBegin, const char* tokenEnd)
+		{
+			if(!ParseFloat(tokenBegin, tokenEnd, v[n % 6]))
+				return false;
+
+			if(n % 6 == 5)
+			{
+				size_t offset = (n / 6)*output.VertexStride;
+				if(output.Positions != nullptr)
+					*reinterpret_cast<XMFLOAT3*>(reinterpret_cast<char*>(output.Positions) + offset) = XMFLOAT3(v[0], v[1], v[2]);
+				if(output.Normals != nullptr)
+					*reinterpret_cast<XMFLOAT3*>(reinterpret_cast<char*>(output.Normals) + offset) = XMFLOAT3(v[3], v[4], v[5]);
+
+				for(int k = 0; k < 3; ++k)
+				{
+					vMin[k] = (std::min)(vMin[k], v[k]);
+					vMax[k] = (std::max)(vMax[k], v[k]);
+				}
+			}
+
+			return true;
+		});
+
+		chunkBounds[c].Min = XMFLOAT3(vMin[0], vMin[1], vMin[2]);
+		chunkBounds[c].Max = XMFLOAT3(vMax[0], vMax[1], vMax[2]);
+	});
+
+	//
+	// Indices.
+	//
+
+	std::vector<std::uint8_t> triangleChunkOk(triangleChunks.size());
+	ParallelFor(triangleChunks.size(), numThreads, [&](unsigned, size_t c)
+	{
+		triangleChunkOk[c] = ForEachRecord(triangleChunks[c], 3, triangleBegin, triangleEnd,
+			[&](size_t n, const char* tokenBegin, const char* tokenEnd)
+		{
+			uint32 index;
+			if(!ParseUint(tokenBegin, tokenEnd, index) || index >= vcount)
+				return false;
+
+			if(output.Indices16 != nullptr)
+				output.Indices16[n] = (uint16)(output.BaseVertex + index);
+			else if(output.Indices32 != nullptr)
+				output.Indices32[n] = output.BaseVertex + index;
+
+			return true;
+		}) ? 1 : 0;
+	});
+
+	XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+	XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+	for(size_t c = 0; c < vertexChunks.size(); ++c)
+	{
+		if(!chunkBounds[c].Ok)
+			return false;
+
+		vMin = XMVectorMin(vMin, XMLoadFloat3(&chunkBounds[c].Min));
+		vMax = XMVectorMax(vMax, XMLoadFloat3(&chunkBounds[c].Max));
+	}
+
+	for(std::uint8_t ok : triangleChunkOk)
+	{
+		if(!ok)
+			return false;
+	}
+
+	if(bounds != nullptr)
+	{
+		if(vcount == 0)
+			vMin = vMax = XMVectorZero();
+
+		XMStoreFloat3(&bounds->Center, 0.5f*(vMin + vMax));
+		XMStoreFloat3(&bounds->Extents, 0.5f*(vMax - vMin));
+	}
+
+	return true;
+}
+
+bool TxtModelLoader::Load(const std::string& filename, GeometryGenerator::MeshData& meshData,
+	BoundingBox* bounds, unsigned numThreads)
+{
+	return Load(filename, [&](uint32 vertexCount, uint32 triangleCount)
+	{
+		meshData.Vertices.assign(vertexCount, GeometryGenerator::Vertex(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f));
+		meshData.Indices32.assign(3*(size_t)triangleCount, 0);
+
+		GeometryGenerator::MeshOutput output;
+		if(vertexCount > 0)
+		{
+			output.Positions = &meshData.Vertices[0].Position;
+			output.Normals = &meshData.Vertices[0].Normal;
+		}
+		output.VertexStride = sizeof(GeometryGenerator::Vertex);
+		output.Indices32 = meshData.Indices32.data();
+		return output;
+	}, bounds, numThreads);
+}
@@ -0,0 +1,96 @@
+//***************************************************************************************
+// TxtModelLoader.h
+//
+// Loads the text models the demos ship with (Models/skull.txt, Models/car.txt):
+//
+//   VertexCount: n
+//   TriangleCount: m
+//   VertexList (pos, normal)
+//   {
+//       px py pz nx ny nz      (n times)
+//   }
+//   TriangleList
+//   {
+//       i0 i1 i2               (m times)
+//   }
+//
+// The file is memory mapped and parsed in place instead of going through
+// std::ifstream, whose per-number locale and stream overhead dominates the load.
+// Each section is cut into fixed-size byte chunks; one pass counts the numbers in
+// every chunk so each chunk knows which vertex or index it starts at, and a second
+// pass parses the chunks on ParallelFor straight into the caller's buffers.  The
+// numbers parse to exactly the values std::ifstream produces, and the bounding box
+// of the positions is computed in the same pass.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include "GeometryGenerator.h"
+
+class TxtModelLoader
+{
+public:
+
+	using uint16 = std::uint16_t;
+	using uint32 = std::uint32_t;
+
+	///<summary>
+	/// Loads filename into the buffers returned by allocate(vertexCount,
+	/// triangleCount).  Only Positions, Normals and one of Indices16/Indices32 of the
+	/// output are used; the file has no tangents or texture coordinates.  bounds, if
+	/// given, receives the box around the positions.  numThreads = 0 uses every
+	/// hardware thread.  Returns false if the file can't be opened or is malformed
+	/// (wrong number count, bad number, index out of range, or more than 65536
+	/// vertices with 16-bit indices).
+	///</summary>
+	static bool Load(const std::string& filename,
+		const std::function<GeometryGenerator::MeshOutput(uint32 vertexCount, uint32 triangleCount)>& allocate,
+		DirectX::BoundingBox* bounds = nullptr, unsigned numThreads = 0);
+
+	static bool Load(const std::string& filename, GeometryGenerator::MeshData& meshData,
+		DirectX::BoundingBox* bounds = nullptr, unsigned numThreads = 0);
+
+	///<summary>
+	/// Same for an app vertex struct with Pos and Normal members and 16 or 32-bit
+	/// indices.  Other vertex members are value-initialized.
+	///</summary>
+	template<typename VertexT, typename IndexT>
+	static bool Load(const std::string& filename, std::vector<VertexT>& vertices, std::vector<IndexT>& indices,
+		DirectX::BoundingBox* bounds = nullptr, unsigned numThreads = 0)
+	{
+		static_assert(sizeof(IndexT) == 2 || sizeof(IndexT) == 4, "Indices must be 16 or 32-bit.");
+
+		return Load(filename, [&](uint32 vertexCount, uint32 triangleCount)
+		{
+			vertices.assign(vertexCount, VertexT());
+			indices.assign(3*(size_t)triangleCount, IndexT());
+
+			GeometryGenerator::MeshOutput output;
+			if(vertexCount > 0)
+			{
+				output.Positions = &vertices[0].Pos;
+				output.Normals = &vertices[0].Normal;
+			}
+			output.VertexStride = sizeof(VertexT);
+			SetIndices(output, indices.data());
+			return output;
+		}, bounds, numThreads);
+	}
+
+private:
+	template<typename IndexT>
+	static void SetIndices(GeometryGenerator::MeshOutput& output, IndexT* indices)
+	{
+		if(sizeof(IndexT) == 2)
+			output.Indices16 = reinterpret_cast<uint16*>(indices);
+		else
+			output.Indices32 = reinterpret_cast<uint32*>(indices);
+	}
+};
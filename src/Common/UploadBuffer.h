@@ -63,6 +63,13 @@ public:
         memcpy(&mMappedData[elementIndex*mElementByteSize], &data, sizeof(T));
     }
 
+    // Where element elementIndex is mapped, for writing it in place instead of
+    // through CopyData.  Write-only: reads from upload memory are very slow.
+    BYTE* GetMappedData(int elementIndex)
+    {
+        return &mMappedData[elementIndex*mElementByteSize];
+    }
+
     UINT GetElementByteSize()
     {
         return mElementByteSize;
@@ -0,0 +1,292 @@
+//***************************************************************************************
+// VertexQuantizer.cpp
+//***************************************************************************************
+
+#include "VertexQuantizer.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	template<typename T>
+	const T& StreamElement(const T* base, size_t stride, size_t i)
+	{
+		return *reinterpret_cast<const T*>(reinterpret_cast<const char*>(base) + i*stride);
+	}
+
+	float FromSnorm16(std::int16_t q)
+	{
+		return std::max(q / 32767.0f, -1.0f);
+	}
+
+	bool IsZero(const XMFLOAT3& v)
+	{
+		return v.x == 0.0f && v.y == 0.0f && v.z == 0.0f;
+	}
+
+	float AngleDegrees(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		XMVECTOR va = XMVector3Normalize(XMLoadFloat3(&a));
+		XMVECTOR vb = XMVector3Normalize(XMLoadFloat3(&b));
+		float d = std::min(std::max(XMVectorGetX(XMVector3Dot(va, vb)), -1.0f), 1.0f);
+		return XMConvertToDegrees(acosf(d));
+	}
+
+	// Octahedral encoding: project the unit vector onto the octahedron |x|+|y|+|z| = 1
+	// and fold the lower half over the diagonals.  Of the four ways to round the
+	// result to 16 bits, keep the one that decodes closest to the input.
+	void EncodeOctahedral(const XMFLOAT3& v, std::int16_t q[2])
+	{
+		float l1 = fabsf(v.x) + fabsf(v.y) + fabsf(v.z);
+		if(l1 <= 0.0f)
+		{
+			q[0] = q[1] = 0;
+			return;
+		}
+
+		float x = v.x / l1;
+		float y = v.y / l1;
+		if(v.z < 0.0f)
+		{
+			float fx = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			float fy = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+			x = fx;
+			y = fy;
+		}
+
+		float sx = std::min(std::max(x, -1.0f), 1.0f) * 32767.0f;
+		float sy = std::min(std::max(y, -1.0f), 1.0f) * 32767.0f;
+
+		XMVECTOR target = XMVector3Normalize(XMLoadFloat3(&v));
+		float bestDot = -2.0f;
+		for(int i = 0; i < 4; ++i)
+		{
+			std::int16_t c[2] =
+			{
+				(std::int16_t)((i & 1) ? ceilf(sx) : floorf(sx)),
+				(std::int16_t)((i & 2) ? ceilf(sy) : floorf(sy))
+			};
+
+			XMFLOAT3 d = VertexQuantizer::DecodeOctahedral(c);
+			float dot = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&d), target));
+			if(dot > bestDot)
+			{
+				bestDot = dot;
+				q[0] = c[0];
+				q[1] = c[1];
+			}
+		}
+	}
+
+	// Rounds the weights to 8 bits so they still sum to exactly 255; the rounding
+	// error is given to the largest weight, where it matters least.
+	void EncodeBoneWeights(const XMFLOAT3& w, std::uint8_t q[4])
+	{
+		float weights[4] = { w.x, w.y, w.z, 1.0f - w.x - w.y - w.z };
+
+		int sum = 0;
+		int largest = 0;
+		for(int i = 0; i < 4; ++i)
+		{
+			float clamped = std::min(std::max(weights[i], 0.0f), 1.0f);
+			q[i] = (std::uint8_t)std::lround(clamped * 255.0f);
+			sum += q[i];
+			if(weights[i] > weights[largest])
+				largest = i;
+		}
+
+		int fixedWeight = q[largest] + (255 - sum);
+		q[largest] = (std::uint8_t)std::min(std::max(fixedWeight, 0), 255);
+	}
+
+	template<typename QuantizedT>
+	void EncodeCommon(const VertexStreams& streams, const QuantizationParams& params,
+		size_t i, QuantizedT& dst, QuantizationError* error)
+	{
+		//
+		// Position.
+		//
+
+		XMFLOAT3 p = streams.Positions ? StreamElement(streams.Positions, streams.PositionStride, i) : XMFLOAT3(0.0f, 0.0f, 0.0f);
+		const float* pf = &p.x;
+		const float* minf = &params.Min.x;
+		const float* extf = &params.Extent.x;
+		for(int k = 0; k < 3; ++k)
+		{
+			float t = extf[k] > 0.0f ? (pf[k] - minf[k]) / extf[k] : 0.0f;
+			t = std::min(std::max(t, 0.0f), 1.0f);
+			dst.Position[k] = (std::uint16_t)std::lround(t * 65535.0f);
+		}
+
+		float sign = streams.TangentSigns ? StreamElement(streams.TangentSigns, streams.TangentSignStride, i) : 1.0f;
+		dst.Position[3] = sign < 0.0f ? 0 : 65535;
+
+		//
+		// Normal and tangent.
+		//
+
+		XMFLOAT3 n = streams.Normals ? StreamElement(streams.Normals, streams.NormalStride, i) : XMFLOAT3(0.0f, 0.0f, 0.0f);
+		XMFLOAT3 t = streams.TangentU ? StreamElement(streams.TangentU, streams.TangentStride, i) : XMFLOAT3(0.0f, 0.0f, 0.0f);
+		EncodeOctahedral(n, dst.Normal);
+		EncodeOctahedral(t, dst.TangentU);
+
+		//
+		// Texture coordinates.
+		//
+
+		XMFLOAT2 uv = streams.TexC ? StreamElement(streams.TexC, streams.TexCStride, i) : XMFLOAT2(0.0f, 0.0f);
+		dst.TexC.x = XMConvertFloatToHalf(uv.x);
+		dst.TexC.y = XMConvertFloatToHalf(uv.y);
+
+		if(error == nullptr)
+			return;
+
+		XMFLOAT3 dp = VertexQuantizer::DecodePosition(dst.Position, params);
+		float dist = XMVectorGetX(XMVector3Length(XMLoadFloat3(&dp) - XMLoadFloat3(&p)));
+		error->Position = std::max(error->Position, dist);
+
+		// Meshes without tangents (or normals) have them zeroed; there is no
+		// direction to measure against.
+		if(streams.Normals && !IsZero(n))
+			error->NormalDegrees = std::max(error->NormalDegrees, AngleDegrees(n, VertexQuantizer::DecodeOctahedral(dst.Normal)));
+		if(streams.TangentU && !IsZero(t))
+			error->TangentDegrees = std::max(error->TangentDegrees, AngleDegrees(t, VertexQuantizer::DecodeOctahedral(dst.TangentU)));
+
+		XMFLOAT2 duv = VertexQuantizer::DecodeTexC(dst.TexC);
+		error->TexC = std::max(error->TexC, std::max(fabsf(duv.x - uv.x), fabsf(duv.y - uv.y)));
+	}
+}
+
+XMMATRIX QuantizationParams::GetDequantizeTransform()const
+{
+	return XMMatrixScaling(Extent.x, Extent.y, Extent.z) * XMMatrixTranslation(Min.x, Min.y, Min.z);
+}
+
+VertexStreams VertexQuantizer::Describe(const GeometryGenerator::MeshData& meshData)
+{
+	VertexStreams streams;
+	if(meshData.Vertices.empty())
+		return streams;
+
+	const GeometryGenerator::Vertex& v = meshData.Vertices[0];
+	streams.VertexCount = meshData.Vertices.size();
+	streams.Positions = &v.Position; streams.PositionStride = sizeof(GeometryGenerator::Vertex);
+	streams.Normals = &v.Normal;     streams.NormalStride = sizeof(GeometryGenerator::Vertex);
+	streams.TangentU = &v.TangentU;  streams.TangentStride = sizeof(GeometryGenerator::Vertex);
+	streams.TexC = &v.TexC;          streams.TexCStride = sizeof(GeometryGenerator::Vertex);
+	return streams;
+}
+
+QuantizationParams VertexQuantizer::ComputeParams(const VertexStreams& streams)
+{
+	QuantizationParams params;
+	if(streams.Positions == nullptr || streams.VertexCount == 0)
+		return params;
+
+	XMVECTOR vMin = XMLoadFloat3(&streams.Positions[0]);
+	XMVECTOR vMax = vMin;
+	for(size_t i = 1; i < streams.VertexCount; ++i)
+	{
+		XMVECTOR p = XMLoadFloat3(&StreamElement(streams.Positions, streams.PositionStride, i));
+		vMin = XMVectorMin(vMin, p);
+		vMax = XMVectorMax(vMax, p);
+	}
+
+	XMStoreFloat3(&params.Min, vMin);
+	XMStoreFloat3(&params.Extent, vMax - vMin);
+	return params;
+}
+
+void VertexQuantizer::Encode(const VertexStreams& streams, const QuantizationParams& params,
+	QuantizedVertex* dst, QuantizationError* error)
+{
+	if(error != nullptr)
+		*error = QuantizationError();
+
+	for(size_t i = 0; i < streams.VertexCount; ++i)
+		EncodeCommon(streams, params, i, dst[i], error);
+}
+
+void VertexQuantizer::Encode(const VertexStreams& streams, const QuantizationParams& params,
+	QuantizedSkinnedVertex* dst, QuantizationError* error)
+{
+	if(error != nullptr)
+		*error = QuantizationError();
+
+	for(size_t i = 0; i < streams.VertexCount; ++i)
+	{
+		EncodeCommon(streams, params, i, dst[i], error);
+
+		XMFLOAT3 w = streams.BoneWeights ? StreamElement(streams.BoneWeights, streams.BoneWeightStride, i) : XMFLOAT3(1.0f, 0.0f, 0.0f);
+		EncodeBoneWeights(w, dst[i].BoneWeights);
+
+		for(int k = 0; k < 4; ++k)
+			dst[i].BoneIndices[k] = streams.BoneIndices ? (&StreamElement(streams.BoneIndices, streams.BoneIndexStride, i))[k] : 0;
+
+		if(error != nullptr)
+		{
+			XMFLOAT4 dw = DecodeBoneWeights(dst[i].BoneWeights);
+			float source[4] = { w.x, w.y, w.z, 1.0f - w.x - w.y - w.z };
+			float decoded[4] = { dw.x, dw.y, dw.z, dw.w };
+			for(int k = 0; k < 4; ++k)
+				error->BoneWeight = std::max(error->BoneWeight, fabsf(decoded[k] - source[k]));
+		}
+	}
+}
+
+void VertexQuantizer::Decode(const QuantizedVertex* src, size_t count, const QuantizationParams& params,
+	GeometryGenerator::Vertex* dst)
+{
+	for(size_t i = 0; i < count; ++i)
+	{
+		dst[i].Position = DecodePosition(src[i].Position, params);
+		dst[i].Normal = DecodeOctahedral(src[i].Normal);
+		dst[i].TangentU = DecodeOctahedral(src[i].TangentU);
+		dst[i].TexC = DecodeTexC(src[i].TexC);
+	}
+}
+
+XMFLOAT3 VertexQuantizer::DecodePosition(const std::uint16_t q[4], const QuantizationParams& params)
+{
+	return XMFLOAT3(
+		params.Min.x + q[0] / 65535.0f * params.Extent.x,
+		params.Min.y + q[1] / 65535.0f * params.Extent.y,
+		params.Min.z + q[2] / 65535.0f * params.Extent.z);
+}
+
+XMFLOAT3 VertexQuantizer::DecodeOctahedral(const std::int16_t q[2])
+{
+	float x = FromSnorm16(q[0]);
+	float y = FromSnorm16(q[1]);
+	float z = 1.0f - fabsf(x) - fabsf(y);
+
+	// Unfold the lower half.
+	float t = std::max(-z, 0.0f);
+	x += x >= 0.0f ? -t : t;
+	y += y >= 0.0f ? -t : t;
+
+	XMFLOAT3 n;
+	XMVECTOR v = XMVectorSet(x, y, z, 0.0f);
+	if(XMVectorGetX(XMVector3LengthSq(v)) > 0.0f)
+		v = XMVector3Normalize(v);
+	XMStoreFloat3(&n, v);
+	return n;
+}
+
+float VertexQuantizer::DecodeTangentSign(const std::uint16_t q[4])
+{
+	return q[3] >= 32768 ? 1.0f : -1.0f;
+}
+
+XMFLOAT2 VertexQuantizer::DecodeTexC(const XMHALF2& q)
+{
+	return XMFLOAT2(XMConvertHalfToFloat(q.x), XMConvertHalfToFloat(q.y));
+}
+
+XMFLOAT4 VertexQuantizer::DecodeBoneWeights(const std::uint8_t q[4])
+{
+	return XMFLOAT4(q[0] / 255.0f, q[1] / 255.0f, q[2] / 255.0f, q[3] / 255.0f);
+}
@@ -0,0 +1,172 @@
+//***************************************************************************************
+// VertexQuantizer.h
+//
+// Packs full float vertices into compact vertex buffer layouts:
+//   -Positions: 16-bit UNORM relative to the mesh bounds (R16G16B16A16_UNORM).
+//   -Normals and tangents: octahedral encoding, 2x16-bit SNORM (R16G16_SNORM).
+//   -Texture coordinates: half floats (R16G16_FLOAT).
+//   -Bone weights: 4x8-bit UNORM summing to exactly 255 (R8G8B8A8_UNORM).
+//
+// GeometryGenerator::Vertex shrinks from 44 to 20 bytes and M3DLoader::SkinnedVertex
+// from 60 to 28 bytes.  The vertex shader undoes the position quantization with
+// QuantizationParams::GetDequantizeTransform() folded into the world matrix, and
+// the octahedral decode is a handful of ALU instructions:
+//
+//     float3 OctDecode(float2 e)
+//     {
+//         float3 n = float3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+//         float t = saturate(-n.z);
+//         n.xy += n.xy >= 0.0f ? -t : t;
+//         return normalize(n);
+//     }
+//
+// The reference decoders here mirror the shader code and are used to report the
+// worst error of every attribute after encoding.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include "GeometryGenerator.h"
+
+struct QuantizedVertex
+{
+	// xyz: position in the bounds.  w: tangent handedness (65535 for +1, 0 for -1),
+	// so the shader must use float4(pos.xyz, 1) as the position.
+	std::uint16_t Position[4];
+	std::int16_t Normal[2];
+	std::int16_t TangentU[2];
+	DirectX::PackedVector::XMHALF2 TexC;
+};
+
+struct QuantizedSkinnedVertex
+{
+	std::uint16_t Position[4];
+	std::int16_t Normal[2];
+	std::int16_t TangentU[2];
+	DirectX::PackedVector::XMHALF2 TexC;
+	std::uint8_t BoneWeights[4];
+	std::uint8_t BoneIndices[4];
+};
+
+// Maps 16-bit position codes back to object space: p = Min + q/65535 * Extent.
+struct QuantizationParams
+{
+	DirectX::XMFLOAT3 Min = { 0.0f, 0.0f, 0.0f };
+	DirectX::XMFLOAT3 Extent = { 0.0f, 0.0f, 0.0f };
+
+	// Transform from the [0,1] UNORM position the input assembler hands the vertex
+	// shader to object space.  Multiply it in front of the world matrix.
+	DirectX::XMMATRIX GetDequantizeTransform()const;
+};
+
+// Worst error of each attribute between the source and the decoded vertices.
+struct QuantizationError
+{
+	float Position = 0.0f;       // distance, object space units
+	float NormalDegrees = 0.0f;  // angle between source and decoded normal
+	float TangentDegrees = 0.0f;
+	float TexC = 0.0f;           // largest absolute difference of u or v
+	float BoneWeight = 0.0f;     // largest absolute difference of one weight
+};
+
+// Strided views of the source attributes, so any vertex struct can be encoded
+// without copying it first.  Null streams are encoded as zero.
+struct VertexStreams
+{
+	size_t VertexCount = 0;
+
+	const DirectX::XMFLOAT3* Positions = nullptr;   size_t PositionStride = 0;
+	const DirectX::XMFLOAT3* Normals = nullptr;     size_t NormalStride = 0;
+	const DirectX::XMFLOAT3* TangentU = nullptr;    size_t TangentStride = 0;
+	const float* TangentSigns = nullptr;            size_t TangentSignStride = 0;
+	const DirectX::XMFLOAT2* TexC = nullptr;        size_t TexCStride = 0;
+	const DirectX::XMFLOAT3* BoneWeights = nullptr; size_t BoneWeightStride = 0;
+	const std::uint8_t* BoneIndices = nullptr;      size_t BoneIndexStride = 0;
+};
+
+class VertexQuantizer
+{
+public:
+
+	static VertexStreams Describe(const GeometryGenerator::MeshData& meshData);
+
+	///<summary>
+	/// Describes a vector of vertices with the members of M3DLoader::Vertex (Pos,
+	/// Normal, TexC, TangentU).  If TangentU is an XMFLOAT4 its w is used as the
+	/// tangent handedness; an XMFLOAT3 tangent is encoded as right-handed.
+	///</summary>
+	template<typename VertexT>
+	static VertexStreams DescribeVertices(const std::vector<VertexT>& vertices)
+	{
+		VertexStreams streams;
+		if(vertices.empty())
+			return streams;
+
+		const VertexT& v = vertices[0];
+		streams.VertexCount = vertices.size();
+		streams.Positions = &v.Pos;           streams.PositionStride = sizeof(VertexT);
+		streams.Normals = &v.Normal;          streams.NormalStride = sizeof(VertexT);
+		streams.TangentU = reinterpret_cast<const DirectX::XMFLOAT3*>(&v.TangentU); streams.TangentStride = sizeof(VertexT);
+		streams.TangentSigns = TangentSign(v.TangentU); streams.TangentSignStride = sizeof(VertexT);
+		streams.TexC = &v.TexC;               streams.TexCStride = sizeof(VertexT);
+		return streams;
+	}
+
+	///<summary>
+	/// Same for skinned vertices with the members of M3DLoader::SkinnedVertex, which
+	/// adds BoneWeights and BoneIndices.
+	///</summary>
+	template<typename SkinnedVertexT>
+	static VertexStreams DescribeSkinned(const std::vector<SkinnedVertexT>& vertices)
+	{
+		VertexStreams streams = DescribeVertices(vertices);
+		if(vertices.empty())
+			return streams;
+
+		const SkinnedVertexT& v = vertices[0];
+		streams.BoneWeights = &v.BoneWeights; streams.BoneWeightStride = sizeof(SkinnedVertexT);
+		streams.BoneIndices = reinterpret_cast<const std::uint8_t*>(&v.BoneIndices[0]); streams.BoneIndexStride = sizeof(SkinnedVertexT);
+		return streams;
+	}
+
+	///<summary>
+	/// Bounds of the positions, used to quantize them.
+	///</summary>
+	static QuantizationParams ComputeParams(const VertexStreams& streams);
+
+	///<summary>
+	/// Encodes streams.VertexCount vertices to dst.  If error is not null it receives
+	/// the worst per-attribute error, measured with the reference decoders.
+	///</summary>
+	static void Encode(const VertexStreams& streams, const QuantizationParams& params,
+		QuantizedVertex* dst, QuantizationError* error = nullptr);
+	static void Encode(const VertexStreams& streams, const QuantizationParams& params,
+		QuantizedSkinnedVertex* dst, QuantizationError* error = nullptr);
+
+	///<summary>
+	/// Reference decoders matching what the shader computes.
+	///</summary>
+	static void Decode(const QuantizedVertex* src, size_t count, const QuantizationParams& params,
+		GeometryGenerator::Vertex* dst);
+
+	static DirectX::XMFLOAT3 DecodePosition(const std::uint16_t q[4], const QuantizationParams& params);
+	static DirectX::XMFLOAT3 DecodeOctahedral(const std::int16_t q[2]);
+	static float DecodeTangentSign(const std::uint16_t q[4]);
+	static DirectX::XMFLOAT2 DecodeTexC(const DirectX::PackedVector::XMHALF2& q);
+	static DirectX::XMFLOAT4 DecodeBoneWeights(const std::uint8_t q[4]);
+
+private:
+	static const float* TangentSign(const DirectX::XMFLOAT3&)
+	{
+		return nullptr;
+	}
+
+	static const float* TangentSign(const DirectX::XMFLOAT4& t)
+	{
+		return &t.w;
+	}
+};
@@ -182,6 +182,10 @@ struct MeshGeometry
 	DXGI_FORMAT IndexFormat = DXGI_FORMAT_R16_UINT;
 	UINT IndexBufferByteSize = 0;
 
+	// Offset of the indices in IndexBufferGPU, for geometry that keeps its vertices
+	// and indices in the same buffer (see GeometryBatcher).
+	UINT IndexBufferByteOffset = 0;
+
 	// A MeshGeometry may store multiple geometries in one vertex/index buffer.
 	// Use this container to define the Submesh geometries so we can draw
 	// the Submeshes individually.
@@ -200,7 +204,7 @@ struct MeshGeometry
 	D3D12_INDEX_BUFFER_VIEW IndexBufferView()const
 	{
 		D3D12_INDEX_BUFFER_VIEW ibv;
-		ibv.BufferLocation = IndexBufferGPU->GetGPUVirtualAddress();
+		ibv.BufferLocation = IndexBufferGPU->GetGPUVirtualAddress() + IndexBufferByteOffset;
 		ibv.Format = IndexFormat;
 		ibv.SizeInBytes = IndexBufferByteSize;
 
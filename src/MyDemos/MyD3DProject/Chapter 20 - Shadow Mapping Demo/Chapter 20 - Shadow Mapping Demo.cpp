@@ -6,6 +6,7 @@
 #include "../../../Common/MathHelper.h"
 #include "../../../Common/UploadBuffer.h"
 #include "../../../Common/GeometryGenerator.h"
+#include "../../../Common/TxtModelLoader.h"
 #include "../../../Common/Camera.h"
 #include "FrameResource.h"
 #include "ShadowMap.h"
@@ -991,38 +992,17 @@ void ShadowMappingDemoApp::BuildShapeGeometry()
 
 void ShadowMappingDemoApp::BuildSkullGeometry()
 {
-	std::ifstream fin("Models/skull.txt");
-
-	if (!fin)
+	std::vector<Vertex> vertices;
+	std::vector<std::int32_t> indices;
+	BoundingBox bounds;
+	if (!TxtModelLoader::Load("Models/skull.txt", vertices, indices, &bounds))
 	{
 		MessageBox(0, L"Models/skull.txt not found.", 0, 0);
 		return;
 	}
 
-	UINT vcount = 0;
-	UINT tcount = 0;
-	std::string ignore;
-
-	fin >> ignore >> vcount;
-	fin >> ignore >> tcount;
-	fin >> ignore >> ignore >> ignore >> ignore;
-
-	XMFLOAT3 vMinf3(+MathHelper::Infinity, +MathHelper::Infinity, +MathHelper::Infinity);
-	XMFLOAT3 vMaxf3(-MathHelper::Infinity, -MathHelper::Infinity, -MathHelper::Infinity);
-
-	XMVECTOR vMin = XMLoadFloat3(&vMinf3);
-	XMVECTOR vMax = XMLoadFloat3(&vMaxf3);
-
-	std::vector<Vertex> vertices(vcount);
-	for (UINT i = 0; i < vcount; ++i)
+	for (UINT i = 0; i < (UINT)vertices.size(); ++i)
 	{
-		fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-		fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
-
-		vertices[i].TexC = { 0.0f, 0.0f };
-
-		XMVECTOR P = XMLoadFloat3(&vertices[i].Pos);
-
 		XMVECTOR N = XMLoadFloat3(&vertices[i].Normal);
 
 		// Generate a tangent vector so normal mapping works.  We aren't applying
@@ -1040,28 +1020,8 @@ void ShadowMappingDemoApp::BuildSkullGeometry()
 			XMVECTOR T = XMVector3Normalize(XMVector3Cross(N, up));
 			XMStoreFloat3(&vertices[i].TangentU, T);
 		}
-
-
-		vMin = XMVectorMin(vMin, P);
-		vMax = XMVectorMax(vMax, P);
 	}
 
-	BoundingBox bounds;
-	XMStoreFloat3(&bounds.Center, 0.5f * (vMin + vMax));
-	XMStoreFloat3(&bounds.Extents, 0.5f * (vMax - vMin));
-
-	fin >> ignore;
-	fin >> ignore;
-	fin >> ignore;
-
-	std::vector<std::int32_t> indices(3 * tcount);
-	for (UINT i = 0; i < tcount; ++i)
-	{
-		fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
-	}
-
-	fin.close();
-
 	//
 	// Pack the indices of all the meshes into one index buffer.
 	//
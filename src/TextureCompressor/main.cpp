@@ -0,0 +1,234 @@
+//***************************************************************************************
+// main.cpp
+//
+// Console tool that block compresses an image into a DDS file with a full mip chain.
+//
+//   TextureCompressor.exe input.(bmp|dds) output.dds [--format auto|bc1|bc3|bc4|bc5|bc7]
+//       [--srgb] [--quality fast|normal|high] [--threads n] [--no-mips]
+//       [--mip-filter box|kaiser|lanczos] [--linear] [--wrap] [--alpha-coverage ref]
+//
+// auto picks BC1 for opaque images and cutouts (alpha only 0 or 255) and BC3 for
+// anything else, the same choice AssetCooker makes for .bmp files.  Mips are
+// filtered in linear light unless --linear says the data isn't colour (normal
+// maps, masks).  Prints the encode time and the PSNR of the top mip.
+//***************************************************************************************
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../Common/BcDecoder.h"
+#include "../Common/BcEncoder.h"
+#include "../Common/DdsWriter.h"
+#include "../Common/MipGenerator.h"
+#include "../Common/RgbaImage.h"
+
+namespace
+{
+	using uint8 = std::uint8_t;
+
+	struct FormatName
+	{
+		const char* Name;
+		DXGI_FORMAT Format;
+		DXGI_FORMAT SrgbFormat;
+		unsigned Channels; // channels the format stores, for PSNR
+	};
+
+	const FormatName Formats[] =
+	{
+		{ "bc1", DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC1_UNORM_SRGB, 4 },
+		{ "bc3", DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC3_UNORM_SRGB, 4 },
+		{ "bc4", DXGI_FORMAT_BC4_UNORM, DXGI_FORMAT_BC4_UNORM,      1 },
+		{ "bc5", DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_BC5_UNORM,      2 },
+		{ "bc7", DXGI_FORMAT_BC7_UNORM, DXGI_FORMAT_BC7_UNORM_SRGB, 4 },
+	};
+
+	void PrintUsage()
+	{
+		printf("usage: TextureCompressor input.(bmp|dds) output.dds [options]\n");
+		printf("  --format          auto, bc1, bc3, bc4, bc5 or bc7 (default auto)\n");
+		printf("  --srgb            write the _SRGB variant of bc1, bc3 or bc7\n");
+		printf("  --quality         fast, normal or high (default normal)\n");
+		printf("  --threads         worker threads, 0 for every hardware thread (default 0)\n");
+		printf("  --no-mips         write the top level only\n");
+		printf("  --mip-filter      box, kaiser or lanczos (default kaiser)\n");
+		printf("  --linear          filter the stored values rather than linear light\n");
+		printf("  --wrap            filter across the edges, for tiling textures\n");
+		printf("  --alpha-coverage  keep the coverage of an alpha test at ref (0-1) in every mip\n");
+	}
+
+	const FormatName* ChooseFormat(const std::string& name, const RgbaImage& image)
+	{
+		std::string chosen = name;
+		if(chosen == "auto")
+		{
+			chosen = "bc1";
+			for(size_t i = 3; i < image.Pixels.size(); i += 4)
+			{
+				if(image.Pixels[i] != 0 && image.Pixels[i] != 255)
+				{
+					chosen = "bc3";
+					break;
+				}
+			}
+		}
+
+		for(const FormatName& format : Formats)
+		{
+			if(chosen == format.Name)
+				return &format;
+		}
+
+		return nullptr;
+	}
+
+	// Peak signal to noise ratio of the decoded blocks against image over the
+	// channels the format stores.  BC1 alpha only counts as 1 bit, so it is skipped.
+	double ComputePsnr(const FormatName& format, const RgbaImage& image, const std::vector<uint8>& blocks)
+	{
+		std::vector<uint8> decoded(image.Pixels.size());
+		size_t rowPitch = blocks.size() / ((image.Height + 3) / 4);
+		BcDecoder::Decode(format.Format, blocks.data(), rowPitch, image.Width, image.Height,
+			decoded.data(), image.RowPitch());
+
+		const unsigned channels = format.Format == DXGI_FORMAT_BC1_UNORM ? 3 : format.Channels;
+		double sum = 0.0;
+		for(size_t p = 0; p < image.Pixels.size(); p += 4)
+		{
+			for(unsigned c = 0; c < channels; ++c)
+			{
+				double d = (double)image.Pixels[p + c] - decoded[p + c];
+				sum += d*d;
+			}
+		}
+
+		double mse = sum / ((double)image.Width*image.Height*channels);
+		return mse > 0.0 ? 10.0*std::log10(255.0*255.0 / mse) : INFINITY;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 3)
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	const std::string input = argv[1];
+	const std::string output = argv[2];
+	std::string formatName = "auto";
+	bool srgb = false;
+	BcEncoder::Quality quality = BcEncoder::Quality::Normal;
+	unsigned numThreads = 0;
+	bool mips = true;
+	MipGenerator::Options mipOptions;
+	mipOptions.Kernel = MipGenerator::Filter::Kaiser;
+	mipOptions.Srgb = true;
+
+	for(int a = 3; a < argc; ++a)
+	{
+		bool hasValue = a + 1 < argc;
+		if(strcmp(argv[a], "--format") == 0 && hasValue)
+			formatName = argv[++a];
+		else if(strcmp(argv[a], "--srgb") == 0)
+			srgb = true;
+		else if(strcmp(argv[a], "--quality") == 0 && hasValue)
+		{
+			std::string value = argv[++a];
+			if(value == "fast")
+				quality = BcEncoder::Quality::Fast;
+			else if(value == "normal")
+				quality = BcEncoder::Quality::Normal;
+			else if(value == "high")
+				quality = BcEncoder::Quality::High;
+			else
+			{
+				PrintUsage();
+				return 2;
+			}
+		}
+		else if(strcmp(argv[a], "--threads") == 0 && hasValue)
+			numThreads = (unsigned)strtoul(argv[++a], nullptr, 10);
+		else if(strcmp(argv[a], "--no-mips") == 0)
+			mips = false;
+		else if(strcmp(argv[a], "--mip-filter") == 0 && hasValue)
+		{
+			std::string value = argv[++a];
+			if(value == "box")
+				mipOptions.Kernel = MipGenerator::Filter::Box;
+			else if(value == "kaiser")
+				mipOptions.Kernel = MipGenerator::Filter::Kaiser;
+			else if(value == "lanczos")
+				mipOptions.Kernel = MipGenerator::Filter::Lanczos;
+			else
+			{
+				PrintUsage();
+				return 2;
+			}
+		}
+		else if(strcmp(argv[a], "--linear") == 0)
+			mipOptions.Srgb = false;
+		else if(strcmp(argv[a], "--wrap") == 0)
+			mipOptions.WrapEdges = true;
+		else if(strcmp(argv[a], "--alpha-coverage") == 0 && hasValue)
+			mipOptions.AlphaReference = (float)atof(argv[++a]);
+		else
+		{
+			PrintUsage();
+			return 2;
+		}
+	}
+
+	RgbaImage image;
+	std::string error;
+	if(!RgbaImage::Load(input, image, error))
+	{
+		printf("%s: %s\n", input.c_str(), error.c_str());
+		return 1;
+	}
+
+	const FormatName* format = ChooseFormat(formatName, image);
+	if(format == nullptr)
+	{
+		printf("unknown format %s\n", formatName.c_str());
+		return 2;
+	}
+
+	// sRGB only changes how the GPU reads the blocks, not how they are encoded.
+	const DXGI_FORMAT fileFormat = srgb ? format->SrgbFormat : format->Format;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::vector<RgbaImage> images(1, image);
+	mipOptions.NumThreads = numThreads;
+	if(mips)
+		MipGenerator::Generate(image, mipOptions, images);
+
+	std::vector<std::vector<uint8>> levels(images.size());
+	double pixelCount = 0.0;
+	for(size_t level = 0; level < images.size(); ++level)
+	{
+		const RgbaImage& mip = images[level];
+		BcEncoder::Encode(format->Format, mip.Pixels.data(), mip.Width, mip.Height, levels[level], quality, numThreads);
+		pixelCount += (double)mip.Width*mip.Height;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	if(!DdsWriter::Write(output, fileFormat, image.Width, image.Height, levels))
+	{
+		printf("can't write %s\n", output.c_str());
+		return 1;
+	}
+
+	printf("%s -> %s: %s %ux%u, %u mips, %.1f ms (%.2f MP/s), PSNR %.2f dB\n",
+		input.c_str(), output.c_str(), format->Name, image.Width, image.Height, (unsigned)levels.size(),
+		seconds*1000.0, pixelCount / 1e6 / seconds, ComputePsnr(*format, image, levels[0]));
+
+	return 0;
+}
@@ -0,0 +1,247 @@
+//***************************************************************************************
+// main.cpp
+//
+// Console tool that packs images into one block compressed DDS file, either a 2D
+// atlas or a texture array (see TextureAtlas.h), and writes the placement of each
+// image next to it as output.layout.
+//
+//   TexturePacker.exe output.dds [--array] [--max-size n] [--guard n] [--npot]
+//       [--format bc1|bc3|bc7] [--srgb] [--quality fast|normal|high] [--threads n]
+//       [--mip-filter box|kaiser|lanczos] [--linear] [--all-mips]
+//       input.(bmp|dds) ...
+//
+// Images are named after their file names without the extension.  Atlases only
+// get the mips that don't blend neighbouring images (TextureAtlas::Result::
+// CleanMipCount) unless --all-mips asks for the full chain; arrays always get the
+// full chain.  The billboard trees' array comes from
+//
+//   TexturePacker.exe treearray.dds --array --format bc3 tree0.bmp tree1.bmp tree2.bmp
+//***************************************************************************************
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../Common/BcEncoder.h"
+#include "../Common/DdsWriter.h"
+#include "../Common/MipGenerator.h"
+#include "../Common/RgbaImage.h"
+#include "../Common/TextureAtlas.h"
+
+namespace
+{
+	using uint8 = std::uint8_t;
+
+	struct FormatName
+	{
+		const char* Name;
+		DXGI_FORMAT Format;
+		DXGI_FORMAT SrgbFormat;
+	};
+
+	const FormatName Formats[] =
+	{
+		{ "bc1", DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC1_UNORM_SRGB },
+		{ "bc3", DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC3_UNORM_SRGB },
+		{ "bc7", DXGI_FORMAT_BC7_UNORM, DXGI_FORMAT_BC7_UNORM_SRGB },
+	};
+
+	void PrintUsage()
+	{
+		printf("usage: TexturePacker output.dds [options] input.(bmp|dds) ...\n");
+		printf("  --array       one image per slice of a texture array instead of an atlas\n");
+		printf("  --max-size    largest atlas page or array slice (default 4096)\n");
+		printf("  --guard       texels of repeated edge around each atlas image (default 8)\n");
+		printf("  --npot        don't round page sizes up to powers of two\n");
+		printf("  --format      bc1, bc3 or bc7 (default bc3)\n");
+		printf("  --srgb        write the _SRGB variant of the format\n");
+		printf("  --quality     fast, normal or high (default normal)\n");
+		printf("  --threads     worker threads, 0 for every hardware thread (default 0)\n");
+		printf("  --mip-filter  box, kaiser or lanczos (default box)\n");
+		printf("  --linear      filter the stored values rather than linear light\n");
+		printf("  --all-mips    give an atlas the full mip chain, neighbours blending in the small mips\n");
+	}
+
+	const FormatName* FindFormat(const std::string& name)
+	{
+		for(const FormatName& format : Formats)
+		{
+			if(name == format.Name)
+				return &format;
+		}
+
+		return nullptr;
+	}
+
+	// "dir/tree0.bmp" -> "tree0"
+	std::string ImageName(const std::string& path)
+	{
+		size_t slash = path.find_last_of("/\\");
+		std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+		size_t dot = name.find_last_of('.');
+		return dot == std::string::npos ? name : name.substr(0, dot);
+	}
+
+	std::string LayoutFilename(const std::string& output)
+	{
+		size_t dot = output.find_last_of('.');
+		size_t slash = output.find_last_of("/\\");
+		if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+			return output + ".layout";
+		return output.substr(0, dot) + ".layout";
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 3)
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	const std::string output = argv[1];
+	std::vector<std::string> inputs;
+	TextureAtlas::Options atlasOptions;
+	std::string formatName = "bc3";
+	bool srgb = false;
+	BcEncoder::Quality quality = BcEncoder::Quality::Normal;
+	unsigned numThreads = 0;
+	bool allMips = false;
+	MipGenerator::Options mipOptions;
+	mipOptions.Kernel = MipGenerator::Filter::Box;
+	mipOptions.Srgb = true;
+
+	for(int a = 2; a < argc; ++a)
+	{
+		bool hasValue = a + 1 < argc;
+		if(strcmp(argv[a], "--array") == 0)
+			atlasOptions.Kind = TextureAtlas::Layout::Array;
+		else if(strcmp(argv[a], "--max-size") == 0 && hasValue)
+			atlasOptions.MaxSize = (unsigned)strtoul(argv[++a], nullptr, 10);
+		else if(strcmp(argv[a], "--guard") == 0 && hasValue)
+			atlasOptions.GuardBand = (unsigned)strtoul(argv[++a], nullptr, 10);
+		else if(strcmp(argv[a], "--npot") == 0)
+			atlasOptions.PowerOfTwo = false;
+		else if(strcmp(argv[a], "--format") == 0 && hasValue)
+			formatName = argv[++a];
+		else if(strcmp(argv[a], "--srgb") == 0)
+			srgb = true;
+		else if(strcmp(argv[a], "--quality") == 0 && hasValue)
+		{
+			std::string value = argv[++a];
+			if(value == "fast")
+				quality = BcEncoder::Quality::Fast;
+			else if(value == "normal")
+				quality = BcEncoder::Quality::Normal;
+			else if(value == "high")
+				quality = BcEncoder::Quality::High;
+			else
+			{
+				PrintUsage();
+				return 2;
+			}
+		}
+		else if(strcmp(argv[a], "--threads") == 0 && hasValue)
+			numThreads = (unsigned)strtoul(argv[++a], nullptr, 10);
+		else if(strcmp(argv[a], "--mip-filter") == 0 && hasValue)
+		{
+			std::string value = argv[++a];
+			if(value == "box")
+				mipOptions.Kernel = MipGenerator::Filter::Box;
+			else if(value == "kaiser")
+				mipOptions.Kernel = MipGenerator::Filter::Kaiser;
+			else if(value == "lanczos")
+				mipOptions.Kernel = MipGenerator::Filter::Lanczos;
+			else
+			{
+				PrintUsage();
+				return 2;
+			}
+		}
+		else if(strcmp(argv[a], "--linear") == 0)
+			mipOptions.Srgb = false;
+		else if(strcmp(argv[a], "--all-mips") == 0)
+			allMips = true;
+		else if(strncmp(argv[a], "--", 2) == 0)
+		{
+			PrintUsage();
+			return 2;
+		}
+		else
+			inputs.push_back(argv[a]);
+	}
+
+	const FormatName* format = FindFormat(formatName);
+	if(format == nullptr || inputs.empty())
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	std::vector<TextureAtlas::Source> sources(inputs.size());
+	for(size_t i = 0; i < inputs.size(); ++i)
+	{
+		std::string error;
+		if(!RgbaImage::Load(inputs[i], sources[i].Image, error))
+		{
+			printf("%s: %s\n", inputs[i].c_str(), error.c_str());
+			return 1;
+		}
+
+		sources[i].Name = ImageName(inputs[i]);
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	TextureAtlas::Result packed;
+	std::string error;
+	if(!TextureAtlas::Build(sources, atlasOptions, packed, error))
+	{
+		printf("%s\n", error.c_str());
+		return 1;
+	}
+
+	const unsigned mipCount = allMips ? MipGenerator::FullMipCount(packed.Width, packed.Height) : packed.CleanMipCount;
+
+	std::vector<std::vector<std::vector<uint8>>> slices(packed.Slices.size());
+	mipOptions.NumThreads = numThreads;
+	for(size_t s = 0; s < packed.Slices.size(); ++s)
+	{
+		std::vector<RgbaImage> images;
+		MipGenerator::Generate(packed.Slices[s], mipOptions, images);
+		images.resize(mipCount);
+
+		slices[s].resize(images.size());
+		for(size_t level = 0; level < images.size(); ++level)
+		{
+			const RgbaImage& mip = images[level];
+			BcEncoder::Encode(format->Format, mip.Pixels.data(), mip.Width, mip.Height, slices[s][level], quality, numThreads);
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	// sRGB only changes how the GPU reads the blocks, not how they are encoded.
+	const DXGI_FORMAT fileFormat = srgb ? format->SrgbFormat : format->Format;
+	if(!DdsWriter::WriteArray(output, fileFormat, packed.Width, packed.Height, slices))
+	{
+		printf("can't write %s\n", output.c_str());
+		return 1;
+	}
+
+	const std::string layout = LayoutFilename(output);
+	if(!TextureAtlas::SaveLayout(layout, packed.Placements))
+	{
+		printf("can't write %s\n", layout.c_str());
+		return 1;
+	}
+
+	printf("%u images -> %s: %s %ux%u, %u slice%s, %u mips, %.1f%% occupied, %.1f ms\n",
+		(unsigned)sources.size(), output.c_str(), format->Name, packed.Width, packed.Height,
+		(unsigned)slices.size(), slices.size() == 1 ? "" : "s", mipCount, 100.0f*packed.Occupancy, seconds*1000.0);
+
+	return 0;
+}